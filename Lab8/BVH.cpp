@@ -0,0 +1,255 @@
+#include "BVH.h"
+#include <cfloat>
+#include <utility>
+
+namespace {
+    void Grow(XMFLOAT4& bbMin, XMFLOAT4& bbMax, const XMFLOAT4& otherMin, const XMFLOAT4& otherMax) {
+        bbMin.x = bbMin.x <= otherMin.x ? bbMin.x : otherMin.x;
+        bbMin.y = bbMin.y <= otherMin.y ? bbMin.y : otherMin.y;
+        bbMin.z = bbMin.z <= otherMin.z ? bbMin.z : otherMin.z;
+        bbMax.x = bbMax.x >= otherMax.x ? bbMax.x : otherMax.x;
+        bbMax.y = bbMax.y >= otherMax.y ? bbMax.y : otherMax.y;
+        bbMax.z = bbMax.z >= otherMax.z ? bbMax.z : otherMax.z;
+    }
+
+    float HalfArea(const XMFLOAT4& bbMin, const XMFLOAT4& bbMax) {
+        float dx = bbMax.x - bbMin.x;
+        float dy = bbMax.y - bbMin.y;
+        float dz = bbMax.z - bbMin.z;
+        return dx * dy + dy * dz + dz * dx;
+    }
+
+    const XMFLOAT4 emptyMin = XMFLOAT4(FLT_MAX, FLT_MAX, FLT_MAX, 1.0f);
+    const XMFLOAT4 emptyMax = XMFLOAT4(-FLT_MAX, -FLT_MAX, -FLT_MAX, 1.0f);
+}
+
+void BVH::Build(const BoxStreams& boxes, int count) {
+    count_ = count;
+    nodes_.clear();
+    indices_.resize(count);
+    for (int i = 0; i < count; i++) {
+        indices_[i] = i;
+    }
+    if (count == 0) {
+        nodePlanes_.clear();
+        return;
+    }
+
+    nodes_.reserve((size_t)2 * count);
+    Node root;
+    root.first = 0;
+    root.count = count;
+    root.left = -1;
+    UpdateLeafBounds(root, boxes);
+    nodes_.push_back(root);
+    Subdivide(0, boxes);
+
+    nodePlanes_.assign(nodes_.size(), 0);
+}
+
+void BVH::UpdateLeafBounds(Node& node, const BoxStreams& boxes) {
+    node.bbMin = emptyMin;
+    node.bbMax = emptyMax;
+    for (int i = node.first; i < node.first + node.count; i++) {
+        int idx = indices_[i];
+        Grow(node.bbMin, node.bbMax,
+            XMFLOAT4(boxes.minX[idx], boxes.minY[idx], boxes.minZ[idx], 1.0f),
+            XMFLOAT4(boxes.maxX[idx], boxes.maxY[idx], boxes.maxZ[idx], 1.0f));
+    }
+}
+
+void BVH::Subdivide(int nodeIdx, const BoxStreams& boxes) {
+    Node node = nodes_[nodeIdx];
+    if (node.count <= maxLeafSize) {
+        return;
+    }
+
+    const AlignedVector<float>* mins[3] = { &boxes.minX, &boxes.minY, &boxes.minZ };
+    const AlignedVector<float>* maxs[3] = { &boxes.maxX, &boxes.maxY, &boxes.maxZ };
+
+    // Centroid bounds choose the binning range
+    float cMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+    float cMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    for (int i = node.first; i < node.first + node.count; i++) {
+        int idx = indices_[i];
+        for (int a = 0; a < 3; a++) {
+            float c = ((*mins[a])[idx] + (*maxs[a])[idx]) * 0.5f;
+            cMin[a] = min(cMin[a], c);
+            cMax[a] = max(cMax[a], c);
+        }
+    }
+
+    float bestCost = FLT_MAX;
+    int bestAxis = -1;
+    int bestSplit = 0;
+    for (int a = 0; a < 3; a++) {
+        float extent = cMax[a] - cMin[a];
+        if (extent <= 0.0f) {
+            continue;
+        }
+
+        XMFLOAT4 binMin[binCount], binMax[binCount];
+        int binSize[binCount] = {};
+        for (int b = 0; b < binCount; b++) {
+            binMin[b] = emptyMin;
+            binMax[b] = emptyMax;
+        }
+
+        float scale = binCount / extent;
+        for (int i = node.first; i < node.first + node.count; i++) {
+            int idx = indices_[i];
+            float c = ((*mins[a])[idx] + (*maxs[a])[idx]) * 0.5f;
+            int b = min(binCount - 1, (int)((c - cMin[a]) * scale));
+            binSize[b]++;
+            Grow(binMin[b], binMax[b],
+                XMFLOAT4(boxes.minX[idx], boxes.minY[idx], boxes.minZ[idx], 1.0f),
+                XMFLOAT4(boxes.maxX[idx], boxes.maxY[idx], boxes.maxZ[idx], 1.0f));
+        }
+
+        // Sweep from the right to get the cost of every split plane in one pass
+        float rightArea[binCount];
+        int rightCount[binCount];
+        XMFLOAT4 accMin = emptyMin, accMax = emptyMax;
+        int acc = 0;
+        for (int b = binCount - 1; b > 0; b--) {
+            acc += binSize[b];
+            if (binSize[b] > 0) {
+                Grow(accMin, accMax, binMin[b], binMax[b]);
+            }
+            rightCount[b] = acc;
+            rightArea[b] = acc > 0 ? HalfArea(accMin, accMax) : 0.0f;
+        }
+
+        accMin = emptyMin;
+        accMax = emptyMax;
+        acc = 0;
+        for (int b = 0; b < binCount - 1; b++) {
+            acc += binSize[b];
+            if (binSize[b] > 0) {
+                Grow(accMin, accMax, binMin[b], binMax[b]);
+            }
+            if (acc == 0 || rightCount[b + 1] == 0) {
+                continue;
+            }
+            float cost = acc * HalfArea(accMin, accMax) + rightCount[b + 1] * rightArea[b + 1];
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestAxis = a;
+                bestSplit = b + 1;
+            }
+        }
+    }
+
+    int mid = node.first;
+    if (bestAxis >= 0) {
+        float leafCost = node.count * HalfArea(node.bbMin, node.bbMax);
+        if (bestCost >= leafCost && node.count <= 2 * maxLeafSize) {
+            return;
+        }
+
+        float scale = binCount / (cMax[bestAxis] - cMin[bestAxis]);
+        int i = node.first;
+        int j = node.first + node.count - 1;
+        while (i <= j) {
+            int idx = indices_[i];
+            float c = ((*mins[bestAxis])[idx] + (*maxs[bestAxis])[idx]) * 0.5f;
+            int b = min(binCount - 1, (int)((c - cMin[bestAxis]) * scale));
+            if (b < bestSplit) {
+                i++;
+            }
+            else {
+                std::swap(indices_[i], indices_[j]);
+                j--;
+            }
+        }
+        mid = i;
+    }
+    if (mid == node.first || mid == node.first + node.count) {
+        // All centroids coincide, split the range in half
+        mid = node.first + node.count / 2;
+    }
+
+    int left = (int)nodes_.size();
+    Node child;
+    child.left = -1;
+
+    child.first = node.first;
+    child.count = mid - node.first;
+    UpdateLeafBounds(child, boxes);
+    nodes_.push_back(child);
+
+    child.first = mid;
+    child.count = node.first + node.count - mid;
+    UpdateLeafBounds(child, boxes);
+    nodes_.push_back(child);
+
+    nodes_[nodeIdx].left = left;
+    Subdivide(left, boxes);
+    Subdivide(left + 1, boxes);
+}
+
+void BVH::Refit(const BoxStreams& boxes) {
+    // Children are always stored after their parent, so a reverse sweep visits them first
+    for (int i = (int)nodes_.size() - 1; i >= 0; i--) {
+        Node& node = nodes_[i];
+        if (node.left < 0) {
+            UpdateLeafBounds(node, boxes);
+        }
+        else {
+            node.bbMin = nodes_[node.left].bbMin;
+            node.bbMax = nodes_[node.left].bbMax;
+            Grow(node.bbMin, node.bbMax, nodes_[(size_t)node.left + 1].bbMin, nodes_[(size_t)node.left + 1].bbMax);
+        }
+    }
+}
+
+int BVH::Cull(Frustum& frustum, const BoxStreams& boxes, int* visibleIndices) {
+    if (nodes_.empty()) {
+        return 0;
+    }
+
+    int visibleCount = 0;
+    // Each stack entry is a node index and the planes its parent straddles
+    stack_.clear();
+    stack_.push_back(0);
+    stack_.push_back((int)Frustum::allPlanes);
+    while (!stack_.empty()) {
+        UINT planeMask = (UINT)stack_.back();
+        stack_.pop_back();
+        int nodeIdx = stack_.back();
+        stack_.pop_back();
+
+        const Node& node = nodes_[nodeIdx];
+        CullResult res = frustum.ClassifyRectangle(node.bbMin, node.bbMax, nodePlanes_[nodeIdx], planeMask);
+        if (res == CullResult::Outside) {
+            continue;
+        }
+        if (res == CullResult::Inside) {
+            for (int i = node.first; i < node.first + node.count; i++) {
+                visibleIndices[visibleCount++] = indices_[i];
+            }
+            continue;
+        }
+
+        if (node.left >= 0) {
+            stack_.push_back(node.left + 1);
+            stack_.push_back((int)planeMask);
+            stack_.push_back(node.left);
+            stack_.push_back((int)planeMask);
+        }
+        else {
+            for (int i = node.first; i < node.first + node.count; i++) {
+                int idx = indices_[i];
+                int lastPlane = -1;
+                UINT boxPlanes = planeMask;
+                XMFLOAT4 bbMin = XMFLOAT4(boxes.minX[idx], boxes.minY[idx], boxes.minZ[idx], 1.0f);
+                XMFLOAT4 bbMax = XMFLOAT4(boxes.maxX[idx], boxes.maxY[idx], boxes.maxZ[idx], 1.0f);
+                if (frustum.ClassifyRectangle(bbMin, bbMax, lastPlane, boxPlanes) != CullResult::Outside) {
+                    visibleIndices[visibleCount++] = idx;
+                }
+            }
+        }
+    }
+
+    return visibleCount;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "MathCommon.h"
+#include "Frustum.h"
+#include <vector>
+
+// Bounding volume hierarchy over instance boxes: binned SAH build, bottom-up refit and hierarchical frustum culling
+class BVH {
+public:
+    BVH() = default;
+
+    void Build(const BoxStreams& boxes, int count);
+    void Refit(const BoxStreams& boxes);
+    // Writes indices of visible boxes, returns their number
+    int Cull(Frustum& frustum, const BoxStreams& boxes, int* visibleIndices);
+    int GetCount() const { return count_; };
+
+    ~BVH() = default;
+private:
+    struct Node {
+        XMFLOAT4 bbMin;
+        XMFLOAT4 bbMax;
+        int first; // range of indices_ covered by the subtree
+        int count;
+        int left;  // right child is left + 1, -1 for leaves
+    };
+
+    static constexpr int maxLeafSize = 4;
+    static constexpr int binCount = 16;
+
+    void Subdivide(int nodeIdx, const BoxStreams& boxes);
+    void UpdateLeafBounds(Node& node, const BoxStreams& boxes);
+
+    std::vector<Node> nodes_;
+    std::vector<int> nodePlanes_;
+    std::vector<int> indices_;
+    std::vector<int> stack_;
+    int count_ = 0;
+};
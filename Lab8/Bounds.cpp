@@ -0,0 +1,90 @@
+#include "Bounds.h"
+
+// Arvo's method: every output coordinate is a sum of independent per-axis terms, so picking the smaller
+// (larger) product on each axis gives the min (max) corner directly. The picked products are summed
+// by XMVector4Transform with a unit vector, i.e. in exactly the order the corner transform uses,
+// which keeps the result bit-identical to transforming all 8 corners.
+void TransformAABB(FXMVECTOR localMin, FXMVECTOR localMax, FXMMATRIX world, XMVECTOR& bbMin, XMVECTOR& bbMax) {
+    XMVECTOR xa = XMVectorMultiply(XMVectorSplatX(localMin), world.r[0]);
+    XMVECTOR xb = XMVectorMultiply(XMVectorSplatX(localMax), world.r[0]);
+    XMVECTOR ya = XMVectorMultiply(XMVectorSplatY(localMin), world.r[1]);
+    XMVECTOR yb = XMVectorMultiply(XMVectorSplatY(localMax), world.r[1]);
+    XMVECTOR za = XMVectorMultiply(XMVectorSplatZ(localMin), world.r[2]);
+    XMVECTOR zb = XMVectorMultiply(XMVectorSplatZ(localMax), world.r[2]);
+
+    XMVECTOR one = XMVectorSplatOne();
+    XMMATRIX minTerms(XMVectorMin(xa, xb), XMVectorMin(ya, yb), XMVectorMin(za, zb), world.r[3]);
+    XMMATRIX maxTerms(XMVectorMax(xa, xb), XMVectorMax(ya, yb), XMVectorMax(za, zb), world.r[3]);
+
+    bbMin = XMVector4Transform(one, minTerms);
+    bbMax = XMVector4Transform(one, maxTerms);
+}
+
+// Four instances at a time: each row of their matrices is transposed so that a register holds one element for all
+// four, and the terms of one output coordinate are summed by XMVector4Transform with a unit vector across them.
+// Every lane then runs the same multiplies, min/max and additions as TransformAABB does for one instance, so the
+// result stays bit-identical.
+static void TransformAABB4(FXMVECTOR localMin, FXMVECTOR localMax, const XMMATRIX* const* ppWorld,
+    XMVECTOR* bbMin, XMVECTOR* bbMax) {
+    XMMATRIX rows[4];
+    for (int r = 0; r < 4; r++) {
+        rows[r] = XMMatrixTranspose(XMMATRIX(ppWorld[0]->r[r], ppWorld[1]->r[r], ppWorld[2]->r[r], ppWorld[3]->r[r]));
+    }
+    XMVECTOR lx = XMVectorSplatX(localMin), ux = XMVectorSplatX(localMax);
+    XMVECTOR ly = XMVectorSplatY(localMin), uy = XMVectorSplatY(localMax);
+    XMVECTOR lz = XMVectorSplatZ(localMin), uz = XMVectorSplatZ(localMax);
+    XMVECTOR one = XMVectorSplatOne();
+    for (int c = 0; c < 3; c++) {
+        XMVECTOR xa = XMVectorMultiply(lx, rows[0].r[c]);
+        XMVECTOR xb = XMVectorMultiply(ux, rows[0].r[c]);
+        XMVECTOR ya = XMVectorMultiply(ly, rows[1].r[c]);
+        XMVECTOR yb = XMVectorMultiply(uy, rows[1].r[c]);
+        XMVECTOR za = XMVectorMultiply(lz, rows[2].r[c]);
+        XMVECTOR zb = XMVectorMultiply(uz, rows[2].r[c]);
+
+        XMMATRIX minTerms(XMVectorMin(xa, xb), XMVectorMin(ya, yb), XMVectorMin(za, zb), rows[3].r[c]);
+        XMMATRIX maxTerms(XMVectorMax(xa, xb), XMVectorMax(ya, yb), XMVectorMax(za, zb), rows[3].r[c]);
+        bbMin[c] = XMVector4Transform(one, minTerms);
+        bbMax[c] = XMVector4Transform(one, maxTerms);
+    }
+    // The w column of an affine matrix is (0, 0, 0, 1), so w of the corners is 1
+    bbMin[3] = one;
+    bbMax[3] = one;
+}
+
+void TransformAABBStream(const XMFLOAT4& localMin, const XMFLOAT4& localMax, const XMMATRIX* pWorld, size_t worldStride,
+    int first, int count, XMFLOAT4* pMin, XMFLOAT4* pMax, BoxStreams& streams) {
+    XMVECTOR lMin = XMLoadFloat4(&localMin);
+    XMVECTOR lMax = XMLoadFloat4(&localMax);
+    const BYTE* pSrc = reinterpret_cast<const BYTE*>(pWorld);
+    auto world = [&](int i) { return reinterpret_cast<const XMMATRIX*>(pSrc + i * worldStride); };
+
+    int i = first;
+    for (; i + 4 <= first + count; i += 4) {
+        const XMMATRIX* ppWorld[4] = { world(i), world(i + 1), world(i + 2), world(i + 3) };
+        XMVECTOR bbMin[4], bbMax[4];
+        TransformAABB4(lMin, lMax, ppWorld, bbMin, bbMax);
+
+        XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(&streams.minX[i]), bbMin[0]);
+        XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(&streams.minY[i]), bbMin[1]);
+        XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(&streams.minZ[i]), bbMin[2]);
+        XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(&streams.maxX[i]), bbMax[0]);
+        XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(&streams.maxY[i]), bbMax[1]);
+        XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(&streams.maxZ[i]), bbMax[2]);
+
+        // Back to one box per register for the AoS arrays
+        XMMATRIX boxMin = XMMatrixTranspose(XMMATRIX(bbMin[0], bbMin[1], bbMin[2], bbMin[3]));
+        XMMATRIX boxMax = XMMatrixTranspose(XMMATRIX(bbMax[0], bbMax[1], bbMax[2], bbMax[3]));
+        for (int k = 0; k < 4; k++) {
+            XMStoreFloat4(&pMin[i + k], boxMin.r[k]);
+            XMStoreFloat4(&pMax[i + k], boxMax.r[k]);
+        }
+    }
+    for (; i < first + count; i++) {
+        XMVECTOR bbMin, bbMax;
+        TransformAABB(lMin, lMax, *world(i), bbMin, bbMax);
+        XMStoreFloat4(&pMin[i], bbMin);
+        XMStoreFloat4(&pMax[i], bbMax);
+        streams.Set(i, pMin[i], pMax[i]);
+    }
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include "MathCommon.h"
+#include "Frustum.h"
+
+// World-space AABB of a local box under an affine matrix, equal to the min/max of its 8 transformed corners
+void TransformAABB(FXMVECTOR localMin, FXMVECTOR localMax, FXMMATRIX world, XMVECTOR& bbMin, XMVECTOR& bbMax);
+
+// Batch version over matrices placed worldStride bytes apart, four instances per step, fills elements
+// [first, first + count) of both AoS arrays and SoA streams (the streams must already be large enough)
+void TransformAABBStream(const XMFLOAT4& localMin, const XMFLOAT4& localMax, const XMMATRIX* pWorld, size_t worldStride,
+    int first, int count, XMFLOAT4* pMin, XMFLOAT4* pMax, BoxStreams& streams);
@@ -1,21 +1,59 @@
 #include "Macros.h"
 #include "LightCalc.h"
 
-struct GeomBuffer {
-    float4x4 worldMatrix;
-    float4x4 norm;
-    float4 shineSpeedTexIdNM;
+struct InstanceData {
+    float4 posScale;
+    uint rotation;
+    uint material;
+    float shine;
+    float padding;
 };
 
-cbuffer GeomBufferInst : register (b0) {
-    GeomBuffer geomBuffer[MAX_CUBE];
-};
+StructuredBuffer<InstanceData> geomBuffer : register (t2);
 
 cbuffer SceneConstantBuffer : register (b1) {
     float4x4 viewProjectionMatrix;
     float4 planes[6];
 };
 
-cbuffer IndexBuffer : register(b2) {
-    uint4 objectIDs[MAX_CUBE];
-};
\ No newline at end of file
+StructuredBuffer<uint> objectIDs : register (t3);
+
+// Position scale and bias of a mesh with quantized vertices
+cbuffer MeshBuffer : register (b3) {
+    float4 positionScale;
+    float4 positionBias;
+};
+
+// x - first element of objectIDs used by the draw, SV_InstanceID does not include the start instance
+cbuffer DrawBuffer : register (b4) {
+    uint4 drawParams;
+};
+
+// Inverse of PackQuaternion in InstanceFormat.cpp
+float4 UnpackQuaternion(uint packed) {
+    uint largest = packed >> 30;
+    float3 c = (float3((packed >> 20) & 0x3FF, (packed >> 10) & 0x3FF, packed & 0x3FF) - 512.0f) * (0.70710678f / 511.0f);
+    float l = sqrt(saturate(1.0f - dot(c, c)));
+    if (largest == 0) {
+        return float4(l, c);
+    }
+    if (largest == 1) {
+        return float4(c.x, l, c.yz);
+    }
+    if (largest == 2) {
+        return float4(c.xy, l, c.z);
+    }
+    return float4(c, l);
+}
+
+float3 RotateVector(float4 q, float3 v) {
+    return v + 2.0f * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+// Inverse of EncodeOctahedral in VertexFormat.cpp
+float3 DecodeOctahedral(float2 e) {
+    float3 n = float3(e, 1.0f - abs(e.x) - abs(e.y));
+    float t = saturate(-n.z);
+    n.xy += n.xy >= 0.0f ? -t : t;
+    return normalize(n);
+}
\ No newline at end of file
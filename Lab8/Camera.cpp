@@ -1,4 +1,5 @@
 #include "Camera.h"
+#include "Macros.h"
 
 Camera::Camera() {
     focus_ = XMFLOAT3(0.0f, 0.0f, 0.0f);
@@ -58,4 +59,8 @@ void Camera::UpdateViewMatrix() {
         DirectX::XMVectorSet(focus_.x, focus_.y, focus_.z, 0.0f),
         DirectX::XMVectorSet(up.x, up.y, up.z, 0.0f)
     );
+}
+
+XMMATRIX Camera::GetProjectionMatrix(float aspectRatio) {
+    return XMMatrixPerspectiveFovLH(XM_PI / 3, aspectRatio, SCREEN_FAR, SCREEN_NEAR);
 }
\ No newline at end of file
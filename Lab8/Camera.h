@@ -1,6 +1,6 @@
 #pragma once
 
-#include "framework.h"
+#include "MathCommon.h"
 
 class Camera {
 public:
@@ -17,6 +17,9 @@ public:
     XMFLOAT3& GetPosition() {
         return position_;
     };
+
+    // Projection of the main view, the depth is reversed: SCREEN_NEAR maps to 1 and SCREEN_FAR to 0
+    static XMMATRIX GetProjectionMatrix(float aspectRatio);
 private:
     XMMATRIX viewMatrix_;
     XMFLOAT3 focus_;
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "GpuTypes.h"
+
+struct CommandCounters {
+    UINT drawCalls;
+    UINT dispatches;
+    UINT stateChanges;
+    UINT copies;
+    UINT64 uploadBytes;
+    UINT mapStalls; // maps that waited for the GPU, only the null context can tell
+    UINT errors;
+};
+
+// Per-frame command interface between Renderer and the graphics API, mirrors the used part of ID3D11DeviceContext
+class CommandContext {
+public:
+    virtual void ClearState() = 0;
+
+    virtual void RSSetViewports(UINT count, const GpuViewport* pViewports) = 0;
+    virtual void RSSetScissorRects(UINT count, const GpuRect* pRects) = 0;
+    virtual void RSSetState(GpuRasterizerState* pState) = 0;
+
+    virtual void OMSetRenderTargets(UINT count, GpuRenderTargetView* const* ppViews, GpuDepthStencilView* pDepthView) = 0;
+    virtual void OMSetDepthStencilState(GpuDepthStencilState* pState, UINT stencilRef) = 0;
+    virtual void OMSetBlendState(GpuBlendState* pState, const float blendFactor[4], UINT sampleMask) = 0;
+    virtual void ClearRenderTargetView(GpuRenderTargetView* pView, const float color[4]) = 0;
+    virtual void ClearDepthStencilView(GpuDepthStencilView* pView, UINT flags, float depth, BYTE stencil) = 0;
+
+    virtual void IASetIndexBuffer(GpuBuffer* pBuffer, GpuFormat format, UINT offset) = 0;
+    virtual void IASetVertexBuffers(UINT slot, UINT count, GpuBuffer* const* ppBuffers, const UINT* pStrides, const UINT* pOffsets) = 0;
+    virtual void IASetInputLayout(GpuInputLayout* pLayout) = 0;
+    virtual void IASetPrimitiveTopology(GpuTopology topology) = 0;
+
+    virtual void VSSetShader(GpuVertexShader* pShader) = 0;
+    virtual void VSSetConstantBuffers(UINT slot, UINT count, GpuBuffer* const* ppBuffers) = 0;
+    virtual void VSSetShaderResources(UINT slot, UINT count, GpuShaderResourceView* const* ppViews) = 0;
+    virtual void PSSetShader(GpuPixelShader* pShader) = 0;
+    virtual void PSSetConstantBuffers(UINT slot, UINT count, GpuBuffer* const* ppBuffers) = 0;
+    virtual void PSSetShaderResources(UINT slot, UINT count, GpuShaderResourceView* const* ppViews) = 0;
+    virtual void PSSetSamplers(UINT slot, UINT count, GpuSamplerState* const* ppSamplers) = 0;
+    virtual void CSSetShader(GpuComputeShader* pShader) = 0;
+    virtual void CSSetConstantBuffers(UINT slot, UINT count, GpuBuffer* const* ppBuffers) = 0;
+    virtual void CSSetShaderResources(UINT slot, UINT count, GpuShaderResourceView* const* ppViews) = 0;
+    virtual void CSSetUnorderedAccessViews(UINT slot, UINT count, GpuUnorderedAccessView* const* ppViews, const UINT* pInitialCounts) = 0;
+
+    virtual void Draw(UINT vertexCount, UINT startVertex) = 0;
+    virtual void DrawIndexed(UINT indexCount, UINT startIndex, INT baseVertex) = 0;
+    virtual void DrawIndexedInstanced(UINT indexCount, UINT instanceCount, UINT startIndex, INT baseVertex, UINT startInstance) = 0;
+    virtual void DrawIndexedInstancedIndirect(GpuBuffer* pArgs, UINT offset) = 0;
+    virtual void Dispatch(UINT x, UINT y, UINT z) = 0;
+
+    virtual void UpdateSubresource(GpuResource* pDst, UINT subresource, const GpuBox* pBox, const void* pData, UINT rowPitch, UINT depthPitch) = 0;
+    virtual HRESULT Map(GpuResource* pResource, UINT subresource, GpuMap type, UINT flags, GpuMappedSubresource* pMapped) = 0;
+    virtual void Unmap(GpuResource* pResource, UINT subresource) = 0;
+    virtual void CopyResource(GpuResource* pDst, GpuResource* pSrc) = 0;
+    virtual void CopySubresourceRegion(GpuResource* pDst, UINT dstSubresource, UINT x, UINT y, UINT z,
+        GpuResource* pSrc, UINT srcSubresource, const GpuBox* pSrcBox) = 0;
+
+    virtual void Begin(GpuQuery* pQuery) = 0;
+    virtual void End(GpuQuery* pQuery) = 0;
+    virtual HRESULT GetData(GpuQuery* pQuery, void* pData, UINT size, UINT flags) = 0;
+
+    const CommandCounters& GetCounters() const { return counters_; };
+    virtual void BeginFrame() { counters_ = {}; };
+
+    virtual ~CommandContext() = default;
+protected:
+    // Size of a buffer resource, 0 for textures
+    static UINT BufferSize(GpuResource* pResource) {
+        return pResource->GetBufferDesc().byteWidth;
+    };
+
+    static bool IsStaging(GpuResource* pResource) {
+        return BufferSize(pResource) > 0 && pResource->GetBufferDesc().usage == GpuUsage::Staging;
+    };
+
+    // Bytes sent from the CPU by an update, a discarding map or a copy out of a staging buffer
+    void CountUpdate(GpuResource* pDst, const GpuBox* pBox) {
+        counters_.uploadBytes += pBox ? pBox->right - pBox->left : BufferSize(pDst);
+    };
+    void CountMap(GpuResource* pResource, GpuMap type) {
+        if (type == GpuMap::WriteDiscard) {
+            counters_.uploadBytes += BufferSize(pResource);
+        }
+    };
+    void CountCopy(GpuResource* pSrc, const GpuBox* pSrcBox) {
+        counters_.copies++;
+        if (IsStaging(pSrc)) {
+            counters_.uploadBytes += pSrcBox ? pSrcBox->right - pSrcBox->left : BufferSize(pSrc);
+        }
+    };
+
+    CommandCounters counters_ = {};
+};
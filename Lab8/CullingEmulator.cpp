@@ -0,0 +1,127 @@
+#include "CullingEmulator.h"
+#include <algorithm>
+#include <atomic>
+
+void CullingEmulator::Dispatch(UINT groupCountX, const XMINT4& numShapes, const XMFLOAT4* planes, const XMFLOAT4* boundsMin,
+    const XMFLOAT4* boundsMax, UINT* indirectArgs, UINT* objectsIds, UINT* groupIds, XMUINT2* groupRanges) {
+    // main
+    std::atomic<UINT> counter(indirectArgs[1]);
+    pJobSystem_->ParallelFor((int)groupCountX, 1, [&](int begin, int end, int worker) {
+        UINT scanBuffer[groupSize];
+        for (UINT group = (UINT)begin; group < (UINT)end; group++) {
+            for (UINT thread = 0; thread < groupSize; thread++) {
+                UINT globalThreadId = group * groupSize + thread;
+                scanBuffer[thread] = 0;
+                if (globalThreadId < (UINT)numShapes.x) {
+                    XMFLOAT3 bbMin(boundsMin[globalThreadId].x, boundsMin[globalThreadId].y, boundsMin[globalThreadId].z);
+                    XMFLOAT3 bbMax(boundsMax[globalThreadId].x, boundsMax[globalThreadId].y, boundsMax[globalThreadId].z);
+                    scanBuffer[thread] = IsBoxInside(planes, bbMin, bbMax) ? 1 : 0;
+                }
+            }
+            ScanGroup(scanBuffer, groupSize);
+            for (UINT thread = 0; thread < groupSize; thread++) {
+                UINT previous = thread > 0 ? scanBuffer[thread - 1] : 0;
+                if (scanBuffer[thread] != previous) {
+                    groupIds[group * groupSize + scanBuffer[thread] - 1] = group * groupSize + thread;
+                }
+            }
+            groupRanges[group] = XMUINT2(scanBuffer[groupSize - 1], 0);
+            counter.fetch_add(scanBuffer[groupSize - 1]);
+        }
+    });
+    indirectArgs[1] = counter.load();
+
+    // ScanGroups, a single group
+    UINT groupCount = ((UINT)numShapes.x + groupSize - 1) / groupSize;
+    UINT base = 0;
+    for (UINT first = 0; first < groupCount; first += scanSize) {
+        UINT scanBuffer[scanSize];
+        for (UINT thread = 0; thread < scanSize; thread++) {
+            scanBuffer[thread] = first + thread < groupCount ? groupRanges[first + thread].x : 0;
+        }
+        ScanGroup(scanBuffer, scanSize);
+        for (UINT thread = 0; thread < scanSize && first + thread < groupCount; thread++) {
+            UINT count = groupRanges[first + thread].x;
+            groupRanges[first + thread] = XMUINT2(count, base + scanBuffer[thread] - count);
+        }
+        base += scanBuffer[scanSize - 1];
+    }
+
+    // Compact
+    pJobSystem_->ParallelFor((int)groupCountX, 1, [&](int begin, int end, int worker) {
+        for (UINT group = (UINT)begin; group < (UINT)end; group++) {
+            XMUINT2 range = groupRanges[group];
+            for (UINT thread = 0; thread < range.x; thread++) {
+                objectsIds[range.y + thread] = groupIds[group * groupSize + thread];
+            }
+        }
+    });
+}
+
+bool CullingEmulator::IsBoxInside(const XMFLOAT4* planes, const XMFLOAT3& bbMin, const XMFLOAT3& bbMax) {
+    for (int i = 0; i < 6; i++) {
+        float dotProduct = ((planes[i].x * bbMin.x) + (planes[i].y * bbMin.y) + (planes[i].z * bbMin.z) + (planes[i].w * 1.0f));
+        if (dotProduct >= 0.0f) {
+            continue;
+        }
+
+        dotProduct = ((planes[i].x * bbMax.x) + (planes[i].y * bbMin.y) + (planes[i].z * bbMin.z) + (planes[i].w * 1.0f));
+        if (dotProduct >= 0.0f) {
+            continue;
+        }
+
+        dotProduct = ((planes[i].x * bbMin.x) + (planes[i].y * bbMax.y) + (planes[i].z * bbMin.z) + (planes[i].w * 1.0f));
+        if (dotProduct >= 0.0f) {
+            continue;
+        }
+
+        dotProduct = ((planes[i].x * bbMax.x) + (planes[i].y * bbMax.y) + (planes[i].z * bbMin.z) + (planes[i].w * 1.0f));
+        if (dotProduct >= 0.0f) {
+            continue;
+        }
+
+        dotProduct = ((planes[i].x * bbMin.x) + (planes[i].y * bbMin.y) + (planes[i].z * bbMax.z) + (planes[i].w * 1.0f));
+        if (dotProduct >= 0.0f) {
+            continue;
+        }
+
+        dotProduct = ((planes[i].x * bbMax.x) + (planes[i].y * bbMin.y) + (planes[i].z * bbMax.z) + (planes[i].w * 1.0f));
+        if (dotProduct >= 0.0f) {
+            continue;
+        }
+
+        dotProduct = ((planes[i].x * bbMin.x) + (planes[i].y * bbMax.y) + (planes[i].z * bbMax.z) + (planes[i].w * 1.0f));
+        if (dotProduct >= 0.0f) {
+            continue;
+        }
+
+        dotProduct = ((planes[i].x * bbMax.x) + (planes[i].y * bbMax.y) + (planes[i].z * bbMax.z) + (planes[i].w * 1.0f));
+        if (dotProduct >= 0.0f) {
+            continue;
+        }
+
+        return false;
+    }
+
+    return true;
+}
+
+void CullingEmulator::ScanGroup(UINT* buffer, UINT size) {
+    UINT previous[scanSize];
+    for (UINT offset = 1; offset < size; offset <<= 1) {
+        std::copy(buffer, buffer + size, previous);
+        for (UINT index = offset; index < size; index++) {
+            buffer[index] += previous[index - offset];
+        }
+    }
+}
+
+UINT CullingEmulator::ExclusiveScan(const UINT* src, UINT* dst, UINT count) {
+    UINT sum = 0;
+    for (UINT i = 0; i < count; i++) {
+        UINT value = src[i];
+        dst[i] = sum;
+        sum += value;
+    }
+    return sum;
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "MathCommon.h"
+#include "Macros.h"
+#include "JobSystem.h"
+
+// CPU emulation of the three FCS.hlsl passes. Thread groups run on the job system in any order, threads of
+// a group in lockstep between barriers, and the per group InterlockedAdd on indirectArgs[1] is an atomic add
+class CullingEmulator {
+public:
+    static constexpr UINT groupSize = CULLING_GROUP_SIZE;
+    static constexpr UINT scanSize = CULLING_SCAN_SIZE;
+
+    CullingEmulator(JobSystem* pJobSystem) : pJobSystem_(pJobSystem) {};
+
+    // Arguments mirror the resources bound in Renderer::UpdateScene: b0 numShapes, b1 planes, t0/t1 bounds,
+    // u0 indirectArgs (5 uints), u1 objectsIds, u2 groupIds (groupSize per group), u3 groupRanges (one per group)
+    void Dispatch(UINT groupCountX, const XMINT4& numShapes, const XMFLOAT4* planes, const XMFLOAT4* boundsMin,
+        const XMFLOAT4* boundsMax, UINT* indirectArgs, UINT* objectsIds, UINT* groupIds, XMUINT2* groupRanges);
+    // Line by line copy of IsBoxInside from FCS.hlsl
+    static bool IsBoxInside(const XMFLOAT4* planes, const XMFLOAT3& bbMin, const XMFLOAT3& bbMax);
+    // ScanBuffer from FCS.hlsl: inclusive Hillis-Steele scan, every step reads before it writes as the barriers ensure
+    static void ScanGroup(UINT* buffer, UINT size);
+    // Sequential reference for the scans, returns the total
+    static UINT ExclusiveScan(const UINT* src, UINT* dst, UINT count);
+
+    ~CullingEmulator() = default;
+private:
+    JobSystem* pJobSystem_;
+};
@@ -0,0 +1,235 @@
+#include "D3D11CommandContext.h"
+
+static_assert(sizeof(GpuViewport) == sizeof(D3D11_VIEWPORT) && sizeof(GpuBox) == sizeof(D3D11_BOX),
+    "Viewports and boxes are passed through as they are");
+static_assert(GpuMapFlag::DoNotWait == D3D11_MAP_FLAG_DO_NOT_WAIT && GPU_E_WAS_STILL_DRAWING == DXGI_ERROR_WAS_STILL_DRAWING,
+    "Map flags and results are passed through as they are");
+
+namespace {
+    template <typename T>
+    T* Native(const GpuObject* pObject) {
+        return pObject ? static_cast<T*>(pObject->GetNative()) : nullptr;
+    }
+
+    // Native objects of a handle array, count is within the slot count of the stage
+    template <typename T, typename H>
+    void Natives(UINT count, H* const* ppObjects, T** ppNatives) {
+        for (UINT i = 0; i < count; i++) {
+            ppNatives[i] = Native<T>(ppObjects[i]);
+        }
+    }
+}
+
+D3D11CommandContext::D3D11CommandContext(ID3D11DeviceContext* pContext) :
+    pContext_(pContext) {
+}
+
+void D3D11CommandContext::ClearState() {
+    counters_.stateChanges++;
+    pContext_->ClearState();
+}
+
+void D3D11CommandContext::RSSetViewports(UINT count, const GpuViewport* pViewports) {
+    counters_.stateChanges++;
+    pContext_->RSSetViewports(count, reinterpret_cast<const D3D11_VIEWPORT*>(pViewports));
+}
+
+void D3D11CommandContext::RSSetScissorRects(UINT count, const GpuRect* pRects) {
+    counters_.stateChanges++;
+    D3D11_RECT rects[D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE];
+    for (UINT i = 0; i < count; i++) {
+        rects[i] = { pRects[i].left, pRects[i].top, pRects[i].right, pRects[i].bottom };
+    }
+    pContext_->RSSetScissorRects(count, rects);
+}
+
+void D3D11CommandContext::RSSetState(GpuRasterizerState* pState) {
+    counters_.stateChanges++;
+    pContext_->RSSetState(Native<ID3D11RasterizerState>(pState));
+}
+
+void D3D11CommandContext::OMSetRenderTargets(UINT count, GpuRenderTargetView* const* ppViews, GpuDepthStencilView* pDepthView) {
+    counters_.stateChanges++;
+    ID3D11RenderTargetView* views[D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT];
+    Natives(count, ppViews, views);
+    pContext_->OMSetRenderTargets(count, views, Native<ID3D11DepthStencilView>(pDepthView));
+}
+
+void D3D11CommandContext::OMSetDepthStencilState(GpuDepthStencilState* pState, UINT stencilRef) {
+    counters_.stateChanges++;
+    pContext_->OMSetDepthStencilState(Native<ID3D11DepthStencilState>(pState), stencilRef);
+}
+
+void D3D11CommandContext::OMSetBlendState(GpuBlendState* pState, const float blendFactor[4], UINT sampleMask) {
+    counters_.stateChanges++;
+    pContext_->OMSetBlendState(Native<ID3D11BlendState>(pState), blendFactor, sampleMask);
+}
+
+void D3D11CommandContext::ClearRenderTargetView(GpuRenderTargetView* pView, const float color[4]) {
+    pContext_->ClearRenderTargetView(Native<ID3D11RenderTargetView>(pView), color);
+}
+
+void D3D11CommandContext::ClearDepthStencilView(GpuDepthStencilView* pView, UINT flags, float depth, BYTE stencil) {
+    pContext_->ClearDepthStencilView(Native<ID3D11DepthStencilView>(pView), flags, depth, stencil);
+}
+
+void D3D11CommandContext::IASetIndexBuffer(GpuBuffer* pBuffer, GpuFormat format, UINT offset) {
+    counters_.stateChanges++;
+    pContext_->IASetIndexBuffer(Native<ID3D11Buffer>(pBuffer), (DXGI_FORMAT)format, offset);
+}
+
+void D3D11CommandContext::IASetVertexBuffers(UINT slot, UINT count, GpuBuffer* const* ppBuffers, const UINT* pStrides, const UINT* pOffsets) {
+    counters_.stateChanges++;
+    ID3D11Buffer* buffers[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+    Natives(count, ppBuffers, buffers);
+    pContext_->IASetVertexBuffers(slot, count, buffers, pStrides, pOffsets);
+}
+
+void D3D11CommandContext::IASetInputLayout(GpuInputLayout* pLayout) {
+    counters_.stateChanges++;
+    pContext_->IASetInputLayout(Native<ID3D11InputLayout>(pLayout));
+}
+
+void D3D11CommandContext::IASetPrimitiveTopology(GpuTopology topology) {
+    counters_.stateChanges++;
+    pContext_->IASetPrimitiveTopology((D3D11_PRIMITIVE_TOPOLOGY)topology);
+}
+
+void D3D11CommandContext::VSSetShader(GpuVertexShader* pShader) {
+    counters_.stateChanges++;
+    pContext_->VSSetShader(Native<ID3D11VertexShader>(pShader), nullptr, 0);
+}
+
+void D3D11CommandContext::VSSetConstantBuffers(UINT slot, UINT count, GpuBuffer* const* ppBuffers) {
+    counters_.stateChanges++;
+    ID3D11Buffer* buffers[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
+    Natives(count, ppBuffers, buffers);
+    pContext_->VSSetConstantBuffers(slot, count, buffers);
+}
+
+void D3D11CommandContext::VSSetShaderResources(UINT slot, UINT count, GpuShaderResourceView* const* ppViews) {
+    counters_.stateChanges++;
+    ID3D11ShaderResourceView* views[D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT];
+    Natives(count, ppViews, views);
+    pContext_->VSSetShaderResources(slot, count, views);
+}
+
+void D3D11CommandContext::PSSetShader(GpuPixelShader* pShader) {
+    counters_.stateChanges++;
+    pContext_->PSSetShader(Native<ID3D11PixelShader>(pShader), nullptr, 0);
+}
+
+void D3D11CommandContext::PSSetConstantBuffers(UINT slot, UINT count, GpuBuffer* const* ppBuffers) {
+    counters_.stateChanges++;
+    ID3D11Buffer* buffers[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
+    Natives(count, ppBuffers, buffers);
+    pContext_->PSSetConstantBuffers(slot, count, buffers);
+}
+
+void D3D11CommandContext::PSSetShaderResources(UINT slot, UINT count, GpuShaderResourceView* const* ppViews) {
+    counters_.stateChanges++;
+    ID3D11ShaderResourceView* views[D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT];
+    Natives(count, ppViews, views);
+    pContext_->PSSetShaderResources(slot, count, views);
+}
+
+void D3D11CommandContext::PSSetSamplers(UINT slot, UINT count, GpuSamplerState* const* ppSamplers) {
+    counters_.stateChanges++;
+    ID3D11SamplerState* samplers[D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT];
+    Natives(count, ppSamplers, samplers);
+    pContext_->PSSetSamplers(slot, count, samplers);
+}
+
+void D3D11CommandContext::CSSetShader(GpuComputeShader* pShader) {
+    counters_.stateChanges++;
+    pContext_->CSSetShader(Native<ID3D11ComputeShader>(pShader), nullptr, 0);
+}
+
+void D3D11CommandContext::CSSetConstantBuffers(UINT slot, UINT count, GpuBuffer* const* ppBuffers) {
+    counters_.stateChanges++;
+    ID3D11Buffer* buffers[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
+    Natives(count, ppBuffers, buffers);
+    pContext_->CSSetConstantBuffers(slot, count, buffers);
+}
+
+void D3D11CommandContext::CSSetShaderResources(UINT slot, UINT count, GpuShaderResourceView* const* ppViews) {
+    counters_.stateChanges++;
+    ID3D11ShaderResourceView* views[D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT];
+    Natives(count, ppViews, views);
+    pContext_->CSSetShaderResources(slot, count, views);
+}
+
+void D3D11CommandContext::CSSetUnorderedAccessViews(UINT slot, UINT count, GpuUnorderedAccessView* const* ppViews, const UINT* pInitialCounts) {
+    counters_.stateChanges++;
+    ID3D11UnorderedAccessView* views[D3D11_PS_CS_UAV_REGISTER_COUNT];
+    Natives(count, ppViews, views);
+    pContext_->CSSetUnorderedAccessViews(slot, count, views, pInitialCounts);
+}
+
+void D3D11CommandContext::Draw(UINT vertexCount, UINT startVertex) {
+    counters_.drawCalls++;
+    pContext_->Draw(vertexCount, startVertex);
+}
+
+void D3D11CommandContext::DrawIndexed(UINT indexCount, UINT startIndex, INT baseVertex) {
+    counters_.drawCalls++;
+    pContext_->DrawIndexed(indexCount, startIndex, baseVertex);
+}
+
+void D3D11CommandContext::DrawIndexedInstanced(UINT indexCount, UINT instanceCount, UINT startIndex, INT baseVertex, UINT startInstance) {
+    counters_.drawCalls++;
+    pContext_->DrawIndexedInstanced(indexCount, instanceCount, startIndex, baseVertex, startInstance);
+}
+
+void D3D11CommandContext::DrawIndexedInstancedIndirect(GpuBuffer* pArgs, UINT offset) {
+    counters_.drawCalls++;
+    pContext_->DrawIndexedInstancedIndirect(Native<ID3D11Buffer>(pArgs), offset);
+}
+
+void D3D11CommandContext::Dispatch(UINT x, UINT y, UINT z) {
+    counters_.dispatches++;
+    pContext_->Dispatch(x, y, z);
+}
+
+void D3D11CommandContext::UpdateSubresource(GpuResource* pDst, UINT subresource, const GpuBox* pBox, const void* pData, UINT rowPitch, UINT depthPitch) {
+    CountUpdate(pDst, pBox);
+    pContext_->UpdateSubresource(Native<ID3D11Resource>(pDst), subresource, reinterpret_cast<const D3D11_BOX*>(pBox), pData, rowPitch, depthPitch);
+}
+
+HRESULT D3D11CommandContext::Map(GpuResource* pResource, UINT subresource, GpuMap type, UINT flags, GpuMappedSubresource* pMapped) {
+    CountMap(pResource, type);
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    HRESULT result = pContext_->Map(Native<ID3D11Resource>(pResource), subresource, (D3D11_MAP)type, flags, &mapped);
+    if (SUCCEEDED(result)) {
+        *pMapped = { mapped.pData, mapped.RowPitch, mapped.DepthPitch };
+    }
+    return result;
+}
+
+void D3D11CommandContext::Unmap(GpuResource* pResource, UINT subresource) {
+    pContext_->Unmap(Native<ID3D11Resource>(pResource), subresource);
+}
+
+void D3D11CommandContext::CopyResource(GpuResource* pDst, GpuResource* pSrc) {
+    CountCopy(pSrc, nullptr);
+    pContext_->CopyResource(Native<ID3D11Resource>(pDst), Native<ID3D11Resource>(pSrc));
+}
+
+void D3D11CommandContext::CopySubresourceRegion(GpuResource* pDst, UINT dstSubresource, UINT x, UINT y, UINT z,
+    GpuResource* pSrc, UINT srcSubresource, const GpuBox* pSrcBox) {
+    CountCopy(pSrc, pSrcBox);
+    pContext_->CopySubresourceRegion(Native<ID3D11Resource>(pDst), dstSubresource, x, y, z, Native<ID3D11Resource>(pSrc), srcSubresource,
+        reinterpret_cast<const D3D11_BOX*>(pSrcBox));
+}
+
+void D3D11CommandContext::Begin(GpuQuery* pQuery) {
+    pContext_->Begin(Native<ID3D11Query>(pQuery));
+}
+
+void D3D11CommandContext::End(GpuQuery* pQuery) {
+    pContext_->End(Native<ID3D11Query>(pQuery));
+}
+
+HRESULT D3D11CommandContext::GetData(GpuQuery* pQuery, void* pData, UINT size, UINT flags) {
+    return pContext_->GetData(Native<ID3D11Query>(pQuery), pData, size, flags);
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "CommandContext.h"
+#include "framework.h"
+
+// Forwards every command to an immediate ID3D11DeviceContext and counts it
+class D3D11CommandContext : public CommandContext {
+public:
+    D3D11CommandContext(ID3D11DeviceContext* pContext);
+
+    void ClearState() override;
+
+    void RSSetViewports(UINT count, const GpuViewport* pViewports) override;
+    void RSSetScissorRects(UINT count, const GpuRect* pRects) override;
+    void RSSetState(GpuRasterizerState* pState) override;
+
+    void OMSetRenderTargets(UINT count, GpuRenderTargetView* const* ppViews, GpuDepthStencilView* pDepthView) override;
+    void OMSetDepthStencilState(GpuDepthStencilState* pState, UINT stencilRef) override;
+    void OMSetBlendState(GpuBlendState* pState, const float blendFactor[4], UINT sampleMask) override;
+    void ClearRenderTargetView(GpuRenderTargetView* pView, const float color[4]) override;
+    void ClearDepthStencilView(GpuDepthStencilView* pView, UINT flags, float depth, BYTE stencil) override;
+
+    void IASetIndexBuffer(GpuBuffer* pBuffer, GpuFormat format, UINT offset) override;
+    void IASetVertexBuffers(UINT slot, UINT count, GpuBuffer* const* ppBuffers, const UINT* pStrides, const UINT* pOffsets) override;
+    void IASetInputLayout(GpuInputLayout* pLayout) override;
+    void IASetPrimitiveTopology(GpuTopology topology) override;
+
+    void VSSetShader(GpuVertexShader* pShader) override;
+    void VSSetConstantBuffers(UINT slot, UINT count, GpuBuffer* const* ppBuffers) override;
+    void VSSetShaderResources(UINT slot, UINT count, GpuShaderResourceView* const* ppViews) override;
+    void PSSetShader(GpuPixelShader* pShader) override;
+    void PSSetConstantBuffers(UINT slot, UINT count, GpuBuffer* const* ppBuffers) override;
+    void PSSetShaderResources(UINT slot, UINT count, GpuShaderResourceView* const* ppViews) override;
+    void PSSetSamplers(UINT slot, UINT count, GpuSamplerState* const* ppSamplers) override;
+    void CSSetShader(GpuComputeShader* pShader) override;
+    void CSSetConstantBuffers(UINT slot, UINT count, GpuBuffer* const* ppBuffers) override;
+    void CSSetShaderResources(UINT slot, UINT count, GpuShaderResourceView* const* ppViews) override;
+    void CSSetUnorderedAccessViews(UINT slot, UINT count, GpuUnorderedAccessView* const* ppViews, const UINT* pInitialCounts) override;
+
+    void Draw(UINT vertexCount, UINT startVertex) override;
+    void DrawIndexed(UINT indexCount, UINT startIndex, INT baseVertex) override;
+    void DrawIndexedInstanced(UINT indexCount, UINT instanceCount, UINT startIndex, INT baseVertex, UINT startInstance) override;
+    void DrawIndexedInstancedIndirect(GpuBuffer* pArgs, UINT offset) override;
+    void Dispatch(UINT x, UINT y, UINT z) override;
+
+    void UpdateSubresource(GpuResource* pDst, UINT subresource, const GpuBox* pBox, const void* pData, UINT rowPitch, UINT depthPitch) override;
+    HRESULT Map(GpuResource* pResource, UINT subresource, GpuMap type, UINT flags, GpuMappedSubresource* pMapped) override;
+    void Unmap(GpuResource* pResource, UINT subresource) override;
+    void CopyResource(GpuResource* pDst, GpuResource* pSrc) override;
+    void CopySubresourceRegion(GpuResource* pDst, UINT dstSubresource, UINT x, UINT y, UINT z,
+        GpuResource* pSrc, UINT srcSubresource, const GpuBox* pSrcBox) override;
+
+    void Begin(GpuQuery* pQuery) override;
+    void End(GpuQuery* pQuery) override;
+    HRESULT GetData(GpuQuery* pQuery, void* pData, UINT size, UINT flags) override;
+
+    ~D3D11CommandContext() = default;
+private:
+    ID3D11DeviceContext* pContext_;
+};
\ No newline at end of file
@@ -0,0 +1,506 @@
+#include "D3D11RenderDevice.h"
+#include "D3DInclude.h"
+#include <string>
+#include <vector>
+
+#define SAFE_RELEASE(A) if ((A) != NULL) { (A)->Release(); (A) = NULL; }
+
+static_assert(sizeof(GpuBufferDesc) == sizeof(D3D11_BUFFER_DESC) && sizeof(GpuTextureDesc) == sizeof(D3D11_TEXTURE2D_DESC) &&
+    sizeof(GpuSubresourceData) == sizeof(D3D11_SUBRESOURCE_DATA) && sizeof(GpuPipelineStatistics) == sizeof(D3D11_QUERY_DATA_PIPELINE_STATISTICS),
+    "Descriptions are passed through as they are");
+
+namespace {
+    // A handle holding a reference to its D3D11 object
+    template <typename Base>
+    class D3D11Object : public Base {
+    public:
+        template <typename... Args>
+        D3D11Object(IUnknown* pObject, const Args&... args) : Base(args...) {
+            this->pNative_ = pObject;
+        };
+
+        ~D3D11Object() {
+            static_cast<IUnknown*>(this->pNative_)->Release();
+        };
+    };
+
+    // Input layouts are validated against the bytecode of a vertex shader
+    class D3D11VertexShader : public D3D11Object<GpuVertexShader> {
+    public:
+        D3D11VertexShader(ID3D11VertexShader* pShader, ID3DBlob* pBytecode) :
+            D3D11Object(pShader),
+            pBytecode_(pBytecode) {
+        };
+
+        ID3DBlob* GetBytecode() const { return pBytecode_; };
+
+        ~D3D11VertexShader() {
+            pBytecode_->Release();
+        };
+    private:
+        ID3DBlob* pBytecode_;
+    };
+
+    template <typename T>
+    T* Native(const GpuObject* pObject) {
+        return pObject ? static_cast<T*>(pObject->GetNative()) : nullptr;
+    }
+
+    // DDSTextureLoader takes wide paths, the texture paths are ASCII
+    std::wstring WidePath(const char* path) {
+        return std::wstring(path, path + strlen(path));
+    }
+}
+
+D3D11RenderDevice::D3D11RenderDevice() :
+    hWnd_(NULL),
+    pDevice_(NULL),
+    pDeviceContext_(NULL),
+    pSwapChain_(NULL),
+    pBackBuffer_(NULL),
+    pContext_(NULL),
+    withUI_(false) {}
+
+HRESULT D3D11RenderDevice::Init(HWND hWnd, UINT width, UINT height) {
+    hWnd_ = hWnd;
+
+    // Create a DirectX graphics interface factory.
+    IDXGIFactory* pFactory = nullptr;
+    HRESULT result = CreateDXGIFactory(__uuidof(IDXGIFactory), (void**)&pFactory);
+    // Select hardware adapter
+    IDXGIAdapter* pSelectedAdapter = NULL;
+    if (SUCCEEDED(result)) {
+        IDXGIAdapter* pAdapter = NULL;
+        UINT adapterIdx = 0;
+        while (SUCCEEDED(pFactory->EnumAdapters(adapterIdx, &pAdapter))) {
+            DXGI_ADAPTER_DESC desc;
+            pAdapter->GetDesc(&desc);
+            if (wcscmp(desc.Description, L"Microsoft Basic Render Driver")) {
+                pSelectedAdapter = pAdapter;
+                break;
+            }
+            pAdapter->Release();
+            adapterIdx++;
+        }
+    }
+    if (pSelectedAdapter == NULL) {
+        SAFE_RELEASE(pFactory);
+        return E_FAIL;
+    }
+
+    // Create DirectX11 pDevice_
+    D3D_FEATURE_LEVEL level;
+    D3D_FEATURE_LEVEL levels[] = { D3D_FEATURE_LEVEL_11_0 };
+    UINT flags = 0;
+#ifdef _DEBUG
+    flags |= D3D11_CREATE_DEVICE_DEBUG;
+#endif // _DEBUG
+    result = D3D11CreateDevice(
+        pSelectedAdapter,
+        D3D_DRIVER_TYPE_UNKNOWN,
+        NULL,
+        flags,
+        levels,
+        1,
+        D3D11_SDK_VERSION,
+        &pDevice_,
+        &level,
+        &pDeviceContext_
+    );
+    if (D3D_FEATURE_LEVEL_11_0 != level || !SUCCEEDED(result)) {
+        SAFE_RELEASE(pFactory);
+        SAFE_RELEASE(pSelectedAdapter);
+        return FAILED(result) ? result : E_FAIL;
+    }
+
+    // Create swap chain
+    DXGI_SWAP_CHAIN_DESC swapChainDesc = { 0 };
+    swapChainDesc.BufferCount = 2;
+    swapChainDesc.BufferDesc.Width = width;
+    swapChainDesc.BufferDesc.Height = height;
+    swapChainDesc.BufferDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    swapChainDesc.BufferDesc.RefreshRate.Numerator = 0;
+    swapChainDesc.BufferDesc.RefreshRate.Denominator = 1;
+    swapChainDesc.BufferDesc.ScanlineOrdering = DXGI_MODE_SCANLINE_ORDER_UNSPECIFIED;
+    swapChainDesc.BufferDesc.Scaling = DXGI_MODE_SCALING_UNSPECIFIED;
+    swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
+    swapChainDesc.OutputWindow = hWnd;
+    swapChainDesc.SampleDesc.Count = 1;
+    swapChainDesc.SampleDesc.Quality = 0;
+    swapChainDesc.Windowed = true;
+    swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
+    swapChainDesc.Flags = 0;
+    result = pFactory->CreateSwapChain(pDevice_, &swapChainDesc, &pSwapChain_);
+
+    SAFE_RELEASE(pFactory);
+    SAFE_RELEASE(pSelectedAdapter);
+    if (SUCCEEDED(result)) {
+        result = CreateBackBuffer();
+    }
+    if (SUCCEEDED(result)) {
+        pContext_ = new D3D11CommandContext(pDeviceContext_);
+        if (!pContext_) {
+            result = E_OUTOFMEMORY;
+        }
+    }
+    return result;
+}
+
+HRESULT D3D11RenderDevice::CreateBackBuffer() {
+    ID3D11Texture2D* pBuffer = NULL;
+    HRESULT result = pSwapChain_->GetBuffer(0, __uuidof(ID3D11Texture2D), (LPVOID*)&pBuffer);
+    ID3D11RenderTargetView* pView = NULL;
+    if (SUCCEEDED(result)) {
+        result = pDevice_->CreateRenderTargetView(pBuffer, NULL, &pView);
+    }
+    SAFE_RELEASE(pBuffer);
+    if (SUCCEEDED(result)) {
+        pBackBuffer_ = new D3D11Object<GpuRenderTargetView>(pView);
+    }
+    return result;
+}
+
+HRESULT D3D11RenderDevice::CreateBuffer(const GpuBufferDesc& desc, const GpuSubresourceData* pData, GpuBuffer** ppBuffer) {
+    ID3D11Buffer* pBuffer = NULL;
+    HRESULT result = pDevice_->CreateBuffer(reinterpret_cast<const D3D11_BUFFER_DESC*>(&desc),
+        reinterpret_cast<const D3D11_SUBRESOURCE_DATA*>(pData), &pBuffer);
+    if (SUCCEEDED(result)) {
+        *ppBuffer = new D3D11Object<GpuBuffer>(pBuffer, desc);
+    }
+    return result;
+}
+
+HRESULT D3D11RenderDevice::CreateTexture2D(const GpuTextureDesc& desc, const GpuSubresourceData* pData, GpuTexture** ppTexture) {
+    ID3D11Texture2D* pTexture = NULL;
+    HRESULT result = pDevice_->CreateTexture2D(reinterpret_cast<const D3D11_TEXTURE2D_DESC*>(&desc),
+        reinterpret_cast<const D3D11_SUBRESOURCE_DATA*>(pData), &pTexture);
+    if (SUCCEEDED(result)) {
+        *ppTexture = new D3D11Object<GpuTexture>(pTexture, desc);
+    }
+    return result;
+}
+
+HRESULT D3D11RenderDevice::CreateShaderResourceView(GpuResource* pResource, GpuShaderResourceView** ppView) {
+    ID3D11ShaderResourceView* pView = NULL;
+    HRESULT result = pDevice_->CreateShaderResourceView(Native<ID3D11Resource>(pResource), NULL, &pView);
+    if (SUCCEEDED(result)) {
+        *ppView = new D3D11Object<GpuShaderResourceView>(pView);
+    }
+    return result;
+}
+
+HRESULT D3D11RenderDevice::CreateUnorderedAccessView(GpuResource* pResource, GpuUnorderedAccessView** ppView) {
+    ID3D11UnorderedAccessView* pView = NULL;
+    HRESULT result = pDevice_->CreateUnorderedAccessView(Native<ID3D11Resource>(pResource), NULL, &pView);
+    if (SUCCEEDED(result)) {
+        *ppView = new D3D11Object<GpuUnorderedAccessView>(pView);
+    }
+    return result;
+}
+
+HRESULT D3D11RenderDevice::CreateRenderTargetView(GpuTexture* pTexture, GpuRenderTargetView** ppView) {
+    ID3D11RenderTargetView* pView = NULL;
+    HRESULT result = pDevice_->CreateRenderTargetView(Native<ID3D11Resource>(pTexture), NULL, &pView);
+    if (SUCCEEDED(result)) {
+        *ppView = new D3D11Object<GpuRenderTargetView>(pView);
+    }
+    return result;
+}
+
+HRESULT D3D11RenderDevice::CreateDepthStencilView(GpuTexture* pTexture, GpuDepthStencilView** ppView) {
+    ID3D11DepthStencilView* pView = NULL;
+    HRESULT result = pDevice_->CreateDepthStencilView(Native<ID3D11Resource>(pTexture), NULL, &pView);
+    if (SUCCEEDED(result)) {
+        *ppView = new D3D11Object<GpuDepthStencilView>(pView);
+    }
+    return result;
+}
+
+HRESULT D3D11RenderDevice::Compile(const GpuShaderDesc& desc, const char* target, ID3DBlob** ppBytecode) {
+    int flags = 0;
+#ifdef _DEBUG
+    flags = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
+#endif
+    D3DInclude includeObj;
+    return D3DCompileFromFile(WidePath(desc.file).c_str(), reinterpret_cast<const D3D_SHADER_MACRO*>(desc.macros), &includeObj,
+        desc.entryPoint, target, flags, 0, ppBytecode, NULL);
+}
+
+HRESULT D3D11RenderDevice::CreateVertexShader(const GpuShaderDesc& desc, GpuVertexShader** ppShader) {
+    ID3DBlob* pBytecode = NULL;
+    HRESULT result = Compile(desc, "vs_5_0", &pBytecode);
+    ID3D11VertexShader* pShader = NULL;
+    if (SUCCEEDED(result)) {
+        result = pDevice_->CreateVertexShader(pBytecode->GetBufferPointer(), pBytecode->GetBufferSize(), NULL, &pShader);
+    }
+    if (SUCCEEDED(result)) {
+        *ppShader = new D3D11VertexShader(pShader, pBytecode);
+    }
+    else {
+        SAFE_RELEASE(pBytecode);
+    }
+    return result;
+}
+
+HRESULT D3D11RenderDevice::CreatePixelShader(const GpuShaderDesc& desc, GpuPixelShader** ppShader) {
+    ID3DBlob* pBytecode = NULL;
+    HRESULT result = Compile(desc, "ps_5_0", &pBytecode);
+    ID3D11PixelShader* pShader = NULL;
+    if (SUCCEEDED(result)) {
+        result = pDevice_->CreatePixelShader(pBytecode->GetBufferPointer(), pBytecode->GetBufferSize(), NULL, &pShader);
+    }
+    SAFE_RELEASE(pBytecode);
+    if (SUCCEEDED(result)) {
+        *ppShader = new D3D11Object<GpuPixelShader>(pShader);
+    }
+    return result;
+}
+
+HRESULT D3D11RenderDevice::CreateComputeShader(const GpuShaderDesc& desc, GpuComputeShader** ppShader) {
+    ID3DBlob* pBytecode = NULL;
+    HRESULT result = Compile(desc, "cs_5_0", &pBytecode);
+    ID3D11ComputeShader* pShader = NULL;
+    if (SUCCEEDED(result)) {
+        result = pDevice_->CreateComputeShader(pBytecode->GetBufferPointer(), pBytecode->GetBufferSize(), NULL, &pShader);
+    }
+    SAFE_RELEASE(pBytecode);
+    if (SUCCEEDED(result)) {
+        *ppShader = new D3D11Object<GpuComputeShader>(pShader);
+    }
+    return result;
+}
+
+HRESULT D3D11RenderDevice::CreateInputLayout(const GpuInputElement* pElements, UINT count, GpuVertexShader* pShader, GpuInputLayout** ppLayout) {
+    std::vector<D3D11_INPUT_ELEMENT_DESC> elements(count);
+    for (UINT i = 0; i < count; i++) {
+        elements[i] = { pElements[i].semantic, pElements[i].semanticIndex, (DXGI_FORMAT)pElements[i].format, pElements[i].slot,
+            pElements[i].offset, D3D11_INPUT_PER_VERTEX_DATA, 0 };
+    }
+    ID3DBlob* pBytecode = static_cast<D3D11VertexShader*>(pShader)->GetBytecode();
+    ID3D11InputLayout* pLayout = NULL;
+    HRESULT result = pDevice_->CreateInputLayout(elements.data(), count, pBytecode->GetBufferPointer(), pBytecode->GetBufferSize(), &pLayout);
+    if (SUCCEEDED(result)) {
+        *ppLayout = new D3D11Object<GpuInputLayout>(pLayout);
+    }
+    return result;
+}
+
+HRESULT D3D11RenderDevice::CreateSamplerState(const GpuSamplerDesc& desc, GpuSamplerState** ppState) {
+    D3D11_SAMPLER_DESC samplerDesc = {};
+    samplerDesc.Filter = (D3D11_FILTER)desc.filter;
+    samplerDesc.AddressU = (D3D11_TEXTURE_ADDRESS_MODE)desc.address;
+    samplerDesc.AddressV = (D3D11_TEXTURE_ADDRESS_MODE)desc.address;
+    samplerDesc.AddressW = (D3D11_TEXTURE_ADDRESS_MODE)desc.address;
+    samplerDesc.MipLODBias = 0.0f;
+    samplerDesc.MaxAnisotropy = desc.maxAnisotropy;
+    samplerDesc.ComparisonFunc = D3D11_COMPARISON_NEVER;
+    samplerDesc.BorderColor[0] = samplerDesc.BorderColor[1] = samplerDesc.BorderColor[2] = samplerDesc.BorderColor[3] = 1.0f;
+    samplerDesc.MinLOD = desc.minLod;
+    samplerDesc.MaxLOD = desc.maxLod;
+
+    ID3D11SamplerState* pState = NULL;
+    HRESULT result = pDevice_->CreateSamplerState(&samplerDesc, &pState);
+    if (SUCCEEDED(result)) {
+        *ppState = new D3D11Object<GpuSamplerState>(pState);
+    }
+    return result;
+}
+
+HRESULT D3D11RenderDevice::CreateRasterizerState(const GpuRasterizerDesc& desc, GpuRasterizerState** ppState) {
+    D3D11_RASTERIZER_DESC rasterizerDesc = {};
+    rasterizerDesc.FillMode = D3D11_FILL_SOLID;
+    rasterizerDesc.CullMode = (D3D11_CULL_MODE)desc.cull;
+    rasterizerDesc.DepthClipEnable = desc.depthClip;
+
+    ID3D11RasterizerState* pState = NULL;
+    HRESULT result = pDevice_->CreateRasterizerState(&rasterizerDesc, &pState);
+    if (SUCCEEDED(result)) {
+        *ppState = new D3D11Object<GpuRasterizerState>(pState);
+    }
+    return result;
+}
+
+HRESULT D3D11RenderDevice::CreateDepthStencilState(const GpuDepthStencilDesc& desc, GpuDepthStencilState** ppState) {
+    D3D11_DEPTH_STENCIL_DESC dsDesc = {};
+    dsDesc.DepthEnable = desc.depthEnable;
+    dsDesc.DepthWriteMask = desc.depthWrite ? D3D11_DEPTH_WRITE_MASK_ALL : D3D11_DEPTH_WRITE_MASK_ZERO;
+    dsDesc.DepthFunc = (D3D11_COMPARISON_FUNC)desc.depthFunc;
+    dsDesc.StencilEnable = FALSE;
+
+    ID3D11DepthStencilState* pState = NULL;
+    HRESULT result = pDevice_->CreateDepthStencilState(&dsDesc, &pState);
+    if (SUCCEEDED(result)) {
+        *ppState = new D3D11Object<GpuDepthStencilState>(pState);
+    }
+    return result;
+}
+
+HRESULT D3D11RenderDevice::CreateBlendState(const GpuBlendDesc& desc, GpuBlendState** ppState) {
+    D3D11_BLEND_DESC blendDesc = { 0 };
+    blendDesc.AlphaToCoverageEnable = false;
+    blendDesc.IndependentBlendEnable = false;
+    blendDesc.RenderTarget[0].BlendEnable = desc.blendEnable;
+    blendDesc.RenderTarget[0].SrcBlend = (D3D11_BLEND)desc.srcBlend;
+    blendDesc.RenderTarget[0].DestBlend = (D3D11_BLEND)desc.destBlend;
+    blendDesc.RenderTarget[0].BlendOp = (D3D11_BLEND_OP)desc.blendOp;
+    blendDesc.RenderTarget[0].SrcBlendAlpha = (D3D11_BLEND)desc.srcBlendAlpha;
+    blendDesc.RenderTarget[0].DestBlendAlpha = (D3D11_BLEND)desc.destBlendAlpha;
+    blendDesc.RenderTarget[0].BlendOpAlpha = (D3D11_BLEND_OP)desc.blendOpAlpha;
+    blendDesc.RenderTarget[0].RenderTargetWriteMask = (UINT8)desc.writeMask;
+
+    ID3D11BlendState* pState = NULL;
+    HRESULT result = pDevice_->CreateBlendState(&blendDesc, &pState);
+    if (SUCCEEDED(result)) {
+        *ppState = new D3D11Object<GpuBlendState>(pState);
+    }
+    return result;
+}
+
+HRESULT D3D11RenderDevice::CreateQuery(GpuQueryType type, GpuQuery** ppQuery) {
+    D3D11_QUERY_DESC desc;
+    desc.Query = (D3D11_QUERY)type;
+    desc.MiscFlags = 0;
+
+    ID3D11Query* pQuery = NULL;
+    HRESULT result = pDevice_->CreateQuery(&desc, &pQuery);
+    if (SUCCEEDED(result)) {
+        *ppQuery = new D3D11Object<GpuQuery>(pQuery);
+    }
+    return result;
+}
+
+HRESULT D3D11RenderDevice::LoadTexture(const char* path, bool cube, GpuShaderResourceView** ppView) {
+    ID3D11ShaderResourceView* pView = NULL;
+    HRESULT result;
+    if (cube) {
+        result = CreateDDSTextureFromFileEx(pDevice_, pDeviceContext_, WidePath(path).c_str(),
+            0, D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, D3D11_RESOURCE_MISC_TEXTURECUBE,
+            DDS_LOADER_DEFAULT, nullptr, &pView);
+    }
+    else {
+        result = CreateDDSTextureFromFile(pDevice_, pDeviceContext_, WidePath(path).c_str(), nullptr, &pView);
+    }
+    if (SUCCEEDED(result)) {
+        *ppView = new D3D11Object<GpuShaderResourceView>(pView);
+    }
+    return result;
+}
+
+HRESULT D3D11RenderDevice::LoadTextureArray(const char* const* paths, UINT count, GpuShaderResourceView** ppView) {
+    std::vector<ID3D11Texture2D*> textures(count, nullptr);
+
+    HRESULT result = S_OK;
+    for (UINT i = 0; i < count && SUCCEEDED(result); ++i) {
+        result = DirectX::CreateDDSTextureFromFile(pDevice_, pDeviceContext_, WidePath(paths[i]).c_str(), (ID3D11Resource**)(&textures[i]), nullptr);
+    }
+
+    ID3D11Texture2D* textureArray = nullptr;
+    D3D11_TEXTURE2D_DESC textureDesc = {};
+    if (SUCCEEDED(result)) {
+        textures[0]->GetDesc(&textureDesc);
+
+        D3D11_TEXTURE2D_DESC arrayDesc;
+        arrayDesc.Width = textureDesc.Width;
+        arrayDesc.Height = textureDesc.Height;
+        arrayDesc.MipLevels = textureDesc.MipLevels;
+        arrayDesc.ArraySize = count;
+        arrayDesc.Format = textureDesc.Format;
+        arrayDesc.SampleDesc.Count = 1;
+        arrayDesc.SampleDesc.Quality = 0;
+        arrayDesc.Usage = D3D11_USAGE_DEFAULT;
+        arrayDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+        arrayDesc.CPUAccessFlags = 0;
+        arrayDesc.MiscFlags = 0;
+
+        result = pDevice_->CreateTexture2D(&arrayDesc, 0, &textureArray);
+    }
+    if (SUCCEEDED(result)) {
+        for (UINT texElement = 0; texElement < count; ++texElement) {
+            for (UINT mipLevel = 0; mipLevel < textureDesc.MipLevels; ++mipLevel) {
+                const int sourceSubresource = D3D11CalcSubresource(mipLevel, 0, textureDesc.MipLevels);
+                const int destSubresource = D3D11CalcSubresource(mipLevel, texElement, textureDesc.MipLevels);
+                pDeviceContext_->CopySubresourceRegion(textureArray, destSubresource, 0, 0, 0, textures[texElement], sourceSubresource, nullptr);
+            }
+        }
+
+        ID3D11ShaderResourceView* pView = NULL;
+        result = pDevice_->CreateShaderResourceView(textureArray, NULL, &pView);
+        if (SUCCEEDED(result)) {
+            *ppView = new D3D11Object<GpuShaderResourceView>(pView);
+        }
+    }
+
+    SAFE_RELEASE(textureArray);
+    for (UINT i = 0; i < count; ++i) {
+        SAFE_RELEASE(textures[i]);
+    }
+    return result;
+}
+
+HRESULT D3D11RenderDevice::ResizeBuffers(UINT width, UINT height) {
+    if (pSwapChain_ == NULL) {
+        return E_FAIL;
+    }
+    SAFE_RELEASE(pBackBuffer_);
+
+    HRESULT result = pSwapChain_->ResizeBuffers(2, width, height, DXGI_FORMAT_R8G8B8A8_UNORM, 0);
+    if (SUCCEEDED(result)) {
+        result = CreateBackBuffer();
+    }
+    return result;
+}
+
+HRESULT D3D11RenderDevice::Present() {
+    return pSwapChain_->Present(0, 0);
+}
+
+bool D3D11RenderDevice::InitUI() {
+    withUI_ = ImGui_ImplWin32_Init(hWnd_) && ImGui_ImplDX11_Init(pDevice_, pDeviceContext_);
+    return withUI_;
+}
+
+void D3D11RenderDevice::NewUIFrame() {
+    ImGui_ImplDX11_NewFrame();
+    ImGui_ImplWin32_NewFrame();
+}
+
+void D3D11RenderDevice::RenderUI(ImDrawData* pDrawData) {
+    ImGui_ImplDX11_RenderDrawData(pDrawData);
+}
+
+void D3D11RenderDevice::ShutdownUI() {
+    if (withUI_) {
+        ImGui_ImplDX11_Shutdown();
+        ImGui_ImplWin32_Shutdown();
+        withUI_ = false;
+    }
+}
+
+D3D11RenderDevice::~D3D11RenderDevice() {
+    ShutdownUI();
+    if (pDeviceContext_ != NULL)
+        pDeviceContext_->ClearState();
+
+    SAFE_RELEASE(pBackBuffer_);
+    if (pContext_) {
+        delete pContext_;
+        pContext_ = NULL;
+    }
+    SAFE_RELEASE(pDeviceContext_);
+    SAFE_RELEASE(pSwapChain_);
+
+#ifdef _DEBUG
+    if (pDevice_ != NULL) {
+        ID3D11Debug* d3dDebug = NULL;
+        pDevice_->QueryInterface(IID_PPV_ARGS(&d3dDebug));
+
+        UINT references = pDevice_->Release();
+        pDevice_ = NULL;
+        if (references > 1) {
+            d3dDebug->ReportLiveDeviceObjects(D3D11_RLDO_DETAIL);
+        }
+        SAFE_RELEASE(d3dDebug);
+    }
+#endif
+    SAFE_RELEASE(pDevice_);
+}
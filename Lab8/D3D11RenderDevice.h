@@ -0,0 +1,58 @@
+#pragma once
+
+#include "RenderDevice.h"
+#include "D3D11CommandContext.h"
+
+// D3D11 device on the first hardware adapter with a swap chain of the window, the UI goes through the
+// Win32 and DX11 ImGui backends
+class D3D11RenderDevice : public RenderDevice {
+public:
+    D3D11RenderDevice();
+
+    HRESULT Init(HWND hWnd, UINT width, UINT height);
+
+    HRESULT CreateBuffer(const GpuBufferDesc& desc, const GpuSubresourceData* pData, GpuBuffer** ppBuffer) override;
+    HRESULT CreateTexture2D(const GpuTextureDesc& desc, const GpuSubresourceData* pData, GpuTexture** ppTexture) override;
+    HRESULT CreateShaderResourceView(GpuResource* pResource, GpuShaderResourceView** ppView) override;
+    HRESULT CreateUnorderedAccessView(GpuResource* pResource, GpuUnorderedAccessView** ppView) override;
+    HRESULT CreateRenderTargetView(GpuTexture* pTexture, GpuRenderTargetView** ppView) override;
+    HRESULT CreateDepthStencilView(GpuTexture* pTexture, GpuDepthStencilView** ppView) override;
+
+    HRESULT CreateVertexShader(const GpuShaderDesc& desc, GpuVertexShader** ppShader) override;
+    HRESULT CreatePixelShader(const GpuShaderDesc& desc, GpuPixelShader** ppShader) override;
+    HRESULT CreateComputeShader(const GpuShaderDesc& desc, GpuComputeShader** ppShader) override;
+    HRESULT CreateInputLayout(const GpuInputElement* pElements, UINT count, GpuVertexShader* pShader, GpuInputLayout** ppLayout) override;
+
+    HRESULT CreateSamplerState(const GpuSamplerDesc& desc, GpuSamplerState** ppState) override;
+    HRESULT CreateRasterizerState(const GpuRasterizerDesc& desc, GpuRasterizerState** ppState) override;
+    HRESULT CreateDepthStencilState(const GpuDepthStencilDesc& desc, GpuDepthStencilState** ppState) override;
+    HRESULT CreateBlendState(const GpuBlendDesc& desc, GpuBlendState** ppState) override;
+    HRESULT CreateQuery(GpuQueryType type, GpuQuery** ppQuery) override;
+
+    HRESULT LoadTexture(const char* path, bool cube, GpuShaderResourceView** ppView) override;
+    HRESULT LoadTextureArray(const char* const* paths, UINT count, GpuShaderResourceView** ppView) override;
+
+    GpuRenderTargetView* GetBackBuffer() override { return pBackBuffer_; }
+    HRESULT ResizeBuffers(UINT width, UINT height) override;
+    HRESULT Present() override;
+
+    bool InitUI() override;
+    void NewUIFrame() override;
+    void RenderUI(ImDrawData* pDrawData) override;
+    void ShutdownUI() override;
+
+    CommandContext* GetContext() override { return pContext_; }
+
+    ~D3D11RenderDevice();
+private:
+    HRESULT CreateBackBuffer();
+    HRESULT Compile(const GpuShaderDesc& desc, const char* target, ID3DBlob** ppBytecode);
+
+    HWND hWnd_;
+    ID3D11Device* pDevice_;
+    ID3D11DeviceContext* pDeviceContext_;
+    IDXGISwapChain* pSwapChain_;
+    GpuRenderTargetView* pBackBuffer_;
+    D3D11CommandContext* pContext_;
+    bool withUI_;
+};
@@ -2,12 +2,18 @@
 
 cbuffer CullParams : register(b0) {
     uint4 numShapes;
-    float4 bbMin[MAX_CUBE];
-    float4 bbMax[MAX_CUBE];
 };
 
+StructuredBuffer<float4> boundsMin : register(t0);
+StructuredBuffer<float4> boundsMax : register(t1);
+
 RWStructuredBuffer<uint> indirectArgs : register(u0);
-RWStructuredBuffer<uint4> objectsIds : register(u1);
+RWStructuredBuffer<uint> objectsIds : register(u1);
+// Visible ids of every group packed at the group start and (count, offset) per group
+RWStructuredBuffer<uint> groupIds : register(u2);
+RWStructuredBuffer<uint2> groupRanges : register(u3);
+
+groupshared uint scanBuffer[CULLING_SCAN_SIZE];
 
 bool IsBoxInside(in float4 planes[6], in float3 bbMin, in float3 bbMax) {
     for (int i = 0; i < 6; i++) {
@@ -21,7 +27,7 @@ bool IsBoxInside(in float4 planes[6], in float3 bbMin, in float3 bbMax) {
             continue;
         }
 
-        dotProduct = ((planes[i].x * bbMin.x) + (planes[i].y * bbMin.y) + (planes[i].z * bbMin.z) + (planes[i].w * 1.0f));
+        dotProduct = ((planes[i].x * bbMin.x) + (planes[i].y * bbMax.y) + (planes[i].z * bbMin.z) + (planes[i].w * 1.0f));
         if (dotProduct >= 0.0f) {
             continue;
         }
@@ -57,14 +63,63 @@ bool IsBoxInside(in float4 planes[6], in float3 bbMin, in float3 bbMax) {
     return true;
 }
 
-[numthreads(64, 1, 1)]
-void main(uint3 globalThreadId : SV_DispatchThreadID) {
-    if (globalThreadId.x >= numShapes.x) {
-        return;
+// Inclusive Hillis-Steele scan of scanBuffer[0, size), mirrored by CullingEmulator::ScanGroup
+void ScanBuffer(uint index, uint size) {
+    for (uint offset = 1; offset < size; offset <<= 1) {
+        uint value = index >= offset ? scanBuffer[index - offset] : 0;
+        GroupMemoryBarrierWithGroupSync();
+        scanBuffer[index] += value;
+        GroupMemoryBarrierWithGroupSync();
+    }
+}
+
+// Pass 1: culls a group of boxes and compacts the visible ones in order, one atomic per group for the total count
+[numthreads(CULLING_GROUP_SIZE, 1, 1)]
+void main(uint3 globalThreadId : SV_DispatchThreadID, uint3 localThreadId : SV_GroupThreadID, uint3 groupId : SV_GroupID) {
+    uint visible = 0;
+    if (globalThreadId.x < numShapes.x && IsBoxInside(planes, boundsMin[globalThreadId.x].xyz, boundsMax[globalThreadId.x].xyz)) {
+        visible = 1;
+    }
+
+    scanBuffer[localThreadId.x] = visible;
+    GroupMemoryBarrierWithGroupSync();
+    ScanBuffer(localThreadId.x, CULLING_GROUP_SIZE);
+
+    if (visible) {
+        groupIds[groupId.x * CULLING_GROUP_SIZE + scanBuffer[localThreadId.x] - 1] = globalThreadId.x;
+    }
+    if (localThreadId.x == CULLING_GROUP_SIZE - 1) {
+        uint count = scanBuffer[localThreadId.x];
+        groupRanges[groupId.x] = uint2(count, 0);
+        InterlockedAdd(indirectArgs[1], count);
+    }
+}
+
+// Pass 2, one group: exclusive scan of the group counts into the group offsets, CULLING_SCAN_SIZE groups at a time
+[numthreads(CULLING_SCAN_SIZE, 1, 1)]
+void ScanGroups(uint3 localThreadId : SV_GroupThreadID) {
+    uint groupCount = (numShapes.x + CULLING_GROUP_SIZE - 1) / CULLING_GROUP_SIZE;
+    uint base = 0;
+    for (uint first = 0; first < groupCount; first += CULLING_SCAN_SIZE) {
+        uint group = first + localThreadId.x;
+        uint count = group < groupCount ? groupRanges[group].x : 0;
+        scanBuffer[localThreadId.x] = count;
+        GroupMemoryBarrierWithGroupSync();
+        ScanBuffer(localThreadId.x, CULLING_SCAN_SIZE);
+
+        if (group < groupCount) {
+            groupRanges[group] = uint2(count, base + scanBuffer[localThreadId.x] - count);
+        }
+        base += scanBuffer[CULLING_SCAN_SIZE - 1];
+        GroupMemoryBarrierWithGroupSync();
     }
-    if (IsBoxInside(planes, bbMin[globalThreadId.x].xyz, bbMax[globalThreadId.x].xyz)) {
-        uint id = 0;
-        InterlockedAdd(indirectArgs[1], 1, id);
-        objectsIds[id] = uint4(globalThreadId.x, 0, 0, 0);
+}
+
+// Pass 3: moves the ids of every group to its offset, so the visible list is sorted by instance id
+[numthreads(CULLING_GROUP_SIZE, 1, 1)]
+void Compact(uint3 globalThreadId : SV_DispatchThreadID, uint3 localThreadId : SV_GroupThreadID, uint3 groupId : SV_GroupID) {
+    uint2 range = groupRanges[groupId.x];
+    if (localThreadId.x < range.x) {
+        objectsIds[range.y + localThreadId.x] = groupIds[globalThreadId.x];
     }
 }
\ No newline at end of file
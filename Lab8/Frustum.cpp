@@ -1,5 +1,32 @@
 #include "Frustum.h"
 
+void BoxStreams::Resize(size_t count) {
+    minX.resize(count);
+    minY.resize(count);
+    minZ.resize(count);
+    maxX.resize(count);
+    maxY.resize(count);
+    maxZ.resize(count);
+}
+
+void BoxStreams::Set(size_t i, const XMFLOAT4& bbMin, const XMFLOAT4& bbMax) {
+    minX[i] = bbMin.x;
+    minY[i] = bbMin.y;
+    minZ[i] = bbMin.z;
+    maxX[i] = bbMax.x;
+    maxY[i] = bbMax.y;
+    maxZ[i] = bbMax.z;
+}
+
+void BoxStreams::Gather4(const int* indices, int count, float values[6][4]) const {
+    const AlignedVector<float>* src[6] = { &minX, &minY, &minZ, &maxX, &maxY, &maxZ };
+    for (int j = 0; j < 6; j++) {
+        for (int k = 0; k < 4; k++) {
+            values[j][k] = k < count ? (*src[j])[indices[k]] : 0.0f;
+        }
+    }
+}
+
 Frustum::Frustum(float screenDepth):
     screenDepth_(screenDepth) {}
 
@@ -132,4 +159,207 @@ bool Frustum::CheckRectangle(XMFLOAT4 bbMin, XMFLOAT4 bbMax) {
     }
 
     return true;
+}
+
+// A box is behind a plane iff its corner farthest along the plane normal (the p-vertex) is,
+// so one dot product per plane gives the same answer as the 8 corner checks above.
+// The sum is evaluated in the same order as in CheckRectangle, so the results match bit for bit.
+UINT Frustum::CheckRectangles4(const float* minX, const float* minY, const float* minZ,
+    const float* maxX, const float* maxY, const float* maxZ) {
+    XMVECTOR visible = XMVectorTrueInt();
+    XMVECTOR zero = XMVectorZero();
+
+    for (int i = 0; i < 6; i++) {
+        XMVECTOR x = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(planes_[i].x >= 0.0f ? maxX : minX));
+        XMVECTOR y = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(planes_[i].y >= 0.0f ? maxY : minY));
+        XMVECTOR z = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(planes_[i].z >= 0.0f ? maxZ : minZ));
+
+        XMVECTOR dotProduct = XMVectorMultiply(XMVectorReplicate(planes_[i].x), x);
+        dotProduct = XMVectorAdd(dotProduct, XMVectorMultiply(XMVectorReplicate(planes_[i].y), y));
+        dotProduct = XMVectorAdd(dotProduct, XMVectorMultiply(XMVectorReplicate(planes_[i].z), z));
+        dotProduct = XMVectorAdd(dotProduct, XMVectorReplicate(planes_[i].w));
+
+        visible = XMVectorAndInt(visible, XMVectorGreaterOrEqual(dotProduct, zero));
+        if (XMVector4EqualInt(visible, XMVectorFalseInt())) {
+            return 0;
+        }
+    }
+
+#if defined(_XM_SSE_INTRINSICS_)
+    return (UINT)_mm_movemask_ps(visible);
+#else
+    XMUINT4 bits;
+    XMStoreUInt4(&bits, visible);
+    return (bits.x & 1u) | ((bits.y & 1u) << 1) | ((bits.z & 1u) << 2) | ((bits.w & 1u) << 3);
+#endif
+}
+
+UINT Frustum::CheckRectanglesTail(const BoxStreams& boxes, int first, int count) {
+    int indices[4] = { first, first + 1, first + 2, first + 3 };
+    float tail[6][4];
+    boxes.Gather4(indices, count, tail);
+    UINT mask = CheckRectangles4(tail[0], tail[1], tail[2], tail[3], tail[4], tail[5]);
+    return mask & ((1u << count) - 1u);
+}
+
+int Frustum::CheckRectangles(const BoxStreams& boxes, int first, int count, int* visibleIndices) {
+    int visibleCount = 0;
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        size_t idx = (size_t)first + i;
+        UINT mask = CheckRectangles4(&boxes.minX[idx], &boxes.minY[idx], &boxes.minZ[idx],
+            &boxes.maxX[idx], &boxes.maxY[idx], &boxes.maxZ[idx]);
+        for (int k = 0; k < 4; k++) {
+            visibleIndices[visibleCount] = first + i + k;
+            visibleCount += (mask >> k) & 1u;
+        }
+    }
+    if (i < count) {
+        UINT mask = CheckRectanglesTail(boxes, first + i, count - i);
+        for (int k = 0; k < count - i; k++) {
+            if (mask & (1u << k)) {
+                visibleIndices[visibleCount++] = first + i + k;
+            }
+        }
+    }
+
+    return visibleCount;
+}
+
+void Frustum::CheckRectanglesMask(const BoxStreams& boxes, int first, int count, UINT* visibleMask) {
+    for (int j = 0; j < (count + 31) / 32; j++) {
+        visibleMask[j] = 0;
+    }
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        size_t idx = (size_t)first + i;
+        UINT mask = CheckRectangles4(&boxes.minX[idx], &boxes.minY[idx], &boxes.minZ[idx],
+            &boxes.maxX[idx], &boxes.maxY[idx], &boxes.maxZ[idx]);
+        visibleMask[i / 32] |= mask << (i % 32);
+    }
+    if (i < count) {
+        visibleMask[i / 32] |= CheckRectanglesTail(boxes, first + i, count - i) << (i % 32);
+    }
+}
+
+CullResult Frustum::ClassifyByPlane(int i, const XMFLOAT4& bbMin, const XMFLOAT4& bbMax) {
+    float px = planes_[i].x >= 0.0f ? bbMax.x : bbMin.x;
+    float py = planes_[i].y >= 0.0f ? bbMax.y : bbMin.y;
+    float pz = planes_[i].z >= 0.0f ? bbMax.z : bbMin.z;
+    float dotProduct = ((planes_[i].x * px) + (planes_[i].y * py) + (planes_[i].z * pz) + (planes_[i].w * 1.0f));
+    if (dotProduct < 0.0f) {
+        return CullResult::Outside;
+    }
+
+    float nx = planes_[i].x >= 0.0f ? bbMin.x : bbMax.x;
+    float ny = planes_[i].y >= 0.0f ? bbMin.y : bbMax.y;
+    float nz = planes_[i].z >= 0.0f ? bbMin.z : bbMax.z;
+    dotProduct = ((planes_[i].x * nx) + (planes_[i].y * ny) + (planes_[i].z * nz) + (planes_[i].w * 1.0f));
+
+    return dotProduct < 0.0f ? CullResult::Intersect : CullResult::Inside;
+}
+
+CullResult Frustum::ClassifyRectangle(const XMFLOAT4& bbMin, const XMFLOAT4& bbMax, int& lastPlane, UINT& planeMask) {
+    UINT intersectMask = 0;
+
+    if (lastPlane >= 0 && lastPlane < 6 && (planeMask & (1u << lastPlane))) {
+        CullResult res = ClassifyByPlane(lastPlane, bbMin, bbMax);
+        if (res == CullResult::Outside) {
+            return res;
+        }
+        if (res == CullResult::Intersect) {
+            intersectMask |= 1u << lastPlane;
+        }
+    }
+
+    for (int i = 0; i < 6; i++) {
+        if (i == lastPlane || !(planeMask & (1u << i))) {
+            continue;
+        }
+
+        CullResult res = ClassifyByPlane(i, bbMin, bbMax);
+        if (res == CullResult::Outside) {
+            lastPlane = i;
+            return res;
+        }
+        if (res == CullResult::Intersect) {
+            intersectMask |= 1u << i;
+        }
+    }
+
+    planeMask = intersectMask;
+    return intersectMask ? CullResult::Intersect : CullResult::Inside;
+}
+
+int MultiViewFrustum::AddView(const XMFLOAT4* planes) {
+    if (GetViewCount() >= maxViews) {
+        return -1;
+    }
+    planes_.insert(planes_.end(), planes, planes + 6);
+    return GetViewCount() - 1;
+}
+
+void MultiViewFrustum::CheckRectangles4(const float* minX, const float* minY, const float* minZ,
+    const float* maxX, const float* maxY, const float* maxZ, UINT* viewMasks) const {
+    XMVECTOR boxMin[3] = {
+        XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(minX)),
+        XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(minY)),
+        XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(minZ))
+    };
+    XMVECTOR boxMax[3] = {
+        XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(maxX)),
+        XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(maxY)),
+        XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(maxZ))
+    };
+    XMVECTOR zero = XMVectorZero();
+    viewMasks[0] = viewMasks[1] = viewMasks[2] = viewMasks[3] = 0;
+
+    int viewCount = GetViewCount();
+    for (int v = 0; v < viewCount; v++) {
+        const XMFLOAT4* planes = &planes_[(size_t)v * 6];
+        XMVECTOR visible = XMVectorTrueInt();
+        for (int i = 0; i < 6; i++) {
+            // p-vertex test with the sum in the same order as in Frustum::CheckRectangles4
+            XMVECTOR dotProduct = XMVectorMultiply(XMVectorReplicate(planes[i].x), planes[i].x >= 0.0f ? boxMax[0] : boxMin[0]);
+            dotProduct = XMVectorAdd(dotProduct, XMVectorMultiply(XMVectorReplicate(planes[i].y), planes[i].y >= 0.0f ? boxMax[1] : boxMin[1]));
+            dotProduct = XMVectorAdd(dotProduct, XMVectorMultiply(XMVectorReplicate(planes[i].z), planes[i].z >= 0.0f ? boxMax[2] : boxMin[2]));
+            dotProduct = XMVectorAdd(dotProduct, XMVectorReplicate(planes[i].w));
+
+            visible = XMVectorAndInt(visible, XMVectorGreaterOrEqual(dotProduct, zero));
+            if (XMVector4EqualInt(visible, XMVectorFalseInt())) {
+                break;
+            }
+        }
+
+#if defined(_XM_SSE_INTRINSICS_)
+        UINT mask = (UINT)_mm_movemask_ps(visible);
+#else
+        XMUINT4 bits;
+        XMStoreUInt4(&bits, visible);
+        UINT mask = (bits.x & 1u) | ((bits.y & 1u) << 1) | ((bits.z & 1u) << 2) | ((bits.w & 1u) << 3);
+#endif
+        for (int k = 0; k < 4; k++) {
+            viewMasks[k] |= ((mask >> k) & 1u) << v;
+        }
+    }
+}
+
+void MultiViewFrustum::CheckRectangles(const BoxStreams& boxes, int first, int count, UINT* viewMasks) const {
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        size_t idx = (size_t)first + i;
+        CheckRectangles4(&boxes.minX[idx], &boxes.minY[idx], &boxes.minZ[idx],
+            &boxes.maxX[idx], &boxes.maxY[idx], &boxes.maxZ[idx], viewMasks + i);
+    }
+    if (i < count) {
+        int indices[4] = { first + i, first + i + 1, first + i + 2, first + i + 3 };
+        float tail[6][4];
+        boxes.Gather4(indices, count - i, tail);
+        UINT masks[4];
+        CheckRectangles4(tail[0], tail[1], tail[2], tail[3], tail[4], tail[5], masks);
+        for (int k = 0; k < count - i; k++) {
+            viewMasks[i + k] = masks[k];
+        }
+    }
 }
\ No newline at end of file
@@ -1,6 +1,27 @@
 #pragma once
 
-#include "framework.h"
+#include "MathCommon.h"
+#include "AlignedAllocator.h"
+#include <vector>
+
+// Structure-of-arrays storage of axis-aligned boxes for batch culling
+struct BoxStreams {
+    AlignedVector<float> minX, minY, minZ;
+    AlignedVector<float> maxX, maxY, maxZ;
+
+    void Resize(size_t count);
+    void Set(size_t i, const XMFLOAT4& bbMin, const XMFLOAT4& bbMax);
+    // Copies up to 4 boxes into minX, minY, minZ, maxX, maxY, maxZ of values, padded with zeros,
+    // for the four-wide tests of the last boxes of a range or of an index list
+    void Gather4(const int* indices, int count, float values[6][4]) const;
+    size_t Size() const { return minX.size(); };
+};
+
+enum class CullResult {
+    Outside,
+    Intersect,
+    Inside
+};
 
 class Frustum {
 public:
@@ -8,10 +29,43 @@ public:
 
     void ConstructFrustum(XMMATRIX viewMatrix, XMMATRIX projectionMatrix);
     bool CheckRectangle(XMFLOAT4 bbMin, XMFLOAT4 bbMax);
+    // Tests boxes [first, first + count) four at a time, writes indices of visible ones and returns their number
+    int CheckRectangles(const BoxStreams& boxes, int first, int count, int* visibleIndices);
+    // Same test, bit j of visibleMask[j / 32] is set if box first + j is visible
+    void CheckRectanglesMask(const BoxStreams& boxes, int first, int count, UINT* visibleMask);
+    // Tests only the p- and n-vertex of the box against each plane of planeMask, starting with lastPlane.
+    // On return lastPlane holds the rejecting plane and planeMask the planes the box straddles,
+    // so children of an intersecting box can be tested against those planes only.
+    CullResult ClassifyRectangle(const XMFLOAT4& bbMin, const XMFLOAT4& bbMax, int& lastPlane, UINT& planeMask);
     XMFLOAT4* GetPlanes() { return planes_; };
 
+    static constexpr UINT allPlanes = 0x3F;
+
     ~Frustum() = default;
 private:
+    UINT CheckRectangles4(const float* minX, const float* minY, const float* minZ,
+        const float* maxX, const float* maxY, const float* maxZ);
+    UINT CheckRectanglesTail(const BoxStreams& boxes, int first, int count);
+    CullResult ClassifyByPlane(int i, const XMFLOAT4& bbMin, const XMFLOAT4& bbMax);
+
     float screenDepth_;
     XMFLOAT4 planes_[6];
 };
+
+// Planes of several views tested together, the bounds of every box are loaded once for all of them
+class MultiViewFrustum {
+public:
+    static constexpr int maxViews = 32;
+
+    void Clear() { planes_.clear(); };
+    // Adds the 6 planes of a Frustum, returns the view index or -1 if there are maxViews views already
+    int AddView(const XMFLOAT4* planes);
+    int GetViewCount() const { return (int)planes_.size() / 6; };
+    // Bit v of viewMasks[j] is set if box first + j is visible in view v, the same test as Frustum::CheckRectangles
+    void CheckRectangles(const BoxStreams& boxes, int first, int count, UINT* viewMasks) const;
+private:
+    void CheckRectangles4(const float* minX, const float* minY, const float* minZ,
+        const float* maxX, const float* maxY, const float* maxZ, UINT* viewMasks) const;
+
+    std::vector<XMFLOAT4> planes_;
+};
\ No newline at end of file
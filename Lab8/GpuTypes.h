@@ -0,0 +1,336 @@
+#pragma once
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <cstdint>
+
+typedef int32_t HRESULT;
+
+#define S_OK ((HRESULT)0)
+#define S_FALSE ((HRESULT)1)
+#define E_FAIL ((HRESULT)0x80004005)
+#define E_INVALIDARG ((HRESULT)0x80070057)
+#define E_OUTOFMEMORY ((HRESULT)0x8007000E)
+#define SUCCEEDED(hr) (((HRESULT)(hr)) >= 0)
+#define FAILED(hr) (((HRESULT)(hr)) < 0)
+#endif
+
+#include "MathCommon.h"
+
+// DXGI_ERROR_WAS_STILL_DRAWING, a map with GpuMapFlag::DoNotWait found the resource still in use by the GPU
+#define GPU_E_WAS_STILL_DRAWING ((HRESULT)0x887A000AL)
+
+// Backend-neutral description of the GPU objects Renderer uses. Enum values are the D3D11 and DXGI ones,
+// so the D3D11 backend passes them through unchanged
+
+enum class GpuFormat : UINT {
+    Unknown = 0,
+    R32G32B32A32Float = 2,
+    R32G32B32Float = 6,
+    R16G16B16A16Unorm = 11,
+    R32G32Float = 16,
+    R8G8B8A8Unorm = 28,
+    R16G16Float = 34,
+    R16G16Snorm = 37,
+    D32Float = 40,
+    R32Uint = 42,
+    R16Uint = 57
+};
+
+enum class GpuUsage : UINT {
+    Default = 0,
+    Immutable = 1,
+    Dynamic = 2,
+    Staging = 3
+};
+
+struct GpuBind {
+    enum : UINT {
+        VertexBuffer = 0x1,
+        IndexBuffer = 0x2,
+        ConstantBuffer = 0x4,
+        ShaderResource = 0x8,
+        RenderTarget = 0x20,
+        DepthStencil = 0x40,
+        UnorderedAccess = 0x80
+    };
+};
+
+struct GpuCpuAccess {
+    enum : UINT {
+        Write = 0x10000,
+        Read = 0x20000
+    };
+};
+
+struct GpuMisc {
+    enum : UINT {
+        TextureCube = 0x4,
+        DrawIndirectArgs = 0x10,
+        BufferStructured = 0x40
+    };
+};
+
+enum class GpuMap : UINT {
+    Read = 1,
+    Write = 2,
+    ReadWrite = 3,
+    WriteDiscard = 4,
+    WriteNoOverwrite = 5
+};
+
+struct GpuMapFlag {
+    enum : UINT {
+        DoNotWait = 0x100000
+    };
+};
+
+enum class GpuTopology : UINT {
+    TriangleList = 4
+};
+
+struct GpuClear {
+    enum : UINT {
+        Depth = 0x1,
+        Stencil = 0x2
+    };
+};
+
+enum class GpuFilter : UINT {
+    MinMagMipPoint = 0,
+    Anisotropic = 0x55
+};
+
+enum class GpuTextureAddress : UINT {
+    Wrap = 1,
+    Clamp = 3
+};
+
+enum class GpuComparison : UINT {
+    Never = 1,
+    Less = 2,
+    Equal = 3,
+    LessEqual = 4,
+    Greater = 5,
+    NotEqual = 6,
+    GreaterEqual = 7,
+    Always = 8
+};
+
+enum class GpuCull : UINT {
+    None = 1,
+    Front = 2,
+    Back = 3
+};
+
+enum class GpuBlend : UINT {
+    Zero = 1,
+    One = 2,
+    SrcAlpha = 5,
+    InvSrcAlpha = 6
+};
+
+enum class GpuBlendOp : UINT {
+    Add = 1
+};
+
+struct GpuColorWrite {
+    enum : UINT {
+        Red = 0x1,
+        Green = 0x2,
+        Blue = 0x4,
+        Alpha = 0x8
+    };
+};
+
+enum class GpuQueryType : UINT {
+    PipelineStatistics = 7
+};
+
+struct GpuViewport {
+    float x;
+    float y;
+    float width;
+    float height;
+    float minDepth;
+    float maxDepth;
+};
+
+struct GpuRect {
+    INT left;
+    INT top;
+    INT right;
+    INT bottom;
+};
+
+struct GpuBox {
+    UINT left;
+    UINT top;
+    UINT front;
+    UINT right;
+    UINT bottom;
+    UINT back;
+};
+
+struct GpuMappedSubresource {
+    void* pData;
+    UINT rowPitch;
+    UINT depthPitch;
+};
+
+struct GpuSubresourceData {
+    const void* pSysMem;
+    UINT sysMemPitch;
+    UINT sysMemSlicePitch;
+};
+
+struct GpuBufferDesc {
+    UINT byteWidth;
+    GpuUsage usage;
+    UINT bindFlags;
+    UINT cpuAccessFlags;
+    UINT miscFlags;
+    UINT structureByteStride;
+};
+
+struct GpuTextureDesc {
+    UINT width;
+    UINT height;
+    UINT mipLevels;
+    UINT arraySize;
+    GpuFormat format;
+    UINT sampleCount;
+    UINT sampleQuality;
+    GpuUsage usage;
+    UINT bindFlags;
+    UINT cpuAccessFlags;
+    UINT miscFlags;
+};
+
+// Per-vertex attributes only
+struct GpuInputElement {
+    const char* semantic;
+    UINT semanticIndex;
+    GpuFormat format;
+    UINT slot;
+    UINT offset;
+};
+
+// macros ends with a { NULL, NULL } entry, or is NULL
+struct GpuShaderMacro {
+    const char* name;
+    const char* definition;
+};
+
+struct GpuShaderDesc {
+    const char* file;
+    const char* entryPoint;
+    const GpuShaderMacro* macros;
+};
+
+struct GpuSamplerDesc {
+    GpuFilter filter;
+    GpuTextureAddress address;
+    UINT maxAnisotropy;
+    float minLod;
+    float maxLod;
+};
+
+struct GpuRasterizerDesc {
+    GpuCull cull;
+    bool depthClip;
+};
+
+struct GpuDepthStencilDesc {
+    bool depthEnable;
+    bool depthWrite;
+    GpuComparison depthFunc;
+};
+
+// The same blending for every render target
+struct GpuBlendDesc {
+    bool blendEnable;
+    GpuBlend srcBlend;
+    GpuBlend destBlend;
+    GpuBlendOp blendOp;
+    GpuBlend srcBlendAlpha;
+    GpuBlend destBlendAlpha;
+    GpuBlendOp blendOpAlpha;
+    UINT writeMask;
+};
+
+struct GpuDrawIndexedIndirectArgs {
+    UINT indexCountPerInstance;
+    UINT instanceCount;
+    UINT startIndexLocation;
+    INT baseVertexLocation;
+    UINT startInstanceLocation;
+};
+
+struct GpuPipelineStatistics {
+    UINT64 iaVertices;
+    UINT64 iaPrimitives;
+    UINT64 vsInvocations;
+    UINT64 gsInvocations;
+    UINT64 gsPrimitives;
+    UINT64 cInvocations;
+    UINT64 cPrimitives;
+    UINT64 psInvocations;
+    UINT64 hsInvocations;
+    UINT64 dsInvocations;
+    UINT64 csInvocations;
+};
+
+static constexpr UINT maxDispatchGroups = 65535;
+
+// Handles of the objects a RenderDevice creates. A backend derives its objects from these,
+// Release destroys the object and whatever the backend holds behind it
+class GpuObject {
+public:
+    void Release() { delete this; };
+    // The backend's own object, NULL for the null backend
+    void* GetNative() const { return pNative_; };
+
+    virtual ~GpuObject() = default;
+protected:
+    void* pNative_ = NULL;
+};
+
+class GpuResource : public GpuObject {
+public:
+    // Description of a buffer, zero for textures
+    const GpuBufferDesc& GetBufferDesc() const { return bufferDesc_; };
+protected:
+    GpuBufferDesc bufferDesc_ = {};
+};
+
+class GpuBuffer : public GpuResource {
+public:
+    GpuBuffer(const GpuBufferDesc& desc) { bufferDesc_ = desc; };
+};
+
+class GpuTexture : public GpuResource {
+public:
+    GpuTexture(const GpuTextureDesc& desc) : desc_(desc) {};
+    const GpuTextureDesc& GetDesc() const { return desc_; };
+private:
+    GpuTextureDesc desc_;
+};
+
+class GpuShaderResourceView : public GpuObject {};
+class GpuUnorderedAccessView : public GpuObject {};
+class GpuRenderTargetView : public GpuObject {};
+class GpuDepthStencilView : public GpuObject {};
+class GpuVertexShader : public GpuObject {};
+class GpuPixelShader : public GpuObject {};
+class GpuComputeShader : public GpuObject {};
+class GpuInputLayout : public GpuObject {};
+class GpuSamplerState : public GpuObject {};
+class GpuRasterizerState : public GpuObject {};
+class GpuDepthStencilState : public GpuObject {};
+class GpuBlendState : public GpuObject {};
+class GpuQuery : public GpuObject {};
@@ -0,0 +1,110 @@
+#include "HashGrid.h"
+
+HashGrid::HashGrid(float cellSize):
+    cellSize_(cellSize) {}
+
+void HashGrid::Clear() {
+    SpatialIndex::Clear();
+    cellCoords_.clear();
+    cellMap_.clear();
+    maxExtent_ = 0.0f;
+}
+
+UINT64 HashGrid::Key(int x, int y, int z) {
+    const UINT64 mask = (1ull << 21) - 1;
+    return (((UINT64)(x + (1 << 20)) & mask) << 42) | (((UINT64)(y + (1 << 20)) & mask) << 21) | ((UINT64)(z + (1 << 20)) & mask);
+}
+
+int HashGrid::AcquireCell(const XMFLOAT4& bbMin, const XMFLOAT4& bbMax) {
+    float extent = max(max(bbMax.x - bbMin.x, bbMax.y - bbMin.y), bbMax.z - bbMin.z) * 0.5f;
+    maxExtent_ = max(maxExtent_, extent);
+
+    int x = (int)floorf((bbMin.x + bbMax.x) * 0.5f / cellSize_);
+    int y = (int)floorf((bbMin.y + bbMax.y) * 0.5f / cellSize_);
+    int z = (int)floorf((bbMin.z + bbMax.z) * 0.5f / cellSize_);
+    UINT64 key = Key(x, y, z);
+    auto it = cellMap_.find(key);
+    if (it != cellMap_.end()) {
+        return it->second;
+    }
+
+    int cell = (int)cellCoords_.size();
+    cellCoords_.push_back(XMINT3(x, y, z));
+    cellIds_.emplace_back();
+    cellMap_[key] = cell;
+    return cell;
+}
+
+void HashGrid::GetLooseBounds(int cell, XMFLOAT4& looseMin, XMFLOAT4& looseMax) const {
+    const XMINT3& c = cellCoords_[cell];
+    looseMin = XMFLOAT4(c.x * cellSize_ - maxExtent_, c.y * cellSize_ - maxExtent_, c.z * cellSize_ - maxExtent_, 1.0f);
+    looseMax = XMFLOAT4((c.x + 1) * cellSize_ + maxExtent_, (c.y + 1) * cellSize_ + maxExtent_, (c.z + 1) * cellSize_ + maxExtent_, 1.0f);
+}
+
+// Small ranges look the cells up in the hash, large ones scan the list of cells
+template<class Test> int HashGrid::VisitCells(const XMFLOAT4& bbMin, const XMFLOAT4& bbMax, int* ids, Test test) {
+    int x0 = (int)floorf((bbMin.x - maxExtent_) / cellSize_), x1 = (int)floorf((bbMax.x + maxExtent_) / cellSize_);
+    int y0 = (int)floorf((bbMin.y - maxExtent_) / cellSize_), y1 = (int)floorf((bbMax.y + maxExtent_) / cellSize_);
+    int z0 = (int)floorf((bbMin.z - maxExtent_) / cellSize_), z1 = (int)floorf((bbMax.z + maxExtent_) / cellSize_);
+
+    int count = 0;
+    double rangeCells = (double)(x1 - x0 + 1) * (y1 - y0 + 1) * (z1 - z0 + 1);
+    if (rangeCells <= (double)cellCoords_.size()) {
+        for (int z = z0; z <= z1; z++) {
+            for (int y = y0; y <= y1; y++) {
+                for (int x = x0; x <= x1; x++) {
+                    auto it = cellMap_.find(Key(x, y, z));
+                    if (it != cellMap_.end() && !cellIds_[it->second].empty()) {
+                        count += test(it->second, ids + count);
+                    }
+                }
+            }
+        }
+        return count;
+    }
+
+    for (int cell = 0; cell < (int)cellCoords_.size(); cell++) {
+        const XMINT3& c = cellCoords_[cell];
+        if (!cellIds_[cell].empty() && c.x >= x0 && c.x <= x1 && c.y >= y0 && c.y <= y1 && c.z >= z0 && c.z <= z1) {
+            count += test(cell, ids + count);
+        }
+    }
+    return count;
+}
+
+int HashGrid::QueryFrustum(Frustum& frustum, int* ids) {
+    int count = 0;
+    XMFLOAT4 looseMin, looseMax;
+    for (int cell = 0; cell < (int)cellCoords_.size(); cell++) {
+        if (cellIds_[cell].empty()) {
+            continue;
+        }
+        GetLooseBounds(cell, looseMin, looseMax);
+        int lastPlane = -1;
+        UINT planeMask = Frustum::allPlanes;
+        CullResult res = frustum.ClassifyRectangle(looseMin, looseMax, lastPlane, planeMask);
+        if (res == CullResult::Inside) {
+            count += AppendCell(cell, ids + count);
+        }
+        else if (res == CullResult::Intersect) {
+            count += TestCellFrustum(frustum, cell, planeMask, ids + count);
+        }
+    }
+    return count;
+}
+
+int HashGrid::QuerySphere(const XMFLOAT3& center, float radius, int* ids) {
+    XMFLOAT4 bbMin(center.x - radius, center.y - radius, center.z - radius, 1.0f);
+    XMFLOAT4 bbMax(center.x + radius, center.y + radius, center.z + radius, 1.0f);
+    return VisitCells(bbMin, bbMax, ids, [&](int cell, int* cellIds) {
+        XMFLOAT4 looseMin, looseMax;
+        GetLooseBounds(cell, looseMin, looseMax);
+        return SphereIntersectsBox(center, radius, looseMin, looseMax) ? TestCellSphere(cell, center, radius, cellIds) : 0;
+    });
+}
+
+int HashGrid::QueryBox(const XMFLOAT4& bbMin, const XMFLOAT4& bbMax, int* ids) {
+    return VisitCells(bbMin, bbMax, ids, [&](int cell, int* cellIds) {
+        return TestCellBox(cell, bbMin, bbMax, cellIds);
+    });
+}
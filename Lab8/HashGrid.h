@@ -0,0 +1,29 @@
+#pragma once
+
+#include "SpatialIndex.h"
+#include <unordered_map>
+
+// Uniform grid of cubic cells stored in a hash of their integer coordinates, a box is kept in the cell of its center.
+// Cells are widened by the largest half extent inserted since Clear, the grid is loose in the same way as the octree
+class HashGrid : public SpatialIndex {
+public:
+    HashGrid(float cellSize);
+
+    void Clear() override;
+    int QueryFrustum(Frustum& frustum, int* ids) override;
+    int QuerySphere(const XMFLOAT3& center, float radius, int* ids) override;
+    int QueryBox(const XMFLOAT4& bbMin, const XMFLOAT4& bbMax, int* ids) override;
+
+    ~HashGrid() = default;
+private:
+    int AcquireCell(const XMFLOAT4& bbMin, const XMFLOAT4& bbMax) override;
+    void GetLooseBounds(int cell, XMFLOAT4& looseMin, XMFLOAT4& looseMax) const;
+    // Calls test for every non-empty cell whose loose bounds may touch [bbMin, bbMax]
+    template<class Test> int VisitCells(const XMFLOAT4& bbMin, const XMFLOAT4& bbMax, int* ids, Test test);
+    static UINT64 Key(int x, int y, int z);
+
+    float cellSize_;
+    float maxExtent_ = 0.0f;
+    std::vector<XMINT3> cellCoords_;
+    std::unordered_map<UINT64, int> cellMap_;
+};
@@ -0,0 +1,145 @@
+#include "InstanceFormat.h"
+
+namespace {
+    // Codes 1..1023 around packZero: an odd number of levels, so a zero component is stored exactly
+    constexpr float packRange = 0.70710678f;
+    constexpr UINT packMask = 0x3FF;
+    constexpr UINT packZero = 512;
+    constexpr float packSteps = 511.0f;
+    constexpr float packScale = packSteps / packRange;
+    constexpr float packUnscale = packRange / packSteps;
+    constexpr float packOffset = packZero + 0.5f;
+}
+
+UINT PackQuaternion(FXMVECTOR q) {
+    XMFLOAT4 v;
+    XMStoreFloat4(&v, XMQuaternionNormalize(q));
+    float c[4] = { v.x, v.y, v.z, v.w };
+
+    UINT largest = 0;
+    for (UINT i = 1; i < 4; i++) {
+        if (fabsf(c[i]) > fabsf(c[largest])) {
+            largest = i;
+        }
+    }
+    // q and -q are the same rotation, keep the dropped component positive
+    float sign = c[largest] < 0.0f ? -1.0f : 1.0f;
+
+    UINT packed = largest << 30;
+    UINT shift = 20;
+    for (UINT i = 0; i < 4; i++) {
+        if (i == largest) {
+            continue;
+        }
+        float value = c[i] * sign * packScale;
+        value = value < -packSteps ? -packSteps : (value > packSteps ? packSteps : value);
+        packed |= (UINT)(value + packOffset) << shift;
+        shift -= 10;
+    }
+    return packed;
+}
+
+XMVECTOR UnpackQuaternion(UINT packed) {
+    UINT largest = packed >> 30;
+    float c[4];
+    float sum = 0.0f;
+    UINT shift = 20;
+    for (UINT i = 0; i < 4; i++) {
+        if (i == largest) {
+            continue;
+        }
+        c[i] = ((float)((packed >> shift) & packMask) - packZero) * packUnscale;
+        sum += c[i] * c[i];
+        shift -= 10;
+    }
+    c[largest] = sqrtf(sum < 1.0f ? 1.0f - sum : 0.0f);
+    return XMVectorSet(c[0], c[1], c[2], c[3]);
+}
+
+void PackInstance(FXMVECTOR position, float scale, FXMVECTOR rotation, float shine, UINT textureId, bool normalMap,
+    InstanceData& instance) {
+    XMStoreFloat4(&instance.posScale, XMVectorSetW(position, scale));
+    instance.rotation = PackQuaternion(rotation);
+    instance.material = (textureId & 0xFFFF) | (normalMap ? 0x10000 : 0);
+    instance.shine = shine;
+    instance.padding = 0.0f;
+}
+
+XMMATRIX UnpackInstance(const InstanceData& instance) {
+    float scale = instance.posScale.w;
+    return XMMatrixScaling(scale, scale, scale) *
+        XMMatrixRotationQuaternion(UnpackQuaternion(instance.rotation)) *
+        XMMatrixTranslation(instance.posScale.x, instance.posScale.y, instance.posScale.z);
+}
+
+void PackSpinInstances(float t, const float* posX, const float* posY, const float* posZ, const float* spin, const float* shine,
+    const UINT* textureId, const char* normalMap, int first, int count, InstanceData* instances, XMMATRIX* world) {
+    XMVECTOR one = XMVectorSplatOne();
+    XMVECTOR two = XMVectorReplicate(2.0f);
+    XMVECTOR zero = XMVectorZero();
+
+    int i = first;
+    for (; i + 4 <= first + count; i += 4) {
+        XMVECTOR halfAngle = XMVectorScale(XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&spin[i])), 0.5f * t);
+        XMVECTOR s, c;
+        XMVectorSinCos(&s, &c, halfAngle);
+
+        // Quaternion (0, s, 0, c): the larger of y and w is dropped and made positive, the other one is stored
+        XMVECTOR dropY = XMVectorGreaterOrEqual(XMVectorAbs(s), XMVectorAbs(c));
+        XMVECTOR dropped = XMVectorSelect(c, s, dropY);
+        XMVECTOR stored = XMVectorSelect(s, c, dropY);
+        stored = XMVectorSelect(stored, XMVectorNegate(stored), XMVectorLess(dropped, zero));
+        XMVECTOR bits = XMVectorClamp(XMVectorScale(stored, packScale), XMVectorReplicate(-packSteps), XMVectorReplicate(packSteps));
+        XMVECTOR storedBits = XMConvertVectorFloatToUInt(XMVectorAdd(bits, XMVectorReplicate(packOffset)), 0);
+
+        // Rebuilt the way UnpackQuaternion does it, x and z are stored as exact zeros
+        XMVECTOR unpacked = XMVectorScale(XMVectorSubtract(XMConvertVectorUIntToFloat(storedBits, 0),
+            XMVectorReplicate((float)packZero)), packUnscale);
+        XMVECTOR largest = XMVectorSqrt(XMVectorMax(XMVectorSubtract(one, XMVectorMultiply(unpacked, unpacked)), zero));
+        XMVECTOR qy = XMVectorSelect(unpacked, largest, dropY);
+        XMVECTOR qw = XMVectorSelect(largest, unpacked, dropY);
+
+        // Rotation matrix of (0, qy, 0, qw), one element per vector over the four instances
+        XMVECTOR cosAngle = XMVectorSubtract(one, XMVectorMultiply(two, XMVectorMultiply(qy, qy)));
+        XMVECTOR sinAngle = XMVectorMultiply(two, XMVectorMultiply(qy, qw));
+        XMMATRIX rows[3] = {
+            XMMATRIX(cosAngle, zero, XMVectorNegate(sinAngle), zero),
+            XMMATRIX(zero, one, zero, zero),
+            XMMATRIX(sinAngle, zero, cosAngle, zero)
+        };
+        for (XMMATRIX& row : rows) {
+            row = XMMatrixTranspose(row);
+        }
+        XMMATRIX translation = XMMatrixTranspose(XMMATRIX(
+            XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&posX[i])),
+            XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&posY[i])),
+            XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&posZ[i])),
+            one));
+
+        XMUINT4 packedBits;
+        XMUINT4 dropYMask;
+        XMStoreUInt4(&packedBits, storedBits);
+        XMStoreUInt4(&dropYMask, dropY);
+        const UINT lanePacked[4] = { packedBits.x, packedBits.y, packedBits.z, packedBits.w };
+        const UINT laneDropY[4] = { dropYMask.x, dropYMask.y, dropYMask.z, dropYMask.w };
+        for (int k = 0; k < 4; k++) {
+            InstanceData& instance = instances[i + k];
+            XMStoreFloat4(&instance.posScale, translation.r[k]);
+            instance.rotation = laneDropY[k] ?
+                (1u << 30) | (packZero << 20) | (packZero << 10) | lanePacked[k] :
+                (3u << 30) | (packZero << 20) | (lanePacked[k] << 10) | packZero;
+            instance.material = (textureId[i + k] & 0xFFFF) | (normalMap[i + k] ? 0x10000 : 0);
+            instance.shine = shine[i + k];
+            instance.padding = 0.0f;
+
+            world[i + k] = XMMATRIX(rows[0].r[k], rows[1].r[k], rows[2].r[k], translation.r[k]);
+        }
+    }
+
+    for (; i < first + count; i++) {
+        XMVECTOR rotation = XMQuaternionRotationRollPitchYaw(0.0f, t * spin[i], 0.0f);
+        PackInstance(XMVectorSet(posX[i], posY[i], posZ[i], 1.0f), 1.0f, rotation, shine[i], textureId[i], normalMap[i] != 0,
+            instances[i]);
+        world[i] = UnpackInstance(instances[i]);
+    }
+}
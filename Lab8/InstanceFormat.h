@@ -0,0 +1,31 @@
+#pragma once
+
+#include "MathCommon.h"
+
+// Compact per-instance data of a rigid, uniformly scaled object, 32 bytes instead of two matrices
+struct InstanceData {
+    XMFLOAT4 posScale;   // xyz - position, w - uniform scale
+    UINT rotation;       // quaternion, see PackQuaternion
+    UINT material;       // texture id in the low 16 bits, bit 16 - normal map flag
+    float shine;
+    float padding;
+};
+
+// Smallest-three encoding: bits 30-31 hold the index of the dropped largest component,
+// the other three are stored in 10 bits each as 512 + 511 * c * sqrt(2), zero maps to 512 exactly
+UINT PackQuaternion(FXMVECTOR q);
+XMVECTOR UnpackQuaternion(UINT packed);
+// Upper bound of the per-component error after a round trip: the stored components are off by at most
+// half a step, the rebuilt largest one, which is at least 1/2, by up to three times that
+constexpr float quaternionPackError = 3.0f * 0.70710678f / 1022.0f;
+
+void PackInstance(FXMVECTOR position, float scale, FXMVECTOR rotation, float shine, UINT textureId, bool normalMap,
+    InstanceData& instance);
+// World matrix exactly as the vertex shader rebuilds it
+XMMATRIX UnpackInstance(const InstanceData& instance);
+
+// Unit-scale instances rotated by angle t * spin[i] around Y, [first, first + count) of the columns: writes the packed
+// instances and the matrices UnpackInstance returns for them, up to rounding. Sin and cos of four instances are computed
+// at once and the quaternions are packed and rebuilt in registers, y and w being the only non-zero components
+void PackSpinInstances(float t, const float* posX, const float* posY, const float* posZ, const float* spin, const float* shine,
+    const UINT* textureId, const char* normalMap, int first, int count, InstanceData* instances, XMMATRIX* world);
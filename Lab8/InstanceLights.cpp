@@ -0,0 +1,116 @@
+#include "InstanceLights.h"
+#include <algorithm>
+#include <cfloat>
+
+InstanceLights::InstanceLights(float cellSize):
+    cellSize_(cellSize) {}
+
+// sphere.w is the radius
+static bool SphereTouchesBox(const XMFLOAT4& sphere, float minX, float minY, float minZ, float maxX, float maxY, float maxZ) {
+    float dx = max(max(minX - sphere.x, sphere.x - maxX), 0.0f);
+    float dy = max(max(minY - sphere.y, sphere.y - maxY), 0.0f);
+    float dz = max(max(minZ - sphere.z, sphere.z - maxZ), 0.0f);
+    return dx * dx + dy * dy + dz * dz <= sphere.w * sphere.w;
+}
+
+int InstanceLights::CellCoord(float value, int axis) const {
+    float origin = axis == 0 ? gridOrigin_.x : (axis == 1 ? gridOrigin_.y : gridOrigin_.z);
+    int cell = (int)floorf((value - origin) / gridCellSize_);
+    return min(max(cell, 0), gridSize_[axis] - 1);
+}
+
+void InstanceLights::Build(const Light* pLights, int lightCount, const BoxStreams& bounds, int instanceCount) {
+    ranges_.resize(instanceCount);
+    lightIndices_.clear();
+    maxCount_ = 0;
+    if (instanceCount == 0) {
+        return;
+    }
+
+    // Grid over the instance centers
+    XMFLOAT3 gridMin(FLT_MAX, FLT_MAX, FLT_MAX), gridMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    float maxExtent = 0.0f;
+    for (int i = 0; i < instanceCount; i++) {
+        XMFLOAT3 center((bounds.minX[i] + bounds.maxX[i]) * 0.5f, (bounds.minY[i] + bounds.maxY[i]) * 0.5f, (bounds.minZ[i] + bounds.maxZ[i]) * 0.5f);
+        gridMin = XMFLOAT3(min(gridMin.x, center.x), min(gridMin.y, center.y), min(gridMin.z, center.z));
+        gridMax = XMFLOAT3(max(gridMax.x, center.x), max(gridMax.y, center.y), max(gridMax.z, center.z));
+        maxExtent = max(maxExtent, max(bounds.maxX[i] - center.x, max(bounds.maxY[i] - center.y, bounds.maxZ[i] - center.z)));
+    }
+    gridOrigin_ = gridMin;
+    gridCellSize_ = cellSize_;
+    for (;;) {
+        gridSize_[0] = (int)((gridMax.x - gridMin.x) / gridCellSize_) + 1;
+        gridSize_[1] = (int)((gridMax.y - gridMin.y) / gridCellSize_) + 1;
+        gridSize_[2] = (int)((gridMax.z - gridMin.z) / gridCellSize_) + 1;
+        if ((double)gridSize_[0] * gridSize_[1] * gridSize_[2] <= maxCells) {
+            break;
+        }
+        gridCellSize_ *= 2.0f;
+    }
+    int cellCount = gridSize_[0] * gridSize_[1] * gridSize_[2];
+
+    // Lights into the cells of their widened box: counts, prefix sum and scatter
+    cellStart_.assign(cellCount + 1, 0);
+    lightCells_[0].resize(lightCount);
+    lightCells_[1].resize(lightCount);
+    for (int i = 0; i < lightCount; i++) {
+        const XMFLOAT4& pos = pLights[i].pos;
+        XMINT3& first = lightCells_[0][i];
+        XMINT3& last = lightCells_[1][i];
+        float reach = pos.w + maxExtent;
+        if (pos.w <= 0.0f || pos.x + reach < gridMin.x || pos.x - reach > gridMax.x || pos.y + reach < gridMin.y ||
+            pos.y - reach > gridMax.y || pos.z + reach < gridMin.z || pos.z - reach > gridMax.z) {
+            first = XMINT3(1, 0, 0);
+            last = XMINT3(0, 0, 0);
+            continue;
+        }
+        first = XMINT3(CellCoord(pos.x - reach, 0), CellCoord(pos.y - reach, 1), CellCoord(pos.z - reach, 2));
+        last = XMINT3(CellCoord(pos.x + reach, 0), CellCoord(pos.y + reach, 1), CellCoord(pos.z + reach, 2));
+        for (int z = first.z; z <= last.z; z++) {
+            for (int y = first.y; y <= last.y; y++) {
+                for (int x = first.x; x <= last.x; x++) {
+                    cellStart_[(z * gridSize_[1] + y) * gridSize_[0] + x + 1]++;
+                }
+            }
+        }
+    }
+    for (int c = 0; c < cellCount; c++) {
+        cellStart_[c + 1] += cellStart_[c];
+    }
+    cellSpheres_.resize(cellStart_[cellCount]);
+    cellLights_.resize(cellStart_[cellCount]);
+    for (int i = 0; i < lightCount; i++) {
+        const XMINT3& first = lightCells_[0][i];
+        const XMINT3& last = lightCells_[1][i];
+        for (int z = first.z; z <= last.z; z++) {
+            for (int y = first.y; y <= last.y; y++) {
+                for (int x = first.x; x <= last.x; x++) {
+                    // cellStart_ of the next cell is its fill position until the scatter ends
+                    UINT entry = cellStart_[(z * gridSize_[1] + y) * gridSize_[0] + x]++;
+                    cellSpheres_[entry] = pLights[i].pos;
+                    cellLights_[entry] = (UINT)i;
+                }
+            }
+        }
+    }
+    for (int c = cellCount; c > 0; c--) {
+        cellStart_[c] = cellStart_[c - 1];
+    }
+    cellStart_[0] = 0;
+
+    for (int i = 0; i < instanceCount; i++) {
+        float minX = bounds.minX[i], minY = bounds.minY[i], minZ = bounds.minZ[i];
+        float maxX = bounds.maxX[i], maxY = bounds.maxY[i], maxZ = bounds.maxZ[i];
+        int cell = (CellCoord((minZ + maxZ) * 0.5f, 2) * gridSize_[1] + CellCoord((minY + maxY) * 0.5f, 1)) * gridSize_[0] +
+            CellCoord((minX + maxX) * 0.5f, 0);
+
+        UINT offset = (UINT)lightIndices_.size();
+        for (UINT e = cellStart_[cell]; e < cellStart_[cell + 1]; e++) {
+            if (SphereTouchesBox(cellSpheres_[e], minX, minY, minZ, maxX, maxY, maxZ)) {
+                lightIndices_.push_back(cellLights_[e]);
+            }
+        }
+        ranges_[i] = XMUINT2(offset, (UINT)lightIndices_.size() - offset);
+        maxCount_ = max(maxCount_, (int)ranges_[i].y);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "MathCommon.h"
+#include "Frustum.h"
+#include "Lighting.h"
+#include <vector>
+
+// Per-instance lists of the lights whose sphere, pos.w being the range, touches the instance bounds.
+// Lights are binned into the cells of a uniform grid over the instances that their box, widened by the largest
+// instance half extent, overlaps. An instance then only tests the lights of the cell of its center.
+// The grid grows its cells to stay under maxCells cells
+class InstanceLights {
+public:
+    static constexpr int maxCells = 1 << 18;
+
+    InstanceLights(float cellSize);
+
+    void Build(const Light* pLights, int lightCount, const BoxStreams& bounds, int instanceCount);
+
+    // Offset in GetLightIndices and light count of every instance
+    const std::vector<XMUINT2>& GetRanges() const { return ranges_; };
+    const std::vector<UINT>& GetLightIndices() const { return lightIndices_; };
+    int GetMaxCount() const { return maxCount_; };
+
+    ~InstanceLights() = default;
+private:
+    int CellCoord(float value, int axis) const;
+
+    float cellSize_;
+    float gridCellSize_ = 1.0f;
+    XMFLOAT3 gridOrigin_ = {};
+    int gridSize_[3] = {};
+    std::vector<UINT> cellStart_;       // first entry of every cell, one more element than cells
+    std::vector<XMFLOAT4> cellSpheres_; // light position and range of every entry
+    std::vector<UINT> cellLights_;      // light index of every entry
+    std::vector<XMINT3> lightCells_[2]; // first and last cell of every light, x > last x for lights out of the grid
+    std::vector<XMUINT2> ranges_;
+    std::vector<UINT> lightIndices_;
+    int maxCount_ = 0;
+};
@@ -0,0 +1,149 @@
+#include "InstanceStore.h"
+#include "Bounds.h"
+#include <algorithm>
+
+InstanceHandle InstanceStore::Add(const InstanceDesc& desc) {
+    UINT slot;
+    if (!freeSlots_.empty()) {
+        slot = freeSlots_.back();
+        freeSlots_.pop_back();
+    }
+    else {
+        slot = (UINT)slotIndex_.size();
+        slotIndex_.push_back(-1);
+        slotGeneration_.push_back(0);
+    }
+
+    int index = Size();
+    slotIndex_[slot] = index;
+    indexSlot_.push_back(slot);
+    posX_.push_back(desc.pos.x);
+    posY_.push_back(desc.pos.y);
+    posZ_.push_back(desc.pos.z);
+    spin_.push_back(desc.spin);
+    shine_.push_back(desc.shine);
+    textureId_.push_back(desc.textureId);
+    normalMap_.push_back(desc.normalMap ? 1 : 0);
+
+    // Transforms and bounds are built by the next update of the new instance
+    XMFLOAT4 point(desc.pos.x, desc.pos.y, desc.pos.z, 1.0f);
+    dirty_.push_back(1);
+    instances_.push_back({});
+    world_.push_back(XMMatrixTranslation(desc.pos.x, desc.pos.y, desc.pos.z));
+    boundsMin_.push_back(point);
+    boundsMax_.push_back(point);
+    bounds_.Resize((size_t)index + 1);
+    bounds_.Set(index, point, point);
+
+    return { slot, slotGeneration_[slot] };
+}
+
+bool InstanceStore::IsValid(InstanceHandle handle) const {
+    return handle.slot < slotIndex_.size() && slotIndex_[handle.slot] >= 0 && slotGeneration_[handle.slot] == handle.generation;
+}
+
+int InstanceStore::Remove(InstanceHandle handle) {
+    if (!IsValid(handle)) {
+        return -1;
+    }
+
+    int index = slotIndex_[handle.slot];
+    int last = Size() - 1;
+    if (index != last) {
+        posX_[index] = posX_[last];
+        posY_[index] = posY_[last];
+        posZ_[index] = posZ_[last];
+        spin_[index] = spin_[last];
+        shine_[index] = shine_[last];
+        textureId_[index] = textureId_[last];
+        normalMap_[index] = normalMap_[last];
+        // The moved instance has to be uploaded at its new index
+        dirty_[index] = 1;
+        instances_[index] = instances_[last];
+        world_[index] = world_[last];
+        boundsMin_[index] = boundsMin_[last];
+        boundsMax_[index] = boundsMax_[last];
+        bounds_.Set(index, boundsMin_[index], boundsMax_[index]);
+        indexSlot_[index] = indexSlot_[last];
+        slotIndex_[indexSlot_[index]] = index;
+    }
+
+    posX_.pop_back();
+    posY_.pop_back();
+    posZ_.pop_back();
+    spin_.pop_back();
+    shine_.pop_back();
+    textureId_.pop_back();
+    normalMap_.pop_back();
+    dirty_.pop_back();
+    instances_.pop_back();
+    world_.pop_back();
+    boundsMin_.pop_back();
+    boundsMax_.pop_back();
+    bounds_.Resize(last);
+    indexSlot_.pop_back();
+
+    slotIndex_[handle.slot] = -1;
+    slotGeneration_[handle.slot]++;
+    freeSlots_.push_back(handle.slot);
+    return index != last ? index : -1;
+}
+
+void InstanceStore::Clear() {
+    *this = InstanceStore();
+}
+
+void InstanceStore::ClearDirty(int first, int count) {
+    std::fill(dirty_.begin() + first, dirty_.begin() + first + count, 0);
+}
+
+void InstanceStore::MarkAllDirty() {
+    std::fill(dirty_.begin(), dirty_.end(), 1);
+}
+
+void InstanceStore::UpdateTransforms(float t, int first, int count) {
+    char* dirty = dirty_.data();
+    InstanceData* instances = instances_.data();
+    XMMATRIX* world = world_.data();
+    if (batchedTransforms_) {
+        int run = first;
+        for (int i = first; i <= first + count; i++) {
+            if (i < first + count && (dirty[i] || spin_[i] != 0.0f)) {
+                dirty[i] = 1;
+                continue;
+            }
+            if (run < i) {
+                PackSpinInstances(t, posX_.data(), posY_.data(), posZ_.data(), spin_.data(), shine_.data(), textureId_.data(),
+                    normalMap_.data(), run, i - run, instances, world);
+            }
+            run = i + 1;
+        }
+        return;
+    }
+
+    for (int i = first; i < first + count; i++) {
+        if (!dirty[i] && spin_[i] == 0.0f) {
+            continue;
+        }
+        dirty[i] = 1;
+        XMVECTOR rotation = XMQuaternionRotationRollPitchYaw(0.0f, t * spin_[i], 0.0f);
+        PackInstance(XMVectorSet(posX_[i], posY_[i], posZ_[i], 1.0f), 1.0f, rotation, shine_[i], textureId_[i], normalMap_[i] != 0,
+            instances[i]);
+        // Bounds and occlusion use the quantized transform the GPU will draw
+        world[i] = UnpackInstance(instances[i]);
+    }
+}
+
+void InstanceStore::UpdateBounds(const XMFLOAT4& localMin, const XMFLOAT4& localMax, int first, int count) {
+    int run = first;
+    for (int i = first; i <= first + count; i++) {
+        if (i < first + count && dirty_[i]) {
+            continue;
+        }
+        if (run < i) {
+            TransformAABBStream(localMin, localMax, world_.data(), sizeof(XMMATRIX), run, i - run, boundsMin_.data(), boundsMax_.data(),
+                bounds_);
+        }
+        run = i + 1;
+    }
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "MathCommon.h"
+#include "Frustum.h"
+#include "InstanceFormat.h"
+#include "AlignedAllocator.h"
+#include <vector>
+
+// Stays valid while the instance lives, the generation tells a reused slot from the removed instance
+struct InstanceHandle {
+    UINT slot;
+    UINT generation;
+};
+
+struct InstanceDesc {
+    XMFLOAT3 pos;
+    float spin;      // rotation speed around Y, radians per second
+    float shine;
+    UINT textureId;
+    bool normalMap;
+};
+
+// Structure-of-arrays storage of the instances: every per-frame pass streams only the columns it uses.
+// Instances are dense in [0, Size()), Remove moves the last instance into the freed index and handles follow it.
+// Next to the description the store keeps what the passes derive from it: the packed instance, the world matrix
+// and the world bounds, and a dirty flag for every instance changed since it was last uploaded
+class InstanceStore {
+public:
+    InstanceStore() = default;
+
+    InstanceHandle Add(const InstanceDesc& desc);
+    // Returns the index the last instance was moved to, or -1 if nothing moved or the handle is stale.
+    // The moved instance is dirty
+    int Remove(InstanceHandle handle);
+    void Clear();
+    bool IsValid(InstanceHandle handle) const;
+    // Dense index of the instance, -1 for a stale handle
+    int GetIndex(InstanceHandle handle) const { return IsValid(handle) ? slotIndex_[handle.slot] : -1; };
+    InstanceHandle GetHandle(int index) const { return { indexSlot_[index], slotGeneration_[indexSlot_[index]] }; };
+    int Size() const { return (int)posX_.size(); };
+
+    XMFLOAT3 GetPosition(int index) const { return XMFLOAT3(posX_[index], posY_[index], posZ_[index]); };
+    const BoxStreams& GetBounds() const { return bounds_; };
+    const XMFLOAT4* GetBoundsMin() const { return boundsMin_.data(); };
+    const XMFLOAT4* GetBoundsMax() const { return boundsMax_.data(); };
+    const InstanceData* GetInstances() const { return instances_.data(); };
+    const XMMATRIX* GetWorld() const { return world_.data(); };
+
+    const char* GetDirty() const { return dirty_.data(); };
+    void ClearDirty(int first, int count);
+    // After the GPU copies were lost, e.g. on reallocated buffers
+    void MarkAllDirty();
+
+    // Rebuilds the packed instance and world matrix of instances [first, first + count) that spin or are dirty
+    // and marks them dirty, reads positions, spins and materials
+    void UpdateTransforms(float t, int first, int count);
+    // Runs of instances go through PackSpinInstances instead of one quaternion and matrix product per instance
+    void SetBatchedTransforms(bool batched) { batchedTransforms_ = batched; };
+    bool GetBatchedTransforms() const { return batchedTransforms_; };
+    // Transforms the local box by the world matrices of dirty instances of [first, first + count), in runs,
+    // into both bounds layouts
+    void UpdateBounds(const XMFLOAT4& localMin, const XMFLOAT4& localMax, int first, int count);
+
+    ~InstanceStore() = default;
+private:
+    AlignedVector<float> posX_, posY_, posZ_;
+    AlignedVector<float> spin_;
+    AlignedVector<float> shine_;
+    AlignedVector<UINT> textureId_;
+    std::vector<char> normalMap_;
+    bool batchedTransforms_ = true;
+
+    std::vector<char> dirty_;
+    std::vector<InstanceData> instances_;
+    AlignedVector<XMMATRIX> world_;
+    AlignedVector<XMFLOAT4> boundsMin_, boundsMax_;
+    BoxStreams bounds_;
+
+    std::vector<UINT> indexSlot_;      // slot of the handle of every dense index
+    std::vector<int> slotIndex_;       // dense index of every slot, -1 for free slots
+    std::vector<UINT> slotGeneration_;
+    std::vector<UINT> freeSlots_;
+};
@@ -0,0 +1,124 @@
+#include "JobSystem.h"
+
+JobSystem::JobSystem(int threadCount):
+    pendingJobs_(0) {
+    if (threadCount <= 0) {
+        threadCount = (int)std::thread::hardware_concurrency();
+    }
+    if (threadCount <= 0) {
+        threadCount = 1;
+    }
+
+    for (int i = 0; i < threadCount; i++) {
+        queues_.push_back(new WorkQueue);
+    }
+    // Worker 0 is whichever thread calls ParallelFor
+    for (int i = 1; i < threadCount; i++) {
+        threads_.emplace_back(&JobSystem::WorkerLoop, this, i);
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        stop_ = true;
+    }
+    wakeCondition_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+    for (auto queue : queues_) {
+        delete queue;
+    }
+}
+
+void JobSystem::ParallelFor(int count, int chunkSize, const RangeFunc& func) {
+    if (count <= 0) {
+        return;
+    }
+    if (chunkSize <= 0) {
+        chunkSize = 1;
+    }
+    int chunkCount = (count + chunkSize - 1) / chunkSize;
+    // Callers may index per-chunk outputs by begin / chunkSize, so a single worker still goes chunk by chunk
+    if (chunkCount == 1 || queues_.size() == 1) {
+        for (int begin = 0; begin < count; begin += chunkSize) {
+            func(begin, begin + chunkSize < count ? begin + chunkSize : count, 0);
+        }
+        return;
+    }
+
+    // Chunks are dealt round-robin so every worker starts on its own queue
+    std::atomic<int> remaining(chunkCount);
+    int workerCount = (int)queues_.size();
+    for (int w = 0; w < workerCount; w++) {
+        std::lock_guard<std::mutex> lock(queues_[w]->mutex);
+        for (int c = w; c < chunkCount; c += workerCount) {
+            int begin = c * chunkSize;
+            int end = begin + chunkSize < count ? begin + chunkSize : count;
+            queues_[w]->jobs.push_back({ &func, begin, end, &remaining });
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        pendingJobs_ += chunkCount;
+    }
+    wakeCondition_.notify_all();
+
+    while (remaining.load(std::memory_order_acquire) > 0) {
+        if (!TryRunJob(0)) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+bool JobSystem::PopJob(int worker, Job& job) {
+    WorkQueue& queue = *queues_[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.jobs.empty()) {
+        return false;
+    }
+    job = queue.jobs.back();
+    queue.jobs.pop_back();
+    return true;
+}
+
+bool JobSystem::StealJob(int worker, Job& job) {
+    int workerCount = (int)queues_.size();
+    for (int i = 1; i < workerCount; i++) {
+        WorkQueue& queue = *queues_[(worker + i) % workerCount];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.jobs.empty()) {
+            job = queue.jobs.front();
+            queue.jobs.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool JobSystem::TryRunJob(int worker) {
+    Job job;
+    if (!PopJob(worker, job) && !StealJob(worker, job)) {
+        return false;
+    }
+
+    pendingJobs_.fetch_sub(1, std::memory_order_relaxed);
+    (*job.func)(job.begin, job.end, worker);
+    job.remaining->fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+void JobSystem::WorkerLoop(int worker) {
+    while (true) {
+        if (TryRunJob(worker)) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(wakeMutex_);
+        wakeCondition_.wait(lock, [this] { return stop_ || pendingJobs_.load() > 0; });
+        if (stop_) {
+            return;
+        }
+    }
+}
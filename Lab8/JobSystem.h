@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Pool of worker threads with one job deque per worker; idle workers steal from the others
+class JobSystem {
+public:
+    // Function called for the range [begin, end) on the worker with index worker
+    typedef std::function<void(int begin, int end, int worker)> RangeFunc;
+
+    JobSystem(int threadCount = 0); // 0 - one thread per hardware core
+
+    // Splits [0, count) into chunks of chunkSize and runs them on all workers, the calling thread takes part
+    // as worker 0 and the call returns when every chunk is done
+    void ParallelFor(int count, int chunkSize, const RangeFunc& func);
+    int GetWorkerCount() const { return (int)queues_.size(); };
+
+    ~JobSystem();
+private:
+    struct Job {
+        const RangeFunc* func;
+        int begin;
+        int end;
+        std::atomic<int>* remaining;
+    };
+
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    void WorkerLoop(int worker);
+    bool TryRunJob(int worker);
+    bool PopJob(int worker, Job& job);
+    bool StealJob(int worker, Job& job);
+
+    std::vector<WorkQueue*> queues_;
+    std::vector<std::thread> threads_;
+    std::mutex wakeMutex_;
+    std::condition_variable wakeCondition_;
+    std::atomic<int> pendingJobs_;
+    bool stop_ = false;
+};
@@ -3,12 +3,15 @@
 
 #include "Lab8.h"
 #include "Renderer.h"
+#include "D3D11RenderDevice.h"
+#include "Input.h"
 
 #define MAX_LOADSTRING 100
 
 HINSTANCE hInst;                                  // текущий экземпляр
 WCHAR szTitle[MAX_LOADSTRING];                    // текст строки заголовка
 WCHAR szWindowClass[MAX_LOADSTRING];              // имя класса главного окна
+Input input;
 
 ATOM                 MyRegisterClass(HINSTANCE hInstance);
 BOOL                 InitInstance(HINSTANCE, int);
@@ -57,6 +60,7 @@ int APIENTRY wWinMain(_In_ HINSTANCE     hInstance,
             if (WM_QUIT == msg.message)
                 exit = true;
         }
+        renderer.MoveCamera(input.ReadMouse(), input.ReadKeyboard());
         renderer.Render();
     }
 
@@ -98,8 +102,16 @@ BOOL InitInstance(HINSTANCE hInstance, int nCmdShow) {
     SetForegroundWindow(hWnd);
     SetFocus(hWnd);
 
+    D3D11RenderDevice* pDevice = new D3D11RenderDevice;
+    if (FAILED(pDevice->Init(hWnd, Renderer::defaultWidth, Renderer::defaultHeight))) {
+        delete pDevice;
+        return FALSE;
+    }
     Renderer& renderer = Renderer::GetInstance();
-    if (!renderer.Init(hInstance, hWnd)) {
+    if (!renderer.Init(pDevice)) {
+        return FALSE;
+    }
+    if (FAILED(input.Init(hInstance, hWnd))) {
         return FALSE;
     }
 
@@ -1,13 +1,27 @@
 #include "Macros.h"
 
 struct LIGHT {
-    float4 lightPos;
+    float4 lightPos; // w - range
     float4 lightColor;
 };
 
 cbuffer LightBuffer : register (b2) {
     float4 cameraPos;
+    // x - lights, y - normal maps, z - show normals, w - per-instance light lists
     int4 lightParams;
-    LIGHT lights[MAX_LIGHT];
-    float4 ambientColor;;
-};
\ No newline at end of file
+    float4 cameraDir;
+    // x, y - screen tiles, z - depth slices
+    int4 clusterParams;
+    // slice = log(depth) * x + y, z, w - tiles per pixel
+    float4 clusterDepth;
+    // L2 harmonics of the sky irradiance from SkyIrradiance.cpp
+    float4 ambientSH[9];
+};
+
+StructuredBuffer<LIGHT> lights : register (t4);
+// Offset in clusterLights and light count of every cluster
+StructuredBuffer<uint2> clusterRanges : register (t5);
+StructuredBuffer<uint> clusterLights : register (t6);
+// Offset in instanceLights and light count of every instance
+StructuredBuffer<uint2> instanceLightRanges : register (t7);
+StructuredBuffer<uint> instanceLights : register (t8);
@@ -1,33 +1,73 @@
 #include "Light.h"
 
-float3 CalculateColor(in float3 objColor, in float3 objNormal, in float3 pos, in float shine, in bool transparent) {
-    float3 finalColor = float3(0, 0, 0);
+// Cluster of LightClusters.cpp the pixel falls into
+uint FindCluster(in float2 screenPos, in float3 pos) {
+    float depth = max(dot(pos - cameraPos.xyz, cameraDir.xyz), 1e-6);
+    uint2 tile = min(uint2(screenPos * clusterDepth.zw), uint2(clusterParams.xy - 1));
+    uint slice = (uint)clamp((int)(log(depth) * clusterDepth.x + clusterDepth.y), 0, clusterParams.z - 1);
+    return (slice * clusterParams.y + tile.y) * clusterParams.x + tile.x;
+}
 
-    if (lightParams.z > 0) {
-        return float3(objNormal * 0.5 + float3(0.5, 0.5, 0.5));
+// Diffuse light of the sky for the normal, the same sum as SkyIrradiance::EvaluateSH
+float3 AmbientLight(in float3 normal) {
+    float3 n = normalize(normal);
+    float3 color = ambientSH[0].xyz + ambientSH[1].xyz * n.y + ambientSH[2].xyz * n.z + ambientSH[3].xyz * n.x +
+        ambientSH[4].xyz * (n.x * n.y) + ambientSH[5].xyz * (n.y * n.z) + ambientSH[6].xyz * (3.0 * n.z * n.z - 1.0) +
+        ambientSH[7].xyz * (n.x * n.z) + ambientSH[8].xyz * (n.x * n.x - n.y * n.y);
+    return max(color, float3(0, 0, 0));
+}
+
+float3 CalculateLight(in LIGHT light, in float3 objColor, in float3 objNormal, in float3 pos, in float shine, in bool transparent) {
+    float3 norm = objNormal;
+
+    float3 lightDir = light.lightPos.xyz - pos;
+    float lightDist = length(lightDir);
+    if (lightDist > light.lightPos.w) {
+        return float3(0, 0, 0);
     }
+    lightDir /= lightDist;
 
-    [unroll]
-    for (int i = 0; i < lightParams.x; i++) {
-        float3 norm = objNormal;
+    // Fades out towards the range
+    float window = saturate(1.0 - pow(lightDist / light.lightPos.w, 4));
+    window *= window;
+    float atten = clamp(1.0 / (lightDist * lightDist), 0, 1) * window;
 
-        float3 lightDir = lights[i].lightPos.xyz - pos;
-        float lightDist = length(lightDir);
-        lightDir /= lightDist;
+    if (transparent && dot(lightDir, objNormal) < 0.0) {
+        norm = -norm;
+    }
+    float3 color = objColor * max(dot(lightDir, norm), 0) * atten * light.lightColor.xyz;
 
-        float atten = clamp(1.0 / (lightDist * lightDist), 0, 1);
+    float3 viewDir = normalize(cameraPos.xyz - pos);
+    float3 reflectDir = reflect(-lightDir, norm);
+    float spec = shine > 0 ? pow(max(dot(viewDir, reflectDir), 0.0), shine.x) : 0.0;
 
-        if (transparent && dot(lightDir, objNormal) < 0.0) {
-            norm = -norm;
-        }
-        finalColor += objColor * max(dot(lightDir, norm), 0) * atten * lights[i].lightColor.xyz;
+    return color + objColor * spec * window * light.lightColor.xyz;
+}
 
-        float3 viewDir = normalize(cameraPos.xyz - pos);
-        float3 reflectDir = reflect(-lightDir, norm);
-        float spec = shine > 0 ? pow(max(dot(viewDir, reflectDir), 0.0), shine.x) : 0.0;
+// Lights of the cluster of the pixel
+float3 CalculateColor(in float3 objColor, in float3 objNormal, in float3 pos, in float2 screenPos, in float shine, in bool transparent) {
+    if (lightParams.z > 0) {
+        return float3(objNormal * 0.5 + float3(0.5, 0.5, 0.5));
+    }
+
+    float3 finalColor = float3(0, 0, 0);
+    uint2 range = clusterRanges[FindCluster(screenPos, pos)];
+    for (uint j = 0; j < range.y; j++) {
+        finalColor += CalculateLight(lights[clusterLights[range.x + j]], objColor, objNormal, pos, shine, transparent);
+    }
+    return finalColor;
+}
 
-        finalColor += objColor * spec * lights[i].lightColor.xyz;
+// Lights of the list of the instance
+float3 CalculateInstanceColor(in float3 objColor, in float3 objNormal, in float3 pos, in uint instanceId, in float shine) {
+    if (lightParams.z > 0) {
+        return float3(objNormal * 0.5 + float3(0.5, 0.5, 0.5));
     }
 
+    float3 finalColor = float3(0, 0, 0);
+    uint2 range = instanceLightRanges[instanceId];
+    for (uint j = 0; j < range.y; j++) {
+        finalColor += CalculateLight(lights[instanceLights[range.x + j]], objColor, objNormal, pos, shine, false);
+    }
     return finalColor;
 }
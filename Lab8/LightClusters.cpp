@@ -0,0 +1,104 @@
+#include "LightClusters.h"
+
+LightClusters::LightClusters(int countX, int countY, int countZ):
+    countX_(countX),
+    countY_(countY),
+    countZ_(countZ),
+    view_(XMMatrixIdentity()) {
+    ranges_.assign(GetClusterCount(), XMUINT2(0, 0));
+}
+
+void LightClusters::SetView(FXMMATRIX view, float fovY, float aspect, float nearZ, float farZ) {
+    view_ = view;
+    tanHalfY_ = tanf(fovY * 0.5f);
+    tanHalfX_ = tanHalfY_ * aspect;
+    nearZ_ = nearZ;
+    farZ_ = farZ;
+    sliceScale_ = countZ_ / logf(farZ / nearZ);
+    sliceBias_ = -logf(nearZ) * sliceScale_;
+}
+
+float LightClusters::LightRange(const XMFLOAT4& color) {
+    float brightest = max(max(color.x, color.y), color.z);
+    return sqrtf(max(brightest, 0.0f) * 256.0f);
+}
+
+int LightClusters::FindCluster(float viewDepth, float u, float v) const {
+    if (viewDepth < nearZ_ || viewDepth >= farZ_) {
+        return -1;
+    }
+    int x = min(max((int)(u * countX_), 0), countX_ - 1);
+    int y = min(max((int)(v * countY_), 0), countY_ - 1);
+    int z = min(max((int)(logf(viewDepth) * sliceScale_ + sliceBias_), 0), countZ_ - 1);
+    return (z * countY_ + y) * countX_ + x;
+}
+
+void LightClusters::Build(const Light* pLights, int count, const int* ids) {
+    pairs_.clear();
+    float logRatio = logf(farZ_ / nearZ_);
+
+    for (int k = 0; k < count; k++) {
+        int i = ids ? ids[k] : k;
+        float range = pLights[i].pos.w;
+        if (range <= 0.0f) {
+            continue;
+        }
+        XMFLOAT3 center;
+        XMStoreFloat3(&center, XMVector3TransformCoord(XMVectorSet(pLights[i].pos.x, pLights[i].pos.y, pLights[i].pos.z, 1.0f), view_));
+        float zMin = max(center.z - range, nearZ_);
+        float zMax = min(center.z + range, farZ_);
+        if (zMin >= zMax) {
+            continue;
+        }
+
+        int sliceMin = min(max((int)(logf(zMin) * sliceScale_ + sliceBias_), 0), countZ_ - 1);
+        int sliceMax = min(max((int)(logf(zMax) * sliceScale_ + sliceBias_), 0), countZ_ - 1);
+        for (int z = sliceMin; z <= sliceMax; z++) {
+            // The sphere within the slab of the slice, its cross section is largest at the depth nearest to the center
+            float slabNear = max(nearZ_ * expf(logRatio * z / countZ_), zMin);
+            float slabFar = min(nearZ_ * expf(logRatio * (z + 1) / countZ_), zMax);
+            float dz = center.z < slabNear ? slabNear - center.z : (center.z > slabFar ? center.z - slabFar : 0.0f);
+            float radius = sqrtf(max(range * range - dz * dz, 0.0f));
+
+            // Screen extent of the box around that cross section over the depths of the slab
+            float x0 = center.x - radius, x1 = center.x + radius;
+            float y0 = center.y - radius, y1 = center.y + radius;
+            float left = min(x0 / slabNear, x0 / slabFar) / tanHalfX_;
+            float right = max(x1 / slabNear, x1 / slabFar) / tanHalfX_;
+            float bottom = min(y0 / slabNear, y0 / slabFar) / tanHalfY_;
+            float top = max(y1 / slabNear, y1 / slabFar) / tanHalfY_;
+            if (left > 1.0f || right < -1.0f || bottom > 1.0f || top < -1.0f) {
+                continue;
+            }
+
+            int tileLeft = min(max((int)((left * 0.5f + 0.5f) * countX_), 0), countX_ - 1);
+            int tileRight = min(max((int)((right * 0.5f + 0.5f) * countX_), 0), countX_ - 1);
+            int tileTop = min(max((int)((0.5f - top * 0.5f) * countY_), 0), countY_ - 1);
+            int tileBottom = min(max((int)((0.5f - bottom * 0.5f) * countY_), 0), countY_ - 1);
+            for (int y = tileTop; y <= tileBottom; y++) {
+                for (int x = tileLeft; x <= tileRight; x++) {
+                    pairs_.push_back(XMUINT2((UINT)((z * countY_ + y) * countX_ + x), (UINT)i));
+                }
+            }
+        }
+    }
+
+    // Counting sort by cluster, lights stay in order within a cluster
+    for (XMUINT2& range : ranges_) {
+        range = XMUINT2(0, 0);
+    }
+    for (const XMUINT2& pair : pairs_) {
+        ranges_[pair.x].y++;
+    }
+    UINT offset = 0;
+    for (XMUINT2& range : ranges_) {
+        range.x = offset;
+        offset += range.y;
+        range.y = 0;
+    }
+    lightIndices_.resize(offset);
+    for (const XMUINT2& pair : pairs_) {
+        XMUINT2& range = ranges_[pair.x];
+        lightIndices_[range.x + range.y++] = pair.y;
+    }
+}
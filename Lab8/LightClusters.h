@@ -0,0 +1,47 @@
+#pragma once
+
+#include "MathCommon.h"
+#include "Lighting.h"
+#include <vector>
+
+// Froxel grid of the view frustum: countX x countY screen tiles and countZ slices, exponential in view depth
+// between near and far. Build bins every light, pos.w being its range, into the clusters its sphere may touch,
+// every cluster gets a range of the light index list. Indices of a cluster keep the order the lights are given in
+class LightClusters {
+public:
+    LightClusters(int countX, int countY, int countZ);
+
+    void SetView(FXMMATRIX view, float fovY, float aspect, float nearZ, float farZ);
+    // Bins the lights ids[0..count), or the first count lights if ids is null
+    void Build(const Light* pLights, int count, const int* ids = nullptr);
+
+    int GetClusterCount() const { return countX_ * countY_ * countZ_; };
+    // Cluster of a view space point and a position on the screen in [0, 1] from the top left corner, -1 outside the slices
+    int FindCluster(float viewDepth, float u, float v) const;
+    // Offset in GetLightIndices and light count of every cluster
+    const std::vector<XMUINT2>& GetRanges() const { return ranges_; };
+    const std::vector<UINT>& GetLightIndices() const { return lightIndices_; };
+    // slice = log(viewDepth) * scale + bias
+    float GetSliceScale() const { return sliceScale_; };
+    float GetSliceBias() const { return sliceBias_; };
+
+    // Default range of a light, where its 1 / d^2 attenuated diffuse term falls below 1/256 of its brightest channel
+    static float LightRange(const XMFLOAT4& color);
+
+    ~LightClusters() = default;
+private:
+    int countX_;
+    int countY_;
+    int countZ_;
+    XMMATRIX view_;
+    float tanHalfX_ = 1.0f;
+    float tanHalfY_ = 1.0f;
+    float nearZ_ = 0.1f;
+    float farZ_ = 100.0f;
+    float sliceScale_ = 1.0f;
+    float sliceBias_ = 0.0f;
+
+    std::vector<XMUINT2> ranges_;
+    std::vector<UINT> lightIndices_;
+    std::vector<XMUINT2> pairs_; // cluster and light of every binned pair
+};
@@ -0,0 +1,115 @@
+#include "LightManager.h"
+#include <algorithm>
+
+LightManager::LightManager(float worldHalfSize):
+    octree_(XMFLOAT3(0.0f, 0.0f, 0.0f), worldHalfSize, 8) {}
+
+int LightManager::Add(const Light& light) {
+    int index = (int)lights_.size();
+    lights_.push_back(light);
+    dirty_.push_back(0);
+    UpdateBounds(index);
+    MarkDirty(index);
+    return index;
+}
+
+void LightManager::Remove(int index) {
+    int last = (int)lights_.size() - 1;
+    if (index < 0 || index > last) {
+        return;
+    }
+    octree_.Remove(last);
+    if (index != last) {
+        lights_[index] = lights_[last];
+        UpdateBounds(index);
+        MarkDirty(index);
+    }
+    lights_.pop_back();
+    dirty_.pop_back();
+}
+
+void LightManager::Clear() {
+    octree_.Clear();
+    lights_.clear();
+    dirty_.clear();
+    dirtyList_.clear();
+}
+
+void LightManager::SetPosition(int index, const XMFLOAT3& pos) {
+    Light& light = lights_[index];
+    light.pos = XMFLOAT4(pos.x, pos.y, pos.z, light.pos.w);
+    UpdateBounds(index);
+    MarkDirty(index);
+}
+
+void LightManager::SetColor(int index, const XMFLOAT4& color) {
+    lights_[index].color = color;
+    MarkDirty(index);
+}
+
+void LightManager::SetRange(int index, float range) {
+    lights_[index].pos.w = range;
+    UpdateBounds(index);
+    MarkDirty(index);
+}
+
+void LightManager::MarkDirty(int index) {
+    if (!dirty_[index]) {
+        dirty_[index] = 1;
+        dirtyList_.push_back(index);
+    }
+}
+
+void LightManager::UpdateBounds(int index) {
+    const XMFLOAT4& pos = lights_[index].pos;
+    float range = max(pos.w, 0.0f);
+    octree_.Move(index, XMFLOAT4(pos.x - range, pos.y - range, pos.z - range, 1.0f),
+        XMFLOAT4(pos.x + range, pos.y + range, pos.z + range, 1.0f));
+}
+
+int LightManager::QueryBox(const XMFLOAT4& bbMin, const XMFLOAT4& bbMax, int* ids) {
+    candidates_.resize(lights_.size());
+    int found = octree_.QueryBox(bbMin, bbMax, candidates_.data());
+    int count = 0;
+    for (int i = 0; i < found; i++) {
+        const XMFLOAT4& pos = lights_[candidates_[i]].pos;
+        float dx = max(max(bbMin.x - pos.x, pos.x - bbMax.x), 0.0f);
+        float dy = max(max(bbMin.y - pos.y, pos.y - bbMax.y), 0.0f);
+        float dz = max(max(bbMin.z - pos.z, pos.z - bbMax.z), 0.0f);
+        if (dx * dx + dy * dy + dz * dz <= pos.w * pos.w) {
+            ids[count++] = candidates_[i];
+        }
+    }
+    return count;
+}
+
+void LightManager::MarkAllDirty() {
+    dirtyList_.resize(lights_.size());
+    for (int i = 0; i < (int)lights_.size(); i++) {
+        dirty_[i] = 1;
+        dirtyList_[i] = i;
+    }
+}
+
+void LightManager::TakeDirtyRuns(std::vector<XMUINT2>& runs) {
+    // Removed lights may have left indices past the end, and a light added again at such an index is listed twice
+    std::sort(dirtyList_.begin(), dirtyList_.end());
+    dirtyList_.erase(std::unique(dirtyList_.begin(), dirtyList_.end()), dirtyList_.end());
+    for (size_t i = 0; i < dirtyList_.size();) {
+        int first = dirtyList_[i];
+        if (first >= (int)lights_.size()) {
+            break;
+        }
+        int last = first;
+        while (++i < dirtyList_.size() && dirtyList_[i] == last + 1 && dirtyList_[i] < (int)lights_.size()) {
+            last++;
+        }
+        runs.push_back(XMUINT2((UINT)first, (UINT)(last - first + 1)));
+    }
+    for (int index : dirtyList_) {
+        if (index < (int)dirty_.size()) {
+            dirty_[index] = 0;
+        }
+    }
+    dirtyList_.clear();
+}
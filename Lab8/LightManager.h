@@ -0,0 +1,47 @@
+#pragma once
+
+#include "MathCommon.h"
+#include "Frustum.h"
+#include "Lighting.h"
+#include "LooseOctree.h"
+#include <vector>
+
+// Dense array of point lights with a loose octree over the boxes of their spheres, pos.w being the range.
+// The setters keep the octree current and mark lights dirty, so the renderer uploads only runs of changed lights.
+// Remove moves the last light into the freed index, as InstanceStore does with instances
+class LightManager {
+public:
+    LightManager(float worldHalfSize);
+
+    int Add(const Light& light);
+    void Remove(int index);
+    void Clear();
+    void SetPosition(int index, const XMFLOAT3& pos);
+    void SetColor(int index, const XMFLOAT4& color);
+    void SetRange(int index, float range);
+
+    int Size() const { return (int)lights_.size(); };
+    const Light& Get(int index) const { return lights_[index]; };
+    const Light* GetData() const { return lights_.data(); };
+
+    // Lights whose sphere touches the box, ids must have room for Size() entries
+    int QueryBox(const XMFLOAT4& bbMin, const XMFLOAT4& bbMax, int* ids);
+    // Lights whose sphere box is not outside the frustum
+    int QueryFrustum(Frustum& frustum, int* ids) { return octree_.QueryFrustum(frustum, ids); };
+
+    // Appends the runs [x, x + y) of lights changed since the last call and clears the marks
+    void TakeDirtyRuns(std::vector<XMUINT2>& runs);
+    // Marks every light, for a consumer that lost what was uploaded before
+    void MarkAllDirty();
+
+    ~LightManager() = default;
+private:
+    void MarkDirty(int index);
+    void UpdateBounds(int index);
+
+    LooseOctree octree_;
+    std::vector<Light> lights_;
+    std::vector<char> dirty_;
+    std::vector<int> dirtyList_;
+    std::vector<int> candidates_;
+};
@@ -0,0 +1,160 @@
+#include "Lighting.h"
+#include <cfloat>
+
+XMFLOAT3 CalculateColor(const LightingParams& params, const XMFLOAT3& objColor, const XMFLOAT3& objNormal, const XMFLOAT3& pos,
+    float shine, bool transparent) {
+    XMVECTOR normal = XMLoadFloat3(&objNormal);
+    XMFLOAT3 result;
+    if (params.showNormals) {
+        XMStoreFloat3(&result, XMVectorMultiplyAdd(normal, XMVectorReplicate(0.5f), XMVectorReplicate(0.5f)));
+        return result;
+    }
+
+    XMVECTOR color = XMLoadFloat3(&objColor);
+    XMVECTOR position = XMLoadFloat3(&pos);
+    XMVECTOR viewDir = XMVector3Normalize(XMVectorSubtract(XMLoadFloat3(&params.cameraPos), position));
+    XMVECTOR finalColor = XMVectorZero();
+    for (int i = 0; i < params.lightCount; i++) {
+        XMVECTOR norm = normal;
+
+        XMVECTOR lightDir = XMVectorSubtract(XMLoadFloat4(&params.pLights[i].pos), position);
+        lightDir = XMVectorSetW(lightDir, 0.0f);
+        float lightDist = XMVectorGetX(XMVector3Length(lightDir));
+        if (lightDist > params.pLights[i].pos.w) {
+            continue;
+        }
+        lightDir = XMVectorScale(lightDir, 1.0f / lightDist);
+
+        float ratio = lightDist / params.pLights[i].pos.w;
+        float window = 1.0f - ratio * ratio * ratio * ratio;
+        window = window > 0.0f ? window * window : 0.0f;
+        float atten = 1.0f / (lightDist * lightDist);
+        atten = (atten > 1.0f ? 1.0f : atten) * window;
+
+        float diffuse = XMVectorGetX(XMVector3Dot(lightDir, norm));
+        if (transparent && diffuse < 0.0f) {
+            norm = XMVectorNegate(norm);
+            diffuse = -diffuse;
+        }
+        XMVECTOR lightColor = XMLoadFloat4(&params.pLights[i].color);
+        finalColor = XMVectorAdd(finalColor, XMVectorScale(XMVectorMultiply(color, lightColor), (diffuse > 0.0f ? diffuse : 0.0f) * atten));
+
+        XMVECTOR reflectDir = XMVector3Reflect(XMVectorNegate(lightDir), norm);
+        float spec = 0.0f;
+        if (shine > 0.0f) {
+            float cosAngle = XMVectorGetX(XMVector3Dot(viewDir, reflectDir));
+            spec = powf(cosAngle > 0.0f ? cosAngle : 0.0f, shine);
+        }
+        finalColor = XMVectorAdd(finalColor, XMVectorScale(XMVectorMultiply(color, lightColor), spec * window));
+    }
+    XMStoreFloat3(&result, finalColor);
+    return result;
+}
+
+void CalculateColor8(const LightingParams& params, const ShadingSamples& samples, bool transparent, ShadedColors& colors) {
+    const XMVECTOR zero = XMVectorZero();
+    const XMVECTOR one = XMVectorReplicate(1.0f);
+    XMVECTOR nx[2], ny[2], nz[2];
+    for (int h = 0; h < 2; h++) {
+        nx[h] = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(samples.normalX + h * 4));
+        ny[h] = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(samples.normalY + h * 4));
+        nz[h] = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(samples.normalZ + h * 4));
+    }
+    if (params.showNormals) {
+        const XMVECTOR half = XMVectorReplicate(0.5f);
+        for (int h = 0; h < 2; h++) {
+            XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(colors.r + h * 4), XMVectorMultiplyAdd(nx[h], half, half));
+            XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(colors.g + h * 4), XMVectorMultiplyAdd(ny[h], half, half));
+            XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(colors.b + h * 4), XMVectorMultiplyAdd(nz[h], half, half));
+        }
+        return;
+    }
+
+    XMVECTOR px[2], py[2], pz[2], vx[2], vy[2], vz[2], shine[2], hasShine[2];
+    XMVECTOR sumR[2], sumG[2], sumB[2];
+    for (int h = 0; h < 2; h++) {
+        px[h] = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(samples.posX + h * 4));
+        py[h] = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(samples.posY + h * 4));
+        pz[h] = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(samples.posZ + h * 4));
+        shine[h] = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(samples.shine + h * 4));
+        hasShine[h] = XMVectorGreater(shine[h], zero);
+
+        vx[h] = XMVectorSubtract(XMVectorReplicate(params.cameraPos.x), px[h]);
+        vy[h] = XMVectorSubtract(XMVectorReplicate(params.cameraPos.y), py[h]);
+        vz[h] = XMVectorSubtract(XMVectorReplicate(params.cameraPos.z), pz[h]);
+        XMVECTOR invLength = XMVectorReciprocal(XMVectorSqrt(
+            XMVectorMultiplyAdd(vx[h], vx[h], XMVectorMultiplyAdd(vy[h], vy[h], XMVectorMultiply(vz[h], vz[h])))));
+        vx[h] = XMVectorMultiply(vx[h], invLength);
+        vy[h] = XMVectorMultiply(vy[h], invLength);
+        vz[h] = XMVectorMultiply(vz[h], invLength);
+        sumR[h] = sumG[h] = sumB[h] = zero;
+    }
+
+    for (int i = 0; i < params.lightCount; i++) {
+        const Light& light = params.pLights[i];
+        if (light.pos.w <= 0.0f) {
+            continue;
+        }
+        XMVECTOR lightX = XMVectorReplicate(light.pos.x);
+        XMVECTOR lightY = XMVectorReplicate(light.pos.y);
+        XMVECTOR lightZ = XMVectorReplicate(light.pos.z);
+        XMVECTOR invRange = XMVectorReplicate(1.0f / light.pos.w);
+        for (int h = 0; h < 2; h++) {
+            XMVECTOR lx = XMVectorSubtract(lightX, px[h]);
+            XMVECTOR ly = XMVectorSubtract(lightY, py[h]);
+            XMVECTOR lz = XMVectorSubtract(lightZ, pz[h]);
+            XMVECTOR distSq = XMVectorMultiplyAdd(lx, lx, XMVectorMultiplyAdd(ly, ly, XMVectorMultiply(lz, lz)));
+            XMVECTOR lightDist = XMVectorSqrt(distSq);
+
+            // The window is zero at and beyond the range, which stands for the skipped lights of the scalar loop
+            XMVECTOR ratio = XMVectorMultiply(lightDist, invRange);
+            ratio = XMVectorMultiply(ratio, ratio);
+            XMVECTOR window = XMVectorMax(XMVectorSubtract(one, XMVectorMultiply(ratio, ratio)), zero);
+            window = XMVectorMultiply(window, window);
+            if (XMVector4Equal(window, zero)) {
+                continue;
+            }
+
+            XMVECTOR invDist = XMVectorReciprocal(lightDist);
+            lx = XMVectorMultiply(lx, invDist);
+            ly = XMVectorMultiply(ly, invDist);
+            lz = XMVectorMultiply(lz, invDist);
+            XMVECTOR atten = XMVectorMultiply(XMVectorMin(XMVectorReciprocal(distSq), one), window);
+
+            XMVECTOR diffuse = XMVectorMultiplyAdd(lx, nx[h], XMVectorMultiplyAdd(ly, ny[h], XMVectorMultiply(lz, nz[h])));
+            XMVECTOR normX = nx[h], normY = ny[h], normZ = nz[h];
+            if (transparent) {
+                // Back lit samples use the flipped normal
+                XMVECTOR sign = XMVectorAndInt(diffuse, XMVectorReplicate(-0.0f));
+                normX = XMVectorXorInt(normX, sign);
+                normY = XMVectorXorInt(normY, sign);
+                normZ = XMVectorXorInt(normZ, sign);
+                diffuse = XMVectorAbs(diffuse);
+            }
+            XMVECTOR intensity = XMVectorMultiply(XMVectorMax(diffuse, zero), atten);
+
+            // reflect(-l, n) = 2 * dot(l, n) * n - l, dot(l, n) is diffuse after the flip
+            XMVECTOR twoDot = XMVectorAdd(diffuse, diffuse);
+            XMVECTOR rx = XMVectorSubtract(XMVectorMultiply(twoDot, normX), lx);
+            XMVECTOR ry = XMVectorSubtract(XMVectorMultiply(twoDot, normY), ly);
+            XMVECTOR rz = XMVectorSubtract(XMVectorMultiply(twoDot, normZ), lz);
+            XMVECTOR cosAngle = XMVectorMultiplyAdd(vx[h], rx, XMVectorMultiplyAdd(vy[h], ry, XMVectorMultiply(vz[h], rz)));
+            XMVECTOR lit = XMVectorAndInt(XMVectorGreater(cosAngle, zero), hasShine[h]);
+            XMVECTOR spec = XMVectorExp2(XMVectorMultiply(shine[h], XMVectorLog2(XMVectorMax(cosAngle, XMVectorReplicate(FLT_MIN)))));
+            intensity = XMVectorAdd(intensity, XMVectorMultiply(XMVectorAndInt(spec, lit), window));
+
+            sumR[h] = XMVectorMultiplyAdd(intensity, XMVectorReplicate(light.color.x), sumR[h]);
+            sumG[h] = XMVectorMultiplyAdd(intensity, XMVectorReplicate(light.color.y), sumG[h]);
+            sumB[h] = XMVectorMultiplyAdd(intensity, XMVectorReplicate(light.color.z), sumB[h]);
+        }
+    }
+
+    for (int h = 0; h < 2; h++) {
+        XMVECTOR r = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(samples.colorR + h * 4));
+        XMVECTOR g = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(samples.colorG + h * 4));
+        XMVECTOR b = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(samples.colorB + h * 4));
+        XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(colors.r + h * 4), XMVectorMultiply(r, sumR[h]));
+        XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(colors.g + h * 4), XMVectorMultiply(g, sumG[h]));
+        XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(colors.b + h * 4), XMVectorMultiply(b, sumB[h]));
+    }
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "MathCommon.h"
+
+struct Light {
+    XMFLOAT4 pos; // w - range
+    XMFLOAT4 color;
+};
+
+struct LightingParams {
+    XMFLOAT3 cameraPos;
+    int lightCount;
+    bool showNormals;
+    const Light* pLights;
+};
+
+// CPU version of CalculateColor from LightCalc.h
+XMFLOAT3 CalculateColor(const LightingParams& params, const XMFLOAT3& objColor, const XMFLOAT3& objNormal, const XMFLOAT3& pos,
+    float shine, bool transparent);
+
+// Eight shading samples in structure-of-arrays form
+struct ShadingSamples {
+    static constexpr int count = 8;
+
+    float posX[count], posY[count], posZ[count];
+    float normalX[count], normalY[count], normalZ[count];
+    float colorR[count], colorG[count], colorB[count];
+    float shine[count];
+};
+
+struct ShadedColors {
+    float r[ShadingSamples::count], g[ShadingSamples::count], b[ShadingSamples::count];
+};
+
+// CalculateColor for eight samples at once: the lights are the outer loop and every light is applied to
+// two four-wide halves, the specular power goes through exp2(shine * log2(x)) instead of powf per sample
+void CalculateColor8(const LightingParams& params, const ShadingSamples& samples, bool transparent, ShadedColors& colors);
@@ -0,0 +1,65 @@
+#include "LodSelector.h"
+#include <cfloat>
+
+LodSelector::LodSelector(float minPixels, float reducedPixels) :
+    viewDepth_(0.0f, 0.0f, 1.0f, 0.0f),
+    minPixels_(minPixels),
+    reducedPixels_(reducedPixels) {}
+
+void LodSelector::SetView(FXMMATRIX view, CXMMATRIX projection, float viewportHeight) {
+    XMFLOAT4X4 v;
+    XMStoreFloat4x4(&v, view);
+    viewDepth_ = XMFLOAT4(v._13, v._23, v._33, v._43);
+    XMFLOAT4X4 p;
+    XMStoreFloat4x4(&p, projection);
+    // _22 is cot(fov / 2) for XMMatrixPerspectiveFovLH, reversed depth or not: a sphere of radius r at depth z
+    // covers r * _22 / z of the half viewport
+    pixelScale_ = p._22 * viewportHeight;
+}
+
+float LodSelector::ProjectedSize(const XMFLOAT4& bbMin, const XMFLOAT4& bbMax) const {
+    float cx = (bbMin.x + bbMax.x) * 0.5f;
+    float cy = (bbMin.y + bbMax.y) * 0.5f;
+    float cz = (bbMin.z + bbMax.z) * 0.5f;
+    float ex = bbMax.x - cx;
+    float ey = bbMax.y - cy;
+    float ez = bbMax.z - cz;
+    float radius = sqrtf(ex * ex + ey * ey + ez * ez);
+
+    float depth = viewDepth_.x * cx + viewDepth_.y * cy + viewDepth_.z * cz + viewDepth_.w;
+    if (depth <= radius) {
+        return FLT_MAX;
+    }
+    return radius * pixelScale_ / depth;
+}
+
+int LodSelector::SelectLod(float pixels) const {
+    if (pixels < minPixels_) {
+        return -1;
+    }
+    return pixels < reducedPixels_ ? 1 : 0;
+}
+
+int LodSelector::Select(const XMFLOAT4* boundsMin, const XMFLOAT4* boundsMax, int* indices, int count, int* lods) const {
+    int selectedCount = 0;
+    for (int i = 0; i < count; i++) {
+        int idx = indices[i];
+        int lod = SelectLod(ProjectedSize(boundsMin[idx], boundsMax[idx]));
+        if (lod >= 0) {
+            indices[selectedCount] = idx;
+            lods[selectedCount++] = lod;
+        }
+    }
+    return selectedCount;
+}
+
+UINT LodSelector::FacingOctant(FXMMATRIX world, const XMFLOAT3& cameraPos) {
+    XMVECTOR toCamera = XMVectorSubtract(XMLoadFloat3(&cameraPos), world.r[3]);
+    UINT octant = 0;
+    for (int k = 0; k < 3; k++) {
+        if (XMVectorGetX(XMVector3Dot(toCamera, world.r[k])) > 0.0f) {
+            octant |= 1u << k;
+        }
+    }
+    return octant;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "MathCommon.h"
+
+// Screen space size of instance bounds: drops instances too small to matter and picks a mesh LOD for the rest
+class LodSelector {
+public:
+    static constexpr int lodCount = 2; // 0 - full cube, 1 - only the three faces turned to the camera
+
+    LodSelector(float minPixels, float reducedPixels);
+
+    void SetView(FXMMATRIX view, CXMMATRIX projection, float viewportHeight);
+    // Diameter in pixels of the sphere around the box, FLT_MAX when the camera is inside the sphere
+    float ProjectedSize(const XMFLOAT4& bbMin, const XMFLOAT4& bbMax) const;
+    // -1 below minPixels, 1 below reducedPixels, 0 otherwise
+    int SelectLod(float pixels) const;
+    // Removes the instances below minPixels from indices keeping the order, writes the LOD of the rest to lods
+    // and returns their number
+    int Select(const XMFLOAT4* boundsMin, const XMFLOAT4* boundsMax, int* indices, int count, int* lods) const;
+    // Bit k is set if the camera is on the positive side of the local axis k of world, so the faces on that
+    // side are the visible ones
+    static UINT FacingOctant(FXMMATRIX world, const XMFLOAT3& cameraPos);
+
+    void SetThresholds(float minPixels, float reducedPixels) { minPixels_ = minPixels; reducedPixels_ = reducedPixels; };
+    float GetMinPixels() const { return minPixels_; };
+    float GetReducedPixels() const { return reducedPixels_; };
+
+    ~LodSelector() = default;
+private:
+    XMFLOAT4 viewDepth_; // third column of the view matrix, view space z = dot(viewDepth_, (x, y, z, 1))
+    float pixelScale_ = 1.0f;
+    float minPixels_;
+    float reducedPixels_;
+};
@@ -0,0 +1,200 @@
+#include "LooseOctree.h"
+
+LooseOctree::LooseOctree(const XMFLOAT3& center, float halfSize, int maxDepth):
+    center_(center),
+    halfSize_(halfSize),
+    maxDepth_(min(max(maxDepth, 0), 20)) {
+    Clear();
+}
+
+void LooseOctree::Clear() {
+    SpatialIndex::Clear();
+    nodes_.clear();
+    nodeMap_.clear();
+
+    Node root;
+    root.looseMin = XMFLOAT4(center_.x - 2.0f * halfSize_, center_.y - 2.0f * halfSize_, center_.z - 2.0f * halfSize_, 1.0f);
+    root.looseMax = XMFLOAT4(center_.x + 2.0f * halfSize_, center_.y + 2.0f * halfSize_, center_.z + 2.0f * halfSize_, 1.0f);
+    for (int& child : root.children) {
+        child = -1;
+    }
+    root.parent = -1;
+    root.subtreeCount = 0;
+    nodes_.push_back(root);
+    cellIds_.emplace_back();
+}
+
+int LooseOctree::AcquireCell(const XMFLOAT4& bbMin, const XMFLOAT4& bbMax) {
+    XMFLOAT3 center((bbMin.x + bbMax.x) * 0.5f, (bbMin.y + bbMax.y) * 0.5f, (bbMin.z + bbMax.z) * 0.5f);
+    float extent = max(max(bbMax.x - bbMin.x, bbMax.y - bbMin.y), bbMax.z - bbMin.z) * 0.5f;
+    XMFLOAT3 local(center.x - center_.x + halfSize_, center.y - center_.y + halfSize_, center.z - center_.z + halfSize_);
+
+    float rootSize = 2.0f * halfSize_;
+    bool insideCube = local.x >= 0.0f && local.x < rootSize && local.y >= 0.0f && local.y < rootSize &&
+        local.z >= 0.0f && local.z < rootSize;
+    int level = 0;
+    float cellHalf = halfSize_;
+    while (insideCube && level < maxDepth_ && cellHalf * 0.5f >= extent) {
+        level++;
+        cellHalf *= 0.5f;
+    }
+    if (level == 0) {
+        // Boxes outside the cube or larger than it are kept in the root, its bounds grow to hold them
+        Node& root = nodes_[0];
+        root.looseMin = XMFLOAT4(min(root.looseMin.x, bbMin.x), min(root.looseMin.y, bbMin.y), min(root.looseMin.z, bbMin.z), 1.0f);
+        root.looseMax = XMFLOAT4(max(root.looseMax.x, bbMax.x), max(root.looseMax.y, bbMax.y), max(root.looseMax.z, bbMax.z), 1.0f);
+        return 0;
+    }
+
+    int cellCount = 1 << level;
+    float cellSize = 2.0f * cellHalf;
+    return GetNode(level,
+        min((int)(local.x / cellSize), cellCount - 1),
+        min((int)(local.y / cellSize), cellCount - 1),
+        min((int)(local.z / cellSize), cellCount - 1));
+}
+
+// Finds the node of the cell, creating it and its missing ancestors
+int LooseOctree::GetNode(int level, int x, int y, int z) {
+    if (level == 0) {
+        return 0;
+    }
+    UINT64 key = ((UINT64)level << 60) | ((UINT64)x << 40) | ((UINT64)y << 20) | (UINT64)z;
+    auto it = nodeMap_.find(key);
+    if (it != nodeMap_.end()) {
+        return it->second;
+    }
+
+    int parent = GetNode(level - 1, x >> 1, y >> 1, z >> 1);
+    float cellHalf = halfSize_ / (float)(1 << level);
+    XMFLOAT3 cellCenter(
+        center_.x - halfSize_ + (2.0f * x + 1.0f) * cellHalf,
+        center_.y - halfSize_ + (2.0f * y + 1.0f) * cellHalf,
+        center_.z - halfSize_ + (2.0f * z + 1.0f) * cellHalf);
+
+    Node node;
+    node.looseMin = XMFLOAT4(cellCenter.x - 2.0f * cellHalf, cellCenter.y - 2.0f * cellHalf, cellCenter.z - 2.0f * cellHalf, 1.0f);
+    node.looseMax = XMFLOAT4(cellCenter.x + 2.0f * cellHalf, cellCenter.y + 2.0f * cellHalf, cellCenter.z + 2.0f * cellHalf, 1.0f);
+    for (int& child : node.children) {
+        child = -1;
+    }
+    node.parent = parent;
+    node.subtreeCount = 0;
+
+    int index = (int)nodes_.size();
+    nodes_.push_back(node);
+    cellIds_.emplace_back();
+    nodes_[parent].children[(x & 1) | ((y & 1) << 1) | ((z & 1) << 2)] = index;
+    nodeMap_[key] = index;
+    return index;
+}
+
+void LooseOctree::OnCellChanged(int cell, int delta) {
+    for (int node = cell; node >= 0; node = nodes_[node].parent) {
+        nodes_[node].subtreeCount += delta;
+    }
+}
+
+int LooseOctree::AppendSubtree(int node, int* ids) {
+    int count = 0;
+    subtreeStack_.clear();
+    subtreeStack_.push_back(node);
+    while (!subtreeStack_.empty()) {
+        int idx = subtreeStack_.back();
+        subtreeStack_.pop_back();
+        count += AppendCell(idx, ids + count);
+        for (int child : nodes_[idx].children) {
+            if (child >= 0 && nodes_[child].subtreeCount > 0) {
+                subtreeStack_.push_back(child);
+            }
+        }
+    }
+    return count;
+}
+
+int LooseOctree::QueryFrustum(Frustum& frustum, int* ids) {
+    int count = 0;
+    // Each stack entry is a node index and the planes its parent straddles
+    stack_.clear();
+    stack_.push_back(0);
+    stack_.push_back((int)Frustum::allPlanes);
+    while (!stack_.empty()) {
+        UINT planeMask = (UINT)stack_.back();
+        stack_.pop_back();
+        int idx = stack_.back();
+        stack_.pop_back();
+
+        const Node& node = nodes_[idx];
+        if (node.subtreeCount == 0) {
+            continue;
+        }
+        int lastPlane = -1;
+        CullResult res = frustum.ClassifyRectangle(node.looseMin, node.looseMax, lastPlane, planeMask);
+        if (res == CullResult::Outside) {
+            continue;
+        }
+        if (res == CullResult::Inside) {
+            count += AppendSubtree(idx, ids + count);
+            continue;
+        }
+
+        count += TestCellFrustum(frustum, idx, planeMask, ids + count);
+        for (int child : node.children) {
+            if (child >= 0) {
+                stack_.push_back(child);
+                stack_.push_back((int)planeMask);
+            }
+        }
+    }
+    return count;
+}
+
+int LooseOctree::QuerySphere(const XMFLOAT3& center, float radius, int* ids) {
+    int count = 0;
+    stack_.clear();
+    stack_.push_back(0);
+    while (!stack_.empty()) {
+        int idx = stack_.back();
+        stack_.pop_back();
+
+        const Node& node = nodes_[idx];
+        if (node.subtreeCount == 0 || !SphereIntersectsBox(center, radius, node.looseMin, node.looseMax)) {
+            continue;
+        }
+        count += TestCellSphere(idx, center, radius, ids + count);
+        for (int child : node.children) {
+            if (child >= 0) {
+                stack_.push_back(child);
+            }
+        }
+    }
+    return count;
+}
+
+int LooseOctree::QueryBox(const XMFLOAT4& bbMin, const XMFLOAT4& bbMax, int* ids) {
+    int count = 0;
+    stack_.clear();
+    stack_.push_back(0);
+    while (!stack_.empty()) {
+        int idx = stack_.back();
+        stack_.pop_back();
+
+        const Node& node = nodes_[idx];
+        if (node.subtreeCount == 0 || !BoxesIntersect(bbMin, bbMax, node.looseMin, node.looseMax)) {
+            continue;
+        }
+        bool contained = bbMin.x <= node.looseMin.x && bbMin.y <= node.looseMin.y && bbMin.z <= node.looseMin.z &&
+            bbMax.x >= node.looseMax.x && bbMax.y >= node.looseMax.y && bbMax.z >= node.looseMax.z;
+        if (contained) {
+            count += AppendSubtree(idx, ids + count);
+            continue;
+        }
+        count += TestCellBox(idx, bbMin, bbMax, ids + count);
+        for (int child : node.children) {
+            if (child >= 0) {
+                stack_.push_back(child);
+            }
+        }
+    }
+    return count;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "SpatialIndex.h"
+#include <unordered_map>
+
+// Loose octree over a cube around center: the bounds of a node are twice the size of its cell, so a box is stored in
+// the deepest node whose cell holds its center and is not smaller than the box. Nodes are found through a hash of
+// (level, cell) instead of descending from the root; boxes with the center outside the cube or larger than it are kept in the root
+class LooseOctree : public SpatialIndex {
+public:
+    LooseOctree(const XMFLOAT3& center, float halfSize, int maxDepth);
+
+    void Clear() override;
+    int QueryFrustum(Frustum& frustum, int* ids) override;
+    int QuerySphere(const XMFLOAT3& center, float radius, int* ids) override;
+    int QueryBox(const XMFLOAT4& bbMin, const XMFLOAT4& bbMax, int* ids) override;
+
+    ~LooseOctree() = default;
+private:
+    struct Node {
+        XMFLOAT4 looseMin;
+        XMFLOAT4 looseMax;
+        int children[8];
+        int parent;
+        int subtreeCount; // ids in the node and its descendants, empty subtrees are skipped by queries
+    };
+
+    int AcquireCell(const XMFLOAT4& bbMin, const XMFLOAT4& bbMax) override;
+    void OnCellChanged(int cell, int delta) override;
+    int GetNode(int level, int x, int y, int z);
+    int AppendSubtree(int node, int* ids);
+
+    XMFLOAT3 center_;
+    float halfSize_;
+    int maxDepth_;
+    std::vector<Node> nodes_; // node i owns cellIds_[i]
+    std::unordered_map<UINT64, int> nodeMap_;
+    std::vector<int> stack_;
+    std::vector<int> subtreeStack_;
+};
@@ -1,5 +1,12 @@
 #define SCREEN_NEAR 0.01f
 #define SCREEN_FAR 100.0f
-#define MAX_CUBE 30
-#define MAX_LIGHT 60
-#define MAX_QUERY 10
\ No newline at end of file
+#define MAX_LIGHT 16384
+#define CLUSTER_X 16
+#define CLUSTER_Y 9
+#define CLUSTER_Z 24
+#define MAX_QUERY 10
+#define MAX_OCCLUDERS 16
+#define OCCLUSION_WIDTH 256
+#define OCCLUSION_HEIGHT 144
+#define CULLING_GROUP_SIZE 64
+#define CULLING_SCAN_SIZE 512
\ No newline at end of file
@@ -0,0 +1,27 @@
+#pragma once
+
+// DirectXMath and the Windows integer types used by the CPU modules, without windows.h,
+// so the modules that include only this header build on any platform with DirectXMath
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+
+typedef unsigned char BYTE;
+typedef short SHORT;
+typedef unsigned short USHORT;
+typedef int INT;
+typedef unsigned int UINT;
+typedef unsigned long long UINT64;
+typedef float FLOAT;
+
+// windows.h defines these as macros
+#ifndef min
+template <typename T>
+inline T min(T a, T b) { return b < a ? b : a; }
+#endif
+#ifndef max
+template <typename T>
+inline T max(T a, T b) { return a < b ? b : a; }
+#endif
+
+using namespace DirectX;
@@ -0,0 +1,303 @@
+#include "NullCommandContext.h"
+#include <cstring>
+
+void NullCommandContext::Record(CommandType type, UINT count) {
+    commands_.push_back({ type, count });
+}
+
+void NullCommandContext::Fail(const char* message) {
+    counters_.errors++;
+    lastError_ = message;
+}
+
+void NullCommandContext::CheckDraw(bool indexed) {
+    counters_.drawCalls++;
+    if (pVertexShader_ == NULL || pPixelShader_ == NULL) {
+        Fail("Draw without a vertex or pixel shader");
+    }
+    if (!hasTarget_) {
+        Fail("Draw without a render target");
+    }
+    if (indexed && pIndexBuffer_ == NULL) {
+        Fail("Indexed draw without an index buffer");
+    }
+}
+
+void NullCommandContext::BeginFrame() {
+    for (auto& resource : resources_) {
+        if (resource.second.mapped) {
+            Fail("Resource left mapped at the end of the frame");
+            resource.second.mapped = false;
+        }
+    }
+    UINT errors = counters_.errors;
+    CommandContext::BeginFrame();
+    counters_.errors = errors;
+    commands_.clear();
+    frame_++;
+}
+
+void NullCommandContext::ClearState() {
+    counters_.stateChanges++;
+    pVertexShader_ = NULL;
+    pPixelShader_ = NULL;
+    pComputeShader_ = NULL;
+    pIndexBuffer_ = NULL;
+    hasTarget_ = false;
+    Record(CommandType::State, 0);
+}
+
+void NullCommandContext::RSSetViewports(UINT count, const GpuViewport* pViewports) {
+    counters_.stateChanges++;
+    Record(CommandType::State, count);
+}
+
+void NullCommandContext::RSSetScissorRects(UINT count, const GpuRect* pRects) {
+    counters_.stateChanges++;
+    Record(CommandType::State, count);
+}
+
+void NullCommandContext::RSSetState(GpuRasterizerState* pState) {
+    counters_.stateChanges++;
+    Record(CommandType::State, 1);
+}
+
+void NullCommandContext::OMSetRenderTargets(UINT count, GpuRenderTargetView* const* ppViews, GpuDepthStencilView* pDepthView) {
+    counters_.stateChanges++;
+    hasTarget_ = pDepthView != NULL;
+    for (UINT i = 0; i < count; i++) {
+        hasTarget_ = hasTarget_ || ppViews[i] != NULL;
+    }
+    Record(CommandType::State, count);
+}
+
+void NullCommandContext::OMSetDepthStencilState(GpuDepthStencilState* pState, UINT stencilRef) {
+    counters_.stateChanges++;
+    Record(CommandType::State, 1);
+}
+
+void NullCommandContext::OMSetBlendState(GpuBlendState* pState, const float blendFactor[4], UINT sampleMask) {
+    counters_.stateChanges++;
+    Record(CommandType::State, 1);
+}
+
+void NullCommandContext::ClearRenderTargetView(GpuRenderTargetView* pView, const float color[4]) {
+    if (pView == NULL) {
+        Fail("Clear of a null render target");
+    }
+    Record(CommandType::Clear, 1);
+}
+
+void NullCommandContext::ClearDepthStencilView(GpuDepthStencilView* pView, UINT flags, float depth, BYTE stencil) {
+    if (pView == NULL) {
+        Fail("Clear of a null depth buffer");
+    }
+    Record(CommandType::Clear, 1);
+}
+
+void NullCommandContext::IASetIndexBuffer(GpuBuffer* pBuffer, GpuFormat format, UINT offset) {
+    counters_.stateChanges++;
+    pIndexBuffer_ = pBuffer;
+    Record(CommandType::State, 1);
+}
+
+void NullCommandContext::IASetVertexBuffers(UINT slot, UINT count, GpuBuffer* const* ppBuffers, const UINT* pStrides, const UINT* pOffsets) {
+    counters_.stateChanges++;
+    Record(CommandType::State, count);
+}
+
+void NullCommandContext::IASetInputLayout(GpuInputLayout* pLayout) {
+    counters_.stateChanges++;
+    Record(CommandType::State, 1);
+}
+
+void NullCommandContext::IASetPrimitiveTopology(GpuTopology topology) {
+    counters_.stateChanges++;
+    Record(CommandType::State, 1);
+}
+
+void NullCommandContext::VSSetShader(GpuVertexShader* pShader) {
+    counters_.stateChanges++;
+    pVertexShader_ = pShader;
+    Record(CommandType::State, 1);
+}
+
+void NullCommandContext::VSSetConstantBuffers(UINT slot, UINT count, GpuBuffer* const* ppBuffers) {
+    counters_.stateChanges++;
+    Record(CommandType::State, count);
+}
+
+void NullCommandContext::VSSetShaderResources(UINT slot, UINT count, GpuShaderResourceView* const* ppViews) {
+    counters_.stateChanges++;
+    Record(CommandType::State, count);
+}
+
+void NullCommandContext::PSSetShader(GpuPixelShader* pShader) {
+    counters_.stateChanges++;
+    pPixelShader_ = pShader;
+    Record(CommandType::State, 1);
+}
+
+void NullCommandContext::PSSetConstantBuffers(UINT slot, UINT count, GpuBuffer* const* ppBuffers) {
+    counters_.stateChanges++;
+    Record(CommandType::State, count);
+}
+
+void NullCommandContext::PSSetShaderResources(UINT slot, UINT count, GpuShaderResourceView* const* ppViews) {
+    counters_.stateChanges++;
+    Record(CommandType::State, count);
+}
+
+void NullCommandContext::PSSetSamplers(UINT slot, UINT count, GpuSamplerState* const* ppSamplers) {
+    counters_.stateChanges++;
+    Record(CommandType::State, count);
+}
+
+void NullCommandContext::CSSetShader(GpuComputeShader* pShader) {
+    counters_.stateChanges++;
+    pComputeShader_ = pShader;
+    Record(CommandType::State, 1);
+}
+
+void NullCommandContext::CSSetConstantBuffers(UINT slot, UINT count, GpuBuffer* const* ppBuffers) {
+    counters_.stateChanges++;
+    Record(CommandType::State, count);
+}
+
+void NullCommandContext::CSSetShaderResources(UINT slot, UINT count, GpuShaderResourceView* const* ppViews) {
+    counters_.stateChanges++;
+    Record(CommandType::State, count);
+}
+
+void NullCommandContext::CSSetUnorderedAccessViews(UINT slot, UINT count, GpuUnorderedAccessView* const* ppViews, const UINT* pInitialCounts) {
+    counters_.stateChanges++;
+    Record(CommandType::State, count);
+}
+
+void NullCommandContext::Draw(UINT vertexCount, UINT startVertex) {
+    CheckDraw(false);
+    Record(CommandType::Draw, vertexCount);
+}
+
+void NullCommandContext::DrawIndexed(UINT indexCount, UINT startIndex, INT baseVertex) {
+    CheckDraw(true);
+    Record(CommandType::Draw, indexCount);
+}
+
+void NullCommandContext::DrawIndexedInstanced(UINT indexCount, UINT instanceCount, UINT startIndex, INT baseVertex, UINT startInstance) {
+    CheckDraw(true);
+    Record(CommandType::Draw, indexCount * instanceCount);
+}
+
+void NullCommandContext::DrawIndexedInstancedIndirect(GpuBuffer* pArgs, UINT offset) {
+    CheckDraw(true);
+    if (pArgs == NULL || offset + sizeof(GpuDrawIndexedIndirectArgs) > BufferSize(pArgs)) {
+        Fail("Indirect arguments out of the buffer");
+    }
+    // The instance count is only known on the GPU
+    Record(CommandType::Draw, 0);
+}
+
+void NullCommandContext::Dispatch(UINT x, UINT y, UINT z) {
+    counters_.dispatches++;
+    if (pComputeShader_ == NULL) {
+        Fail("Dispatch without a compute shader");
+    }
+    if (x > maxDispatchGroups || y > maxDispatchGroups ||
+        z > maxDispatchGroups) {
+        Fail("Dispatch exceeds the group count limit");
+    }
+    Record(CommandType::Dispatch, x * y * z);
+}
+
+void NullCommandContext::UpdateSubresource(GpuResource* pDst, UINT subresource, const GpuBox* pBox, const void* pData, UINT rowPitch, UINT depthPitch) {
+    if (pDst == NULL || pData == NULL) {
+        Fail("Update of a null resource or from null data");
+        return;
+    }
+    UINT size = BufferSize(pDst);
+    if (pBox && size > 0 && (pBox->left >= pBox->right || pBox->right > size)) {
+        Fail("Update box out of the buffer");
+    }
+    CountUpdate(pDst, pBox);
+    Record(CommandType::Update, pBox ? pBox->right - pBox->left : size);
+}
+
+HRESULT NullCommandContext::Map(GpuResource* pResource, UINT subresource, GpuMap type, UINT flags, GpuMappedSubresource* pMapped) {
+    UINT size = pResource ? BufferSize(pResource) : 0;
+    if (size == 0) {
+        Fail("Map of something other than a buffer");
+        return E_INVALIDARG;
+    }
+    MappedResource& resource = resources_[pResource];
+    if (resource.mapped) {
+        Fail("Map of a mapped resource");
+        return E_FAIL;
+    }
+    // Discarding maps get fresh memory, the others have to wait for the copies still reading the resource
+    bool inUse = resource.readFrame > 0 && frame_ - resource.readFrame < gpuLatency_;
+    if (inUse && type != GpuMap::WriteDiscard && type != GpuMap::WriteNoOverwrite) {
+        if (flags & GpuMapFlag::DoNotWait) {
+            return GPU_E_WAS_STILL_DRAWING;
+        }
+        counters_.mapStalls++;
+    }
+    resource.memory.resize(size);
+    resource.mapped = true;
+    pMapped->pData = resource.memory.data();
+    pMapped->rowPitch = size;
+    pMapped->depthPitch = size;
+    CountMap(pResource, type);
+    Record(CommandType::Map, size);
+    return S_OK;
+}
+
+void NullCommandContext::Unmap(GpuResource* pResource, UINT subresource) {
+    auto it = resources_.find(pResource);
+    if (it == resources_.end() || !it->second.mapped) {
+        Fail("Unmap of a resource that is not mapped");
+        return;
+    }
+    it->second.mapped = false;
+}
+
+void NullCommandContext::CopyResource(GpuResource* pDst, GpuResource* pSrc) {
+    if (pDst == NULL || pSrc == NULL || pDst == pSrc || BufferSize(pDst) != BufferSize(pSrc)) {
+        Fail("Copy between different or identical resources");
+        return;
+    }
+    CountCopy(pSrc, nullptr);
+    resources_[pSrc].readFrame = frame_;
+    Record(CommandType::Copy, BufferSize(pSrc));
+}
+
+void NullCommandContext::CopySubresourceRegion(GpuResource* pDst, UINT dstSubresource, UINT x, UINT y, UINT z,
+    GpuResource* pSrc, UINT srcSubresource, const GpuBox* pSrcBox) {
+    if (pDst == NULL || pSrc == NULL) {
+        Fail("Copy of a null resource");
+        return;
+    }
+    UINT size = pSrcBox ? pSrcBox->right - pSrcBox->left : BufferSize(pSrc);
+    if ((pSrcBox && pSrcBox->right > BufferSize(pSrc)) || x + size > BufferSize(pDst)) {
+        Fail("Copy region out of the buffer");
+    }
+    CountCopy(pSrc, pSrcBox);
+    resources_[pSrc].readFrame = frame_;
+    Record(CommandType::Copy, size);
+}
+
+void NullCommandContext::Begin(GpuQuery* pQuery) {
+    Record(CommandType::Query, 0);
+}
+
+void NullCommandContext::End(GpuQuery* pQuery) {
+    Record(CommandType::Query, 0);
+}
+
+HRESULT NullCommandContext::GetData(GpuQuery* pQuery, void* pData, UINT size, UINT flags) {
+    // Nothing ran, so every query is complete and empty
+    if (pData != NULL) {
+        memset(pData, 0, size);
+    }
+    return S_OK;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "CommandContext.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum class CommandType {
+    State,
+    Clear,
+    Draw,
+    Dispatch,
+    Update,
+    Map,
+    Copy,
+    Query
+};
+
+struct RecordedCommand {
+    CommandType type;
+    UINT count; // indices or vertices times instances for draws, groups for dispatches, bytes for uploads
+};
+
+// Records and validates commands without sending them anywhere, so a frame costs only its CPU part.
+// Map hands out host memory of the buffer's size. With a GPU latency the sources of copies stay in use for that
+// many frames, as if the GPU ran behind: a map of such a resource fails with GPU_E_WAS_STILL_DRAWING under
+// GpuMapFlag::DoNotWait and counts a stall otherwise.
+class NullCommandContext : public CommandContext {
+public:
+    NullCommandContext() = default;
+
+    void ClearState() override;
+
+    void RSSetViewports(UINT count, const GpuViewport* pViewports) override;
+    void RSSetScissorRects(UINT count, const GpuRect* pRects) override;
+    void RSSetState(GpuRasterizerState* pState) override;
+
+    void OMSetRenderTargets(UINT count, GpuRenderTargetView* const* ppViews, GpuDepthStencilView* pDepthView) override;
+    void OMSetDepthStencilState(GpuDepthStencilState* pState, UINT stencilRef) override;
+    void OMSetBlendState(GpuBlendState* pState, const float blendFactor[4], UINT sampleMask) override;
+    void ClearRenderTargetView(GpuRenderTargetView* pView, const float color[4]) override;
+    void ClearDepthStencilView(GpuDepthStencilView* pView, UINT flags, float depth, BYTE stencil) override;
+
+    void IASetIndexBuffer(GpuBuffer* pBuffer, GpuFormat format, UINT offset) override;
+    void IASetVertexBuffers(UINT slot, UINT count, GpuBuffer* const* ppBuffers, const UINT* pStrides, const UINT* pOffsets) override;
+    void IASetInputLayout(GpuInputLayout* pLayout) override;
+    void IASetPrimitiveTopology(GpuTopology topology) override;
+
+    void VSSetShader(GpuVertexShader* pShader) override;
+    void VSSetConstantBuffers(UINT slot, UINT count, GpuBuffer* const* ppBuffers) override;
+    void VSSetShaderResources(UINT slot, UINT count, GpuShaderResourceView* const* ppViews) override;
+    void PSSetShader(GpuPixelShader* pShader) override;
+    void PSSetConstantBuffers(UINT slot, UINT count, GpuBuffer* const* ppBuffers) override;
+    void PSSetShaderResources(UINT slot, UINT count, GpuShaderResourceView* const* ppViews) override;
+    void PSSetSamplers(UINT slot, UINT count, GpuSamplerState* const* ppSamplers) override;
+    void CSSetShader(GpuComputeShader* pShader) override;
+    void CSSetConstantBuffers(UINT slot, UINT count, GpuBuffer* const* ppBuffers) override;
+    void CSSetShaderResources(UINT slot, UINT count, GpuShaderResourceView* const* ppViews) override;
+    void CSSetUnorderedAccessViews(UINT slot, UINT count, GpuUnorderedAccessView* const* ppViews, const UINT* pInitialCounts) override;
+
+    void Draw(UINT vertexCount, UINT startVertex) override;
+    void DrawIndexed(UINT indexCount, UINT startIndex, INT baseVertex) override;
+    void DrawIndexedInstanced(UINT indexCount, UINT instanceCount, UINT startIndex, INT baseVertex, UINT startInstance) override;
+    void DrawIndexedInstancedIndirect(GpuBuffer* pArgs, UINT offset) override;
+    void Dispatch(UINT x, UINT y, UINT z) override;
+
+    void UpdateSubresource(GpuResource* pDst, UINT subresource, const GpuBox* pBox, const void* pData, UINT rowPitch, UINT depthPitch) override;
+    HRESULT Map(GpuResource* pResource, UINT subresource, GpuMap type, UINT flags, GpuMappedSubresource* pMapped) override;
+    void Unmap(GpuResource* pResource, UINT subresource) override;
+    void CopyResource(GpuResource* pDst, GpuResource* pSrc) override;
+    void CopySubresourceRegion(GpuResource* pDst, UINT dstSubresource, UINT x, UINT y, UINT z,
+        GpuResource* pSrc, UINT srcSubresource, const GpuBox* pSrcBox) override;
+
+    void Begin(GpuQuery* pQuery) override;
+    void End(GpuQuery* pQuery) override;
+    HRESULT GetData(GpuQuery* pQuery, void* pData, UINT size, UINT flags) override;
+
+    void BeginFrame() override;
+    void SetGpuLatency(UINT frames) { gpuLatency_ = frames; };
+    // Drops the memory and the state of a resource the device releases, a later resource may reuse its address
+    void ReleaseResource(GpuResource* pResource) { resources_.erase(pResource); };
+    size_t GetTrackedResourceCount() const { return resources_.size(); };
+    const std::vector<RecordedCommand>& GetCommands() const { return commands_; };
+    const std::string& GetLastError() const { return lastError_; };
+
+    ~NullCommandContext() = default;
+private:
+    struct MappedResource {
+        std::vector<BYTE> memory;
+        bool mapped = false;
+        UINT64 readFrame = 0; // last frame a copy read the resource, 0 - never
+    };
+
+    void Record(CommandType type, UINT count);
+    void Fail(const char* message);
+    void CheckDraw(bool indexed);
+
+    GpuVertexShader* pVertexShader_ = NULL;
+    GpuPixelShader* pPixelShader_ = NULL;
+    GpuComputeShader* pComputeShader_ = NULL;
+    GpuBuffer* pIndexBuffer_ = NULL;
+    bool hasTarget_ = false;
+    UINT gpuLatency_ = 0;
+    UINT64 frame_ = 1;
+
+    std::unordered_map<GpuResource*, MappedResource> resources_;
+    std::vector<RecordedCommand> commands_;
+    std::string lastError_;
+};
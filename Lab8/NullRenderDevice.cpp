@@ -0,0 +1,170 @@
+#include "NullRenderDevice.h"
+#include "imgui.h"
+
+namespace {
+    // A resource that the context stops tracking when it is released
+    template <typename Base>
+    class NullResource : public Base {
+    public:
+        template <typename Desc>
+        NullResource(NullCommandContext* pContext, const Desc& desc) : Base(desc), pContext_(pContext) {};
+
+        ~NullResource() {
+            pContext_->ReleaseResource(this);
+        };
+    private:
+        NullCommandContext* pContext_;
+    };
+}
+
+NullRenderDevice::NullRenderDevice(UINT width, UINT height) :
+    width_(width),
+    height_(height),
+    pBackBuffer_(new GpuRenderTargetView()) {}
+
+HRESULT NullRenderDevice::CreateBuffer(const GpuBufferDesc& desc, const GpuSubresourceData* pData, GpuBuffer** ppBuffer) {
+    if (desc.byteWidth == 0 || (desc.usage == GpuUsage::Immutable && pData == NULL) ||
+        ((desc.miscFlags & GpuMisc::BufferStructured) && desc.structureByteStride == 0)) {
+        return E_INVALIDARG;
+    }
+    *ppBuffer = new NullResource<GpuBuffer>(&context_, desc);
+    return S_OK;
+}
+
+HRESULT NullRenderDevice::CreateTexture2D(const GpuTextureDesc& desc, const GpuSubresourceData* pData, GpuTexture** ppTexture) {
+    if (desc.width == 0 || desc.height == 0 || desc.arraySize == 0 || (desc.usage == GpuUsage::Immutable && pData == NULL)) {
+        return E_INVALIDARG;
+    }
+    *ppTexture = new NullResource<GpuTexture>(&context_, desc);
+    return S_OK;
+}
+
+HRESULT NullRenderDevice::CreateShaderResourceView(GpuResource* pResource, GpuShaderResourceView** ppView) {
+    if (pResource == NULL) {
+        return E_INVALIDARG;
+    }
+    *ppView = new GpuShaderResourceView();
+    return S_OK;
+}
+
+HRESULT NullRenderDevice::CreateUnorderedAccessView(GpuResource* pResource, GpuUnorderedAccessView** ppView) {
+    if (pResource == NULL) {
+        return E_INVALIDARG;
+    }
+    *ppView = new GpuUnorderedAccessView();
+    return S_OK;
+}
+
+HRESULT NullRenderDevice::CreateRenderTargetView(GpuTexture* pTexture, GpuRenderTargetView** ppView) {
+    if (pTexture == NULL || !(pTexture->GetDesc().bindFlags & GpuBind::RenderTarget)) {
+        return E_INVALIDARG;
+    }
+    *ppView = new GpuRenderTargetView();
+    return S_OK;
+}
+
+HRESULT NullRenderDevice::CreateDepthStencilView(GpuTexture* pTexture, GpuDepthStencilView** ppView) {
+    if (pTexture == NULL || !(pTexture->GetDesc().bindFlags & GpuBind::DepthStencil)) {
+        return E_INVALIDARG;
+    }
+    *ppView = new GpuDepthStencilView();
+    return S_OK;
+}
+
+HRESULT NullRenderDevice::CreateVertexShader(const GpuShaderDesc& desc, GpuVertexShader** ppShader) {
+    *ppShader = new GpuVertexShader();
+    return S_OK;
+}
+
+HRESULT NullRenderDevice::CreatePixelShader(const GpuShaderDesc& desc, GpuPixelShader** ppShader) {
+    *ppShader = new GpuPixelShader();
+    return S_OK;
+}
+
+HRESULT NullRenderDevice::CreateComputeShader(const GpuShaderDesc& desc, GpuComputeShader** ppShader) {
+    *ppShader = new GpuComputeShader();
+    return S_OK;
+}
+
+HRESULT NullRenderDevice::CreateInputLayout(const GpuInputElement* pElements, UINT count, GpuVertexShader* pShader, GpuInputLayout** ppLayout) {
+    if (pElements == NULL || count == 0 || pShader == NULL) {
+        return E_INVALIDARG;
+    }
+    *ppLayout = new GpuInputLayout();
+    return S_OK;
+}
+
+HRESULT NullRenderDevice::CreateSamplerState(const GpuSamplerDesc& desc, GpuSamplerState** ppState) {
+    *ppState = new GpuSamplerState();
+    return S_OK;
+}
+
+HRESULT NullRenderDevice::CreateRasterizerState(const GpuRasterizerDesc& desc, GpuRasterizerState** ppState) {
+    *ppState = new GpuRasterizerState();
+    return S_OK;
+}
+
+HRESULT NullRenderDevice::CreateDepthStencilState(const GpuDepthStencilDesc& desc, GpuDepthStencilState** ppState) {
+    *ppState = new GpuDepthStencilState();
+    return S_OK;
+}
+
+HRESULT NullRenderDevice::CreateBlendState(const GpuBlendDesc& desc, GpuBlendState** ppState) {
+    *ppState = new GpuBlendState();
+    return S_OK;
+}
+
+HRESULT NullRenderDevice::CreateQuery(GpuQueryType type, GpuQuery** ppQuery) {
+    *ppQuery = new GpuQuery();
+    return S_OK;
+}
+
+HRESULT NullRenderDevice::LoadTexture(const char* path, bool cube, GpuShaderResourceView** ppView) {
+    *ppView = new GpuShaderResourceView();
+    return S_OK;
+}
+
+HRESULT NullRenderDevice::LoadTextureArray(const char* const* paths, UINT count, GpuShaderResourceView** ppView) {
+    if (count == 0) {
+        return E_INVALIDARG;
+    }
+    *ppView = new GpuShaderResourceView();
+    return S_OK;
+}
+
+HRESULT NullRenderDevice::ResizeBuffers(UINT width, UINT height) {
+    if (width == 0 || height == 0) {
+        return E_INVALIDARG;
+    }
+    width_ = width;
+    height_ = height;
+    return S_OK;
+}
+
+HRESULT NullRenderDevice::Present() {
+    presentCount_++;
+    return S_OK;
+}
+
+bool NullRenderDevice::InitUI() {
+    ImGuiIO& io = ImGui::GetIO();
+    io.IniFilename = NULL;
+    unsigned char* pixels;
+    int width, height;
+    io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+    return true;
+}
+
+void NullRenderDevice::NewUIFrame() {
+    ImGuiIO& io = ImGui::GetIO();
+    io.DisplaySize = ImVec2((float)width_, (float)height_);
+    io.DeltaTime = 1.0f / 60.0f;
+}
+
+void NullRenderDevice::RenderUI(ImDrawData* pDrawData) {}
+
+void NullRenderDevice::ShutdownUI() {}
+
+NullRenderDevice::~NullRenderDevice() {
+    pBackBuffer_->Release();
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "RenderDevice.h"
+#include "NullCommandContext.h"
+
+// Device of the null backend: creates placeholder objects after checking their descriptions,
+// shaders and textures are not loaded, and the UI is laid out but not drawn. Runs without a window.
+class NullRenderDevice : public RenderDevice {
+public:
+    NullRenderDevice(UINT width, UINT height);
+
+    HRESULT CreateBuffer(const GpuBufferDesc& desc, const GpuSubresourceData* pData, GpuBuffer** ppBuffer) override;
+    HRESULT CreateTexture2D(const GpuTextureDesc& desc, const GpuSubresourceData* pData, GpuTexture** ppTexture) override;
+    HRESULT CreateShaderResourceView(GpuResource* pResource, GpuShaderResourceView** ppView) override;
+    HRESULT CreateUnorderedAccessView(GpuResource* pResource, GpuUnorderedAccessView** ppView) override;
+    HRESULT CreateRenderTargetView(GpuTexture* pTexture, GpuRenderTargetView** ppView) override;
+    HRESULT CreateDepthStencilView(GpuTexture* pTexture, GpuDepthStencilView** ppView) override;
+
+    HRESULT CreateVertexShader(const GpuShaderDesc& desc, GpuVertexShader** ppShader) override;
+    HRESULT CreatePixelShader(const GpuShaderDesc& desc, GpuPixelShader** ppShader) override;
+    HRESULT CreateComputeShader(const GpuShaderDesc& desc, GpuComputeShader** ppShader) override;
+    HRESULT CreateInputLayout(const GpuInputElement* pElements, UINT count, GpuVertexShader* pShader, GpuInputLayout** ppLayout) override;
+
+    HRESULT CreateSamplerState(const GpuSamplerDesc& desc, GpuSamplerState** ppState) override;
+    HRESULT CreateRasterizerState(const GpuRasterizerDesc& desc, GpuRasterizerState** ppState) override;
+    HRESULT CreateDepthStencilState(const GpuDepthStencilDesc& desc, GpuDepthStencilState** ppState) override;
+    HRESULT CreateBlendState(const GpuBlendDesc& desc, GpuBlendState** ppState) override;
+    HRESULT CreateQuery(GpuQueryType type, GpuQuery** ppQuery) override;
+
+    HRESULT LoadTexture(const char* path, bool cube, GpuShaderResourceView** ppView) override;
+    HRESULT LoadTextureArray(const char* const* paths, UINT count, GpuShaderResourceView** ppView) override;
+
+    GpuRenderTargetView* GetBackBuffer() override { return pBackBuffer_; };
+    HRESULT ResizeBuffers(UINT width, UINT height) override;
+    HRESULT Present() override;
+
+    bool InitUI() override;
+    void NewUIFrame() override;
+    void RenderUI(ImDrawData* pDrawData) override;
+    void ShutdownUI() override;
+
+    NullCommandContext* GetContext() override { return &context_; };
+    UINT GetPresentCount() const { return presentCount_; };
+
+    ~NullRenderDevice();
+private:
+    UINT width_;
+    UINT height_;
+    UINT presentCount_ = 0;
+    GpuRenderTargetView* pBackBuffer_;
+    NullCommandContext context_;
+};
@@ -0,0 +1,187 @@
+#include "OcclusionCulling.h"
+#include <algorithm>
+#include <cfloat>
+
+namespace {
+    const USHORT BoxIndices[] = {
+        0, 2, 1, 1, 2, 3,
+        4, 5, 6, 5, 7, 6,
+        0, 1, 4, 1, 5, 4,
+        2, 6, 3, 3, 6, 7,
+        0, 4, 2, 2, 4, 6,
+        1, 3, 5, 3, 7, 5
+    };
+}
+
+OcclusionCuller::OcclusionCuller(int width, int height) :
+    viewProjection_(XMMatrixIdentity()),
+    width_((width + tileSize - 1) / tileSize * tileSize),
+    height_((height + tileSize - 1) / tileSize * tileSize),
+    tilesX_(width_ / tileSize),
+    tilesY_(height_ / tileSize),
+    depth_((size_t)width_ * height_, 0.0f),
+    tileDepth_((size_t)tilesX_ * tilesY_, 0.0f) {}
+
+void OcclusionCuller::Clear() {
+    std::fill(depth_.begin(), depth_.end(), 0.0f);
+    std::fill(tileDepth_.begin(), tileDepth_.end(), 0.0f);
+}
+
+void OcclusionCuller::RenderBox(FXMMATRIX world, const XMFLOAT4& localMin, const XMFLOAT4& localMax) {
+    XMMATRIX worldViewProjection = XMMatrixMultiply(world, viewProjection_);
+
+    XMFLOAT4 screen[8];
+    for (int i = 0; i < 8; i++) {
+        XMVECTOR corner = XMVectorSet(i & 1 ? localMax.x : localMin.x, i & 2 ? localMax.y : localMin.y,
+            i & 4 ? localMax.z : localMin.z, 1.0f);
+        XMFLOAT4 clip;
+        XMStoreFloat4(&clip, XMVector4Transform(corner, worldViewProjection));
+        // Occluders crossing the near plane are skipped, dropping them only makes culling less aggressive
+        if (clip.w < SCREEN_NEAR) {
+            return;
+        }
+        screen[i] = XMFLOAT4((clip.x / clip.w * 0.5f + 0.5f) * width_, (0.5f - clip.y / clip.w * 0.5f) * height_,
+            clip.z / clip.w, 1.0f);
+    }
+
+    for (int i = 0; i < 36; i += 3) {
+        RasterizeTriangle(screen[BoxIndices[i]], screen[BoxIndices[i + 1]], screen[BoxIndices[i + 2]]);
+    }
+}
+
+void OcclusionCuller::RasterizeTriangle(const XMFLOAT4& v0, const XMFLOAT4& v1, const XMFLOAT4& v2) {
+    float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+    if (fabsf(area) < 1e-6f) {
+        return;
+    }
+    // Orient every triangle the same way, occluders are drawn without back face culling
+    const XMFLOAT4& a = v0;
+    const XMFLOAT4& b = area > 0.0f ? v1 : v2;
+    const XMFLOAT4& c = area > 0.0f ? v2 : v1;
+    area = fabsf(area);
+
+    int left = max((int)floorf(min(a.x, min(b.x, c.x))), 0);
+    int right = min((int)ceilf(max(a.x, max(b.x, c.x))), width_ - 1);
+    int top = max((int)floorf(min(a.y, min(b.y, c.y))), 0);
+    int bottom = min((int)ceilf(max(a.y, max(b.y, c.y))), height_ - 1);
+    if (left > right || top > bottom) {
+        return;
+    }
+
+    // Edge functions E(p) = stepX * p.x + stepY * p.y + offset, positive inside,
+    // divided by the area they give the barycentric weight of the opposite vertex
+    float invArea = 1.0f / area;
+    float stepX[3] = { b.y - c.y, c.y - a.y, a.y - b.y };
+    float stepY[3] = { c.x - b.x, a.x - c.x, b.x - a.x };
+    float offset[3] = { b.x * c.y - b.y * c.x, c.x * a.y - c.y * a.x, a.x * b.y - a.y * b.x };
+
+    // Depth is affine in screen space: z = zStepX * x + zStepY * y + zOffset
+    float zStepX = (a.z * stepX[0] + b.z * stepX[1] + c.z * stepX[2]) * invArea;
+    float zStepY = (a.z * stepY[0] + b.z * stepY[1] + c.z * stepY[2]) * invArea;
+    float zOffset = (a.z * offset[0] + b.z * offset[1] + c.z * offset[2]) * invArea;
+
+    XMVECTOR e0StepX = XMVectorReplicate(stepX[0]);
+    XMVECTOR e1StepX = XMVectorReplicate(stepX[1]);
+    XMVECTOR e2StepX = XMVectorReplicate(stepX[2]);
+    XMVECTOR zStep = XMVectorReplicate(zStepX);
+    XMVECTOR zero = XMVectorZero();
+
+    left &= ~3;
+    for (int y = top; y <= bottom; y++) {
+        float py = y + 0.5f;
+        XMVECTOR px = XMVectorSet(left + 0.5f, left + 1.5f, left + 2.5f, left + 3.5f);
+        XMVECTOR e0 = XMVectorAdd(XMVectorMultiply(px, e0StepX), XMVectorReplicate(stepY[0] * py + offset[0]));
+        XMVECTOR e1 = XMVectorAdd(XMVectorMultiply(px, e1StepX), XMVectorReplicate(stepY[1] * py + offset[1]));
+        XMVECTOR e2 = XMVectorAdd(XMVectorMultiply(px, e2StepX), XMVectorReplicate(stepY[2] * py + offset[2]));
+        XMVECTOR z = XMVectorAdd(XMVectorMultiply(px, zStep), XMVectorReplicate(zStepY * py + zOffset));
+
+        float* row = &depth_[(size_t)y * width_];
+        for (int x = left; x <= right; x += 4) {
+            XMVECTOR inside = XMVectorAndInt(XMVectorGreaterOrEqual(e0, zero),
+                XMVectorAndInt(XMVectorGreaterOrEqual(e1, zero), XMVectorGreaterOrEqual(e2, zero)));
+            if (!XMVector4EqualInt(inside, XMVectorFalseInt())) {
+                XMVECTOR old = XMLoadFloat4(reinterpret_cast<XMFLOAT4*>(row + x));
+                XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(row + x), XMVectorSelect(old, XMVectorMax(old, z), inside));
+            }
+
+            e0 = XMVectorAdd(e0, XMVectorScale(e0StepX, 4.0f));
+            e1 = XMVectorAdd(e1, XMVectorScale(e1StepX, 4.0f));
+            e2 = XMVectorAdd(e2, XMVectorScale(e2StepX, 4.0f));
+            z = XMVectorAdd(z, XMVectorScale(zStep, 4.0f));
+        }
+    }
+}
+
+void OcclusionCuller::BuildHierarchy() {
+    for (int ty = 0; ty < tilesY_; ty++) {
+        for (int tx = 0; tx < tilesX_; tx++) {
+            XMVECTOR farthest = XMVectorReplicate(FLT_MAX);
+            for (int y = 0; y < tileSize; y++) {
+                const float* row = &depth_[(size_t)(ty * tileSize + y) * width_ + tx * tileSize];
+                for (int x = 0; x < tileSize; x += 4) {
+                    farthest = XMVectorMin(farthest, XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(row + x)));
+                }
+            }
+            XMFLOAT4 f;
+            XMStoreFloat4(&f, farthest);
+            tileDepth_[(size_t)ty * tilesX_ + tx] = min(min(f.x, f.y), min(f.z, f.w));
+        }
+    }
+}
+
+bool OcclusionCuller::TestTile(int tx, int ty, int left, int top, int right, int bottom, float depth) {
+    if (tileDepth_[(size_t)ty * tilesX_ + tx] > depth) {
+        return false;
+    }
+
+    int x0 = max(left, tx * tileSize);
+    int x1 = min(right, tx * tileSize + tileSize - 1);
+    int y0 = max(top, ty * tileSize);
+    int y1 = min(bottom, ty * tileSize + tileSize - 1);
+    for (int y = y0; y <= y1; y++) {
+        const float* row = &depth_[(size_t)y * width_];
+        for (int x = x0; x <= x1; x++) {
+            if (row[x] <= depth) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool OcclusionCuller::TestRectangle(const XMFLOAT4& bbMin, const XMFLOAT4& bbMax) {
+    float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+    float nearest = -FLT_MAX;
+    for (int i = 0; i < 8; i++) {
+        XMVECTOR corner = XMVectorSet(i & 1 ? bbMax.x : bbMin.x, i & 2 ? bbMax.y : bbMin.y, i & 4 ? bbMax.z : bbMin.z, 1.0f);
+        XMFLOAT4 clip;
+        XMStoreFloat4(&clip, XMVector4Transform(corner, viewProjection_));
+        if (clip.w < SCREEN_NEAR) {
+            return true;
+        }
+        float sx = (clip.x / clip.w * 0.5f + 0.5f) * width_;
+        float sy = (0.5f - clip.y / clip.w * 0.5f) * height_;
+        minX = min(minX, sx);
+        maxX = max(maxX, sx);
+        minY = min(minY, sy);
+        maxY = max(maxY, sy);
+        nearest = max(nearest, clip.z / clip.w);
+    }
+
+    int left = max((int)floorf(minX), 0);
+    int right = min((int)ceilf(maxX), width_ - 1);
+    int top = max((int)floorf(minY), 0);
+    int bottom = min((int)ceilf(maxY), height_ - 1);
+    if (left > right || top > bottom) {
+        return true;
+    }
+
+    for (int ty = top / tileSize; ty <= bottom / tileSize; ty++) {
+        for (int tx = left / tileSize; tx <= right / tileSize; tx++) {
+            if (TestTile(tx, ty, left, top, right, bottom, nearest)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "MathCommon.h"
+#include "Macros.h"
+#include <vector>
+
+// Low resolution CPU depth buffer for occlusion culling, uses the same reversed depth as the scene (1 - near, 0 - far)
+class OcclusionCuller {
+public:
+    static constexpr int tileSize = 8;
+
+    OcclusionCuller(int width, int height);
+
+    void Clear();
+    void SetViewProjection(FXMMATRIX viewProjection) { viewProjection_ = viewProjection; };
+    // Rasterizes the box [localMin, localMax] transformed by world as an occluder
+    void RenderBox(FXMMATRIX world, const XMFLOAT4& localMin, const XMFLOAT4& localMax);
+    // Updates the farthest depth per tile, call after all occluders are rendered
+    void BuildHierarchy();
+    // Returns false if the world space box is hidden behind the rendered occluders
+    bool TestRectangle(const XMFLOAT4& bbMin, const XMFLOAT4& bbMax);
+
+    ~OcclusionCuller() = default;
+private:
+    void RasterizeTriangle(const XMFLOAT4& v0, const XMFLOAT4& v1, const XMFLOAT4& v2);
+    bool TestTile(int tx, int ty, int left, int top, int right, int bottom, float depth);
+
+    XMMATRIX viewProjection_;
+    int width_;
+    int height_;
+    int tilesX_;
+    int tilesY_;
+    std::vector<float> depth_;
+    std::vector<float> tileDepth_;
+};
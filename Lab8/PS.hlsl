@@ -15,11 +15,11 @@ struct PS_INPUT {
 };
 
 float4 main(PS_INPUT input) : SV_TARGET{
-    float3 color = cubeTexture.Sample(cubeSampler, float3(input.uv, geomBuffer[input.instanceId].shineSpeedTexIdNM.z)).xyz;
-    float3 finalColor = ambientColor.xyz * color;
+    uint material = geomBuffer[input.instanceId].material;
+    float3 color = cubeTexture.Sample(cubeSampler, float3(input.uv, (float)(material & 0xFFFF))).xyz;
 
     float3 norm = float3(0, 0, 0);
-    if (lightParams.y > 0 && geomBuffer[input.instanceId].shineSpeedTexIdNM.w > 0.0f) {
+    if (lightParams.y > 0 && (material & 0x10000) != 0) {
         float3 binorm = normalize(cross(input.normal, input.tangent));
         float3 localNorm = cubeNormal.Sample(cubeSampler, input.uv).xyz * 2.0 - 1.0;
         norm = localNorm.x * normalize(input.tangent) + localNorm.y * binorm + localNorm.z * normalize(input.normal);
@@ -28,5 +28,10 @@ float4 main(PS_INPUT input) : SV_TARGET{
         norm = input.normal;
     }
 
-    return float4(CalculateColor(finalColor, norm, input.worldPos.xyz, geomBuffer[input.instanceId].shineSpeedTexIdNM.x, false), 1.0);
+    float shine = geomBuffer[input.instanceId].shine;
+    float3 ambient = lightParams.z > 0 ? float3(0, 0, 0) : AmbientLight(norm) * color;
+    if (lightParams.w > 0) {
+        return float4(ambient + CalculateInstanceColor(color, norm, input.worldPos.xyz, input.instanceId, shine), 1.0);
+    }
+    return float4(ambient + CalculateColor(color, norm, input.worldPos.xyz, input.position.xy, shine, false), 1.0);
 }
\ No newline at end of file
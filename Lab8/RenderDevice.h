@@ -0,0 +1,49 @@
+#pragma once
+
+#include "CommandContext.h"
+
+struct ImDrawData;
+
+// Creates the GPU objects of a backend and owns its output: the back buffer, presenting and the UI renderer.
+// Mirrors the used part of ID3D11Device and IDXGISwapChain
+class RenderDevice {
+public:
+    virtual HRESULT CreateBuffer(const GpuBufferDesc& desc, const GpuSubresourceData* pData, GpuBuffer** ppBuffer) = 0;
+    virtual HRESULT CreateTexture2D(const GpuTextureDesc& desc, const GpuSubresourceData* pData, GpuTexture** ppTexture) = 0;
+    // Views of the whole resource in its own format
+    virtual HRESULT CreateShaderResourceView(GpuResource* pResource, GpuShaderResourceView** ppView) = 0;
+    virtual HRESULT CreateUnorderedAccessView(GpuResource* pResource, GpuUnorderedAccessView** ppView) = 0;
+    virtual HRESULT CreateRenderTargetView(GpuTexture* pTexture, GpuRenderTargetView** ppView) = 0;
+    virtual HRESULT CreateDepthStencilView(GpuTexture* pTexture, GpuDepthStencilView** ppView) = 0;
+
+    // Shaders are compiled from HLSL files relative to the working directory
+    virtual HRESULT CreateVertexShader(const GpuShaderDesc& desc, GpuVertexShader** ppShader) = 0;
+    virtual HRESULT CreatePixelShader(const GpuShaderDesc& desc, GpuPixelShader** ppShader) = 0;
+    virtual HRESULT CreateComputeShader(const GpuShaderDesc& desc, GpuComputeShader** ppShader) = 0;
+    virtual HRESULT CreateInputLayout(const GpuInputElement* pElements, UINT count, GpuVertexShader* pShader, GpuInputLayout** ppLayout) = 0;
+
+    virtual HRESULT CreateSamplerState(const GpuSamplerDesc& desc, GpuSamplerState** ppState) = 0;
+    virtual HRESULT CreateRasterizerState(const GpuRasterizerDesc& desc, GpuRasterizerState** ppState) = 0;
+    virtual HRESULT CreateDepthStencilState(const GpuDepthStencilDesc& desc, GpuDepthStencilState** ppState) = 0;
+    virtual HRESULT CreateBlendState(const GpuBlendDesc& desc, GpuBlendState** ppState) = 0;
+    virtual HRESULT CreateQuery(GpuQueryType type, GpuQuery** ppQuery) = 0;
+
+    // DDS textures; an array takes one slice per file, all of the size and format of the first
+    virtual HRESULT LoadTexture(const char* path, bool cube, GpuShaderResourceView** ppView) = 0;
+    virtual HRESULT LoadTextureArray(const char* const* paths, UINT count, GpuShaderResourceView** ppView) = 0;
+
+    virtual GpuRenderTargetView* GetBackBuffer() = 0;
+    virtual HRESULT ResizeBuffers(UINT width, UINT height) = 0;
+    virtual HRESULT Present() = 0;
+
+    // The UI renderer of the current ImGui context
+    virtual bool InitUI() = 0;
+    virtual void NewUIFrame() = 0;
+    virtual void RenderUI(ImDrawData* pDrawData) = 0;
+    virtual void ShutdownUI() = 0;
+
+    // Immediate context, commands run in the order they are issued
+    virtual CommandContext* GetContext() = 0;
+
+    virtual ~RenderDevice() = default;
+};
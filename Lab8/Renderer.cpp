@@ -1,4 +1,5 @@
 ﻿#include "Renderer.h"
+#include "imgui.h"
 
 #define SAFE_RELEASE(A) if ((A) != NULL) { (A)->Release(); (A) = NULL; }
 
@@ -9,14 +10,23 @@ Renderer& Renderer::GetInstance() {
 
 Renderer::Renderer() :
     pDevice_(NULL),
-    pDeviceContext_(NULL),
-    pSwapChain_(NULL),
-    pRenderTargetView_(NULL),
     pRasterizerState_(NULL),
     pSampler_(NULL),
     pCamera_(NULL),
-    pInput_(NULL),
     pFrustum_(NULL),
+    pJobSystem_(NULL),
+    pOcclusionCuller_(NULL),
+    pUploadRing_(NULL),
+    pContext_(NULL),
+    pNullContext_(NULL),
+    pSoftwareRasterizer_(NULL),
+    pLodSelector_(NULL),
+    pTemporalCuller_(NULL),
+    pSpatialIndex_(NULL),
+    pLightClusters_(NULL),
+    pInstanceLights_(NULL),
+    pLightManager_(NULL),
+    pSkyIrradiance_(NULL),
     pDepthBuffer_(NULL),
     pDepthBufferDSV_(NULL),
     pBlendState_(NULL),
@@ -25,117 +35,105 @@ Renderer::Renderer() :
     numSphereTriangles_(0),
     radius_(1.0) {}
 
-bool Renderer::Init(HINSTANCE hInstance, HWND hWnd) {
-    // Create a DirectX graphics interface factory.​
-    IDXGIFactory* pFactory = nullptr;
-    HRESULT result = CreateDXGIFactory(__uuidof(IDXGIFactory), (void**)&pFactory);
-    // Select hardware adapter
-    IDXGIAdapter* pSelectedAdapter = NULL;
+bool Renderer::Init(RenderDevice* pDevice) {
+    pDevice_ = pDevice;
+
+    HRESULT result = S_OK;
     if (SUCCEEDED(result)) {
-        IDXGIAdapter* pAdapter = NULL;
-        UINT adapterIdx = 0;
-        while (SUCCEEDED(pFactory->EnumAdapters(adapterIdx, &pAdapter))) {
-            DXGI_ADAPTER_DESC desc;
-            pAdapter->GetDesc(&desc);
-            if (wcscmp(desc.Description, L"Microsoft Basic Render Driver")) {
-                pSelectedAdapter = pAdapter;
-                break;
-            }
-            pAdapter->Release();
-            adapterIdx++;
+        pCamera_ = new Camera;
+        if (!pCamera_) {
+            result = S_FALSE;
         }
     }
-    if (pSelectedAdapter == NULL) {
-        SAFE_RELEASE(pFactory);
-        return false;
+    if (SUCCEEDED(result)) {
+        pFrustum_ = new Frustum(SCREEN_NEAR);
+        if (!pFrustum_) {
+            result = S_FALSE;
+        }
     }
-
-    // Create DirectX11 pDevice_
-    D3D_FEATURE_LEVEL level;
-    D3D_FEATURE_LEVEL levels[] = { D3D_FEATURE_LEVEL_11_0 };
-    UINT flags = 0;
-#ifdef _DEBUG
-    flags |= D3D11_CREATE_DEVICE_DEBUG;
-#endif // _DEBUG
-    result = D3D11CreateDevice(
-        pSelectedAdapter,
-        D3D_DRIVER_TYPE_UNKNOWN,
-        NULL,
-        flags,
-        levels,
-        1,
-        D3D11_SDK_VERSION,
-        &pDevice_,
-        &level,
-        &pDeviceContext_
-    );
-    if (D3D_FEATURE_LEVEL_11_0 != level || !SUCCEEDED(result)) {
-        SAFE_RELEASE(pFactory);
-        SAFE_RELEASE(pSelectedAdapter);
-        Cleanup();
-        return false;
+    if (SUCCEEDED(result)) {
+        pJobSystem_ = new JobSystem;
+        if (!pJobSystem_) {
+            result = S_FALSE;
+        }
     }
-
-    // Create swap chain
-    DXGI_SWAP_CHAIN_DESC swapChainDesc = { 0 };
-    swapChainDesc.BufferCount = 2;
-    swapChainDesc.BufferDesc.Width = defaultWidth;
-    swapChainDesc.BufferDesc.Height = defaultHeight;
-    swapChainDesc.BufferDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-    swapChainDesc.BufferDesc.RefreshRate.Numerator = 0;
-    swapChainDesc.BufferDesc.RefreshRate.Denominator = 1;
-    swapChainDesc.BufferDesc.ScanlineOrdering = DXGI_MODE_SCANLINE_ORDER_UNSPECIFIED;
-    swapChainDesc.BufferDesc.Scaling = DXGI_MODE_SCALING_UNSPECIFIED;
-    swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
-    swapChainDesc.OutputWindow = hWnd;
-    swapChainDesc.SampleDesc.Count = 1;
-    swapChainDesc.SampleDesc.Quality = 0;
-    swapChainDesc.Windowed = true;
-    swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
-    swapChainDesc.Flags = 0;
-    result = pFactory->CreateSwapChain(pDevice_, &swapChainDesc, &pSwapChain_);
-
-    ID3D11Texture2D* pBackBuffer = NULL;
     if (SUCCEEDED(result)) {
-        result = pSwapChain_->GetBuffer(0, __uuidof(ID3D11Texture2D), (LPVOID*)&pBackBuffer);
+        pOcclusionCuller_ = new OcclusionCuller(OCCLUSION_WIDTH, OCCLUSION_HEIGHT);
+        if (!pOcclusionCuller_) {
+            result = S_FALSE;
+        }
     }
     if (SUCCEEDED(result)) {
-        result = pDevice_->CreateRenderTargetView(pBackBuffer, NULL, &pRenderTargetView_);
+        pUploadRing_ = new UploadRing(pDevice_);
+        if (!pUploadRing_) {
+            result = S_FALSE;
+        }
     }
     if (SUCCEEDED(result)) {
-        D3D11_QUERY_DESC desc;
-        desc.Query = D3D11_QUERY_PIPELINE_STATISTICS;
-        desc.MiscFlags = 0;
-        for (int i = 0; i < MAX_QUERY && SUCCEEDED(result); i++) {
-            result = pDevice_->CreateQuery(&desc, &queries_[i]);
+        pNullContext_ = new NullCommandContext;
+        if (!pNullContext_) {
+            result = S_FALSE;
         }
+        pContext_ = pDevice_->GetContext();
     }
     if (SUCCEEDED(result)) {
-        result = InitScene();
+        pSoftwareRasterizer_ = new SoftwareRasterizer(pJobSystem_);
+        if (!pSoftwareRasterizer_) {
+            result = S_FALSE;
+        }
+        else {
+            pSoftwareRasterizer_->Resize(defaultWidth, defaultHeight);
+        }
     }
-    SAFE_RELEASE(pFactory);
-    SAFE_RELEASE(pSelectedAdapter);
-    SAFE_RELEASE(pBackBuffer);
     if (SUCCEEDED(result)) {
-        pCamera_ = new Camera;
-        if (!pCamera_) {
+        pLodSelector_ = new LodSelector(2.0f, 32.0f);
+        if (!pLodSelector_) {
             result = S_FALSE;
         }
     }
     if (SUCCEEDED(result)) {
-        pInput_ = new Input;
-        if (!pInput_) {
+        pTemporalCuller_ = new TemporalCuller(0.5f);
+        if (!pTemporalCuller_) {
             result = S_FALSE;
         }
     }
     if (SUCCEEDED(result)) {
-        pFrustum_ = new Frustum(SCREEN_NEAR);
-        if (!pFrustum_) {
+        pSpatialIndex_ = SpatialIndex::Create(spatialIndexType_);
+        if (!pSpatialIndex_) {
             result = S_FALSE;
         }
     }
     if (SUCCEEDED(result)) {
-        result = pInput_->Init(hInstance, hWnd);
+        pLightClusters_ = new LightClusters(CLUSTER_X, CLUSTER_Y, CLUSTER_Z);
+        if (!pLightClusters_) {
+            result = S_FALSE;
+        }
+    }
+    if (SUCCEEDED(result)) {
+        pInstanceLights_ = new InstanceLights(4.0f);
+        if (!pInstanceLights_) {
+            result = S_FALSE;
+        }
+    }
+    if (SUCCEEDED(result)) {
+        pLightManager_ = new LightManager(32.0f);
+        if (!pLightManager_) {
+            result = S_FALSE;
+        }
+    }
+    if (SUCCEEDED(result)) {
+        pSkyIrradiance_ = new SkyIrradiance(pJobSystem_);
+        if (!pSkyIrradiance_) {
+            result = S_FALSE;
+        }
+    }
+    if (SUCCEEDED(result)) {
+        for (int i = 0; i < MAX_QUERY && SUCCEEDED(result); i++) {
+            result = pDevice_->CreateQuery(GpuQueryType::PipelineStatistics, &queries_[i]);
+        }
+    }
+    if (SUCCEEDED(result)) {
+        result = InitScene();
     }
     if (SUCCEEDED(result)) {
         result = InitRenderTexture(defaultWidth, defaultHeight);
@@ -145,8 +143,7 @@ bool Renderer::Init(HINSTANCE hInstance, HWND hWnd) {
     ImGui::CreateContext();
     ImGuiIO& io = ImGui::GetIO(); (void)io;
     ImGui::StyleColorsDark();
-    ImGui_ImplWin32_Init(hWnd);
-    ImGui_ImplDX11_Init(pDevice_, pDeviceContext_);
+    pDevice_->InitUI();
 
     if (FAILED(result)) {
         Cleanup();
@@ -156,59 +153,176 @@ bool Renderer::Init(HINSTANCE hInstance, HWND hWnd) {
 }
 
 HRESULT Renderer::InitRenderTexture(int textureWidth, int textureHeight) {
-    D3D11_TEXTURE2D_DESC textureDesc;
-    ZeroMemory(&textureDesc, sizeof(textureDesc));
-
-    textureDesc.Width = textureWidth;
-    textureDesc.Height = textureHeight;
-    textureDesc.MipLevels = 1;
-    textureDesc.ArraySize = 1;
-    textureDesc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
-    textureDesc.SampleDesc.Count = 1;
-    textureDesc.Usage = D3D11_USAGE_DEFAULT;
-    textureDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
-    textureDesc.CPUAccessFlags = 0;
-    textureDesc.MiscFlags = 0;
-
-    HRESULT result = pDevice_->CreateTexture2D(&textureDesc, NULL, &pRenderTargetTexture_);
+    GpuTextureDesc textureDesc = {};
+    textureDesc.width = textureWidth;
+    textureDesc.height = textureHeight;
+    textureDesc.mipLevels = 1;
+    textureDesc.arraySize = 1;
+    textureDesc.format = GpuFormat::R32G32B32A32Float;
+    textureDesc.sampleCount = 1;
+    textureDesc.usage = GpuUsage::Default;
+    textureDesc.bindFlags = GpuBind::RenderTarget | GpuBind::ShaderResource;
+    textureDesc.cpuAccessFlags = 0;
+    textureDesc.miscFlags = 0;
+
+    HRESULT result = pDevice_->CreateTexture2D(textureDesc, NULL, &pRenderTargetTexture_);
     if (FAILED(result)) {
         return result;
     }
 
-    D3D11_RENDER_TARGET_VIEW_DESC renderTargetViewDesc;
-    renderTargetViewDesc.Format = textureDesc.Format;
-    renderTargetViewDesc.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2D;
-    renderTargetViewDesc.Texture2D.MipSlice = 0;
+    result = pDevice_->CreateRenderTargetView(pRenderTargetTexture_, &pPostEffectRenderTargetView_);
+    if (FAILED(result)) {
+        return result;
+    }
 
-    result = pDevice_->CreateRenderTargetView(pRenderTargetTexture_, &renderTargetViewDesc, &pPostEffectRenderTargetView_);
+    result = pDevice_->CreateShaderResourceView(pRenderTargetTexture_, &pShaderResourceView_);
+    if (FAILED(result)) {
+        return result;
+    }
+
+    return S_OK;
+}
+
+void Renderer::GenerateCubes(int count) {
+    for (int i = 0; i < count; i++) {
+        InstanceDesc desc;
+        UINT textureIndex = (UINT)(rand() % 2);
+        desc.pos = XMFLOAT3((float)(rand() % 12 - 6), (float)(rand() % 12 - 6), (float)(rand() % 12 - 6));
+        desc.spin = (float)(rand() % 5);
+        desc.shine = 5.0f;
+        desc.textureId = textureIndex;
+        desc.normalMap = textureIndex == 0;
+        cubeHandles_.push_back(cubeStore_.Add(desc));
+    }
+}
+
+// Random cubes go, the last cube of the store takes the index of a removed one
+void Renderer::RemoveCubes(int count) {
+    for (int i = 0; i < count && !cubeHandles_.empty(); i++) {
+        size_t pos = (size_t)rand() % cubeHandles_.size();
+        cubeStore_.Remove(cubeHandles_[pos]);
+        cubeHandles_[pos] = cubeHandles_.back();
+        cubeHandles_.pop_back();
+    }
+}
+
+HRESULT Renderer::CreateStructuredBuffer(UINT stride, UINT count, bool withUAV, GpuBuffer** ppBuffer,
+    GpuShaderResourceView** ppSRV, GpuUnorderedAccessView** ppUAV) {
+    GpuBufferDesc desc = {};
+    desc.byteWidth = stride * count;
+    desc.usage = GpuUsage::Default;
+    desc.bindFlags = GpuBind::ShaderResource;
+    if (withUAV) {
+        desc.bindFlags |= GpuBind::UnorderedAccess;
+    }
+    desc.cpuAccessFlags = 0;
+    desc.miscFlags = GpuMisc::BufferStructured;
+    desc.structureByteStride = stride;
+
+    HRESULT result = pDevice_->CreateBuffer(desc, nullptr, ppBuffer);
+    if (SUCCEEDED(result) && ppSRV) {
+        result = pDevice_->CreateShaderResourceView(*ppBuffer, ppSRV);
+    }
+    if (SUCCEEDED(result) && ppUAV) {
+        result = pDevice_->CreateUnorderedAccessView(*ppBuffer, ppUAV);
+    }
+    return result;
+}
+
+void Renderer::ReleaseInstanceBuffers() {
+    SAFE_RELEASE(pGeomBufferInstSRV_);
+    SAFE_RELEASE(pGeomBufferInst_);
+    SAFE_RELEASE(pCullingBoundsSRV_[0]);
+    SAFE_RELEASE(pCullingBoundsSRV_[1]);
+    SAFE_RELEASE(pCullingBoundsMin_);
+    SAFE_RELEASE(pCullingBoundsMax_);
+    SAFE_RELEASE(pGeomBufferInstVisSRV_);
+    SAFE_RELEASE(pGeomBufferInstVis_);
+    SAFE_RELEASE(pGeomBufferInstVisGpuUAV_);
+    SAFE_RELEASE(pGeomBufferInstVisGpu_);
+    SAFE_RELEASE(pCullingGroupIdsUAV_);
+    SAFE_RELEASE(pCullingGroupIds_);
+    SAFE_RELEASE(pCullingGroupRangesUAV_);
+    SAFE_RELEASE(pCullingGroupRanges_);
+    SAFE_RELEASE(pInstanceLightRangesSRV_);
+    SAFE_RELEASE(pInstanceLightRanges_);
+    instanceCapacity_ = 0;
+}
+
+// Instance buffers grow geometrically and nothing is copied over: only dirty runs are uploaded, so UpdateScene
+// marks every instance dirty and forgets the uploaded index list when the capacity changes
+HRESULT Renderer::ReserveInstances(UINT count) {
+    if (count <= instanceCapacity_) {
+        return S_OK;
+    }
+    UINT capacity = instanceCapacity_ > initialInstanceCapacity ? instanceCapacity_ : initialInstanceCapacity;
+    while (capacity < count) {
+        capacity *= 2;
+    }
+
+    ReleaseInstanceBuffers();
+
+    HRESULT result = CreateStructuredBuffer(sizeof(InstanceData), capacity, false, &pGeomBufferInst_, &pGeomBufferInstSRV_, nullptr);
+    if (SUCCEEDED(result)) {
+        result = CreateStructuredBuffer(sizeof(XMFLOAT4), capacity, false, &pCullingBoundsMin_, &pCullingBoundsSRV_[0], nullptr);
+    }
+    if (SUCCEEDED(result)) {
+        result = CreateStructuredBuffer(sizeof(XMFLOAT4), capacity, false, &pCullingBoundsMax_, &pCullingBoundsSRV_[1], nullptr);
+    }
+    if (SUCCEEDED(result)) {
+        result = CreateStructuredBuffer(sizeof(UINT), capacity, false, &pGeomBufferInstVis_, &pGeomBufferInstVisSRV_, nullptr);
+    }
+    if (SUCCEEDED(result)) {
+        result = CreateStructuredBuffer(sizeof(UINT), capacity, true, &pGeomBufferInstVisGpu_, nullptr, &pGeomBufferInstVisGpuUAV_);
+    }
+    // The capacity is a multiple of the culling group size
+    if (SUCCEEDED(result)) {
+        result = CreateStructuredBuffer(sizeof(UINT), capacity, true, &pCullingGroupIds_, nullptr, &pCullingGroupIdsUAV_);
+    }
+    if (SUCCEEDED(result)) {
+        result = CreateStructuredBuffer(sizeof(XMUINT2), capacity / CULLING_GROUP_SIZE, true, &pCullingGroupRanges_, nullptr, &pCullingGroupRangesUAV_);
+    }
+    if (SUCCEEDED(result)) {
+        result = CreateStructuredBuffer(sizeof(XMUINT2), capacity, false, &pInstanceLightRanges_, &pInstanceLightRangesSRV_, nullptr);
+    }
     if (FAILED(result)) {
+        ReleaseInstanceBuffers();
         return result;
     }
 
-    D3D11_SHADER_RESOURCE_VIEW_DESC shaderResourceViewDesc;
-    shaderResourceViewDesc.Format = textureDesc.Format;
-    shaderResourceViewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-    shaderResourceViewDesc.Texture2D.MostDetailedMip = 0;
-    shaderResourceViewDesc.Texture2D.MipLevels = 1;
+    instanceCapacity_ = capacity;
+    return S_OK;
+}
 
-    result = pDevice_->CreateShaderResourceView(pRenderTargetTexture_, &shaderResourceViewDesc, &pShaderResourceView_);
+// Light index lists grow geometrically like the instance buffers
+HRESULT Renderer::ReserveLightIndices(UINT count, UINT& capacity, GpuBuffer** ppBuffer, GpuShaderResourceView** ppSRV) {
+    if (count <= capacity) {
+        return S_OK;
+    }
+    UINT newCapacity = capacity > initialLightIndexCapacity ? capacity : initialLightIndexCapacity;
+    while (newCapacity < count) {
+        newCapacity *= 2;
+    }
+
+    SAFE_RELEASE(*ppSRV);
+    SAFE_RELEASE(*ppBuffer);
+    capacity = 0;
+
+    HRESULT result = CreateStructuredBuffer(sizeof(UINT), newCapacity, false, ppBuffer, ppSRV, nullptr);
     if (FAILED(result)) {
+        SAFE_RELEASE(*ppSRV);
+        SAFE_RELEASE(*ppBuffer);
         return result;
     }
 
+    capacity = newCapacity;
     return S_OK;
 }
 
 HRESULT Renderer::InitScene() {
     HRESULT result;
 
-    for (int i = 0; i < MAX_CUBE; i++) {
-        Cube tmp;
-        float textureIndex = (float)(rand() % 2);
-        tmp.pos = XMFLOAT4((float)(rand() % 12 - 6), (float)(rand() % 12 - 6), (float)(rand() % 12 - 6), 1.0f);
-        tmp.shineSpeedIdNM = XMFLOAT4(5.0f, (float)(rand() % 5), textureIndex, textureIndex > 0.0f ? 0.0f : 1.0f);
-        cubes_.push_back(tmp);
-    }
+    GenerateCubes(initialCubeCount);
 
     static const Vertex Vertices[] = {
         {{-1.0, -1.0,  1.0}, {0,1}, {0,-1,0}, {1,0,0}},
@@ -249,18 +363,24 @@ HRESULT Renderer::InitScene() {
         16, 18, 17, 16, 19, 18,
         20, 22, 21, 20, 23, 22
     };
-    static const D3D11_INPUT_ELEMENT_DESC InputDesc[] = {
-        {"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0},
-        {"TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0},
-        {"NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 20, D3D11_INPUT_PER_VERTEX_DATA, 0},
-        {"TANGENT", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 32, D3D11_INPUT_PER_VERTEX_DATA, 0},
+    static const GpuInputElement InputDesc[] = {
+        {"POSITION", 0, GpuFormat::R32G32B32Float, 0, 0},
+        {"TEXCOORD", 0, GpuFormat::R32G32Float, 0, 12},
+        {"NORMAL", 0, GpuFormat::R32G32B32Float, 0, 20},
+        {"TANGENT", 0, GpuFormat::R32G32B32Float, 0, 32},
+    };
+    static const GpuInputElement PackedInputDesc[] = {
+        {"POSITION", 0, GpuFormat::R16G16B16A16Unorm, 0, 0},
+        {"TEXCOORD", 0, GpuFormat::R16G16Float, 0, 8},
+        {"NORMAL", 0, GpuFormat::R16G16Snorm, 0, 12},
+        {"TANGENT", 0, GpuFormat::R16G16Snorm, 0, 16},
     };
 
     static const USHORT IndicesT[] = {
         0, 2, 1, 0, 3, 2
     };
-    static const D3D11_INPUT_ELEMENT_DESC InputDescT[] = {
-        {"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0}
+    static const GpuInputElement InputDescT[] = {
+        {"POSITION", 0, GpuFormat::R32G32B32Float, 0, 0}
     };
 
     UINT LatLines = 20, LongLines = 20;
@@ -286,644 +406,527 @@ HRESULT Renderer::InitScene() {
             XMMATRIX Rotationy = XMMatrixRotationZ(phi);
             currVertPos = XMVector3TransformNormal(XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f), (Rotationx * Rotationy));
             currVertPos = XMVector3Normalize(currVertPos);
-            vertices[i * (__int64)LongLines + j + 1].x = XMVectorGetX(currVertPos);
-            vertices[i * (__int64)LongLines + j + 1].y = XMVectorGetY(currVertPos);
-            vertices[i * (__int64)LongLines + j + 1].z = XMVectorGetZ(currVertPos);
+            vertices[i * (size_t)LongLines + j + 1].x = XMVectorGetX(currVertPos);
+            vertices[i * (size_t)LongLines + j + 1].y = XMVectorGetY(currVertPos);
+            vertices[i * (size_t)LongLines + j + 1].z = XMVectorGetZ(currVertPos);
         }
     }
 
-    vertices[(__int64)numSphereVertices - 1].x = 0.0f;
-    vertices[(__int64)numSphereVertices - 1].y = 0.0f;
-    vertices[(__int64)numSphereVertices - 1].z = -1.0f;
+    vertices[(size_t)numSphereVertices - 1].x = 0.0f;
+    vertices[(size_t)numSphereVertices - 1].y = 0.0f;
+    vertices[(size_t)numSphereVertices - 1].z = -1.0f;
 
-    std::vector<UINT> indices((__int64)numSphereTriangles_ * 3);
+    std::vector<UINT> indices((size_t)numSphereTriangles_ * 3);
 
     UINT k = 0;
     for (UINT i = 0; i < LongLines - 1; i++) {
         indices[k] = 0;
-        indices[(__int64)k + 2] = i + 1;
-        indices[(__int64)k + 1] = i + 2;
+        indices[(size_t)k + 2] = i + 1;
+        indices[(size_t)k + 1] = i + 2;
         k += 3;
     }
     indices[k] = 0;
-    indices[(__int64)k + 2] = LongLines;
-    indices[(__int64)k + 1] = 1;
+    indices[(size_t)k + 2] = LongLines;
+    indices[(size_t)k + 1] = 1;
     k += 3;
 
     for (UINT i = 0; i < LatLines - 3; i++) {
         for (UINT j = 0; j < LongLines - 1; j++) {
             indices[k] = i * LongLines + j + 1;
-            indices[(__int64)k + 1] = i * LongLines + j + 2;
-            indices[(__int64)k + 2] = (i + 1) * LongLines + j + 1;
+            indices[(size_t)k + 1] = i * LongLines + j + 2;
+            indices[(size_t)k + 2] = (i + 1) * LongLines + j + 1;
 
-            indices[(__int64)k + 3] = (i + 1) * LongLines + j + 1;
-            indices[(__int64)k + 4] = i * LongLines + j + 2;
-            indices[(__int64)k + 5] = (i + 1) * LongLines + j + 2;
+            indices[(size_t)k + 3] = (i + 1) * LongLines + j + 1;
+            indices[(size_t)k + 4] = i * LongLines + j + 2;
+            indices[(size_t)k + 5] = (i + 1) * LongLines + j + 2;
 
             k += 6;
         }
 
         indices[k] = (i * LongLines) + LongLines;
-        indices[(__int64)k + 1] = (i * LongLines) + 1;
-        indices[(__int64)k + 2] = ((i + 1) * LongLines) + LongLines;
+        indices[(size_t)k + 1] = (i * LongLines) + 1;
+        indices[(size_t)k + 2] = ((i + 1) * LongLines) + LongLines;
 
-        indices[(__int64)k + 3] = ((i + 1) * LongLines) + LongLines;
-        indices[(__int64)k + 4] = (i * LongLines) + 1;
-        indices[(__int64)k + 5] = ((i + 1) * LongLines) + 1;
+        indices[(size_t)k + 3] = ((i + 1) * LongLines) + LongLines;
+        indices[(size_t)k + 4] = (i * LongLines) + 1;
+        indices[(size_t)k + 5] = ((i + 1) * LongLines) + 1;
 
         k += 6;
     }
 
     for (UINT i = 0; i < LongLines - 1; i++) {
         indices[k] = numSphereVertices - 1;
-        indices[(__int64)k + 2] = (numSphereVertices - 1) - (i + 1);
-        indices[(__int64)k + 1] = (numSphereVertices - 1) - (i + 2);
+        indices[(size_t)k + 2] = (numSphereVertices - 1) - (i + 1);
+        indices[(size_t)k + 1] = (numSphereVertices - 1) - (i + 2);
         k += 3;
     }
 
     indices[k] = numSphereVertices - 1;
-    indices[(__int64)k + 2] = (numSphereVertices - 1) - LongLines;
-    indices[(__int64)k + 1] = numSphereVertices - 2;
+    indices[(size_t)k + 2] = (numSphereVertices - 1) - LongLines;
+    indices[(size_t)k + 1] = numSphereVertices - 2;
+
+    // LOD 0 is the whole cube, LOD 1 has 8 variants with the faces seen from every octant, see LodSelector::FacingOctant
+    std::vector<USHORT> lodIndices(Indices, Indices + sizeof(Indices) / sizeof(Indices[0]));
+    for (UINT octant = 0; octant < 8; octant++) {
+        const UINT faces[3] = { octant & 1 ? 2u : 3u, octant & 2 ? 1u : 0u, octant & 4 ? 4u : 5u };
+        for (UINT face : faces) {
+            lodIndices.insert(lodIndices.end(), Indices + face * 6, Indices + face * 6 + 6);
+        }
+    }
+
+    cubeVertices_.assign(Vertices, Vertices + sizeof(Vertices) / sizeof(Vertices[0]));
+    cubeIndices_.assign(Indices, Indices + sizeof(Indices) / sizeof(Indices[0]));
+    skyVertices_ = vertices;
+    skyIndices_ = indices;
+    transparentIndices_.assign(IndicesT, IndicesT + sizeof(IndicesT) / sizeof(IndicesT[0]));
 
-    static const D3D11_INPUT_ELEMENT_DESC SkyboxInputDesc[] = {
-        {"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0},
+    static const GpuInputElement SkyboxInputDesc[] = {
+        {"POSITION", 0, GpuFormat::R32G32B32Float, 0, 0},
     };
 
-    D3D11_BUFFER_DESC desc = {};
-    desc.ByteWidth = sizeof(Vertices);
-    desc.Usage = D3D11_USAGE_IMMUTABLE;
-    desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-    desc.CPUAccessFlags = 0;
-    desc.MiscFlags = 0;
-    desc.StructureByteStride = 0;
+    const UINT numVertices = sizeof(Vertices) / sizeof(Vertices[0]);
+    PackedVertex packedVertices[numVertices];
+    MeshQuantization quantization = PackVertices(Vertices, numVertices, packedVertices);
 
-    D3D11_SUBRESOURCE_DATA data;
-    data.pSysMem = &Vertices;
-    data.SysMemPitch = sizeof(Vertices);
-    data.SysMemSlicePitch = 0;
+    GpuBufferDesc desc = {};
+    desc.byteWidth = withQuantizedVertices_ ? sizeof(packedVertices) : sizeof(Vertices);
+    desc.usage = GpuUsage::Immutable;
+    desc.bindFlags = GpuBind::VertexBuffer;
+    desc.cpuAccessFlags = 0;
+    desc.miscFlags = 0;
+    desc.structureByteStride = 0;
 
-    result = pDevice_->CreateBuffer(&desc, &data, &pVertexBuffer_[0]);
+    GpuSubresourceData data;
+    data.pSysMem = withQuantizedVertices_ ? (const void*)packedVertices : (const void*)Vertices;
+    data.sysMemPitch = desc.byteWidth;
+    data.sysMemSlicePitch = 0;
+
+    result = pDevice_->CreateBuffer(desc, &data, &pVertexBuffer_[0]);
 
     if (SUCCEEDED(result)) {
-        D3D11_BUFFER_DESC desc = {};
-        desc.ByteWidth = sizeof(Indices);
-        desc.Usage = D3D11_USAGE_IMMUTABLE;
-        desc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-        desc.CPUAccessFlags = 0;
-        desc.MiscFlags = 0;
-        desc.StructureByteStride = 0;
+        GpuBufferDesc desc = {};
+        desc.byteWidth = sizeof(MeshQuantization);
+        desc.usage = GpuUsage::Immutable;
+        desc.bindFlags = GpuBind::ConstantBuffer;
+        desc.cpuAccessFlags = 0;
+        desc.miscFlags = 0;
+        desc.structureByteStride = 0;
 
-        D3D11_SUBRESOURCE_DATA data;
-        data.pSysMem = &Indices;
-        data.SysMemPitch = sizeof(Indices);
-        data.SysMemSlicePitch = 0;
+        GpuSubresourceData data;
+        data.pSysMem = &quantization;
+        data.sysMemPitch = sizeof(quantization);
+        data.sysMemSlicePitch = 0;
 
-        result = pDevice_->CreateBuffer(&desc, &data, &pIndexBuffer_[0]);
+        result = pDevice_->CreateBuffer(desc, &data, &pMeshBuffer_);
     }
+
     if (SUCCEEDED(result)) {
-        D3D11_BUFFER_DESC desc = {};
-        desc.ByteWidth = sizeof(D3D11_DRAW_INDEXED_INSTANCED_INDIRECT_ARGS);
-        desc.Usage = D3D11_USAGE_DEFAULT;
-        desc.BindFlags = D3D11_BIND_UNORDERED_ACCESS;
-        desc.CPUAccessFlags = 0;
-        desc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
-        desc.StructureByteStride = sizeof(UINT);
-
-        result = pDevice_->CreateBuffer(&desc, nullptr, &pInderectArgsSrc_);
-        if (SUCCEEDED(result)) {
-            result = pDevice_->CreateUnorderedAccessView(pInderectArgsSrc_, nullptr, &pInderectArgsUAV_);
-        }
+        GpuBufferDesc desc = {};
+        desc.byteWidth = UINT(sizeof(USHORT) * lodIndices.size());
+        desc.usage = GpuUsage::Immutable;
+        desc.bindFlags = GpuBind::IndexBuffer;
+        desc.cpuAccessFlags = 0;
+        desc.miscFlags = 0;
+        desc.structureByteStride = 0;
+
+        GpuSubresourceData data;
+        data.pSysMem = lodIndices.data();
+        data.sysMemPitch = desc.byteWidth;
+        data.sysMemSlicePitch = 0;
+
+        result = pDevice_->CreateBuffer(desc, &data, &pIndexBuffer_[0]);
     }
     if (SUCCEEDED(result)) {
-        D3D11_BUFFER_DESC desc = {};
-        desc.ByteWidth = sizeof(D3D11_DRAW_INDEXED_INSTANCED_INDIRECT_ARGS);
-        desc.Usage = D3D11_USAGE_DEFAULT;
-        desc.BindFlags = 0;
-        desc.CPUAccessFlags = 0;
-        desc.MiscFlags = D3D11_RESOURCE_MISC_DRAWINDIRECT_ARGS;
-        desc.StructureByteStride = 0;
+        GpuBufferDesc desc = {};
+        desc.byteWidth = sizeof(XMUINT4);
+        desc.usage = GpuUsage::Default;
+        desc.bindFlags = GpuBind::ConstantBuffer;
+        desc.cpuAccessFlags = 0;
+        desc.miscFlags = 0;
+        desc.structureByteStride = 0;
 
-        result = pDevice_->CreateBuffer(&desc, nullptr, &pInderectArgs_);
+        result = pDevice_->CreateBuffer(desc, nullptr, &pDrawBuffer_);
     }
     if (SUCCEEDED(result)) {
-        D3D11_BUFFER_DESC desc = {};
-        desc.ByteWidth = sizeof(XMINT4) * MAX_CUBE;
-        desc.Usage = D3D11_USAGE_DEFAULT;
-        desc.BindFlags = D3D11_BIND_UNORDERED_ACCESS;
-        desc.CPUAccessFlags = 0;
-        desc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
-        desc.StructureByteStride = sizeof(XMINT4);
-
-        result = pDevice_->CreateBuffer(&desc, nullptr, &pGeomBufferInstVisGpu_);
+        GpuBufferDesc desc = {};
+        desc.byteWidth = sizeof(GpuDrawIndexedIndirectArgs);
+        desc.usage = GpuUsage::Default;
+        desc.bindFlags = GpuBind::UnorderedAccess;
+        desc.cpuAccessFlags = 0;
+        desc.miscFlags = GpuMisc::BufferStructured;
+        desc.structureByteStride = sizeof(UINT);
+
+        result = pDevice_->CreateBuffer(desc, nullptr, &pInderectArgsSrc_);
         if (SUCCEEDED(result)) {
-            result = pDevice_->CreateUnorderedAccessView(pGeomBufferInstVisGpu_, nullptr, &pGeomBufferInstVisGpuUAV_);
+            result = pDevice_->CreateUnorderedAccessView(pInderectArgsSrc_, &pInderectArgsUAV_);
         }
     }
     if (SUCCEEDED(result)) {
-        D3D11_BUFFER_DESC desc = {};
-        desc.ByteWidth = sizeof(XMINT4) * MAX_CUBE;
-        desc.Usage = D3D11_USAGE_DEFAULT;
-        desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-        desc.CPUAccessFlags = 0;
-        desc.MiscFlags = 0;
-        desc.StructureByteStride = 0;
+        GpuBufferDesc desc = {};
+        desc.byteWidth = sizeof(GpuDrawIndexedIndirectArgs);
+        desc.usage = GpuUsage::Default;
+        desc.bindFlags = 0;
+        desc.cpuAccessFlags = 0;
+        desc.miscFlags = GpuMisc::DrawIndirectArgs;
+        desc.structureByteStride = 0;
 
-        result = pDevice_->CreateBuffer(&desc, nullptr, &pGeomBufferInstVis_);
+        result = pDevice_->CreateBuffer(desc, nullptr, &pInderectArgs_);
+    }
+    if (SUCCEEDED(result)) {
+        result = ReserveInstances(initialInstanceCapacity);
     }
-
-    ID3D10Blob* vertexShaderBuffer = nullptr;
-    ID3D10Blob* pixelShaderBuffer = nullptr;
-    ID3D10Blob* computeShaderBuffer = nullptr;
-    int flags = 0;
-#ifdef _DEBUG
-    flags = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
-#endif
-
-    D3DInclude includeObj;
 
     if (SUCCEEDED(result)) {
-        result = D3DCompileFromFile(L"VS.hlsl", NULL, &includeObj, "main", "vs_5_0", flags, 0, &vertexShaderBuffer, NULL);
-        if (SUCCEEDED(result)) {
-            result = pDevice_->CreateVertexShader(vertexShaderBuffer->GetBufferPointer(), vertexShaderBuffer->GetBufferSize(), NULL, &pVertexShader_[0]);
-        }
+        static const GpuShaderMacro Shader_Macros[] = { {"QUANTIZED_VERTICES", "1"}, {NULL, NULL} };
+        result = pDevice_->CreateVertexShader({ "VS.hlsl", "main", withQuantizedVertices_ ? Shader_Macros : NULL }, &pVertexShader_[0]);
     }
     if (SUCCEEDED(result)) {
-        result = D3DCompileFromFile(L"PS.hlsl", NULL, &includeObj, "main", "ps_5_0", flags, 0, &pixelShaderBuffer, NULL);
-        if (SUCCEEDED(result)) {
-            result = pDevice_->CreatePixelShader(pixelShaderBuffer->GetBufferPointer(), pixelShaderBuffer->GetBufferSize(), NULL, &pPixelShader_[0]);
-        }
+        result = pDevice_->CreatePixelShader({ "PS.hlsl", "main", NULL }, &pPixelShader_[0]);
     }
     if (SUCCEEDED(result)) {
-        result = D3DCompileFromFile(L"FCS.hlsl", NULL, &includeObj, "main", "cs_5_0", flags, 0, &computeShaderBuffer, NULL);
-        if (SUCCEEDED(result)) {
-            result = pDevice_->CreateComputeShader(computeShaderBuffer->GetBufferPointer(), computeShaderBuffer->GetBufferSize(), NULL, &pCullingShader_);
-        }
+        result = pDevice_->CreateComputeShader({ "FCS.hlsl", "main", NULL }, &pCullingShader_);
     }
     if (SUCCEEDED(result)) {
-        int numElements = sizeof(InputDesc) / sizeof(InputDesc[0]);
-        result = pDevice_->CreateInputLayout(InputDesc, numElements, vertexShaderBuffer->GetBufferPointer(), vertexShaderBuffer->GetBufferSize(), &pInputLayout_[0]);
+        result = pDevice_->CreateComputeShader({ "FCS.hlsl", "ScanGroups", NULL }, &pCullingScanShader_);
     }
-
-    SAFE_RELEASE(vertexShaderBuffer);
-    SAFE_RELEASE(pixelShaderBuffer);
-    SAFE_RELEASE(computeShaderBuffer);
-
     if (SUCCEEDED(result)) {
-        D3D11_BUFFER_DESC desc = {};
-        desc.ByteWidth = sizeof(GeomBuffer) * MAX_CUBE;
-        desc.Usage = D3D11_USAGE_DEFAULT;
-        desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-        desc.CPUAccessFlags = 0;
-        desc.MiscFlags = 0;
-        desc.StructureByteStride = 0;
-
-        GeomBuffer geomBufferInst[MAX_CUBE];
-        CullingParams cullingParams;
-        for (int i = 0; i < cubes_.size(); i++) {
-            geomBufferInst[i].worldMatrix = XMMatrixTranslation(cubes_[i].pos.x, cubes_[i].pos.y, cubes_[i].pos.z);
-            geomBufferInst[i].norm = geomBufferInst[i].worldMatrix;
-            geomBufferInst[i].shineSpeedTexIdNM = cubes_[i].shineSpeedIdNM;
-
-            XMFLOAT4 min, max;
-            XMStoreFloat4(&min, XMVector4Transform(XMLoadFloat4(&AABB[0]), geomBufferInst[i].worldMatrix));
-            XMStoreFloat4(&max, XMVector4Transform(XMLoadFloat4(&AABB[7]), geomBufferInst[i].worldMatrix));
-            cullingParams.bbMin[i] = min;
-            cullingParams.bbMax[i] = max;
+        result = pDevice_->CreateComputeShader({ "FCS.hlsl", "Compact", NULL }, &pCullingCompactShader_);
+    }
+    if (SUCCEEDED(result)) {
+        if (withQuantizedVertices_) {
+            UINT numElements = sizeof(PackedInputDesc) / sizeof(PackedInputDesc[0]);
+            result = pDevice_->CreateInputLayout(PackedInputDesc, numElements, pVertexShader_[0], &pInputLayout_[0]);
         }
-        cullingParams.numShapes = XMINT4(int(cubes_.size()), 0, 0, 0);
+        else {
+            UINT numElements = sizeof(InputDesc) / sizeof(InputDesc[0]);
+            result = pDevice_->CreateInputLayout(InputDesc, numElements, pVertexShader_[0], &pInputLayout_[0]);
+        }
+    }
 
-        D3D11_SUBRESOURCE_DATA data;
-        data.pSysMem = &geomBufferInst;
-        data.SysMemPitch = sizeof(geomBufferInst);
-        data.SysMemSlicePitch = 0;
+    if (SUCCEEDED(result)) {
+        GpuBufferDesc desc = {};
+        desc.byteWidth = sizeof(CullingParams);
+        desc.usage = GpuUsage::Default;
+        desc.bindFlags = GpuBind::ConstantBuffer;
+        desc.cpuAccessFlags = 0;
+        desc.miscFlags = 0;
+        desc.structureByteStride = 0;
 
-        result = pDevice_->CreateBuffer(&desc, &data, &pGeomBufferInst_);
+        CullingParams cullingParams;
+        cullingParams.numShapes = XMINT4(0, 0, 0, 0);
 
-        if (SUCCEEDED(result)) {
-            data.pSysMem = &cullingParams;
-            data.SysMemPitch = sizeof(cullingParams);
-            data.SysMemSlicePitch = 0;
-            result = pDevice_->CreateBuffer(&desc, &data, &pCullingParams_);
-        }
+        GpuSubresourceData data;
+        data.pSysMem = &cullingParams;
+        data.sysMemPitch = sizeof(cullingParams);
+        data.sysMemSlicePitch = 0;
+
+        result = pDevice_->CreateBuffer(desc, &data, &pCullingParams_);
 
-        desc.ByteWidth = sizeof(TransparentWorldMatrixBuffer);
-        desc.Usage = D3D11_USAGE_DEFAULT;
-        desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-        desc.CPUAccessFlags = 0;
-        desc.MiscFlags = 0;
-        desc.StructureByteStride = 0;
+        desc.byteWidth = sizeof(TransparentWorldMatrixBuffer);
+        desc.usage = GpuUsage::Default;
+        desc.bindFlags = GpuBind::ConstantBuffer;
+        desc.cpuAccessFlags = 0;
+        desc.miscFlags = 0;
+        desc.structureByteStride = 0;
 
         TransparentWorldMatrixBuffer worldMatrixBuffer;
 
         data.pSysMem = &worldMatrixBuffer;
-        data.SysMemPitch = sizeof(worldMatrixBuffer);
-        data.SysMemSlicePitch = 0;
+        data.sysMemPitch = sizeof(worldMatrixBuffer);
+        data.sysMemSlicePitch = 0;
         if (SUCCEEDED(result)) {
             worldMatrixBuffer.worldMatrix = TransparentMatrixs[0];
             worldMatrixBuffer.color = XMFLOAT4(1.0f, 0.0f, 0.0f, 0.0f);
-            result = pDevice_->CreateBuffer(&desc, &data, &pPlanesWorldMatrixBuffer_[0]);
+            result = pDevice_->CreateBuffer(desc, &data, &pPlanesWorldMatrixBuffer_[0]);
         }
         if (SUCCEEDED(result)) {
             worldMatrixBuffer.worldMatrix = TransparentMatrixs[1];
             worldMatrixBuffer.color = XMFLOAT4(0.0f, 1.0f, 0.0f, 0.0f);
-            result = pDevice_->CreateBuffer(&desc, &data, &pPlanesWorldMatrixBuffer_[1]);
+            result = pDevice_->CreateBuffer(desc, &data, &pPlanesWorldMatrixBuffer_[1]);
         }
     }
     if (SUCCEEDED(result)) {
-        D3D11_BUFFER_DESC desc = {};
-        desc.ByteWidth = sizeof(SceneBuffer);
-        desc.Usage = D3D11_USAGE_DYNAMIC;
-        desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-        desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-        desc.MiscFlags = 0;
-        desc.StructureByteStride = 0;
+        GpuBufferDesc desc = {};
+        desc.byteWidth = sizeof(SceneBuffer);
+        desc.usage = GpuUsage::Dynamic;
+        desc.bindFlags = GpuBind::ConstantBuffer;
+        desc.cpuAccessFlags = GpuCpuAccess::Write;
+        desc.miscFlags = 0;
+        desc.structureByteStride = 0;
 
-        result = pDevice_->CreateBuffer(&desc, nullptr, &pViewMatrixBuffer_[0]);
+        result = pDevice_->CreateBuffer(desc, nullptr, &pViewMatrixBuffer_[0]);
     }
     if (SUCCEEDED(result)) {
-        D3D11_BUFFER_DESC desc = {};
-        desc.ByteWidth = sizeof(LightBuffer);
-        desc.Usage = D3D11_USAGE_DYNAMIC;
-        desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-        desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-        desc.MiscFlags = 0;
-        desc.StructureByteStride = 0;
+        GpuBufferDesc desc = {};
+        desc.byteWidth = sizeof(LightBuffer);
+        desc.usage = GpuUsage::Dynamic;
+        desc.bindFlags = GpuBind::ConstantBuffer;
+        desc.cpuAccessFlags = GpuCpuAccess::Write;
+        desc.miscFlags = 0;
+        desc.structureByteStride = 0;
 
-        result = pDevice_->CreateBuffer(&desc, nullptr, &pLightBuffer_);
+        result = pDevice_->CreateBuffer(desc, nullptr, &pLightBuffer_);
+    }
+    if (SUCCEEDED(result)) {
+        result = CreateStructuredBuffer(sizeof(Light), MAX_LIGHT, false, &pLightsBuffer_, &pLightsSRV_, nullptr);
+    }
+    if (SUCCEEDED(result)) {
+        result = CreateStructuredBuffer(sizeof(XMUINT2), CLUSTER_X * CLUSTER_Y * CLUSTER_Z, false, &pClusterRanges_, &pClusterRangesSRV_, nullptr);
+    }
+    if (SUCCEEDED(result)) {
+        result = ReserveLightIndices(initialLightIndexCapacity, clusterLightCapacity_, &pClusterLights_, &pClusterLightsSRV_);
+    }
+    if (SUCCEEDED(result)) {
+        result = ReserveLightIndices(initialLightIndexCapacity, instanceLightCapacity_, &pInstanceLightIndices_, &pInstanceLightIndicesSRV_);
     }
     {
         if (SUCCEEDED(result)) {
-            D3D11_BUFFER_DESC desc = {};
-            desc.ByteWidth = sizeof(SkyboxVertex) * numSphereVertices;
-            desc.Usage = D3D11_USAGE_IMMUTABLE;
-            desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-            desc.CPUAccessFlags = 0;
-            desc.MiscFlags = 0;
-            desc.StructureByteStride = 0;
-
-            D3D11_SUBRESOURCE_DATA data;
-            ZeroMemory(&data, sizeof(data));
+            GpuBufferDesc desc = {};
+            desc.byteWidth = sizeof(SkyboxVertex) * numSphereVertices;
+            desc.usage = GpuUsage::Immutable;
+            desc.bindFlags = GpuBind::VertexBuffer;
+            desc.cpuAccessFlags = 0;
+            desc.miscFlags = 0;
+            desc.structureByteStride = 0;
+
+            GpuSubresourceData data = {};
             data.pSysMem = &vertices[0];
-            result = pDevice_->CreateBuffer(&desc, &data, &pVertexBuffer_[1]);
+            result = pDevice_->CreateBuffer(desc, &data, &pVertexBuffer_[1]);
         }
         if (SUCCEEDED(result)) {
-            D3D11_BUFFER_DESC desc = {};
-            ZeroMemory(&desc, sizeof(desc));
-            desc.ByteWidth = sizeof(UINT) * numSphereTriangles_ * 3;
-            desc.Usage = D3D11_USAGE_IMMUTABLE;
-            desc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-            desc.CPUAccessFlags = 0;
-            desc.MiscFlags = 0;
-            desc.StructureByteStride = 0;
-
-            D3D11_SUBRESOURCE_DATA data;
+            GpuBufferDesc desc = {};
+            desc.byteWidth = sizeof(UINT) * numSphereTriangles_ * 3;
+            desc.usage = GpuUsage::Immutable;
+            desc.bindFlags = GpuBind::IndexBuffer;
+            desc.cpuAccessFlags = 0;
+            desc.miscFlags = 0;
+            desc.structureByteStride = 0;
+
+            GpuSubresourceData data;
             data.pSysMem = &indices[0];
 
-            result = pDevice_->CreateBuffer(&desc, &data, &pIndexBuffer_[1]);
+            result = pDevice_->CreateBuffer(desc, &data, &pIndexBuffer_[1]);
         }
 
-        ID3D10Blob* vertexShaderBuffer = nullptr;
-        ID3D10Blob* pixelShaderBuffer = nullptr;
-        int flags = 0;
-#ifdef _DEBUG
-        flags = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
-#endif
-
         if (SUCCEEDED(result)) {
-            result = D3DCompileFromFile(L"CubeMapVS.hlsl", NULL, NULL, "main", "vs_5_0", flags, 0, &vertexShaderBuffer, NULL);
-            if (SUCCEEDED(result)) {
-                result = pDevice_->CreateVertexShader(vertexShaderBuffer->GetBufferPointer(), vertexShaderBuffer->GetBufferSize(), NULL, &pVertexShader_[1]);
-            }
+            result = pDevice_->CreateVertexShader({ "CubeMapVS.hlsl", "main", NULL }, &pVertexShader_[1]);
         }
         if (SUCCEEDED(result)) {
-            result = D3DCompileFromFile(L"CubeMapPS.hlsl", NULL, NULL, "main", "ps_5_0", flags, 0, &pixelShaderBuffer, NULL);
-            if (SUCCEEDED(result)) {
-                result = pDevice_->CreatePixelShader(pixelShaderBuffer->GetBufferPointer(), pixelShaderBuffer->GetBufferSize(), NULL, &pPixelShader_[1]);
-            }
+            result = pDevice_->CreatePixelShader({ "CubeMapPS.hlsl", "main", NULL }, &pPixelShader_[1]);
         }
         if (SUCCEEDED(result)) {
-            int numElements = sizeof(SkyboxInputDesc) / sizeof(SkyboxInputDesc[0]);
-            result = pDevice_->CreateInputLayout(SkyboxInputDesc, numElements, vertexShaderBuffer->GetBufferPointer(), vertexShaderBuffer->GetBufferSize(), &pInputLayout_[1]);
+            UINT numElements = sizeof(SkyboxInputDesc) / sizeof(SkyboxInputDesc[0]);
+            result = pDevice_->CreateInputLayout(SkyboxInputDesc, numElements, pVertexShader_[1], &pInputLayout_[1]);
         }
 
-        SAFE_RELEASE(vertexShaderBuffer);
-        SAFE_RELEASE(pixelShaderBuffer);
-
         if (SUCCEEDED(result)) {
-            D3D11_BUFFER_DESC desc = {};
-            desc.ByteWidth = sizeof(SkyboxWorldMatrixBuffer);
-            desc.Usage = D3D11_USAGE_DEFAULT;
-            desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-            desc.CPUAccessFlags = 0;
-            desc.MiscFlags = 0;
-            desc.StructureByteStride = 0;
+            GpuBufferDesc desc = {};
+            desc.byteWidth = sizeof(SkyboxWorldMatrixBuffer);
+            desc.usage = GpuUsage::Default;
+            desc.bindFlags = GpuBind::ConstantBuffer;
+            desc.cpuAccessFlags = 0;
+            desc.miscFlags = 0;
+            desc.structureByteStride = 0;
 
             SkyboxWorldMatrixBuffer skyboxWorldMatrixBuffer;
 
             skyboxWorldMatrixBuffer.worldMatrix = XMMatrixIdentity();
             skyboxWorldMatrixBuffer.size = XMFLOAT4(radius_, 0.0f, 0.0f, 0.0f);
 
-            D3D11_SUBRESOURCE_DATA data;
+            GpuSubresourceData data;
             data.pSysMem = &skyboxWorldMatrixBuffer;
-            data.SysMemPitch = sizeof(skyboxWorldMatrixBuffer);
-            data.SysMemSlicePitch = 0;
+            data.sysMemPitch = sizeof(skyboxWorldMatrixBuffer);
+            data.sysMemSlicePitch = 0;
 
-            result = pDevice_->CreateBuffer(&desc, &data, &pSkyboxWorldMatrixBuffer_);
+            result = pDevice_->CreateBuffer(desc, &data, &pSkyboxWorldMatrixBuffer_);
         }
         if (SUCCEEDED(result)) {
-            D3D11_BUFFER_DESC desc = {};
-            desc.ByteWidth = sizeof(SkyboxViewMatrixBuffer);
-            desc.Usage = D3D11_USAGE_DYNAMIC;
-            desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-            desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-            desc.MiscFlags = 0;
-            desc.StructureByteStride = 0;
-
-            result = pDevice_->CreateBuffer(&desc, nullptr, &pViewMatrixBuffer_[1]);
+            GpuBufferDesc desc = {};
+            desc.byteWidth = sizeof(SkyboxViewMatrixBuffer);
+            desc.usage = GpuUsage::Dynamic;
+            desc.bindFlags = GpuBind::ConstantBuffer;
+            desc.cpuAccessFlags = GpuCpuAccess::Write;
+            desc.miscFlags = 0;
+            desc.structureByteStride = 0;
+
+            result = pDevice_->CreateBuffer(desc, nullptr, &pViewMatrixBuffer_[1]);
         }
     }
     {
         if (SUCCEEDED(result)) {
-            D3D11_BUFFER_DESC desc = {};
-            desc.ByteWidth = sizeof(VerticesT);
-            desc.Usage = D3D11_USAGE_IMMUTABLE;
-            desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-            desc.CPUAccessFlags = 0;
-            desc.MiscFlags = 0;
-            desc.StructureByteStride = 0;
-
-            D3D11_SUBRESOURCE_DATA data;
+            GpuBufferDesc desc = {};
+            desc.byteWidth = sizeof(VerticesT);
+            desc.usage = GpuUsage::Immutable;
+            desc.bindFlags = GpuBind::VertexBuffer;
+            desc.cpuAccessFlags = 0;
+            desc.miscFlags = 0;
+            desc.structureByteStride = 0;
+
+            GpuSubresourceData data;
             data.pSysMem = &VerticesT;
-            data.SysMemPitch = sizeof(VerticesT);
-            data.SysMemSlicePitch = 0;
+            data.sysMemPitch = sizeof(VerticesT);
+            data.sysMemSlicePitch = 0;
 
-            result = pDevice_->CreateBuffer(&desc, &data, &pVertexBuffer_[2]);
+            result = pDevice_->CreateBuffer(desc, &data, &pVertexBuffer_[2]);
         }
         if (SUCCEEDED(result)) {
-            D3D11_BUFFER_DESC desc = {};
-            desc.ByteWidth = sizeof(IndicesT);
-            desc.Usage = D3D11_USAGE_IMMUTABLE;
-            desc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-            desc.CPUAccessFlags = 0;
-            desc.MiscFlags = 0;
-            desc.StructureByteStride = 0;
-
-            D3D11_SUBRESOURCE_DATA data;
+            GpuBufferDesc desc = {};
+            desc.byteWidth = sizeof(IndicesT);
+            desc.usage = GpuUsage::Immutable;
+            desc.bindFlags = GpuBind::IndexBuffer;
+            desc.cpuAccessFlags = 0;
+            desc.miscFlags = 0;
+            desc.structureByteStride = 0;
+
+            GpuSubresourceData data;
             data.pSysMem = &IndicesT;
-            data.SysMemPitch = sizeof(IndicesT);
-            data.SysMemSlicePitch = 0;
+            data.sysMemPitch = sizeof(IndicesT);
+            data.sysMemSlicePitch = 0;
 
-            result = pDevice_->CreateBuffer(&desc, &data, &pIndexBuffer_[2]);
+            result = pDevice_->CreateBuffer(desc, &data, &pIndexBuffer_[2]);
         }
 
-        ID3D10Blob* vertexShaderBuffer = nullptr;
-        ID3D10Blob* pixelShaderBuffer = nullptr;
-        int flags = 0;
-#ifdef _DEBUG
-        flags = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
-#endif
-        D3D_SHADER_MACRO Shader_Macros[] = { {"USE_LIGHTS"}, {NULL, NULL} };
+        static const GpuShaderMacro Shader_Macros[] = { {"USE_LIGHTS", NULL}, {NULL, NULL} };
 
         if (SUCCEEDED(result)) {
-            result = D3DCompileFromFile(L"TVS.hlsl", NULL, &includeObj, "main", "vs_5_0", flags, 0, &vertexShaderBuffer, NULL);
-            if (SUCCEEDED(result)) {
-                result = pDevice_->CreateVertexShader(vertexShaderBuffer->GetBufferPointer(), vertexShaderBuffer->GetBufferSize(), NULL, &pVertexShader_[2]);
-            }
+            result = pDevice_->CreateVertexShader({ "TVS.hlsl", "main", NULL }, &pVertexShader_[2]);
         }
         if (SUCCEEDED(result)) {
-            result = D3DCompileFromFile(L"TPS.hlsl", Shader_Macros, &includeObj, "main", "ps_5_0", flags, 0, &pixelShaderBuffer, NULL);
-            if (SUCCEEDED(result)) {
-                result = pDevice_->CreatePixelShader(pixelShaderBuffer->GetBufferPointer(), pixelShaderBuffer->GetBufferSize(), NULL, &pPixelShader_[2]);
-            }
+            result = pDevice_->CreatePixelShader({ "TPS.hlsl", "main", Shader_Macros }, &pPixelShader_[2]);
         }
         if (SUCCEEDED(result)) {
-            int numElements = sizeof(InputDescT) / sizeof(InputDescT[0]);
-            result = pDevice_->CreateInputLayout(InputDescT, numElements, vertexShaderBuffer->GetBufferPointer(), vertexShaderBuffer->GetBufferSize(), &pInputLayout_[2]);
+            UINT numElements = sizeof(InputDescT) / sizeof(InputDescT[0]);
+            result = pDevice_->CreateInputLayout(InputDescT, numElements, pVertexShader_[2], &pInputLayout_[2]);
         }
-
-        SAFE_RELEASE(vertexShaderBuffer);
-        SAFE_RELEASE(pixelShaderBuffer);
     }
     {
-        ID3D10Blob* vertexShaderBuffer = nullptr;
-        ID3D10Blob* pixelShaderBuffer = nullptr;
-        int flags = 0;
-#ifdef _DEBUG
-        flags = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
-#endif
         if (SUCCEEDED(result)) {
-            result = D3DCompileFromFile(L"PostEffectVS.hlsl", NULL, NULL, "main", "vs_5_0", flags, 0, &vertexShaderBuffer, NULL);
-            if (SUCCEEDED(result)) {
-                result = pDevice_->CreateVertexShader(vertexShaderBuffer->GetBufferPointer(), vertexShaderBuffer->GetBufferSize(), NULL, &pPostEffectVertexShader_);
-            }
+            result = pDevice_->CreateVertexShader({ "PostEffectVS.hlsl", "main", NULL }, &pPostEffectVertexShader_);
         }
         if (SUCCEEDED(result)) {
-            result = D3DCompileFromFile(L"PostEffectPS.hlsl", NULL, NULL, "main", "ps_5_0", flags, 0, &pixelShaderBuffer, NULL);
-            if (SUCCEEDED(result)) {
-                result = pDevice_->CreatePixelShader(pixelShaderBuffer->GetBufferPointer(), pixelShaderBuffer->GetBufferSize(), NULL, &pPostEffectPixelShader_);
-            }
+            result = pDevice_->CreatePixelShader({ "PostEffectPS.hlsl", "main", NULL }, &pPostEffectPixelShader_);
         }
 
-        SAFE_RELEASE(vertexShaderBuffer);
-        SAFE_RELEASE(pixelShaderBuffer);
-
         if (SUCCEEDED(result)) {
-            D3D11_SAMPLER_DESC samplerDesc;
-            ZeroMemory(&samplerDesc, sizeof(samplerDesc));
-            samplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_POINT;
-            samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
-            samplerDesc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
-            samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
-            samplerDesc.ComparisonFunc = D3D11_COMPARISON_NEVER;
-            samplerDesc.MinLOD = 0;
-            samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
-            samplerDesc.MaxAnisotropy = D3D11_MAX_MAXANISOTROPY;
-
-            result = pDevice_->CreateSamplerState(&samplerDesc, &pPostEffectSamplerState_);
+            GpuSamplerDesc samplerDesc = {};
+            samplerDesc.filter = GpuFilter::MinMagMipPoint;
+            samplerDesc.address = GpuTextureAddress::Clamp;
+            samplerDesc.minLod = 0;
+            samplerDesc.maxLod = FLT_MAX;
+            samplerDesc.maxAnisotropy = 16;
+
+            result = pDevice_->CreateSamplerState(samplerDesc, &pPostEffectSamplerState_);
         }
         if (SUCCEEDED(result)) {
-            D3D11_BUFFER_DESC desc = {};
-            desc.ByteWidth = sizeof(PostEffectConstantBuffer);
-            desc.Usage = D3D11_USAGE_DEFAULT;
-            desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-            desc.CPUAccessFlags = 0;
-            desc.MiscFlags = 0;
-            desc.StructureByteStride = 0;
+            GpuBufferDesc desc = {};
+            desc.byteWidth = sizeof(PostEffectConstantBuffer);
+            desc.usage = GpuUsage::Default;
+            desc.bindFlags = GpuBind::ConstantBuffer;
+            desc.cpuAccessFlags = 0;
+            desc.miscFlags = 0;
+            desc.structureByteStride = 0;
 
             PostEffectConstantBuffer postEffectConstantBuffer;
             postEffectConstantBuffer.params = XMINT4(withPostEffect_, 0, 0, 0);
 
-            D3D11_SUBRESOURCE_DATA data;
+            GpuSubresourceData data;
             data.pSysMem = &postEffectConstantBuffer;
-            data.SysMemPitch = sizeof(postEffectConstantBuffer);
-            data.SysMemSlicePitch = 0;
+            data.sysMemPitch = sizeof(postEffectConstantBuffer);
+            data.sysMemSlicePitch = 0;
 
-            result = pDevice_->CreateBuffer(&desc, &data, &pPostEffectConstantBuffer_);
+            result = pDevice_->CreateBuffer(desc, &data, &pPostEffectConstantBuffer_);
         }
     }
     if (SUCCEEDED(result)) {
-        D3D11_RASTERIZER_DESC desc = {};
-        desc.AntialiasedLineEnable = false;
-        desc.FillMode = D3D11_FILL_SOLID;
-        desc.CullMode = D3D11_CULL_NONE;
-        desc.DepthBias = 0;
-        desc.DepthBiasClamp = 0.0f;
-        desc.FrontCounterClockwise = false;
-        desc.DepthClipEnable = true;
-        desc.ScissorEnable = false;
-        desc.MultisampleEnable = false;
-        desc.SlopeScaledDepthBias = 0.0f;
-
-        result = pDevice_->CreateRasterizerState(&desc, &pRasterizerState_);
+        GpuRasterizerDesc desc = {};
+        desc.cull = GpuCull::None;
+        desc.depthClip = true;
+
+        result = pDevice_->CreateRasterizerState(desc, &pRasterizerState_);
     }
     if (SUCCEEDED(result)) {
-        std::vector<const wchar_t*> filenames = {L"textures/156.dds", L"textures/198.dds"};
-        UINT textureCount = (UINT)filenames.size();
-
-        std::vector<ID3D11Texture2D*> textures(textureCount);
-
-        for (UINT i = 0; i < textureCount; ++i) {
-            result = DirectX::CreateDDSTextureFromFile(pDevice_, pDeviceContext_, filenames[i], (ID3D11Resource**)(&textures[i]), nullptr);
-        }
-        if (FAILED(result)) {
-            return result;
-        }
-
-        D3D11_TEXTURE2D_DESC textureDesc;
-        textures[0]->GetDesc(&textureDesc);
-
-        D3D11_TEXTURE2D_DESC arrayDesc;
-        arrayDesc.Width = textureDesc.Width;
-        arrayDesc.Height = textureDesc.Height;
-        arrayDesc.MipLevels = textureDesc.MipLevels;
-        arrayDesc.ArraySize = textureCount;
-        arrayDesc.Format = textureDesc.Format;
-        arrayDesc.SampleDesc.Count = 1;
-        arrayDesc.SampleDesc.Quality = 0;
-        arrayDesc.Usage = D3D11_USAGE_DEFAULT;
-        arrayDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
-        arrayDesc.CPUAccessFlags = 0;
-        arrayDesc.MiscFlags = 0;
-
-        ID3D11Texture2D* textureArray = nullptr;
-        result = pDevice_->CreateTexture2D(&arrayDesc, 0, &textureArray);
-        if (FAILED(result)) {
-            return result;
-        }
-
-        for (UINT texElement = 0; texElement < textureCount; ++texElement) {
-            for (UINT mipLevel = 0; mipLevel < textureDesc.MipLevels; ++mipLevel) {
-                const int sourceSubresource = D3D11CalcSubresource(mipLevel, 0, textureDesc.MipLevels);
-                const int destSubresource = D3D11CalcSubresource(mipLevel, texElement, textureDesc.MipLevels);
-                pDeviceContext_->CopySubresourceRegion(textureArray, destSubresource, 0, 0, 0, textures[texElement], sourceSubresource, nullptr);
-            }
-        }
-
-        D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc;
-        viewDesc.Format = arrayDesc.Format;
-        viewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
-        viewDesc.Texture2DArray.MostDetailedMip = 0;
-        viewDesc.Texture2DArray.MipLevels = arrayDesc.MipLevels;
-        viewDesc.Texture2DArray.FirstArraySlice = 0;
-        viewDesc.Texture2DArray.ArraySize = textureCount;
-
-        result = pDevice_->CreateShaderResourceView(textureArray, &viewDesc, &pTexture_[0]);
-        if (FAILED(result)) {
-            return result;
-        }
-        textureArray->Release();
-        for (UINT i = 0; i < textureCount; ++i) {
-            textures[i]->Release();
-        }
-
+        static const char* const filenames[] = { "textures/156.dds", "textures/198.dds" };
+        result = pDevice_->LoadTextureArray(filenames, sizeof(filenames) / sizeof(filenames[0]), &pTexture_[0]);
     }
     if (SUCCEEDED(result)) {
-        result = CreateDDSTextureFromFile(pDevice_, pDeviceContext_, L"textures/156_norm.dds", nullptr, &pTexture_[1]);
+        result = pDevice_->LoadTexture("textures/156_norm.dds", false, &pTexture_[1]);
     }
     if (SUCCEEDED(result)) {
-        result = CreateDDSTextureFromFileEx(pDevice_, pDeviceContext_, L"textures/cube.dds",
-            0, D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, D3D11_RESOURCE_MISC_TEXTURECUBE,
-            DDS_LOADER_DEFAULT, nullptr, &pTexture_[2]);
+        result = pDevice_->LoadTexture("textures/cube.dds", true, &pTexture_[2]);
     }
     if (SUCCEEDED(result)) {
-        D3D11_SAMPLER_DESC desc = {};
-
-        desc.Filter = D3D11_FILTER_ANISOTROPIC;
-        desc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
-        desc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
-        desc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
-        desc.MinLOD = -D3D11_FLOAT32_MAX;
-        desc.MaxLOD = D3D11_FLOAT32_MAX;
-        desc.MipLODBias = 0.0f;
-        desc.MaxAnisotropy = 16;
-        desc.ComparisonFunc = D3D11_COMPARISON_NEVER;
-        desc.BorderColor[0] = desc.BorderColor[1] = desc.BorderColor[2] = desc.BorderColor[3] = 1.0f;
+        // Ambient light from the sky, the same light from every direction if the cubemap format is not supported
+        if (!pSkyIrradiance_->Load("textures/cube.dds", "textures/cube.sh")) {
+            pSkyIrradiance_->SetConstant(XMFLOAT3(1.0f, 1.0f, 1.0f));
+        }
+    }
+    if (SUCCEEDED(result)) {
+        GpuSamplerDesc desc = {};
+        desc.filter = GpuFilter::Anisotropic;
+        desc.address = GpuTextureAddress::Clamp;
+        desc.minLod = -FLT_MAX;
+        desc.maxLod = FLT_MAX;
+        desc.maxAnisotropy = 16;
 
-        result = pDevice_->CreateSamplerState(&desc, &pSampler_);
+        result = pDevice_->CreateSamplerState(desc, &pSampler_);
     }
     if (SUCCEEDED(result)) {
-        D3D11_DEPTH_STENCIL_DESC dsDesc = { };
-        dsDesc.DepthEnable = TRUE;
-        dsDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL;
-        dsDesc.DepthFunc = D3D11_COMPARISON_GREATER;
-        dsDesc.StencilEnable = FALSE;
+        GpuDepthStencilDesc dsDesc = {};
+        dsDesc.depthEnable = true;
+        dsDesc.depthWrite = true;
+        dsDesc.depthFunc = GpuComparison::Greater;
 
-        result = pDevice_->CreateDepthStencilState(&dsDesc, &pDepthState_[0]);
+        result = pDevice_->CreateDepthStencilState(dsDesc, &pDepthState_[0]);
     }
     if (SUCCEEDED(result)) {
-        D3D11_DEPTH_STENCIL_DESC dsDesc = { };
-        dsDesc.DepthEnable = TRUE;
-        dsDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
-        dsDesc.DepthFunc = D3D11_COMPARISON_GREATER_EQUAL;
-        dsDesc.StencilEnable = FALSE;
+        GpuDepthStencilDesc dsDesc = {};
+        dsDesc.depthEnable = true;
+        dsDesc.depthWrite = false;
+        dsDesc.depthFunc = GpuComparison::GreaterEqual;
 
-        result = pDevice_->CreateDepthStencilState(&dsDesc, &pDepthState_[1]);
+        result = pDevice_->CreateDepthStencilState(dsDesc, &pDepthState_[1]);
     }
     if (SUCCEEDED(result)) {
-        D3D11_BLEND_DESC desc = { 0 };
-        desc.AlphaToCoverageEnable = false;
-        desc.IndependentBlendEnable = false;
-        desc.RenderTarget[0].BlendEnable = true;
-        desc.RenderTarget[0].BlendOp = D3D11_BLEND_OP_ADD;
-        desc.RenderTarget[0].DestBlend = D3D11_BLEND_INV_SRC_ALPHA;
-        desc.RenderTarget[0].SrcBlend = D3D11_BLEND_SRC_ALPHA;
-        desc.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_RED |
-            D3D11_COLOR_WRITE_ENABLE_GREEN | D3D11_COLOR_WRITE_ENABLE_BLUE;
-        desc.RenderTarget[0].BlendOpAlpha = D3D11_BLEND_OP_ADD;
-        desc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_ONE;
-        desc.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ZERO;
-
-        result = pDevice_->CreateBlendState(&desc, &pBlendState_);
+        GpuBlendDesc desc = {};
+        desc.blendEnable = true;
+        desc.blendOp = GpuBlendOp::Add;
+        desc.destBlend = GpuBlend::InvSrcAlpha;
+        desc.srcBlend = GpuBlend::SrcAlpha;
+        desc.writeMask = GpuColorWrite::Red | GpuColorWrite::Green | GpuColorWrite::Blue;
+        desc.blendOpAlpha = GpuBlendOp::Add;
+        desc.destBlendAlpha = GpuBlend::One;
+        desc.srcBlendAlpha = GpuBlend::Zero;
+
+        result = pDevice_->CreateBlendState(desc, &pBlendState_);
     }
 
     return result;
 }
 
-void Renderer::ProcessPostEffect(D3D11_VIEWPORT viewport) {
-    pDeviceContext_->OMSetRenderTargets(1, &pRenderTargetView_, nullptr);
-    pDeviceContext_->RSSetViewports(1, &viewport);
+void Renderer::ProcessPostEffect(GpuViewport viewport) {
+    GpuRenderTargetView* views[] = { pDevice_->GetBackBuffer() };
+    pContext_->OMSetRenderTargets(1, views, nullptr);
+    pContext_->RSSetViewports(1, &viewport);
 
-    pDeviceContext_->IASetInputLayout(nullptr);
-    pDeviceContext_->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    pContext_->IASetInputLayout(nullptr);
+    pContext_->IASetPrimitiveTopology(GpuTopology::TriangleList);
 
-    pDeviceContext_->VSSetShader(pPostEffectVertexShader_, nullptr, 0);
-    pDeviceContext_->PSSetShader(pPostEffectPixelShader_, nullptr, 0);
-    pDeviceContext_->PSSetConstantBuffers(0, 1, &pPostEffectConstantBuffer_);
-    pDeviceContext_->PSSetShaderResources(0, 1, &pShaderResourceView_);
-    pDeviceContext_->PSSetSamplers(0, 1, &pPostEffectSamplerState_);
+    pContext_->VSSetShader(pPostEffectVertexShader_);
+    pContext_->PSSetShader(pPostEffectPixelShader_);
+    pContext_->PSSetConstantBuffers(0, 1, &pPostEffectConstantBuffer_);
+    pContext_->PSSetShaderResources(0, 1, &pShaderResourceView_);
+    pContext_->PSSetSamplers(0, 1, &pPostEffectSamplerState_);
 
-    pDeviceContext_->Draw(3, 0);
+    pContext_->Draw(3, 0);
 
-    ID3D11ShaderResourceView* nullsrv[] = { nullptr };
-    pDeviceContext_->PSSetShaderResources(0, 1, nullsrv);
+    GpuShaderResourceView* nullsrv[] = { nullptr };
+    pContext_->PSSetShaderResources(0, 1, nullsrv);
 }
 
-void Renderer::InputHandler() {
-    XMFLOAT3 mouse = pInput_->ReadMouse();
+void Renderer::MoveCamera(const XMFLOAT3& mouse, const XMFLOAT4& keyboard) {
     pCamera_->Rotate(mouse.x / 200.0f, mouse.y / 200.0f);
     pCamera_->Zoom(-mouse.z / 100.0f);
 
-    XMFLOAT4 keyboard = pInput_->ReadKeyboard();
     float di = 0.0, dj = 0.0;
     if (keyboard.x > 0.0)
         dj += 0.005f;
@@ -937,11 +940,11 @@ void Renderer::InputHandler() {
 }
 
 void Renderer::ReadQueries() {
-    D3D11_QUERY_DATA_PIPELINE_STATISTICS stats;
+    GpuPipelineStatistics stats;
     while (lastCompletedFrame_ < curFrame_) {
-        HRESULT result = pDeviceContext_->GetData(queries_[lastCompletedFrame_ % MAX_QUERY], &stats, sizeof(D3D11_QUERY_DATA_PIPELINE_STATISTICS), 0);
+        HRESULT result = pContext_->GetData(queries_[lastCompletedFrame_ % MAX_QUERY], &stats, sizeof(GpuPipelineStatistics), 0);
         if (result == S_OK) {
-            cubesCountGPU_ = int(stats.IAPrimitives / 12);
+            cubesCountGPU_ = int(stats.iaPrimitives / 12);
             lastCompletedFrame_++;
         }
         else {
@@ -950,11 +953,165 @@ void Renderer::ReadQueries() {
     }
 }
 
+// View 0 is the main camera, views 1-6 are the cube faces of a reflection probe at probePos
+void Renderer::BuildCullingViews(const XMFLOAT3& probePos) {
+    static const XMFLOAT3 faceDirs[6] = { {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1} };
+    static const XMFLOAT3 faceUps[6] = { {0, 1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}, {0, 1, 0}, {0, 1, 0} };
+
+    cullingViewFrustums_.assign(7, *pFrustum_);
+    XMMATRIX faceProjection = XMMatrixPerspectiveFovLH(XM_PIDIV2, 1.0f, SCREEN_FAR, SCREEN_NEAR);
+    for (int f = 0; f < 6; f++) {
+        XMMATRIX faceView = XMMatrixLookToLH(XMLoadFloat3(&probePos), XMLoadFloat3(&faceDirs[f]), XMLoadFloat3(&faceUps[f]));
+        cullingViewFrustums_[1 + f].ConstructFrustum(faceView, faceProjection);
+    }
+
+    cullingViews_.Clear();
+    for (Frustum& frustum : cullingViewFrustums_) {
+        cullingViews_.AddView(frustum.GetPlanes());
+    }
+}
+
+// Transforms and bounds of each chunk are independent, and with a CPU frustum mode every chunk compacts its
+// visible cubes in place at its own offset, so the workers never share output slots
+void Renderer::UpdateInstances(float t) {
+    int count = cubeStore_.Size();
+    cubeIndexies_.resize(count);
+    int chunkCount = (count + cullingChunkSize - 1) / cullingChunkSize;
+    chunkVisibleCounts_.assign(chunkCount, 0);
+    viewVisibleCounts_.clear();
+    if (cullingMode_ == CullingMode::MultiView) {
+        BuildCullingViews(pCamera_->GetPosition());
+        cubeViewMasks_.resize(count);
+        viewVisibleCounts_.assign(cullingViews_.GetViewCount(), 0);
+    }
+
+    pJobSystem_->ParallelFor(count, cullingChunkSize, [&](int begin, int end, int worker) {
+        // Only rotating and not yet uploaded cubes are rebuilt, bounds are transformed per dirty run
+        cubeStore_.UpdateTransforms(t, begin, end - begin);
+        cubeStore_.UpdateBounds(AABB[0], AABB[7], begin, end - begin);
+        if (cullingMode_ == CullingMode::Parallel || cullingMode_ == CullingMode::MultiView) {
+            chunkVisibleCounts_[begin / cullingChunkSize] = CullChunk(begin, end);
+        }
+    });
+}
+
+int Renderer::CullChunk(int begin, int end) {
+    const BoxStreams& cubeBounds = cubeStore_.GetBounds();
+    if (cullingMode_ != CullingMode::MultiView) {
+        return pFrustum_->CheckRectangles(cubeBounds, begin, end - begin, &cubeIndexies_[begin]);
+    }
+
+    // The main camera list is compacted from bit 0 of the view masks
+    cullingViews_.CheckRectangles(cubeBounds, begin, end - begin, &cubeViewMasks_[begin]);
+    int visibleCount = 0;
+    for (int i = begin; i < end; i++) {
+        cubeIndexies_[begin + visibleCount] = i;
+        visibleCount += cubeViewMasks_[i] & 1u;
+    }
+    return visibleCount;
+}
+
+void Renderer::CullInstances() {
+    switch (cullingMode_) {
+    case CullingMode::Parallel:
+    case CullingMode::MultiView:
+        CompactChunks();
+        break;
+    case CullingMode::BVH:
+        CullBVH();
+        break;
+    case CullingMode::PlaneCoherency:
+        CullPlaneCoherency();
+        break;
+    case CullingMode::Temporal:
+        CullTemporal();
+        break;
+    case CullingMode::SpatialIndex:
+        CullSpatialIndex();
+        break;
+    default:
+        // Every cube is drawn, or the culling shader builds the visible list
+        for (int i = 0; i < cubeStore_.Size(); i++) {
+            cubeIndexies_[i] = i;
+        }
+        break;
+    }
+
+    if (cullingMode_ != CullingMode::Temporal) {
+        pTemporalCuller_->Invalidate();
+    }
+    if (cullingMode_ != CullingMode::SpatialIndex && pSpatialIndex_->GetCount() > 0) {
+        pSpatialIndex_->Clear();
+    }
+}
+
+void Renderer::CompactChunks() {
+    int visibleCount = 0;
+    for (int c = 0; c < (int)chunkVisibleCounts_.size(); c++) {
+        int chunkBegin = c * cullingChunkSize;
+        if (visibleCount != chunkBegin) {
+            std::copy(&cubeIndexies_[chunkBegin], &cubeIndexies_[chunkBegin] + chunkVisibleCounts_[c], &cubeIndexies_[visibleCount]);
+        }
+        visibleCount += chunkVisibleCounts_[c];
+    }
+    cubeIndexies_.resize(visibleCount);
+
+    for (int i = 0; i < (cullingMode_ == CullingMode::MultiView ? cubeStore_.Size() : 0); i++) {
+        for (int v = 0; v < (int)viewVisibleCounts_.size(); v++) {
+            viewVisibleCounts_[v] += (cubeViewMasks_[i] >> v) & 1u;
+        }
+    }
+}
+
+void Renderer::CullBVH() {
+    const BoxStreams& cubeBounds = cubeStore_.GetBounds();
+    if (cubeBVH_.GetCount() != cubeStore_.Size()) {
+        cubeBVH_.Build(cubeBounds, cubeStore_.Size());
+    }
+    else {
+        cubeBVH_.Refit(cubeBounds);
+    }
+    cubeIndexies_.resize(cubeBVH_.Cull(*pFrustum_, cubeBounds, cubeIndexies_.data()));
+}
+
+void Renderer::CullPlaneCoherency() {
+    const XMFLOAT4* boundsMin = cubeStore_.GetBoundsMin();
+    const XMFLOAT4* boundsMax = cubeStore_.GetBoundsMax();
+    cubeCullPlanes_.resize(cubeStore_.Size(), 0);
+    int visibleCount = 0;
+    for (int i = 0; i < cubeStore_.Size(); i++) {
+        UINT planeMask = Frustum::allPlanes;
+        if (pFrustum_->ClassifyRectangle(boundsMin[i], boundsMax[i], cubeCullPlanes_[i], planeMask) != CullResult::Outside) {
+            cubeIndexies_[visibleCount++] = i;
+        }
+    }
+    cubeIndexies_.resize(visibleCount);
+}
+
+void Renderer::CullTemporal() {
+    // Dirty flags are still set for the cubes whose bounds were rebuilt this frame
+    cubeIndexies_.resize(pTemporalCuller_->Cull(*pFrustum_, cubeStore_.GetBounds(), cubeStore_.GetDirty(), cubeStore_.Size(),
+        cubeIndexies_.data()));
+}
+
+void Renderer::CullSpatialIndex() {
+    // Cubes with rebuilt bounds move in the index, cubes past the count leave it
+    const char* dirty = cubeStore_.GetDirty();
+    for (int i = 0; i < cubeStore_.Size(); i++) {
+        if (dirty[i] || !pSpatialIndex_->Contains(i)) {
+            pSpatialIndex_->Move(i, cubeStore_.GetBoundsMin()[i], cubeStore_.GetBoundsMax()[i]);
+        }
+    }
+    for (int i = cubeStore_.Size(); pSpatialIndex_->GetCount() > cubeStore_.Size(); i++) {
+        pSpatialIndex_->Remove(i);
+    }
+    cubeIndexies_.resize(pSpatialIndex_->QueryFrustum(*pFrustum_, cubeIndexies_.data()));
+}
+
 bool Renderer::UpdateScene() {
     HRESULT result;
 
-    ImGui_ImplDX11_NewFrame();
-    ImGui_ImplWin32_NewFrame();
+    pDevice_->NewUIFrame();
     ImGui::NewFrame();
 
     static bool window = true;
@@ -965,43 +1122,80 @@ bool Renderer::UpdateScene() {
 
         ImGui::Checkbox("Use normal maps", &useNormalMap_);
         ImGui::Checkbox("Show normals", &showNormals_);
+        ImGui::SliderFloat("Sky ambient", &ambientScale_, 0.0f, 2.0f);
+        ImGui::Text(pSkyIrradiance_->IsFromCache() ? "Sky harmonics: cached" : "Sky harmonics: projected");
         if (ImGui::Checkbox("Post effect", &withPostEffect_)) {
             PostEffectConstantBuffer postEffectConstantBuffer;
             postEffectConstantBuffer.params = XMINT4(withPostEffect_, 0, 0, 0);
-            pDeviceContext_->UpdateSubresource(pPostEffectConstantBuffer_, 0, nullptr, &postEffectConstantBuffer, 0, 0);
+            pContext_->UpdateSubresource(pPostEffectConstantBuffer_, 0, nullptr, &postEffectConstantBuffer, 0, 0);
         }
 
+        auto addLight = [&]() {
+            Light light = { XMFLOAT4((float)(rand() % 12 - 6), (float)(rand() % 12 - 6), (float)(rand() % 12 - 6), 0.0f),
+                XMFLOAT4((rand() % 255) / 255.0f, (rand() % 255) / 255.0f, (rand() % 255) / 255.0f, 0.0f) };
+            light.pos.w = LightClusters::LightRange(light.color);
+            pLightManager_->Add(light);
+        };
         if (ImGui::Button("+")) {
-            if (lights_.size() < MAX_LIGHT)
-                lights_.push_back({ XMFLOAT4((float)(rand() % 12 - 6), (float)(rand() % 12 - 6), (float)(rand() % 12 - 6), 0.0f),
-                    XMFLOAT4((rand() % 255) / 255.0f, (rand() % 255) / 255.0f, (rand() % 255) / 255.0f, 0.0f) });
+            if (pLightManager_->Size() < MAX_LIGHT)
+                addLight();
         }
         ImGui::SameLine();
         if (ImGui::Button("-")) {
-            if (lights_.size() > 0)
-                lights_.pop_back();
+            if (pLightManager_->Size() > 0)
+                pLightManager_->Remove(pLightManager_->Size() - 1);
         }
-
-        static float col[MAX_LIGHT][3];
-        static float pos[MAX_LIGHT][4];
-        for (int i = 0; i < lights_.size(); i++) {
-            std::string str = "Light " + std::to_string(i);
-            ImGui::Text(str.c_str());
-
-            pos[i][0] = lights_[i].pos.x;
-            pos[i][1] = lights_[i].pos.y;
-            pos[i][2] = lights_[i].pos.z;
-            str = "Pos " + std::to_string(i);
+        ImGui::SameLine();
+        if (ImGui::Button("+100")) {
+            for (int i = 0; i < 100 && pLightManager_->Size() < MAX_LIGHT; i++) {
+                addLight();
+            }
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("+1000")) {
+            for (int i = 0; i < 1000 && pLightManager_->Size() < MAX_LIGHT; i++) {
+                addLight();
+            }
+        }
+        ImGui::Checkbox("Move lights", &withMovingLights_);
+        std::string str = "Lights: " + std::to_string(pLightManager_->Size()) + ", visible: " + std::to_string(visibleLightCount_) +
+            ", uploaded: " + std::to_string(uploadedLightCount_) + ", cluster lights: " +
+            std::to_string(pLightClusters_->GetLightIndices().size()) + ", max per cluster: " + std::to_string(maxClusterLights_);
+        ImGui::Text(str.c_str());
+        ImGui::Checkbox("Per-instance light lists", &withInstanceLights_);
+        if (withInstanceLights_) {
+            str = "Instance lights: " + std::to_string(pInstanceLights_->GetLightIndices().size()) + ", max per instance: " +
+                std::to_string(pInstanceLights_->GetMaxCount());
             ImGui::Text(str.c_str());
-            ImGui::DragFloat3(str.c_str(), pos[i], 0.1f, -6.0f, 6.0f);
-            lights_[i].pos = XMFLOAT4(pos[i][0], pos[i][1], pos[i][2], 1.0f);
+        }
 
-            col[i][0] = lights_[i].color.x;
-            col[i][1] = lights_[i].color.y;
-            col[i][2] = lights_[i].color.z;
-            str = "Color " + std::to_string(i);
-            ImGui::ColorEdit3(str.c_str(), col[i]);
-            lights_[i].color = XMFLOAT4(col[i][0], col[i][1], col[i][2], 1.0f);
+        // Only edited lights go through the setters, so they alone are uploaded
+        if (ImGui::TreeNode("Light list")) {
+            for (int i = 0; i < pLightManager_->Size(); i++) {
+                const Light& light = pLightManager_->Get(i);
+                str = "Light " + std::to_string(i);
+                ImGui::Text(str.c_str());
+
+                float pos[3] = { light.pos.x, light.pos.y, light.pos.z };
+                str = "Pos " + std::to_string(i);
+                ImGui::Text(str.c_str());
+                if (ImGui::DragFloat3(str.c_str(), pos, 0.1f, -6.0f, 6.0f)) {
+                    pLightManager_->SetPosition(i, XMFLOAT3(pos[0], pos[1], pos[2]));
+                }
+
+                float col[3] = { light.color.x, light.color.y, light.color.z };
+                str = "Color " + std::to_string(i);
+                if (ImGui::ColorEdit3(str.c_str(), col)) {
+                    pLightManager_->SetColor(i, XMFLOAT4(col[0], col[1], col[2], 1.0f));
+                }
+
+                float range = light.pos.w;
+                str = "Range " + std::to_string(i);
+                if (ImGui::DragFloat(str.c_str(), &range, 0.1f, 0.0f, 100.0f)) {
+                    pLightManager_->SetRange(i, range);
+                }
+            }
+            ImGui::TreePop();
         }
 
         ImGui::End();
@@ -1010,92 +1204,257 @@ bool Renderer::UpdateScene() {
         ImGui::Begin("Instances", &window2);
 
         if (ImGui::Button("+")) {
-            if (cubesCount_ < MAX_CUBE) {
-                ++cubesCount_;
-            }
+            GenerateCubes(1);
         }
         ImGui::SameLine();
         if (ImGui::Button("-")) {
-            if (cubesCount_ > 0) {
-                --cubesCount_;
-            }
+            RemoveCubes(1);
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("+1000")) {
+            GenerateCubes(1000);
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("-1000")) {
+            RemoveCubes(1000);
         }
 
-        std::string str = "Count: " + std::to_string(cubesCount_);
+        std::string str = "Count: " + std::to_string(cubeStore_.Size());
+        ImGui::Text(str.c_str());
+        str = "Uploaded: " + std::to_string(frameUploadBytes_) + " B, dirty: " + std::to_string(dirtyCubes_);
         ImGui::Text(str.c_str());
+        bool batchedTransforms = cubeStore_.GetBatchedTransforms();
+        if (ImGui::Checkbox("Batched transforms", &batchedTransforms)) {
+            cubeStore_.SetBatchedTransforms(batchedTransforms);
+        }
+        str = "Draws: " + std::to_string(frameCounters_.drawCalls) + ", dispatches: " + std::to_string(frameCounters_.dispatches) +
+            ", state changes: " + std::to_string(frameCounters_.stateChanges) + ", frame upload: " + std::to_string(frameCounters_.uploadBytes) + " B";
+        ImGui::Text(str.c_str());
+        ImGui::Checkbox("Null backend", &withNullBackend_);
+        if (withNullBackend_) {
+            ImGui::SameLine();
+            str = "Errors: " + std::to_string(frameCounters_.errors);
+            ImGui::Text(str.c_str());
+            if (!pNullContext_->GetLastError().empty()) {
+                ImGui::Text(pNullContext_->GetLastError().c_str());
+            }
+        }
+        ImGui::Checkbox("Software rasterizer", &withSoftwareRasterizer_);
+        if (withSoftwareRasterizer_) {
+            const SoftwareStats& stats = pSoftwareRasterizer_->GetStats();
+            double seconds = max(stats.milliseconds, 1e-3) / 1000.0;
+            ImGui::Text("Software: %.2f ms, %.1f Mpix/s, %.2f Mtri/s", stats.milliseconds,
+                stats.pixels / seconds / 1e6, stats.triangles / seconds / 1e6);
+        }
 
-        if (!withGPUCulling_) {
+        if (cullingMode_ != CullingMode::GPU) {
             str = "Rendered: " + std::to_string(cubeIndexies_.size());
             ImGui::Text(str.c_str());
+            if (withOcclusionCulling_) {
+                ImGui::SameLine();
+                str = "Occluded: " + std::to_string(occludedCount_);
+                ImGui::Text(str.c_str());
+            }
         }
         else {
             str = "Rendered (GPU): " + std::to_string(cubesCountGPU_);
             ImGui::Text(str.c_str());
         }
-        ImGui::Checkbox("Culling", &withCulling_);
-        if (withCulling_) {
-            ImGui::Checkbox("Culling (GPU)", &withGPUCulling_);
+        // In the order of CullingMode
+        static const char* cullingModes[] = { "Off", "Frustum (parallel)", "Frustum and probe (multi-view)", "BVH",
+            "Plane coherency", "Temporal coherence", "Spatial index", "GPU" };
+        int cullingMode = (int)cullingMode_;
+        if (ImGui::Combo("Culling", &cullingMode, cullingModes, IM_ARRAYSIZE(cullingModes))) {
+            cullingMode_ = (CullingMode)cullingMode;
         }
-        else {
-            withGPUCulling_ = false;
+        if (cullingMode_ == CullingMode::Temporal) {
+            float tolerance = pTemporalCuller_->GetTolerance();
+            ImGui::DragFloat("Tolerance", &tolerance, 0.01f, 0.0f, 4.0f);
+            pTemporalCuller_->SetTolerance(tolerance);
+            const TemporalCullingStats& stats = pTemporalCuller_->GetStats();
+            ImGui::Text("Re-tested: %d, skipped: %d, boundary: %d%s", stats.tested, stats.skipped, stats.boundary,
+                stats.fullRetest ? " (full)" : "");
+        }
+        if (cullingMode_ == CullingMode::SpatialIndex) {
+            const char* indexTypes[] = { "Loose octree", "Hash grid" };
+            int indexType = (int)spatialIndexType_;
+            if (ImGui::Combo("Index", &indexType, indexTypes, IM_ARRAYSIZE(indexTypes)) && indexType != (int)spatialIndexType_) {
+                SpatialIndex* pIndex = SpatialIndex::Create((SpatialIndexType)indexType);
+                if (pIndex) {
+                    delete pSpatialIndex_;
+                    pSpatialIndex_ = pIndex;
+                    spatialIndexType_ = (SpatialIndexType)indexType;
+                }
+            }
+        }
+        if (cullingMode_ == CullingMode::MultiView && !viewVisibleCounts_.empty()) {
+            // Main camera and a reflection probe at the camera culled in one pass, the probe is not rendered
+            str = "Visible per view:";
+            for (int count : viewVisibleCounts_) {
+                str += " " + std::to_string(count);
+            }
+            ImGui::Text(str.c_str());
+        }
+        if (IsCPUCulling()) {
+            ImGui::Checkbox("Occlusion culling", &withOcclusionCulling_);
+            ImGui::Checkbox("Size culling and LOD", &withLod_);
+            if (withLod_) {
+                float minPixels = pLodSelector_->GetMinPixels();
+                float reducedPixels = pLodSelector_->GetReducedPixels();
+                ImGui::DragFloat("Min pixels", &minPixels, 0.1f, 0.0f, 64.0f);
+                ImGui::DragFloat("LOD pixels", &reducedPixels, 1.0f, 0.0f, 1024.0f);
+                pLodSelector_->SetThresholds(minPixels, reducedPixels);
+                str = "Too small: " + std::to_string(tooSmallCount_) + ", reduced: " + std::to_string(reducedCount_) +
+                    ", draws: " + std::to_string(lodDraws_.size());
+                ImGui::Text(str.c_str());
+            }
         }
 
         ImGui::End();
     }
 
-    InputHandler();
-
     XMMATRIX mView = pCamera_->GetViewMatrix();
 
-    XMMATRIX mProjection = XMMatrixPerspectiveFovLH(XM_PI / 3, width_ / (FLOAT)height_, SCREEN_FAR, SCREEN_NEAR);
+    XMMATRIX mProjection = Camera::GetProjectionMatrix(width_ / (FLOAT)height_);
 
     static float t = 0.0f;
-    static ULONGLONG timeStart = 0;
-    ULONGLONG timeCur = GetTickCount64();
-    if (timeStart == 0) {
-        timeStart = timeCur;
-    }
-    t = (timeCur - timeStart) / 1000.0f;
+    static std::chrono::steady_clock::time_point timeStart = std::chrono::steady_clock::now();
+    t = std::chrono::duration<float>(std::chrono::steady_clock::now() - timeStart).count();
 
-    GeomBuffer geomBufferInst[MAX_CUBE];
-    for (int i = 0; i < cubesCount_; i++) {
-        geomBufferInst[i].worldMatrix = XMMatrixRotationY(cubes_[i].pos.w * t * cubes_[i].shineSpeedIdNM.y) * XMMatrixTranslation(cubes_[i].pos.x, cubes_[i].pos.y, cubes_[i].pos.z);
-        geomBufferInst[i].norm = geomBufferInst[i].worldMatrix;
-        geomBufferInst[i].shineSpeedTexIdNM = cubes_[i].shineSpeedIdNM;
+    UINT capacity = instanceCapacity_;
+    result = ReserveInstances((UINT)cubeStore_.Size());
+    if (FAILED(result)) {
+        return false;
+    }
+    // Reallocated buffers start empty
+    if (instanceCapacity_ != capacity) {
+        cubeStore_.MarkAllDirty();
+        uploadedIndexies_.clear();
     }
-
-    pDeviceContext_->UpdateSubresource(pGeomBufferInst_, 0, nullptr, &geomBufferInst, 0, 0);
 
     CullingParams cullingParams;
     pFrustum_->ConstructFrustum(mView, mProjection);
-    cubeIndexies_.clear();
-    for (int i = 0; i < cubesCount_; i++) {
-        XMFLOAT4 min, max, vec;
-        XMStoreFloat4(&vec, XMVector4Transform(XMLoadFloat4(&AABB[0]), geomBufferInst[i].worldMatrix));
-        max = vec;
-        min = vec;
-        for (int j = 1; j < 8; j++) {
-            XMStoreFloat4(&vec, XMVector4Transform(XMLoadFloat4(&AABB[j]), geomBufferInst[i].worldMatrix));
-            max.x = max.x >= vec.x ? max.x : vec.x;
-            max.y = max.y >= vec.y ? max.y : vec.y;
-            max.z = max.z >= vec.z ? max.z : vec.z;
-            min.x = min.x <= vec.x ? min.x : vec.x;
-            min.y = min.y <= vec.y ? min.y : vec.y;
-            min.z = min.z <= vec.z ? min.z : vec.z;
-        }
-        if (!withCulling_ || withGPUCulling_ || pFrustum_->CheckRectangle(min, max)) {
-            cubeIndexies_.push_back(i);
-        }
-        cullingParams.bbMin[i] = min;
-        cullingParams.bbMax[i] = max;
-    }
-    cullingParams.numShapes = XMINT4(cubesCount_, 0, 0, 0);
-
-    pDeviceContext_->UpdateSubresource(pCullingParams_, 0, nullptr, &cullingParams, 0, 0);
+    UpdateInstances(t);
+    cullingParams.numShapes = XMINT4(cubeStore_.Size(), 0, 0, 0);
+    CullInstances();
 
     XMFLOAT3 cameraPos = pCamera_->GetPosition();
-    D3D11_MAPPED_SUBRESOURCE subresource, skyboxSubresource;
-    result = pDeviceContext_->Map(pViewMatrixBuffer_[0], 0, D3D11_MAP_WRITE_DISCARD, 0, &subresource);
+
+    occludedCount_ = 0;
+    if (withOcclusionCulling_ && IsCPUCulling() && !cubeIndexies_.empty()) {
+        // The nearest frustum-visible cubes are the most likely to hide the rest
+        occluders_ = cubeIndexies_;
+        auto distance = [&](int i) {
+            XMFLOAT3 pos = cubeStore_.GetPosition(i);
+            float dx = pos.x - cameraPos.x;
+            float dy = pos.y - cameraPos.y;
+            float dz = pos.z - cameraPos.z;
+            return dx * dx + dy * dy + dz * dz;
+        };
+        size_t occluderCount = min(occluders_.size(), (size_t)MAX_OCCLUDERS);
+        std::nth_element(occluders_.begin(), occluders_.begin() + (occluderCount - 1), occluders_.end(),
+            [&](int a, int b) { return distance(a) < distance(b); });
+
+        pOcclusionCuller_->Clear();
+        pOcclusionCuller_->SetViewProjection(XMMatrixMultiply(mView, mProjection));
+        for (size_t i = 0; i < occluderCount; i++) {
+            pOcclusionCuller_->RenderBox(cubeStore_.GetWorld()[occluders_[i]], AABB[0], AABB[7]);
+        }
+        pOcclusionCuller_->BuildHierarchy();
+
+        int visibleCount = 0;
+        for (int idx : cubeIndexies_) {
+            if (pOcclusionCuller_->TestRectangle(cubeStore_.GetBoundsMin()[idx], cubeStore_.GetBoundsMax()[idx])) {
+                cubeIndexies_[visibleCount++] = idx;
+            }
+        }
+        occludedCount_ = (int)cubeIndexies_.size() - visibleCount;
+        cubeIndexies_.resize(visibleCount);
+    }
+
+    lodDraws_.clear();
+    tooSmallCount_ = 0;
+    reducedCount_ = 0;
+    if (withLod_ && IsCPUCulling()) {
+        pLodSelector_->SetView(mView, mProjection, (float)height_);
+        cubeLods_.resize(cubeIndexies_.size());
+        int selectedCount = pLodSelector_->Select(cubeStore_.GetBoundsMin(), cubeStore_.GetBoundsMax(), cubeIndexies_.data(),
+            (int)cubeIndexies_.size(), cubeLods_.data());
+        tooSmallCount_ = (int)cubeIndexies_.size() - selectedCount;
+
+        // One draw per bucket: whole cubes, then reduced ones grouped by the octant facing the camera
+        UINT bucketCounts[9] = {};
+        for (int i = 0; i < selectedCount; i++) {
+            if (cubeLods_[i] > 0) {
+                cubeLods_[i] = 1 + (int)LodSelector::FacingOctant(cubeStore_.GetWorld()[cubeIndexies_[i]], cameraPos);
+                reducedCount_++;
+            }
+            bucketCounts[cubeLods_[i]]++;
+        }
+        UINT bucketOffsets[9];
+        UINT offset = 0;
+        for (int b = 0; b < 9; b++) {
+            bucketOffsets[b] = offset;
+            if (bucketCounts[b] > 0) {
+                lodDraws_.push_back({ b == 0 ? 36u : 18u, b == 0 ? 0u : 36u + 18u * (b - 1), bucketCounts[b], offset });
+            }
+            offset += bucketCounts[b];
+        }
+        lodOrder_.resize(selectedCount);
+        for (int i = 0; i < selectedCount; i++) {
+            lodOrder_[bucketOffsets[cubeLods_[i]]++] = cubeIndexies_[i];
+        }
+        cubeIndexies_.swap(lodOrder_);
+    }
+    else {
+        lodDraws_.push_back({ 36u, 0u, (UINT)cubeIndexies_.size(), 0u });
+    }
+
+    frameUploadBytes_ = 0;
+    if (uploadedShapes_ != cubeStore_.Size()) {
+        pContext_->UpdateSubresource(pCullingParams_, 0, nullptr, &cullingParams, 0, 0);
+        uploadedShapes_ = cubeStore_.Size();
+        frameUploadBytes_ += sizeof(cullingParams);
+    }
+
+    if (withMovingLights_) {
+        // Lights circle around the vertical axis
+        XMMATRIX rotation = XMMatrixRotationY((t - lightTime_) * 0.5f);
+        for (int i = 0; i < pLightManager_->Size(); i++) {
+            const XMFLOAT4& pos = pLightManager_->Get(i).pos;
+            XMFLOAT3 moved;
+            XMStoreFloat3(&moved, XMVector3TransformCoord(XMVectorSet(pos.x, pos.y, pos.z, 1.0f), rotation));
+            pLightManager_->SetPosition(i, moved);
+        }
+    }
+    lightTime_ = t;
+
+    // Every light that may be visible is binned into the froxels its range reaches, the pixel shaders only visit
+    // the lights of their froxel, or of their instance with per-instance lists
+    const Light* lights = pLightManager_->GetData();
+    visibleLights_.resize(pLightManager_->Size());
+    visibleLightCount_ = pLightManager_->QueryFrustum(*pFrustum_, visibleLights_.data());
+    pLightClusters_->SetView(mView, XM_PI / 3, width_ / (FLOAT)height_, SCREEN_NEAR, SCREEN_FAR);
+    pLightClusters_->Build(lights, visibleLightCount_, visibleLights_.data());
+    maxClusterLights_ = 0;
+    for (const XMUINT2& range : pLightClusters_->GetRanges()) {
+        maxClusterLights_ = max(maxClusterLights_, (int)range.y);
+    }
+    result = ReserveLightIndices((UINT)pLightClusters_->GetLightIndices().size(), clusterLightCapacity_, &pClusterLights_, &pClusterLightsSRV_);
+    if (FAILED(result)) {
+        return false;
+    }
+    if (withInstanceLights_) {
+        pInstanceLights_->Build(lights, pLightManager_->Size(), cubeStore_.GetBounds(), cubeStore_.Size());
+        result = ReserveLightIndices((UINT)pInstanceLights_->GetLightIndices().size(), instanceLightCapacity_,
+            &pInstanceLightIndices_, &pInstanceLightIndicesSRV_);
+        if (FAILED(result)) {
+            return false;
+        }
+    }
+
+    GpuMappedSubresource subresource, skyboxSubresource;
+    result = pContext_->Map(pViewMatrixBuffer_[0], 0, GpuMap::WriteDiscard, 0, &subresource);
     if (SUCCEEDED(result)) {
         SceneBuffer& sceneBuffer = *reinterpret_cast<SceneBuffer*>(subresource.pData);
         sceneBuffer.viewProjectionMatrix = XMMatrixMultiply(mView, mProjection);
@@ -1103,48 +1462,122 @@ bool Renderer::UpdateScene() {
         for (int i = 0; i < 6; i++) {
             sceneBuffer.planes[i] = planes[i];
         }
-        pDeviceContext_->Unmap(pViewMatrixBuffer_[0], 0);
+        pContext_->Unmap(pViewMatrixBuffer_[0], 0);
+    }
+
+    // Runs of dirty instances and the visible list, if it changed, go through the upload ring
+    const char* dirty = cubeStore_.GetDirty();
+    dirtyCubes_ = 0;
+    for (int i = 0; i < cubeStore_.Size(); i++) {
+        dirtyCubes_ += dirty[i];
+    }
+    if (cullingMode_ == CullingMode::GPU) {
+        // The culling shader overwrites the visible list
+        uploadedIndexies_.clear();
+    }
+    bool indexiesChanged = cullingMode_ != CullingMode::GPU && cubeIndexies_ != uploadedIndexies_;
+    UINT uploadSize = UINT(dirtyCubes_ * (sizeof(InstanceData) + 2 * sizeof(XMFLOAT4)));
+    if (indexiesChanged) {
+        uploadSize += UINT(sizeof(UINT) * cubeIndexies_.size());
+    }
+    const std::vector<XMUINT2>& clusterRanges = pLightClusters_->GetRanges();
+    const std::vector<UINT>& clusterLights = pLightClusters_->GetLightIndices();
+    // Only lights changed since the last frame are uploaded
+    lightRuns_.clear();
+    pLightManager_->TakeDirtyRuns(lightRuns_);
+    uploadedLightCount_ = 0;
+    for (const XMUINT2& run : lightRuns_) {
+        uploadedLightCount_ += (int)run.y;
+    }
+    uploadSize += UINT(sizeof(Light) * uploadedLightCount_ + sizeof(XMUINT2) * clusterRanges.size() + sizeof(UINT) * clusterLights.size());
+    if (withInstanceLights_) {
+        uploadSize += UINT(sizeof(XMUINT2) * pInstanceLights_->GetRanges().size() + sizeof(UINT) * pInstanceLights_->GetLightIndices().size());
+    }
+    result = pUploadRing_->Begin(pContext_, uploadSize);
+    if (FAILED(result)) {
+        return false;
     }
-
-    if (!withGPUCulling_) {
-        XMINT4 indexBuffer[MAX_CUBE];
-        for (int i = 0; i < cubeIndexies_.size(); i++) {
-            indexBuffer[i] = XMINT4(cubeIndexies_[i], 0, 0, 0);
+    for (int i = 0; i < cubeStore_.Size(); i++) {
+        if (!dirty[i]) {
+            continue;
         }
-        pDeviceContext_->UpdateSubresource(pGeomBufferInstVis_, 0, nullptr, &indexBuffer, 0, 0);
+        int run = i;
+        while (i < cubeStore_.Size() && dirty[i]) {
+            i++;
+        }
+        pUploadRing_->Write(pGeomBufferInst_, UINT(sizeof(InstanceData) * run), cubeStore_.GetInstances() + run,
+            UINT(sizeof(InstanceData) * (i - run)));
+        pUploadRing_->Write(pCullingBoundsMin_, UINT(sizeof(XMFLOAT4) * run), cubeStore_.GetBoundsMin() + run, UINT(sizeof(XMFLOAT4) * (i - run)));
+        pUploadRing_->Write(pCullingBoundsMax_, UINT(sizeof(XMFLOAT4) * run), cubeStore_.GetBoundsMax() + run, UINT(sizeof(XMFLOAT4) * (i - run)));
+        cubeStore_.ClearDirty(run, i - run);
+    }
+    if (indexiesChanged) {
+        pUploadRing_->Write(pGeomBufferInstVis_, 0, cubeIndexies_.data(), UINT(sizeof(UINT) * cubeIndexies_.size()));
+        uploadedIndexies_ = cubeIndexies_;
+    }
+    for (const XMUINT2& run : lightRuns_) {
+        pUploadRing_->Write(pLightsBuffer_, UINT(sizeof(Light) * run.x), lights + run.x, UINT(sizeof(Light) * run.y));
+    }
+    pUploadRing_->Write(pClusterRanges_, 0, clusterRanges.data(), UINT(sizeof(XMUINT2) * clusterRanges.size()));
+    pUploadRing_->Write(pClusterLights_, 0, clusterLights.data(), UINT(sizeof(UINT) * clusterLights.size()));
+    if (withInstanceLights_) {
+        const std::vector<XMUINT2>& ranges = pInstanceLights_->GetRanges();
+        const std::vector<UINT>& indices = pInstanceLights_->GetLightIndices();
+        pUploadRing_->Write(pInstanceLightRanges_, 0, ranges.data(), UINT(sizeof(XMUINT2) * ranges.size()));
+        pUploadRing_->Write(pInstanceLightIndices_, 0, indices.data(), UINT(sizeof(UINT) * indices.size()));
+    }
+    result = pUploadRing_->End();
+    frameUploadBytes_ += pUploadRing_->GetFrameBytes();
+    if (FAILED(result)) {
+        return false;
     }
 
-    result = pDeviceContext_->Map(pLightBuffer_, 0, D3D11_MAP_WRITE_DISCARD, 0, &subresource);
+    const XMFLOAT4* skyCoefficients = pSkyIrradiance_->GetCoefficients();
+    for (int i = 0; i < SkyIrradiance::coefficientCount; i++) {
+        XMStoreFloat4(&ambientSH_[i], XMVectorScale(XMLoadFloat4(&skyCoefficients[i]), ambientScale_));
+    }
+    result = pContext_->Map(pLightBuffer_, 0, GpuMap::WriteDiscard, 0, &subresource);
     if (SUCCEEDED(result)) {
         LightBuffer& lightBuffer = *reinterpret_cast<LightBuffer*>(subresource.pData);
         lightBuffer.cameraPos = XMFLOAT4(cameraPos.x, cameraPos.y, cameraPos.z, 1.0f);
-        lightBuffer.ambientColor = XMFLOAT4(0.9f, 0.9f, 0.9f, 1.0f);
-        lightBuffer.lightParams = XMINT4(int(lights_.size()), (int)useNormalMap_, (int)showNormals_, 0);
-        for (int i = 0; i < lights_.size(); i++) {
-            lightBuffer.lights[i].pos = lights_[i].pos;
-            lightBuffer.lights[i].color = lights_[i].color;
-        }
-        pDeviceContext_->Unmap(pLightBuffer_, 0);
+        lightBuffer.lightParams = XMINT4(pLightManager_->Size(), (int)useNormalMap_, (int)showNormals_, (int)withInstanceLights_);
+        XMMATRIX viewT = XMMatrixTranspose(mView);
+        XMStoreFloat4(&lightBuffer.cameraDir, viewT.r[2]);
+        lightBuffer.clusterParams = XMINT4(CLUSTER_X, CLUSTER_Y, CLUSTER_Z, 0);
+        lightBuffer.clusterDepth = XMFLOAT4(pLightClusters_->GetSliceScale(), pLightClusters_->GetSliceBias(),
+            CLUSTER_X / (float)width_, CLUSTER_Y / (float)height_);
+        memcpy(lightBuffer.ambientSH, ambientSH_, sizeof(ambientSH_));
+        pContext_->Unmap(pLightBuffer_, 0);
     }
 
     // GPU Culling
-    D3D11_DRAW_INDEXED_INSTANCED_INDIRECT_ARGS args;
-    args.IndexCountPerInstance = 36;
-    args.InstanceCount = 0;
-    args.StartInstanceLocation = 0;
-    args.BaseVertexLocation = 0;
-    args.StartIndexLocation = 0;
-    pDeviceContext_->UpdateSubresource(pInderectArgsSrc_, 0, nullptr, &args, 0, 0);
-    UINT groupNumber = cubesCount_ / 64u + !!(cubesCount_ % 64u);
-    pDeviceContext_->CSSetConstantBuffers(0, 1, &pCullingParams_);
-    pDeviceContext_->CSSetConstantBuffers(1, 1, &pViewMatrixBuffer_[0]);
-    pDeviceContext_->CSSetUnorderedAccessViews(0, 1, &pInderectArgsUAV_, nullptr);
-    pDeviceContext_->CSSetUnorderedAccessViews(1, 1, &pGeomBufferInstVisGpuUAV_, nullptr);
-    pDeviceContext_->CSSetShader(pCullingShader_, nullptr, 0);
-    pDeviceContext_->Dispatch(groupNumber, 1, 1);
-
-    pDeviceContext_->CopyResource(pGeomBufferInstVis_, pGeomBufferInstVisGpu_);
-    pDeviceContext_->CopyResource(pInderectArgs_, pInderectArgsSrc_);
+    if (cullingMode_ == CullingMode::GPU) {
+        GpuDrawIndexedIndirectArgs args;
+        args.indexCountPerInstance = 36;
+        args.instanceCount = 0;
+        args.startInstanceLocation = 0;
+        args.baseVertexLocation = 0;
+        args.startIndexLocation = 0;
+        pContext_->UpdateSubresource(pInderectArgsSrc_, 0, nullptr, &args, 0, 0);
+        UINT groupNumber = cubeStore_.Size() / CULLING_GROUP_SIZE + !!(cubeStore_.Size() % CULLING_GROUP_SIZE);
+        pContext_->CSSetConstantBuffers(0, 1, &pCullingParams_);
+        pContext_->CSSetConstantBuffers(1, 1, &pViewMatrixBuffer_[0]);
+        pContext_->CSSetShaderResources(0, 2, pCullingBoundsSRV_);
+        GpuUnorderedAccessView* cullingUAVs[] = { pInderectArgsUAV_, pGeomBufferInstVisGpuUAV_, pCullingGroupIdsUAV_, pCullingGroupRangesUAV_ };
+        pContext_->CSSetUnorderedAccessViews(0, 4, cullingUAVs, nullptr);
+        // Cull and compact every group, scan the group counts, then move the groups to their offsets
+        if (groupNumber > 0) {
+            pContext_->CSSetShader(pCullingShader_);
+            pContext_->Dispatch(groupNumber, 1, 1);
+            pContext_->CSSetShader(pCullingScanShader_);
+            pContext_->Dispatch(1, 1, 1);
+            pContext_->CSSetShader(pCullingCompactShader_);
+            pContext_->Dispatch(groupNumber, 1, 1);
+        }
+
+        pContext_->CopyResource(pGeomBufferInstVis_, pGeomBufferInstVisGpu_);
+        pContext_->CopyResource(pInderectArgs_, pInderectArgsSrc_);
+    }
 
     if (SUCCEEDED(result)) {
         SkyboxWorldMatrixBuffer skyboxWorldMatrixBuffer;
@@ -1152,21 +1585,21 @@ bool Renderer::UpdateScene() {
         skyboxWorldMatrixBuffer.worldMatrix = XMMatrixIdentity();
         skyboxWorldMatrixBuffer.size = XMFLOAT4(radius_, 0.0f, 0.0f, 0.0f);
 
-        pDeviceContext_->UpdateSubresource(pSkyboxWorldMatrixBuffer_, 0, nullptr, &skyboxWorldMatrixBuffer, 0, 0);
+        pContext_->UpdateSubresource(pSkyboxWorldMatrixBuffer_, 0, nullptr, &skyboxWorldMatrixBuffer, 0, 0);
 
-        result = pDeviceContext_->Map(pViewMatrixBuffer_[1], 0, D3D11_MAP_WRITE_DISCARD, 0, &skyboxSubresource);
+        result = pContext_->Map(pViewMatrixBuffer_[1], 0, GpuMap::WriteDiscard, 0, &skyboxSubresource);
     }
     if (SUCCEEDED(result)) {
         SkyboxViewMatrixBuffer& skyboxSceneBuffer = *reinterpret_cast<SkyboxViewMatrixBuffer*>(skyboxSubresource.pData);
         skyboxSceneBuffer.viewProjectionMatrix = XMMatrixMultiply(mView, mProjection);
         skyboxSceneBuffer.cameraPos = XMFLOAT4(cameraPos.x, cameraPos.y, cameraPos.z, 1.0f);
-        pDeviceContext_->Unmap(pViewMatrixBuffer_[1], 0);
+        pContext_->Unmap(pViewMatrixBuffer_[1], 0);
     }
 
     ImGui::Render();
 
     XMFLOAT4 rectVert[4];
-    float maxDist = -D3D11_FLOAT32_MAX;
+    float maxDist = -FLT_MAX;
     for (int i = 0; i < 4; i++) {
         rectVert[i] = XMFLOAT4(VerticesT[i].x, VerticesT[i].y, VerticesT[i].z, 1.0f);
     }
@@ -1177,7 +1610,7 @@ bool Renderer::UpdateScene() {
             (rectVert[i].z - cameraPos.z) * (rectVert[i].z - cameraPos.z);
         maxDist = max(maxDist, dist);
     }
-    float maxDist2 = -D3D11_FLOAT32_MAX;
+    float maxDist2 = -FLT_MAX;
     for (int i = 0; i < 4; i++) {
         rectVert[i] = XMFLOAT4(VerticesT[i].x, VerticesT[i].y, VerticesT[i].z, 1.0f);
     }
@@ -1194,185 +1627,283 @@ bool Renderer::UpdateScene() {
 }
 
 bool Renderer::Render() {
+    // Whatever the other backend uploaded never reached this one
+    CommandContext* pContext = withNullBackend_ ? (CommandContext*)pNullContext_ : pDevice_->GetContext();
+    if (pContext != pContext_) {
+        pContext_ = pContext;
+        cubeStore_.MarkAllDirty();
+        uploadedIndexies_.clear();
+        uploadedShapes_ = -1;
+        pLightManager_->MarkAllDirty();
+    }
+    frameCounters_ = pContext_->GetCounters();
+    pContext_->BeginFrame();
+
     if (!UpdateScene())
         return false;
 
-    pDeviceContext_->ClearState();
+    pContext_->ClearState();
 
-    D3D11_VIEWPORT viewport;
-    viewport.TopLeftX = 0;
-    viewport.TopLeftY = 0;
-    viewport.Width = (FLOAT)width_;
-    viewport.Height = (FLOAT)height_;
-    viewport.MinDepth = 0.0f;
-    viewport.MaxDepth = 1.0f;
-    pDeviceContext_->RSSetViewports(1, &viewport);
+    GpuViewport viewport;
+    viewport.x = 0;
+    viewport.y = 0;
+    viewport.width = (FLOAT)width_;
+    viewport.height = (FLOAT)height_;
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+    pContext_->RSSetViewports(1, &viewport);
 
-    D3D11_RECT rect;
+    GpuRect rect;
     rect.left = 0;
     rect.top = 0;
-    rect.right = width_;
-    rect.bottom = height_;
-    pDeviceContext_->RSSetScissorRects(1, &rect);
+    rect.right = (INT)width_;
+    rect.bottom = (INT)height_;
+    pContext_->RSSetScissorRects(1, &rect);
 
-    pDeviceContext_->OMSetRenderTargets(1, &pPostEffectRenderTargetView_, pDepthBufferDSV_);
+    pContext_->OMSetRenderTargets(1, &pPostEffectRenderTargetView_, pDepthBufferDSV_);
     static const FLOAT color[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
-    pDeviceContext_->ClearRenderTargetView(pPostEffectRenderTargetView_, color);
-    pDeviceContext_->ClearDepthStencilView(pDepthBufferDSV_, D3D11_CLEAR_DEPTH, 0.0f, 0);
+    pContext_->ClearRenderTargetView(pPostEffectRenderTargetView_, color);
+    pContext_->ClearDepthStencilView(pDepthBufferDSV_, GpuClear::Depth, 0.0f, 0);
+
+    if (withSoftwareRasterizer_) {
+        RenderSoftware();
+    }
+    else {
+        RenderScene();
+    }
+
+    static const FLOAT backColor[4] = { 0.4f, 0.2f, 0.4f, 1.0f };
+    GpuRenderTargetView* views[] = { pDevice_->GetBackBuffer() };
+    if (withNullBackend_) {
+        // The frame was only recorded, the UI is drawn straight into the back buffer
+        CommandContext* pDeviceContext = pDevice_->GetContext();
+        pDeviceContext->OMSetRenderTargets(1, views, nullptr);
+        pDeviceContext->RSSetViewports(1, &viewport);
+        pDeviceContext->ClearRenderTargetView(views[0], backColor);
+        pDevice_->RenderUI(ImGui::GetDrawData());
+    }
+    else {
+        pDevice_->RenderUI(ImGui::GetDrawData());
+
+        pContext_->OMSetRenderTargets(1, views, pDepthBufferDSV_);
+
+        pContext_->ClearRenderTargetView(views[0], backColor);
+        pContext_->ClearDepthStencilView(pDepthBufferDSV_, GpuClear::Depth, 0.0f, 0);
+
+        ProcessPostEffect(viewport);
+    }
+
+    HRESULT result = pDevice_->Present();
 
-    pDeviceContext_->RSSetState(pRasterizerState_);
-    pDeviceContext_->OMSetDepthStencilState(pDepthState_[0], 0);
+    return SUCCEEDED(result);
+}
+
+void Renderer::RenderScene() {
+    pContext_->RSSetState(pRasterizerState_);
+    pContext_->OMSetDepthStencilState(pDepthState_[0], 0);
 
-    ID3D11ShaderResourceView* resources[] = { pTexture_[0], pTexture_[1] };
-    pDeviceContext_->PSSetShaderResources(0, 2, resources);
+    GpuShaderResourceView* resources[] = { pTexture_[0], pTexture_[1] };
+    pContext_->PSSetShaderResources(0, 2, resources);
 
-    ID3D11SamplerState* samplers[] = { pSampler_ };
-    pDeviceContext_->PSSetSamplers(0, 1, samplers);
+    GpuSamplerState* samplers[] = { pSampler_ };
+    pContext_->PSSetSamplers(0, 1, samplers);
 
-    pDeviceContext_->IASetIndexBuffer(pIndexBuffer_[0], DXGI_FORMAT_R16_UINT, 0);
-    ID3D11Buffer* vertexBuffers[] = { pVertexBuffer_[0] };
-    UINT strides[] = { sizeof(Vertex) };
+    pContext_->IASetIndexBuffer(pIndexBuffer_[0], GpuFormat::R16Uint, 0);
+    GpuBuffer* vertexBuffers[] = { pVertexBuffer_[0] };
+    UINT strides[] = { withQuantizedVertices_ ? (UINT)sizeof(PackedVertex) : (UINT)sizeof(Vertex) };
     UINT offsets[] = { 0 };
-    pDeviceContext_->IASetVertexBuffers(0, 1, vertexBuffers, strides, offsets);
-    pDeviceContext_->IASetInputLayout(pInputLayout_[0]);
-    pDeviceContext_->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-    pDeviceContext_->VSSetConstantBuffers(0, 1, &pGeomBufferInst_);
-    pDeviceContext_->VSSetConstantBuffers(1, 1, &pViewMatrixBuffer_[0]);
-    pDeviceContext_->VSSetConstantBuffers(2, 1, &pGeomBufferInstVis_);
-    pDeviceContext_->VSSetShader(pVertexShader_[0], nullptr, 0);
-    pDeviceContext_->PSSetShader(pPixelShader_[0], nullptr, 0);
-    pDeviceContext_->PSSetConstantBuffers(0, 1, &pGeomBufferInst_);
-    pDeviceContext_->PSSetConstantBuffers(1, 1, &pViewMatrixBuffer_[0]);
-    pDeviceContext_->PSSetConstantBuffers(2, 1, &pLightBuffer_);
-
-    if (withCulling_) {
-        if (withGPUCulling_) {
-            pDeviceContext_->Begin(queries_[curFrame_ % MAX_QUERY]);
-            pDeviceContext_->DrawIndexedInstancedIndirect(pInderectArgs_, 0);
-            pDeviceContext_->End(queries_[curFrame_ % MAX_QUERY]);
-            curFrame_++;
-        }
-        else {
-            pDeviceContext_->DrawIndexedInstanced(36, (UINT)cubeIndexies_.size(), 0, 0, 0);
-        }
+    pContext_->IASetVertexBuffers(0, 1, vertexBuffers, strides, offsets);
+    pContext_->IASetInputLayout(pInputLayout_[0]);
+    pContext_->IASetPrimitiveTopology(GpuTopology::TriangleList);
+    GpuShaderResourceView* instanceResources[] = { pGeomBufferInstSRV_, pGeomBufferInstVisSRV_ };
+    pContext_->VSSetShaderResources(2, 2, instanceResources);
+    pContext_->VSSetConstantBuffers(1, 1, &pViewMatrixBuffer_[0]);
+    pContext_->VSSetConstantBuffers(3, 1, &pMeshBuffer_);
+    pContext_->VSSetConstantBuffers(4, 1, &pDrawBuffer_);
+    pContext_->VSSetShader(pVertexShader_[0]);
+    pContext_->PSSetShader(pPixelShader_[0]);
+    pContext_->PSSetShaderResources(2, 1, &pGeomBufferInstSRV_);
+    pContext_->PSSetConstantBuffers(1, 1, &pViewMatrixBuffer_[0]);
+    pContext_->PSSetConstantBuffers(2, 1, &pLightBuffer_);
+    GpuShaderResourceView* lightResources[] = { pLightsSRV_, pClusterRangesSRV_, pClusterLightsSRV_,
+        pInstanceLightRangesSRV_, pInstanceLightIndicesSRV_ };
+    pContext_->PSSetShaderResources(4, 5, lightResources);
+
+    if (cullingMode_ == CullingMode::GPU) {
+        XMUINT4 drawParams(0, 0, 0, 0);
+        pContext_->UpdateSubresource(pDrawBuffer_, 0, nullptr, &drawParams, 0, 0);
+        pContext_->Begin(queries_[curFrame_ % MAX_QUERY]);
+        pContext_->DrawIndexedInstancedIndirect(pInderectArgs_, 0);
+        pContext_->End(queries_[curFrame_ % MAX_QUERY]);
+        curFrame_++;
     }
     else {
-        pDeviceContext_->DrawIndexedInstanced(36, MAX_CUBE, 0, 0, 0);
+        for (const LodDraw& draw : lodDraws_) {
+            XMUINT4 drawParams(draw.firstInstance, 0, 0, 0);
+            pContext_->UpdateSubresource(pDrawBuffer_, 0, nullptr, &drawParams, 0, 0);
+            pContext_->DrawIndexedInstanced(draw.indexCount, draw.instanceCount, draw.startIndex, 0, 0);
+        }
     }
     ReadQueries();
 
-    pDeviceContext_->OMSetDepthStencilState(pDepthState_[1], 0);
+    pContext_->OMSetDepthStencilState(pDepthState_[1], 0);
     {
-        ID3D11ShaderResourceView* resources[] = { pTexture_[2] };
-        pDeviceContext_->PSSetShaderResources(0, 1, resources);
+        GpuShaderResourceView* resources[] = { pTexture_[2] };
+        pContext_->PSSetShaderResources(0, 1, resources);
 
-        pDeviceContext_->IASetIndexBuffer(pIndexBuffer_[1], DXGI_FORMAT_R32_UINT, 0);
-        ID3D11Buffer* vertexBuffers[] = { pVertexBuffer_[1] };
+        pContext_->IASetIndexBuffer(pIndexBuffer_[1], GpuFormat::R32Uint, 0);
+        GpuBuffer* vertexBuffers[] = { pVertexBuffer_[1] };
         UINT strides[] = { 12 };
         UINT offsets[] = { 0 };
-        pDeviceContext_->IASetVertexBuffers(0, 1, vertexBuffers, strides, offsets);
-        pDeviceContext_->IASetInputLayout(pInputLayout_[1]);
-        pDeviceContext_->VSSetShader(pVertexShader_[1], nullptr, 0);
-        pDeviceContext_->VSSetConstantBuffers(0, 1, &pSkyboxWorldMatrixBuffer_);
-        pDeviceContext_->VSSetConstantBuffers(1, 1, &pViewMatrixBuffer_[1]);
-        pDeviceContext_->PSSetShader(pPixelShader_[1], nullptr, 0);
+        pContext_->IASetVertexBuffers(0, 1, vertexBuffers, strides, offsets);
+        pContext_->IASetInputLayout(pInputLayout_[1]);
+        pContext_->VSSetShader(pVertexShader_[1]);
+        pContext_->VSSetConstantBuffers(0, 1, &pSkyboxWorldMatrixBuffer_);
+        pContext_->VSSetConstantBuffers(1, 1, &pViewMatrixBuffer_[1]);
+        pContext_->PSSetShader(pPixelShader_[1]);
 
-        pDeviceContext_->DrawIndexed(numSphereTriangles_ * 3, 0, 0);
+        pContext_->DrawIndexed(numSphereTriangles_ * 3, 0, 0);
     }
 
     {
-        pDeviceContext_->IASetIndexBuffer(pIndexBuffer_[2], DXGI_FORMAT_R16_UINT, 0);
-        ID3D11Buffer* vertexBuffers[] = { pVertexBuffer_[2] };
+        pContext_->IASetIndexBuffer(pIndexBuffer_[2], GpuFormat::R16Uint, 0);
+        GpuBuffer* vertexBuffers[] = { pVertexBuffer_[2] };
         UINT strides[] = { 12 };
         UINT offsets[] = { 0 };
-        pDeviceContext_->IASetVertexBuffers(0, 1, vertexBuffers, strides, offsets);
-        pDeviceContext_->IASetInputLayout(pInputLayout_[2]);
+        pContext_->IASetVertexBuffers(0, 1, vertexBuffers, strides, offsets);
+        pContext_->IASetInputLayout(pInputLayout_[2]);
 
-        pDeviceContext_->VSSetShader(pVertexShader_[2], nullptr, 0);
-        pDeviceContext_->PSSetShader(pPixelShader_[2], nullptr, 0);
-        pDeviceContext_->VSSetConstantBuffers(1, 1, &pViewMatrixBuffer_[0]);
+        pContext_->VSSetShader(pVertexShader_[2]);
+        pContext_->PSSetShader(pPixelShader_[2]);
+        pContext_->VSSetConstantBuffers(1, 1, &pViewMatrixBuffer_[0]);
 
-        pDeviceContext_->OMSetBlendState(pBlendState_, nullptr, 0xFFFFFFFF);
+        pContext_->OMSetBlendState(pBlendState_, nullptr, 0xFFFFFFFF);
 
         if (isFirst_) {
-            pDeviceContext_->VSSetConstantBuffers(0, 1, &pPlanesWorldMatrixBuffer_[0]);
-            pDeviceContext_->PSSetConstantBuffers(0, 1, &pPlanesWorldMatrixBuffer_[0]);
-            pDeviceContext_->DrawIndexed(6, 0, 0);
+            pContext_->VSSetConstantBuffers(0, 1, &pPlanesWorldMatrixBuffer_[0]);
+            pContext_->PSSetConstantBuffers(0, 1, &pPlanesWorldMatrixBuffer_[0]);
+            pContext_->DrawIndexed(6, 0, 0);
 
-            pDeviceContext_->VSSetConstantBuffers(0, 1, &pPlanesWorldMatrixBuffer_[1]);
-            pDeviceContext_->PSSetConstantBuffers(0, 1, &pPlanesWorldMatrixBuffer_[1]);
-            pDeviceContext_->DrawIndexed(6, 0, 0);
+            pContext_->VSSetConstantBuffers(0, 1, &pPlanesWorldMatrixBuffer_[1]);
+            pContext_->PSSetConstantBuffers(0, 1, &pPlanesWorldMatrixBuffer_[1]);
+            pContext_->DrawIndexed(6, 0, 0);
         }
         else {
-            pDeviceContext_->VSSetConstantBuffers(0, 1, &pPlanesWorldMatrixBuffer_[1]);
-            pDeviceContext_->PSSetConstantBuffers(0, 1, &pPlanesWorldMatrixBuffer_[1]);
-            pDeviceContext_->DrawIndexed(6, 0, 0);
+            pContext_->VSSetConstantBuffers(0, 1, &pPlanesWorldMatrixBuffer_[1]);
+            pContext_->PSSetConstantBuffers(0, 1, &pPlanesWorldMatrixBuffer_[1]);
+            pContext_->DrawIndexed(6, 0, 0);
 
-            pDeviceContext_->VSSetConstantBuffers(0, 1, &pPlanesWorldMatrixBuffer_[0]);
-            pDeviceContext_->PSSetConstantBuffers(0, 1, &pPlanesWorldMatrixBuffer_[0]);
-            pDeviceContext_->DrawIndexed(6, 0, 0);
+            pContext_->VSSetConstantBuffers(0, 1, &pPlanesWorldMatrixBuffer_[0]);
+            pContext_->PSSetConstantBuffers(0, 1, &pPlanesWorldMatrixBuffer_[0]);
+            pContext_->DrawIndexed(6, 0, 0);
         }
     }
+}
 
-    ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData());
+void Renderer::RenderSoftware() {
+    // Flat colors stand in for the cube textures and the sky cubemap, they live on the GPU only
+    static const XMFLOAT3 TextureColors[] = { {0.7f, 0.55f, 0.4f}, {0.55f, 0.6f, 0.65f} };
+    static const XMFLOAT3 TransparentColors[] = { {1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f} };
+    static const XMFLOAT3 SkyZenith = { 0.3f, 0.5f, 0.85f };
 
-    ID3D11RenderTargetView* views[] = { pRenderTargetView_ };
-    pDeviceContext_->OMSetRenderTargets(1, views, pDepthBufferDSV_);
+    XMMATRIX viewProjection = XMMatrixMultiply(pCamera_->GetViewMatrix(),
+        Camera::GetProjectionMatrix(width_ / (FLOAT)height_));
+    XMFLOAT3 cameraPos = pCamera_->GetPosition();
 
-    static const FLOAT backColor[4] = { 0.4f, 0.2f, 0.4f, 1.0f };
-    pDeviceContext_->ClearRenderTargetView(pRenderTargetView_, backColor);
-    pDeviceContext_->ClearDepthStencilView(pDepthBufferDSV_, D3D11_CLEAR_DEPTH, 0.0f, 0);
+    LightingParams lighting = { cameraPos, pLightManager_->Size(), showNormals_, pLightManager_->GetData() };
+    pSoftwareRasterizer_->SetLighting(lighting, ambientSH_);
+    pSoftwareRasterizer_->Clear(XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f));
+
+    softwareVertices_.resize(max(cubeVertices_.size(), skyVertices_.size()));
+    for (int idx : cubeIndexies_) {
+        const XMMATRIX& world = cubeStore_.GetWorld()[idx];
+        XMMATRIX worldViewProjection = XMMatrixMultiply(world, viewProjection);
+        for (size_t i = 0; i < cubeVertices_.size(); i++) {
+            XMVECTOR pos = XMVectorSetW(XMLoadFloat3(&cubeVertices_[i].pos), 1.0f);
+            XMStoreFloat4(&softwareVertices_[i].clip, XMVector4Transform(pos, worldViewProjection));
+            XMStoreFloat3(&softwareVertices_[i].pos, XMVector3Transform(pos, world));
+            XMStoreFloat3(&softwareVertices_[i].normal, XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&cubeVertices_[i].normal), world)));
+        }
 
-    ProcessPostEffect(viewport);
+        SoftwareMaterial material;
+        material.shader = SoftwareShader::Lit;
+        const InstanceData& instance = cubeStore_.GetInstances()[idx];
+        material.color = TextureColors[(instance.material & 0xFFFF) % 2];
+        material.shine = instance.shine;
+        material.alpha = 1.0f;
+        for (size_t i = 0; i < cubeIndices_.size(); i += 3) {
+            pSoftwareRasterizer_->DrawTriangle(softwareVertices_[cubeIndices_[i]], softwareVertices_[cubeIndices_[i + 1]],
+                softwareVertices_[cubeIndices_[i + 2]], material);
+        }
+    }
 
-    HRESULT result = pSwapChain_->Present(0, 0);
+    // Same as CubeMapVS.hlsl: a sphere around the camera pushed to the far plane
+    for (size_t i = 0; i < skyVertices_.size(); i++) {
+        XMVECTOR local = XMVectorSet(skyVertices_[i].x, skyVertices_[i].y, skyVertices_[i].z, 0.0f);
+        XMVECTOR pos = XMVectorSetW(XMVectorAdd(XMLoadFloat3(&cameraPos), XMVectorScale(local, radius_)), 1.0f);
+        XMStoreFloat4(&softwareVertices_[i].clip, XMVector4Transform(pos, viewProjection));
+        softwareVertices_[i].clip.z = 0.0f;
+        XMStoreFloat3(&softwareVertices_[i].pos, local);
+        softwareVertices_[i].normal = XMFLOAT3(0.0f, 0.0f, 0.0f);
+    }
+    SoftwareMaterial skyMaterial = { SoftwareShader::Sky, SkyZenith, 0.0f, 1.0f };
+    for (size_t i = 0; i < skyIndices_.size(); i += 3) {
+        pSoftwareRasterizer_->DrawTriangle(softwareVertices_[skyIndices_[i]], softwareVertices_[skyIndices_[i + 1]],
+            softwareVertices_[skyIndices_[i + 2]], skyMaterial);
+    }
+
+    for (int k = 0; k < 2; k++) {
+        int plane = isFirst_ ? k : 1 - k;
+        XMMATRIX worldViewProjection = XMMatrixMultiply(TransparentMatrixs[plane], viewProjection);
+        for (int i = 0; i < 4; i++) {
+            XMVECTOR pos = XMVectorSet(VerticesT[i].x, VerticesT[i].y, VerticesT[i].z, 1.0f);
+            XMStoreFloat4(&softwareVertices_[i].clip, XMVector4Transform(pos, worldViewProjection));
+            XMStoreFloat3(&softwareVertices_[i].pos, XMVector3Transform(pos, TransparentMatrixs[plane]));
+            softwareVertices_[i].normal = XMFLOAT3(1.0f, 0.0f, 0.0f);
+        }
+        SoftwareMaterial material = { SoftwareShader::Transparent, TransparentColors[plane], 0.0f, 0.5f };
+        for (size_t i = 0; i < transparentIndices_.size(); i += 3) {
+            pSoftwareRasterizer_->DrawTriangle(softwareVertices_[transparentIndices_[i]], softwareVertices_[transparentIndices_[i + 1]],
+                softwareVertices_[transparentIndices_[i + 2]], material);
+        }
+    }
 
-    return SUCCEEDED(result);
+    pSoftwareRasterizer_->Flush();
+    pContext_->UpdateSubresource(pRenderTargetTexture_, 0, nullptr, pSoftwareRasterizer_->GetColor(),
+        pSoftwareRasterizer_->GetRowPitch(), 0);
 }
 
 bool Renderer::Resize(UINT width, UINT height) {
-    if (pSwapChain_ == NULL)
+    if (pDevice_ == NULL)
         return false;
 
-    SAFE_RELEASE(pRenderTargetView_);
-
-    width_ = max(width, 8);
-    height_ = max(height, 8);
+    width_ = max(width, 8u);
+    height_ = max(height, 8u);
 
-    auto result = pSwapChain_->ResizeBuffers(2, width_, height_, DXGI_FORMAT_R8G8B8A8_UNORM, 0);
-    if (!SUCCEEDED(result))
-        return false;
-
-    ID3D11Texture2D* pBuffer;
-    result = pSwapChain_->GetBuffer(0, __uuidof(ID3D11Texture2D), (LPVOID*) &pBuffer);
-    if (!SUCCEEDED(result))
-        return false;
-
-    result = pDevice_->CreateRenderTargetView(pBuffer, NULL, &pRenderTargetView_);
-    SAFE_RELEASE(pBuffer);
+    HRESULT result = pDevice_->ResizeBuffers(width_, height_);
     if (!SUCCEEDED(result))
         return false;
 
     SAFE_RELEASE(pDepthBuffer_);
     SAFE_RELEASE(pDepthBufferDSV_);
-    D3D11_TEXTURE2D_DESC desc = {};
-    desc.Format = DXGI_FORMAT_D32_FLOAT;
-    desc.ArraySize = 1;
-    desc.MipLevels = 1;
-    desc.Usage = D3D11_USAGE_DEFAULT;
-    desc.Height = height_;
-    desc.Width = width_;
-    desc.BindFlags = D3D11_BIND_DEPTH_STENCIL;
-    desc.CPUAccessFlags = 0;
-    desc.MiscFlags = 0;
-    desc.SampleDesc.Count = 1;
-    desc.SampleDesc.Quality = 0;
-
-    result = pDevice_->CreateTexture2D(&desc, NULL, &pDepthBuffer_);
+    GpuTextureDesc desc = {};
+    desc.format = GpuFormat::D32Float;
+    desc.arraySize = 1;
+    desc.mipLevels = 1;
+    desc.usage = GpuUsage::Default;
+    desc.height = height_;
+    desc.width = width_;
+    desc.bindFlags = GpuBind::DepthStencil;
+    desc.cpuAccessFlags = 0;
+    desc.miscFlags = 0;
+    desc.sampleCount = 1;
+    desc.sampleQuality = 0;
+
+    result = pDevice_->CreateTexture2D(desc, NULL, &pDepthBuffer_);
     if (!SUCCEEDED(result))
         return false;
 
-    result = pDevice_->CreateDepthStencilView(pDepthBuffer_, NULL, &pDepthBufferDSV_);
+    result = pDevice_->CreateDepthStencilView(pDepthBuffer_, &pDepthBufferDSV_);
     if (!SUCCEEDED(result))
         return false;
 
@@ -1380,6 +1911,7 @@ bool Renderer::Resize(UINT width, UINT height) {
     result = InitRenderTexture(width_, height_);
     if (!SUCCEEDED(result))
         return false;
+    pSoftwareRasterizer_->Resize(width_, height_);
 
     float n = 0.01f;
     float fov = XM_PI / 3;
@@ -1397,30 +1929,40 @@ void Renderer::ReleaseRenderTexture() {
 }
 
 void Renderer::Cleanup() {
-    ImGui_ImplDX11_Shutdown();
-    ImGui_ImplWin32_Shutdown();
-    ImGui::DestroyContext();
+    if (pDevice_ == NULL)
+        return;
+
+    pDevice_->ShutdownUI();
+    if (ImGui::GetCurrentContext() != NULL)
+        ImGui::DestroyContext();
 
-    if (pDeviceContext_ != NULL)
-        pDeviceContext_->ClearState();
+    pDevice_->GetContext()->ClearState();
 
-    SAFE_RELEASE(pRenderTargetView_);
-    SAFE_RELEASE(pDeviceContext_);
-    SAFE_RELEASE(pSwapChain_);
     SAFE_RELEASE(pRasterizerState_);
     SAFE_RELEASE(pSampler_);
     SAFE_RELEASE(pDepthBuffer_);
     SAFE_RELEASE(pDepthBufferDSV_);
     SAFE_RELEASE(pBlendState_);
     SAFE_RELEASE(pLightBuffer_);
-    SAFE_RELEASE(pGeomBufferInst_);
+    SAFE_RELEASE(pLightsSRV_);
+    SAFE_RELEASE(pLightsBuffer_);
+    SAFE_RELEASE(pClusterRangesSRV_);
+    SAFE_RELEASE(pClusterRanges_);
+    SAFE_RELEASE(pClusterLightsSRV_);
+    SAFE_RELEASE(pClusterLights_);
+    SAFE_RELEASE(pInstanceLightIndicesSRV_);
+    SAFE_RELEASE(pInstanceLightIndices_);
+    SAFE_RELEASE(pMeshBuffer_);
+    SAFE_RELEASE(pDrawBuffer_);
+    ReleaseInstanceBuffers();
+    cubeStore_.Clear();
+    cubeHandles_.clear();
     SAFE_RELEASE(pCullingParams_);
     SAFE_RELEASE(pCullingShader_);
+    SAFE_RELEASE(pCullingScanShader_);
+    SAFE_RELEASE(pCullingCompactShader_);
     SAFE_RELEASE(pInderectArgsSrc_);
     SAFE_RELEASE(pInderectArgs_);
-    SAFE_RELEASE(pGeomBufferInstVisGpu_);
-    SAFE_RELEASE(pGeomBufferInstVisGpuUAV_);
-    SAFE_RELEASE(pGeomBufferInstVis_);
     SAFE_RELEASE(pInderectArgsUAV_);
 
     SAFE_RELEASE(pVertexBuffer_[0]);
@@ -1463,7 +2005,7 @@ void Renderer::Cleanup() {
     SAFE_RELEASE(pPostEffectConstantBuffer_);
 
     for (auto& q : queries_) {
-        q->Release();
+        SAFE_RELEASE(q);
     }
 
     ReleaseRenderTexture();
@@ -1472,29 +2014,62 @@ void Renderer::Cleanup() {
         delete pCamera_;
         pCamera_ = NULL;
     }
-    if (pInput_) {
-        delete pInput_;
-        pInput_ = NULL;
-    }
     if (pFrustum_) {
         delete pFrustum_;
         pFrustum_ = NULL;
     }
-
-#ifdef _DEBUG
-    if (pDevice_ != NULL) {
-        ID3D11Debug* d3dDebug = NULL;
-        pDevice_->QueryInterface(IID_PPV_ARGS(&d3dDebug));
-
-        UINT references = pDevice_->Release();
-        pDevice_ = NULL;
-        if (references > 1) {
-            d3dDebug->ReportLiveDeviceObjects(D3D11_RLDO_DETAIL);
-        }
-        SAFE_RELEASE(d3dDebug);
+    if (pJobSystem_) {
+        delete pJobSystem_;
+        pJobSystem_ = NULL;
+    }
+    if (pOcclusionCuller_) {
+        delete pOcclusionCuller_;
+        pOcclusionCuller_ = NULL;
     }
-#endif
-    SAFE_RELEASE(pDevice_);
+    if (pUploadRing_) {
+        delete pUploadRing_;
+        pUploadRing_ = NULL;
+    }
+    if (pNullContext_) {
+        delete pNullContext_;
+        pNullContext_ = NULL;
+    }
+    if (pSoftwareRasterizer_) {
+        delete pSoftwareRasterizer_;
+        pSoftwareRasterizer_ = NULL;
+    }
+    if (pLodSelector_) {
+        delete pLodSelector_;
+        pLodSelector_ = NULL;
+    }
+    if (pTemporalCuller_) {
+        delete pTemporalCuller_;
+        pTemporalCuller_ = NULL;
+    }
+    if (pSpatialIndex_) {
+        delete pSpatialIndex_;
+        pSpatialIndex_ = NULL;
+    }
+    if (pLightClusters_) {
+        delete pLightClusters_;
+        pLightClusters_ = NULL;
+    }
+    if (pInstanceLights_) {
+        delete pInstanceLights_;
+        pInstanceLights_ = NULL;
+    }
+    if (pLightManager_) {
+        delete pLightManager_;
+        pLightManager_ = NULL;
+    }
+    if (pSkyIrradiance_) {
+        delete pSkyIrradiance_;
+        pSkyIrradiance_ = NULL;
+    }
+    pContext_ = NULL;
+
+    delete pDevice_;
+    pDevice_ = NULL;
 }
 
 Renderer::~Renderer() {
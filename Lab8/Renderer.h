@@ -1,56 +1,61 @@
 #pragma once
 
 #include "Camera.h"
-#include "Input.h"
-#include "D3DInclude.h"
+#include "RenderDevice.h"
 #include "Macros.h"
 #include "Frustum.h"
+#include "BVH.h"
+#include "Bounds.h"
+#include "JobSystem.h"
+#include "OcclusionCulling.h"
+#include "UploadRing.h"
+#include "InstanceFormat.h"
+#include "VertexFormat.h"
+#include "NullCommandContext.h"
+#include "Lighting.h"
+#include "SoftwareRasterizer.h"
+#include "LodSelector.h"
+#include "TemporalCulling.h"
+#include "SpatialIndex.h"
+#include "InstanceStore.h"
+#include "LightClusters.h"
+#include "InstanceLights.h"
+#include "LightManager.h"
+#include "SkyIrradiance.h"
 #include <vector>
 #include <string>
-
-struct Light {
-    XMFLOAT4 pos;
-    XMFLOAT4 color;
-};
-
-struct Cube {
-    XMFLOAT4 pos;
-    XMFLOAT4 shineSpeedIdNM;
-};
+#include <algorithm>
+#include <chrono>
+#include <cfloat>
 
 struct PostEffectConstantBuffer {
     XMINT4 params;
 };
 
-struct Vertex {
-    XMFLOAT3 pos;
-    XMFLOAT2 uv;
-    XMFLOAT3 normal;
-    XMFLOAT3 tangent;
-};
-
-struct GeomBuffer {
-    XMMATRIX worldMatrix;
-    XMMATRIX norm;
-    XMFLOAT4 shineSpeedTexIdNM;
-};
-
 struct SceneBuffer {
     XMMATRIX viewProjectionMatrix;
     XMFLOAT4 planes[6];
 };
 
+// One instanced draw of the cubes: an index range of the LOD index buffer and a range of the visible list
+struct LodDraw {
+    UINT indexCount;
+    UINT startIndex;
+    UINT instanceCount;
+    UINT firstInstance;
+};
+
 struct CullingParams {
     XMINT4 numShapes;
-    XMFLOAT4 bbMin[MAX_CUBE];
-    XMFLOAT4 bbMax[MAX_CUBE];
 };
 
 struct LightBuffer {
     XMFLOAT4 cameraPos;
     XMINT4 lightParams;
-    Light lights[MAX_LIGHT];
-    XMFLOAT4 ambientColor;
+    XMFLOAT4 cameraDir;
+    XMINT4 clusterParams;
+    XMFLOAT4 clusterDepth;
+    XMFLOAT4 ambientSH[SkyIrradiance::coefficientCount];
 };
 
 struct SkyboxVertex {
@@ -76,18 +81,37 @@ struct TransparentWorldMatrixBuffer {
     XMFLOAT4 color;
 };
 
+// How the visible list of the cubes is built each frame
+enum class CullingMode {
+    None,
+    Parallel,       // batch frustum test of every chunk on the job system
+    MultiView,      // Parallel that also tests the faces of a reflection probe at the camera
+    BVH,
+    PlaneCoherency,
+    Temporal,
+    SpatialIndex,
+    GPU             // the culling shader writes the visible list and the indirect arguments
+};
+
 class Renderer {
 public:
     static constexpr UINT defaultWidth = 1280;
     static constexpr UINT defaultHeight = 720;
+    static constexpr int cullingChunkSize = 1024;
+    static constexpr UINT initialInstanceCapacity = 64;
+    static constexpr int initialCubeCount = 2;
+    static constexpr UINT initialLightIndexCapacity = 4096;
 
     static Renderer& GetInstance();
     Renderer(const Renderer&) = delete;
     Renderer(Renderer&&) = delete;
 
-    bool Init(HINSTANCE hInstance, HWND hWnd);
+    // Takes ownership of the device
+    bool Init(RenderDevice* pDevice);
+    void MoveCamera(const XMFLOAT3& mouse, const XMFLOAT4& keyboard);
     bool Render();
     bool Resize(UINT width, UINT height);
+    void SetCullingMode(CullingMode mode) { cullingMode_ = mode; }
 
     void Cleanup();
     ~Renderer();
@@ -96,72 +120,158 @@ private:
     Renderer();
 
     HRESULT InitScene();
-    void InputHandler();
     bool UpdateScene();
-    void ProcessPostEffect(D3D11_VIEWPORT viewport);
+    void RenderScene();
+    void RenderSoftware();
+    void ProcessPostEffect(GpuViewport viewport);
     HRESULT InitRenderTexture(int textureWidth, int textureHeight);
     void ReleaseRenderTexture();
     void ReadQueries();
-
-    ID3D11Device* pDevice_;
-    ID3D11DeviceContext* pDeviceContext_;
-    IDXGISwapChain* pSwapChain_;
-    ID3D11RenderTargetView* pRenderTargetView_;
-
-    ID3D11Buffer* pVertexBuffer_[3] = {NULL, NULL, NULL };
-    ID3D11Buffer* pIndexBuffer_[3] = { NULL, NULL, NULL };
-    ID3D11InputLayout* pInputLayout_[3] = { NULL, NULL, NULL };
-    ID3D11VertexShader* pVertexShader_[3] = { NULL, NULL, NULL };
-    ID3D11PixelShader* pPixelShader_[3] = { NULL, NULL, NULL };
-
-    ID3D11Buffer* pGeomBufferInst_ = NULL;
-    ID3D11Buffer* pPlanesWorldMatrixBuffer_[2] = { NULL, NULL };
-    ID3D11Buffer* pSkyboxWorldMatrixBuffer_ = NULL;
-    ID3D11Buffer* pViewMatrixBuffer_[2] = { NULL, NULL };
-    ID3D11Buffer* pLightBuffer_ = NULL;
-    ID3D11RasterizerState* pRasterizerState_;
-    ID3D11SamplerState* pSampler_;
-
-    ID3D11ShaderResourceView* pTexture_[3] = { NULL, NULL, NULL };
-    ID3D11Texture2D* pDepthBuffer_;
-    ID3D11DepthStencilView* pDepthBufferDSV_;
-    ID3D11DepthStencilState* pDepthState_[2] = { NULL, NULL };
-    ID3D11BlendState* pBlendState_;
-
-    ID3D11VertexShader* pPostEffectVertexShader_ = NULL;
-    ID3D11PixelShader* pPostEffectPixelShader_ = NULL;
-    ID3D11SamplerState* pPostEffectSamplerState_ = NULL;
-    ID3D11Buffer* pPostEffectConstantBuffer_ = NULL;
-    ID3D11Texture2D* pRenderTargetTexture_ = NULL;
-    ID3D11RenderTargetView* pPostEffectRenderTargetView_ = NULL;
-    ID3D11ShaderResourceView* pShaderResourceView_ = NULL;
-
-    ID3D11Buffer* pCullingParams_ = NULL;
-    ID3D11ComputeShader* pCullingShader_ = NULL;
-
-    ID3D11Buffer* pInderectArgsSrc_ = NULL;
-    ID3D11Buffer* pInderectArgs_ = NULL;
-    ID3D11UnorderedAccessView* pInderectArgsUAV_ = NULL;
-    ID3D11Buffer* pGeomBufferInstVis_ = NULL;
-    ID3D11Buffer* pGeomBufferInstVisGpu_ = NULL;
-    ID3D11UnorderedAccessView* pGeomBufferInstVisGpuUAV_ = NULL;
+    void GenerateCubes(int count);
+    void RemoveCubes(int count);
+    HRESULT ReserveInstances(UINT count);
+    HRESULT ReserveLightIndices(UINT count, UINT& capacity, GpuBuffer** ppBuffer, GpuShaderResourceView** ppSRV);
+    HRESULT CreateStructuredBuffer(UINT stride, UINT count, bool withUAV, GpuBuffer** ppBuffer,
+        GpuShaderResourceView** ppSRV, GpuUnorderedAccessView** ppUAV);
+    void ReleaseInstanceBuffers();
+    void BuildCullingViews(const XMFLOAT3& probePos);
+    void UpdateInstances(float t);
+    int CullChunk(int begin, int end);
+    void CullInstances();
+    void CompactChunks();
+    void CullBVH();
+    void CullPlaneCoherency();
+    void CullTemporal();
+    void CullSpatialIndex();
+    bool IsCPUCulling() const { return cullingMode_ != CullingMode::None && cullingMode_ != CullingMode::GPU; }
+
+    RenderDevice* pDevice_;
+
+    GpuBuffer* pVertexBuffer_[3] = {NULL, NULL, NULL };
+    GpuBuffer* pIndexBuffer_[3] = { NULL, NULL, NULL };
+    GpuInputLayout* pInputLayout_[3] = { NULL, NULL, NULL };
+    GpuVertexShader* pVertexShader_[3] = { NULL, NULL, NULL };
+    GpuPixelShader* pPixelShader_[3] = { NULL, NULL, NULL };
+
+    GpuBuffer* pGeomBufferInst_ = NULL;
+    GpuShaderResourceView* pGeomBufferInstSRV_ = NULL;
+    GpuBuffer* pPlanesWorldMatrixBuffer_[2] = { NULL, NULL };
+    GpuBuffer* pSkyboxWorldMatrixBuffer_ = NULL;
+    GpuBuffer* pViewMatrixBuffer_[2] = { NULL, NULL };
+    GpuBuffer* pLightBuffer_ = NULL;
+    GpuBuffer* pLightsBuffer_ = NULL;
+    GpuShaderResourceView* pLightsSRV_ = NULL;
+    GpuBuffer* pClusterRanges_ = NULL;
+    GpuShaderResourceView* pClusterRangesSRV_ = NULL;
+    GpuBuffer* pClusterLights_ = NULL;
+    GpuShaderResourceView* pClusterLightsSRV_ = NULL;
+    UINT clusterLightCapacity_ = 0;
+    GpuBuffer* pInstanceLightRanges_ = NULL;
+    GpuShaderResourceView* pInstanceLightRangesSRV_ = NULL;
+    GpuBuffer* pInstanceLightIndices_ = NULL;
+    GpuShaderResourceView* pInstanceLightIndicesSRV_ = NULL;
+    UINT instanceLightCapacity_ = 0;
+    GpuBuffer* pMeshBuffer_ = NULL;
+    GpuBuffer* pDrawBuffer_ = NULL;
+    GpuRasterizerState* pRasterizerState_;
+    GpuSamplerState* pSampler_;
+
+    GpuShaderResourceView* pTexture_[3] = { NULL, NULL, NULL };
+    GpuTexture* pDepthBuffer_;
+    GpuDepthStencilView* pDepthBufferDSV_;
+    GpuDepthStencilState* pDepthState_[2] = { NULL, NULL };
+    GpuBlendState* pBlendState_;
+
+    GpuVertexShader* pPostEffectVertexShader_ = NULL;
+    GpuPixelShader* pPostEffectPixelShader_ = NULL;
+    GpuSamplerState* pPostEffectSamplerState_ = NULL;
+    GpuBuffer* pPostEffectConstantBuffer_ = NULL;
+    GpuTexture* pRenderTargetTexture_ = NULL;
+    GpuRenderTargetView* pPostEffectRenderTargetView_ = NULL;
+    GpuShaderResourceView* pShaderResourceView_ = NULL;
+
+    GpuBuffer* pCullingParams_ = NULL;
+    GpuComputeShader* pCullingShader_ = NULL;
+    GpuComputeShader* pCullingScanShader_ = NULL;
+    GpuComputeShader* pCullingCompactShader_ = NULL;
+    GpuBuffer* pCullingBoundsMin_ = NULL;
+    GpuBuffer* pCullingBoundsMax_ = NULL;
+    GpuShaderResourceView* pCullingBoundsSRV_[2] = { NULL, NULL };
+
+    GpuBuffer* pInderectArgsSrc_ = NULL;
+    GpuBuffer* pInderectArgs_ = NULL;
+    GpuUnorderedAccessView* pInderectArgsUAV_ = NULL;
+    GpuBuffer* pGeomBufferInstVis_ = NULL;
+    GpuShaderResourceView* pGeomBufferInstVisSRV_ = NULL;
+    GpuBuffer* pGeomBufferInstVisGpu_ = NULL;
+    GpuUnorderedAccessView* pGeomBufferInstVisGpuUAV_ = NULL;
+    GpuBuffer* pCullingGroupIds_ = NULL;
+    GpuUnorderedAccessView* pCullingGroupIdsUAV_ = NULL;
+    GpuBuffer* pCullingGroupRanges_ = NULL;
+    GpuUnorderedAccessView* pCullingGroupRangesUAV_ = NULL;
 
     Camera* pCamera_;
-    Input* pInput_;
     Frustum* pFrustum_;
+    JobSystem* pJobSystem_;
+    OcclusionCuller* pOcclusionCuller_;
+    UploadRing* pUploadRing_;
+    CommandContext* pContext_;
+    NullCommandContext* pNullContext_;
+    SoftwareRasterizer* pSoftwareRasterizer_;
+    LodSelector* pLodSelector_;
+    TemporalCuller* pTemporalCuller_;
+    SpatialIndex* pSpatialIndex_;
+    LightClusters* pLightClusters_;
+    InstanceLights* pInstanceLights_;
+    LightManager* pLightManager_;
+    SkyIrradiance* pSkyIrradiance_;
 
     bool useNormalMap_ = true;
     bool showNormals_ = false;
+    float ambientScale_ = 0.3f;
+    XMFLOAT4 ambientSH_[SkyIrradiance::coefficientCount] = {}; // sky coefficients times ambientScale_
     bool withPostEffect_ = true;
-    bool withCulling_ = true;
-    bool withGPUCulling_ = false;
-    std::vector<Light> lights_;
-    std::vector<Cube> cubes_;
+    CullingMode cullingMode_ = CullingMode::Parallel;
+    SpatialIndexType spatialIndexType_ = SpatialIndexType::LooseOctree;
+    bool withOcclusionCulling_ = false;
+    bool withLod_ = false;
+    bool withQuantizedVertices_ = true;
+    bool withNullBackend_ = false;
+    bool withSoftwareRasterizer_ = false;
+    CommandCounters frameCounters_ = {};
+    std::vector<int> visibleLights_;
+    int visibleLightCount_ = 0;
+    std::vector<XMUINT2> lightRuns_;
+    int uploadedLightCount_ = 0;
+    bool withMovingLights_ = false;
+    float lightTime_ = 0.0f;
+    int maxClusterLights_ = 0;
+    bool withInstanceLights_ = false;
+    InstanceStore cubeStore_;
+    std::vector<InstanceHandle> cubeHandles_;
     std::vector<int> cubeIndexies_;
-    int cubesCount_ = 2;
+    UINT instanceCapacity_ = 0;
+    std::vector<int> uploadedIndexies_;
+    int uploadedShapes_ = -1;
+    int dirtyCubes_ = 0;
+    UINT64 frameUploadBytes_ = 0;
+    std::vector<int> cubeCullPlanes_;
+    BVH cubeBVH_;
+    std::vector<int> chunkVisibleCounts_;
+    std::vector<int> occluders_;
+    int occludedCount_ = 0;
+    std::vector<int> cubeLods_;
+    std::vector<int> lodOrder_;
+    std::vector<LodDraw> lodDraws_;
+    int tooSmallCount_ = 0;
+    std::vector<Frustum> cullingViewFrustums_;
+    MultiViewFrustum cullingViews_;
+    std::vector<UINT> cubeViewMasks_;
+    std::vector<int> viewVisibleCounts_;
+    int reducedCount_ = 0;
     int cubesCountGPU_ = 2;
 
-    ID3D11Query* queries_[MAX_QUERY];
+    GpuQuery* queries_[MAX_QUERY] = {};
     unsigned int curFrame_ = 0;
     unsigned int lastCompletedFrame_ = 0;
 
@@ -170,6 +280,14 @@ private:
     UINT numSphereTriangles_;
     float radius_;
 
+    // Meshes kept on the CPU for the software rasterizer
+    std::vector<Vertex> cubeVertices_;
+    std::vector<USHORT> cubeIndices_;
+    std::vector<SkyboxVertex> skyVertices_;
+    std::vector<UINT> skyIndices_;
+    std::vector<USHORT> transparentIndices_;
+    std::vector<SoftwareVertex> softwareVertices_;
+
     const TransparentVertex VerticesT[4] = {
         {0, -1, -1},
         {0,  1, -1},
@@ -0,0 +1,476 @@
+#include "SkyIrradiance.h"
+#include <DirectXPackedVector.h>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+using namespace DirectX::PackedVector;
+
+// Layout of the DDS headers of DDSTextureLoader11.cpp
+#pragma pack(push, 1)
+struct SkyDDSPixelFormat {
+    uint32_t size;
+    uint32_t flags;
+    uint32_t fourCC;
+    uint32_t bitCount;
+    uint32_t maskR;
+    uint32_t maskG;
+    uint32_t maskB;
+    uint32_t maskA;
+};
+
+struct SkyDDSHeader {
+    uint32_t size;
+    uint32_t flags;
+    uint32_t height;
+    uint32_t width;
+    uint32_t pitchOrLinearSize;
+    uint32_t depth;
+    uint32_t mipMapCount;
+    uint32_t reserved1[11];
+    SkyDDSPixelFormat format;
+    uint32_t caps;
+    uint32_t caps2;
+    uint32_t caps3;
+    uint32_t caps4;
+    uint32_t reserved2;
+};
+
+struct SkyDDSHeaderDX10 {
+    uint32_t dxgiFormat;
+    uint32_t resourceDimension;
+    uint32_t miscFlag;
+    uint32_t arraySize;
+    uint32_t miscFlags2;
+};
+#pragma pack(pop)
+
+static constexpr uint32_t ddsMagic = 0x20534444;          // "DDS "
+static constexpr uint32_t ddsFourCCFlag = 0x4;
+static constexpr uint32_t ddsCubeMapAllFaces = 0xFE00;
+static constexpr uint32_t ddsMiscTextureCube = 0x4;       // D3D11_RESOURCE_MISC_TEXTURECUBE
+static constexpr uint32_t cacheMagic = 0x324C4853;        // "SHL2"
+static constexpr uint32_t cacheVersion = 1;
+
+static constexpr uint32_t FourCC(char a, char b, char c, char d) {
+    return (uint32_t)(uint8_t)a | ((uint32_t)(uint8_t)b << 8) | ((uint32_t)(uint8_t)c << 16) | ((uint32_t)(uint8_t)d << 24);
+}
+
+enum class SkyTexelFormat {
+    Unknown,
+    RGBA8,
+    BGRA8,
+    RGBA16F,
+    RGBA32F,
+    BC1,
+    BC2,
+    BC3
+};
+
+static bool IsBlockCompressed(SkyTexelFormat format) {
+    return format == SkyTexelFormat::BC1 || format == SkyTexelFormat::BC2 || format == SkyTexelFormat::BC3;
+}
+
+// Bytes of a texel, of a 4x4 block for the compressed formats
+static int TexelBytes(SkyTexelFormat format) {
+    switch (format) {
+    case SkyTexelFormat::RGBA8:
+    case SkyTexelFormat::BGRA8:
+        return 4;
+    case SkyTexelFormat::RGBA16F:
+    case SkyTexelFormat::BC1:
+        return 8;
+    case SkyTexelFormat::RGBA32F:
+    case SkyTexelFormat::BC2:
+    case SkyTexelFormat::BC3:
+        return 16;
+    default:
+        return 0;
+    }
+}
+
+static size_t SurfaceBytes(SkyTexelFormat format, int size) {
+    if (IsBlockCompressed(format)) {
+        size_t blocks = (size_t)max(1, (size + 3) / 4);
+        return blocks * blocks * TexelBytes(format);
+    }
+    return (size_t)size * size * TexelBytes(format);
+}
+
+static SkyTexelFormat LegacyFormat(const SkyDDSPixelFormat& format) {
+    if (format.flags & ddsFourCCFlag) {
+        switch (format.fourCC) {
+        case FourCC('D', 'X', 'T', '1'): return SkyTexelFormat::BC1;
+        case FourCC('D', 'X', 'T', '2'):
+        case FourCC('D', 'X', 'T', '3'): return SkyTexelFormat::BC2;
+        case FourCC('D', 'X', 'T', '4'):
+        case FourCC('D', 'X', 'T', '5'): return SkyTexelFormat::BC3;
+        case 113: return SkyTexelFormat::RGBA16F; // D3DFMT_A16B16G16R16F
+        case 116: return SkyTexelFormat::RGBA32F; // D3DFMT_A32B32G32R32F
+        default: return SkyTexelFormat::Unknown;
+        }
+    }
+    if (format.bitCount == 32 && format.maskR == 0x000000FF && format.maskG == 0x0000FF00 && format.maskB == 0x00FF0000) {
+        return SkyTexelFormat::RGBA8;
+    }
+    if (format.bitCount == 32 && format.maskR == 0x00FF0000 && format.maskG == 0x0000FF00 && format.maskB == 0x000000FF) {
+        return SkyTexelFormat::BGRA8;
+    }
+    return SkyTexelFormat::Unknown;
+}
+
+// Values of DXGI_FORMAT that a sky can be stored in
+enum SkyDXGIFormat : uint32_t {
+    DXGI_FORMAT_R32G32B32A32_FLOAT = 2,
+    DXGI_FORMAT_R16G16B16A16_FLOAT = 10,
+    DXGI_FORMAT_R8G8B8A8_UNORM = 28,
+    DXGI_FORMAT_R8G8B8A8_UNORM_SRGB = 29,
+    DXGI_FORMAT_BC1_UNORM = 71,
+    DXGI_FORMAT_BC1_UNORM_SRGB = 72,
+    DXGI_FORMAT_BC2_UNORM = 74,
+    DXGI_FORMAT_BC2_UNORM_SRGB = 75,
+    DXGI_FORMAT_BC3_UNORM = 77,
+    DXGI_FORMAT_BC3_UNORM_SRGB = 78,
+    DXGI_FORMAT_B8G8R8A8_UNORM = 87,
+    DXGI_FORMAT_B8G8R8X8_UNORM = 88,
+    DXGI_FORMAT_B8G8R8A8_UNORM_SRGB = 91,
+    DXGI_FORMAT_B8G8R8X8_UNORM_SRGB = 93
+};
+
+static SkyTexelFormat DX10Format(uint32_t format, bool& srgb) {
+    srgb = format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB || format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB ||
+        format == DXGI_FORMAT_B8G8R8X8_UNORM_SRGB || format == DXGI_FORMAT_BC1_UNORM_SRGB ||
+        format == DXGI_FORMAT_BC2_UNORM_SRGB || format == DXGI_FORMAT_BC3_UNORM_SRGB;
+    switch (format) {
+    case DXGI_FORMAT_R8G8B8A8_UNORM:
+    case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB: return SkyTexelFormat::RGBA8;
+    case DXGI_FORMAT_B8G8R8A8_UNORM:
+    case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+    case DXGI_FORMAT_B8G8R8X8_UNORM:
+    case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB: return SkyTexelFormat::BGRA8;
+    case DXGI_FORMAT_R16G16B16A16_FLOAT: return SkyTexelFormat::RGBA16F;
+    case DXGI_FORMAT_R32G32B32A32_FLOAT: return SkyTexelFormat::RGBA32F;
+    case DXGI_FORMAT_BC1_UNORM:
+    case DXGI_FORMAT_BC1_UNORM_SRGB: return SkyTexelFormat::BC1;
+    case DXGI_FORMAT_BC2_UNORM:
+    case DXGI_FORMAT_BC2_UNORM_SRGB: return SkyTexelFormat::BC2;
+    case DXGI_FORMAT_BC3_UNORM:
+    case DXGI_FORMAT_BC3_UNORM_SRGB: return SkyTexelFormat::BC3;
+    default: return SkyTexelFormat::Unknown;
+    }
+}
+
+static XMFLOAT3 Unpack565(uint16_t color) {
+    return XMFLOAT3(((color >> 11) & 31) / 31.0f, ((color >> 5) & 63) / 63.0f, (color & 31) / 31.0f);
+}
+
+// Color part of a BC1, BC2 or BC3 block, the last two always use four colors
+static void DecodeColorBlock(const uint8_t* block, bool allowTransparent, XMFLOAT3 texels[16]) {
+    uint16_t color0 = (uint16_t)(block[0] | (block[1] << 8));
+    uint16_t color1 = (uint16_t)(block[2] | (block[3] << 8));
+    XMFLOAT3 palette[4] = { Unpack565(color0), Unpack565(color1) };
+    const XMFLOAT3& a = palette[0];
+    const XMFLOAT3& b = palette[1];
+    if (color0 > color1 || !allowTransparent) {
+        palette[2] = XMFLOAT3((2 * a.x + b.x) / 3, (2 * a.y + b.y) / 3, (2 * a.z + b.z) / 3);
+        palette[3] = XMFLOAT3((a.x + 2 * b.x) / 3, (a.y + 2 * b.y) / 3, (a.z + 2 * b.z) / 3);
+    }
+    else {
+        palette[2] = XMFLOAT3((a.x + b.x) / 2, (a.y + b.y) / 2, (a.z + b.z) / 2);
+        palette[3] = XMFLOAT3(0.0f, 0.0f, 0.0f);
+    }
+    uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | ((uint32_t)block[7] << 24);
+    for (int i = 0; i < 16; i++) {
+        texels[i] = palette[(indices >> (2 * i)) & 3];
+    }
+}
+
+static float SrgbToLinear(float value) {
+    return value <= 0.04045f ? value / 12.92f : powf((value + 0.055f) / 1.055f, 2.4f);
+}
+
+static void DecodeSurface(const uint8_t* data, SkyTexelFormat format, int size, XMFLOAT3* texels) {
+    if (IsBlockCompressed(format)) {
+        int blocks = max(1, (size + 3) / 4);
+        int colorOffset = format == SkyTexelFormat::BC1 ? 0 : 8;
+        XMFLOAT3 blockTexels[16];
+        for (int by = 0; by < blocks; by++) {
+            for (int bx = 0; bx < blocks; bx++) {
+                const uint8_t* block = data + (by * blocks + bx) * TexelBytes(format);
+                DecodeColorBlock(block + colorOffset, format == SkyTexelFormat::BC1, blockTexels);
+                for (int y = 0; y < 4 && by * 4 + y < size; y++) {
+                    for (int x = 0; x < 4 && bx * 4 + x < size; x++) {
+                        texels[(by * 4 + y) * size + bx * 4 + x] = blockTexels[y * 4 + x];
+                    }
+                }
+            }
+        }
+        return;
+    }
+    for (int i = 0; i < size * size; i++) {
+        const uint8_t* texel = data + (size_t)i * TexelBytes(format);
+        switch (format) {
+        case SkyTexelFormat::RGBA8:
+            texels[i] = XMFLOAT3(texel[0] / 255.0f, texel[1] / 255.0f, texel[2] / 255.0f);
+            break;
+        case SkyTexelFormat::BGRA8:
+            texels[i] = XMFLOAT3(texel[2] / 255.0f, texel[1] / 255.0f, texel[0] / 255.0f);
+            break;
+        case SkyTexelFormat::RGBA16F: {
+            HALF half[3];
+            memcpy(half, texel, sizeof(half));
+            texels[i] = XMFLOAT3(XMConvertHalfToFloat(half[0]), XMConvertHalfToFloat(half[1]),
+                XMConvertHalfToFloat(half[2]));
+            break;
+        }
+        default:
+            memcpy(&texels[i], texel, sizeof(XMFLOAT3));
+            break;
+        }
+    }
+}
+
+bool SkyIrradiance::DecodeCubeMap(const std::vector<uint8_t>& ddsData, CubeMapFaces& faces, int maxSize) {
+    size_t offset = sizeof(uint32_t) + sizeof(SkyDDSHeader);
+    if (ddsData.size() < offset) {
+        return false;
+    }
+    uint32_t magic;
+    SkyDDSHeader header;
+    memcpy(&magic, ddsData.data(), sizeof(magic));
+    memcpy(&header, ddsData.data() + sizeof(uint32_t), sizeof(header));
+    if (magic != ddsMagic || header.size != sizeof(SkyDDSHeader) || header.format.size != sizeof(SkyDDSPixelFormat)) {
+        return false;
+    }
+
+    SkyTexelFormat format;
+    bool srgb = false;
+    bool cube = (header.caps2 & ddsCubeMapAllFaces) == ddsCubeMapAllFaces;
+    if ((header.format.flags & ddsFourCCFlag) && header.format.fourCC == FourCC('D', 'X', '1', '0')) {
+        SkyDDSHeaderDX10 header10;
+        if (ddsData.size() < offset + sizeof(header10)) {
+            return false;
+        }
+        memcpy(&header10, ddsData.data() + offset, sizeof(header10));
+        offset += sizeof(header10);
+        format = DX10Format(header10.dxgiFormat, srgb);
+        cube = (header10.miscFlag & ddsMiscTextureCube) != 0;
+    }
+    else {
+        format = LegacyFormat(header.format);
+    }
+    if (format == SkyTexelFormat::Unknown || !cube || header.width != header.height || header.width == 0) {
+        return false;
+    }
+
+    // Every face is followed by its mips, the first one of at most maxSize texels is decoded
+    int mips = max(1, (int)header.mipMapCount);
+    int mip = 0;
+    size_t mipOffset = 0, faceBytes = 0;
+    for (int level = 0; level < mips; level++) {
+        if (level == mip && ((int)header.width >> level) > maxSize && level + 1 < mips) {
+            mip++;
+            mipOffset += SurfaceBytes(format, max(1, (int)header.width >> level));
+        }
+        faceBytes += SurfaceBytes(format, max(1, (int)header.width >> level));
+    }
+    if (ddsData.size() < offset + 6 * faceBytes) {
+        return false;
+    }
+
+    int size = max(1, (int)header.width >> mip);
+    faces.size = size;
+    faces.texels.resize((size_t)6 * size * size);
+    for (int face = 0; face < 6; face++) {
+        XMFLOAT3* texels = faces.texels.data() + (size_t)face * size * size;
+        DecodeSurface(ddsData.data() + offset + face * faceBytes + mipOffset, format, size, texels);
+        if (srgb) {
+            for (int i = 0; i < size * size; i++) {
+                texels[i] = XMFLOAT3(SrgbToLinear(texels[i].x), SrgbToLinear(texels[i].y), SrgbToLinear(texels[i].z));
+            }
+        }
+    }
+    return true;
+}
+
+SkyIrradiance::SkyIrradiance(JobSystem* pJobSystem):
+    pJobSystem_(pJobSystem) {
+    SetConstant(XMFLOAT3(1.0f, 1.0f, 1.0f));
+}
+
+void SkyIrradiance::SetConstant(const XMFLOAT3& color) {
+    for (int i = 0; i < coefficientCount; i++) {
+        coefficients_[i] = XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f);
+    }
+    coefficients_[0] = XMFLOAT4(color.x, color.y, color.z, 0.0f);
+}
+
+XMFLOAT3 SkyIrradiance::FaceDirection(int face, float u, float v) {
+    // u to the right and v down, in [-1, 1]
+    switch (face) {
+    case 0: return XMFLOAT3(1.0f, -v, -u);
+    case 1: return XMFLOAT3(-1.0f, -v, u);
+    case 2: return XMFLOAT3(u, 1.0f, v);
+    case 3: return XMFLOAT3(u, -1.0f, -v);
+    case 4: return XMFLOAT3(u, -v, 1.0f);
+    default: return XMFLOAT3(-u, -v, -1.0f);
+    }
+}
+
+// Solid angle of the face rectangle from (0, 0) to (u, v)
+static double AreaElement(double u, double v) {
+    return atan2(u * v, sqrt(u * u + v * v + 1.0));
+}
+
+// Polynomials of the basis functions, in the order of the coefficients
+static void BasisPolynomials(float x, float y, float z, float basis[SkyIrradiance::coefficientCount]) {
+    basis[0] = 1.0f;
+    basis[1] = y;
+    basis[2] = z;
+    basis[3] = x;
+    basis[4] = x * y;
+    basis[5] = y * z;
+    basis[6] = 3.0f * z * z - 1.0f;
+    basis[7] = x * z;
+    basis[8] = x * x - y * y;
+}
+
+void SkyIrradiance::Project(const CubeMapFaces& faces) {
+    // Squared basis constants times the cosine lobe over pi: 1, 2 / 3 and 1 / 4 for the bands 0, 1 and 2
+    static const double scale[coefficientCount] = {
+        0.282095 * 0.282095,
+        0.488603 * 0.488603 * 2.0 / 3.0, 0.488603 * 0.488603 * 2.0 / 3.0, 0.488603 * 0.488603 * 2.0 / 3.0,
+        1.092548 * 1.092548 / 4.0, 1.092548 * 1.092548 / 4.0, 0.315392 * 0.315392 / 4.0,
+        1.092548 * 1.092548 / 4.0, 0.546274 * 0.546274 / 4.0
+    };
+
+    // Solid angle and inverse distance to the center of every texel, the same on all faces
+    int size = faces.size;
+    float texelSize = 2.0f / size;
+    texelWeights_.resize((size_t)size * size);
+    pJobSystem_->ParallelFor(size, 16, [&](int begin, int end, int worker) {
+        for (int y = begin; y < end; y++) {
+            double v0 = -1.0 + y * (double)texelSize, v1 = v0 + texelSize;
+            for (int x = 0; x < size; x++) {
+                double u0 = -1.0 + x * (double)texelSize, u1 = u0 + texelSize;
+                float u = float(u0 + u1) * 0.5f, v = float(v0 + v1) * 0.5f;
+                texelWeights_[y * size + x] = XMFLOAT2(
+                    float(AreaElement(u0, v0) - AreaElement(u0, v1) - AreaElement(u1, v0) + AreaElement(u1, v1)),
+                    1.0f / sqrtf(1.0f + u * u + v * v));
+            }
+        }
+    });
+
+    // Rows of all faces in parallel, a row is summed in floats and added to the doubles of the worker
+    std::vector<double> sums((size_t)pJobSystem_->GetWorkerCount() * coefficientCount * 3, 0.0);
+    pJobSystem_->ParallelFor(6 * size, 16, [&](int begin, int end, int worker) {
+        double* workerSums = sums.data() + (size_t)worker * coefficientCount * 3;
+        float basis[coefficientCount];
+        for (int row = begin; row < end; row++) {
+            int face = row / size;
+            int y = row % size;
+            const XMFLOAT3* texels = faces.texels.data() + (size_t)row * size;
+            const XMFLOAT2* weights = texelWeights_.data() + (size_t)y * size;
+            float rowSums[coefficientCount * 3] = {};
+            for (int x = 0; x < size; x++) {
+                XMFLOAT3 dir = FaceDirection(face, -1.0f + (x + 0.5f) * texelSize, -1.0f + (y + 0.5f) * texelSize);
+                BasisPolynomials(dir.x * weights[x].y, dir.y * weights[x].y, dir.z * weights[x].y, basis);
+                for (int i = 0; i < coefficientCount; i++) {
+                    float weight = basis[i] * weights[x].x;
+                    rowSums[i * 3 + 0] += texels[x].x * weight;
+                    rowSums[i * 3 + 1] += texels[x].y * weight;
+                    rowSums[i * 3 + 2] += texels[x].z * weight;
+                }
+            }
+            for (int i = 0; i < coefficientCount * 3; i++) {
+                workerSums[i] += rowSums[i];
+            }
+        }
+    });
+
+    for (int i = 0; i < coefficientCount; i++) {
+        double total[3] = {};
+        for (int worker = 0; worker < pJobSystem_->GetWorkerCount(); worker++) {
+            for (int c = 0; c < 3; c++) {
+                total[c] += sums[((size_t)worker * coefficientCount + i) * 3 + c];
+            }
+        }
+        coefficients_[i] = XMFLOAT4(float(total[0] * scale[i]), float(total[1] * scale[i]), float(total[2] * scale[i]), 0.0f);
+    }
+}
+
+XMFLOAT3 SkyIrradiance::EvaluateSH(const XMFLOAT4* coefficients, const XMFLOAT3& normal) {
+    float basis[coefficientCount];
+    BasisPolynomials(normal.x, normal.y, normal.z, basis);
+    XMFLOAT3 color(0.0f, 0.0f, 0.0f);
+    for (int i = 0; i < coefficientCount; i++) {
+        color.x += coefficients[i].x * basis[i];
+        color.y += coefficients[i].y * basis[i];
+        color.z += coefficients[i].z * basis[i];
+    }
+    // L2 ringing can go below zero opposite a bright sun
+    return XMFLOAT3(max(color.x, 0.0f), max(color.y, 0.0f), max(color.z, 0.0f));
+}
+
+UINT64 SkyIrradiance::HashData(const std::vector<uint8_t>& data) {
+    // FNV-1a over eight bytes at a time, then the tail bytes
+    UINT64 hash = 14695981039346656037ull;
+    size_t words = data.size() / sizeof(UINT64);
+    for (size_t i = 0; i < words; i++) {
+        UINT64 word;
+        memcpy(&word, data.data() + i * sizeof(UINT64), sizeof(word));
+        hash = (hash ^ word) * 1099511628211ull;
+    }
+    for (size_t i = words * sizeof(UINT64); i < data.size(); i++) {
+        hash = (hash ^ data[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+bool SkyIrradiance::Load(const std::string& ddsPath, const std::string& cachePath) {
+    fromCache_ = false;
+
+    std::ifstream file(ddsPath, std::ios::binary | std::ios::ate);
+    if (!file) {
+        return false;
+    }
+    std::vector<uint8_t> ddsData((size_t)file.tellg());
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char*>(ddsData.data()), ddsData.size())) {
+        return false;
+    }
+    UINT64 hash = HashData(ddsData);
+
+    std::ifstream cache(cachePath, std::ios::binary);
+    if (cache) {
+        uint32_t magic = 0, version = 0;
+        UINT64 cachedHash = 0;
+        XMFLOAT4 coefficients[coefficientCount];
+        cache.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+        cache.read(reinterpret_cast<char*>(&version), sizeof(version));
+        cache.read(reinterpret_cast<char*>(&cachedHash), sizeof(cachedHash));
+        cache.read(reinterpret_cast<char*>(coefficients), sizeof(coefficients));
+        if (cache && magic == cacheMagic && version == cacheVersion && cachedHash == hash) {
+            memcpy(coefficients_, coefficients, sizeof(coefficients));
+            fromCache_ = true;
+        }
+    }
+
+    if (!fromCache_) {
+        CubeMapFaces faces;
+        if (!DecodeCubeMap(ddsData, faces)) {
+            return false;
+        }
+        Project(faces);
+
+        // The cache only saves time, failing to write it is not an error
+        std::ofstream output(cachePath, std::ios::binary | std::ios::trunc);
+        if (output) {
+            output.write(reinterpret_cast<const char*>(&cacheMagic), sizeof(cacheMagic));
+            output.write(reinterpret_cast<const char*>(&cacheVersion), sizeof(cacheVersion));
+            output.write(reinterpret_cast<const char*>(&hash), sizeof(hash));
+            output.write(reinterpret_cast<const char*>(coefficients_), sizeof(coefficients_));
+        }
+    }
+    return true;
+}
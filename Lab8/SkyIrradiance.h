@@ -0,0 +1,48 @@
+#pragma once
+
+#include "MathCommon.h"
+#include "JobSystem.h"
+#include <string>
+#include <vector>
+
+// Faces of a cubemap as linear RGB, +X, -X, +Y, -Y, +Z, -Z like the faces of a D3D11 cube texture
+struct CubeMapFaces {
+    int size;
+    std::vector<XMFLOAT3> texels; // 6 * size * size, rows top to bottom
+};
+
+// Irradiance of the sky as L2 spherical harmonics. The cubemap is projected on the nine basis functions and
+// convolved with the cosine lobe, the coefficients are premultiplied by the basis constants and 1 / pi so that
+// AmbientLight in LightCalc.h and EvaluateSH only sum them over the polynomials of the normal.
+// Coefficients are cached next to the cubemap and reused while the hash of the file stays the same
+class SkyIrradiance {
+public:
+    static constexpr int coefficientCount = 9;
+
+    SkyIrradiance(JobSystem* pJobSystem);
+
+    // Reads the coefficients of the DDS cubemap from cachePath or projects the file and rewrites the cache,
+    // false if the cubemap can not be read or decoded
+    bool Load(const std::string& ddsPath, const std::string& cachePath);
+    void Project(const CubeMapFaces& faces);
+    // Same light from every direction
+    void SetConstant(const XMFLOAT3& color);
+
+    const XMFLOAT4* GetCoefficients() const { return coefficients_; };
+    XMFLOAT3 Evaluate(const XMFLOAT3& normal) const { return EvaluateSH(coefficients_, normal); };
+    bool IsFromCache() const { return fromCache_; };
+
+    // Every face of a DDS cube texture in the formats of DDSTextureLoader11 that a sky is stored in. The largest
+    // mip of at most maxSize texels is decoded, L2 harmonics do not need more, the top one without mips
+    static bool DecodeCubeMap(const std::vector<uint8_t>& ddsData, CubeMapFaces& faces, int maxSize = 256);
+    static XMFLOAT3 EvaluateSH(const XMFLOAT4* coefficients, const XMFLOAT3& normal);
+    static XMFLOAT3 FaceDirection(int face, float u, float v);
+    static UINT64 HashData(const std::vector<uint8_t>& data);
+
+    ~SkyIrradiance() = default;
+private:
+    JobSystem* pJobSystem_;
+    XMFLOAT4 coefficients_[coefficientCount] = {};
+    std::vector<XMFLOAT2> texelWeights_; // solid angle and inverse length of the direction
+    bool fromCache_ = false;
+};
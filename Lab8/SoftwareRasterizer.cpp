@@ -0,0 +1,375 @@
+#include "SoftwareRasterizer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace {
+    const XMFLOAT3 SkyHorizon = { 0.8f, 0.85f, 0.9f };
+
+    SoftwareVertex Lerp(const SoftwareVertex& a, const SoftwareVertex& b, float t) {
+        SoftwareVertex v;
+        XMStoreFloat4(&v.clip, XMVectorLerp(XMLoadFloat4(&a.clip), XMLoadFloat4(&b.clip), t));
+        XMStoreFloat3(&v.pos, XMVectorLerp(XMLoadFloat3(&a.pos), XMLoadFloat3(&b.pos), t));
+        XMStoreFloat3(&v.normal, XMVectorLerp(XMLoadFloat3(&a.normal), XMLoadFloat3(&b.normal), t));
+        return v;
+    }
+
+    // Sutherland-Hodgman against distance(v) >= 0, returns the new vertex count
+    template<class Distance>
+    int ClipPolygon(const SoftwareVertex* src, int count, SoftwareVertex* dst, Distance distance) {
+        int result = 0;
+        for (int i = 0; i < count; i++) {
+            const SoftwareVertex& a = src[i];
+            const SoftwareVertex& b = src[(i + 1) % count];
+            float da = distance(a);
+            float db = distance(b);
+            if (da >= 0.0f) {
+                dst[result++] = a;
+            }
+            if ((da >= 0.0f) != (db >= 0.0f)) {
+                dst[result++] = Lerp(a, b, da / (da - db));
+            }
+        }
+        return result;
+    }
+
+    bool IsSameMaterial(const SoftwareMaterial& a, const SoftwareMaterial& b) {
+        return a.shader == b.shader && a.color.x == b.color.x && a.color.y == b.color.y && a.color.z == b.color.z &&
+            a.shine == b.shine && a.alpha == b.alpha;
+    }
+
+    double MillisecondsSince(std::chrono::high_resolution_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+}
+
+SoftwareRasterizer::SoftwareRasterizer(JobSystem* pJobSystem) :
+    pJobSystem_(pJobSystem),
+    workerPixels_(pJobSystem->GetWorkerCount(), 0) {}
+
+void SoftwareRasterizer::Resize(int width, int height) {
+    width_ = width;
+    height_ = height;
+    tilesX_ = (width + tileSize - 1) / tileSize;
+    tilesY_ = (height + tileSize - 1) / tileSize;
+    // Rows are padded to whole tiles so four pixel blocks never leave the buffers
+    stride_ = tilesX_ * tileSize;
+    color_.assign((size_t)stride_ * tilesY_ * tileSize, XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f));
+    depth_.assign((size_t)stride_ * tilesY_ * tileSize, 0.0f);
+    bins_.assign((size_t)tilesX_ * tilesY_, std::vector<int>());
+}
+
+void SoftwareRasterizer::Clear(const XMFLOAT4& color) {
+    frameStart_ = std::chrono::high_resolution_clock::now();
+    std::fill(color_.begin(), color_.end(), color);
+    std::fill(depth_.begin(), depth_.end(), 0.0f);
+    stats_ = {};
+}
+
+void SoftwareRasterizer::SetLighting(const LightingParams& params, const XMFLOAT4* ambientSH) {
+    lighting_ = params;
+    memcpy(ambientSH_, ambientSH, sizeof(ambientSH_));
+}
+
+void SoftwareRasterizer::DrawTriangle(const SoftwareVertex& v0, const SoftwareVertex& v1, const SoftwareVertex& v2,
+    const SoftwareMaterial& material) {
+    // Whole triangle outside one of the clip planes
+    for (int axis = 0; axis < 2; axis++) {
+        float c0 = axis ? v0.clip.y : v0.clip.x;
+        float c1 = axis ? v1.clip.y : v1.clip.x;
+        float c2 = axis ? v2.clip.y : v2.clip.x;
+        if ((c0 > v0.clip.w && c1 > v1.clip.w && c2 > v2.clip.w) || (c0 < -v0.clip.w && c1 < -v1.clip.w && c2 < -v2.clip.w)) {
+            return;
+        }
+    }
+
+    if (materials_.empty() || !IsSameMaterial(materials_.back(), material)) {
+        materials_.push_back(material);
+    }
+    int materialIdx = (int)materials_.size() - 1;
+
+    if (v0.clip.w >= SCREEN_NEAR && v1.clip.w >= SCREEN_NEAR && v2.clip.w >= SCREEN_NEAR &&
+        v0.clip.z >= 0.0f && v1.clip.z >= 0.0f && v2.clip.z >= 0.0f) {
+        SetupTriangle(v0, v1, v2, materialIdx);
+        return;
+    }
+
+    const SoftwareVertex polygon[3] = { v0, v1, v2 };
+    ClipAndSetup(polygon, 3, materialIdx);
+}
+
+void SoftwareRasterizer::ClipAndSetup(const SoftwareVertex* polygon, int count, int material) {
+    // Near (w >= SCREEN_NEAR, the same plane as z <= w for the reversed projection) and far (z >= 0) planes,
+    // every plane adds at most one vertex
+    SoftwareVertex nearClipped[4];
+    SoftwareVertex clipped[5];
+    count = ClipPolygon(polygon, count, nearClipped, [](const SoftwareVertex& v) { return v.clip.w - SCREEN_NEAR; });
+    count = ClipPolygon(nearClipped, count, clipped, [](const SoftwareVertex& v) { return v.clip.z; });
+    for (int i = 2; i < count; i++) {
+        SetupTriangle(clipped[0], clipped[i - 1], clipped[i], material);
+    }
+}
+
+void SoftwareRasterizer::SetupTriangle(const SoftwareVertex& v0, const SoftwareVertex& v1, const SoftwareVertex& v2, int material) {
+    const SoftwareVertex* v[3] = { &v0, &v1, &v2 };
+    XMFLOAT4 screen[3];
+    for (int i = 0; i < 3; i++) {
+        float invW = 1.0f / v[i]->clip.w;
+        screen[i] = XMFLOAT4((v[i]->clip.x * invW * 0.5f + 0.5f) * width_, (0.5f - v[i]->clip.y * invW * 0.5f) * height_,
+            v[i]->clip.z * invW, invW);
+    }
+
+    float area = (screen[1].x - screen[0].x) * (screen[2].y - screen[0].y) - (screen[1].y - screen[0].y) * (screen[2].x - screen[0].x);
+    if (fabsf(area) < 1e-8f) {
+        return;
+    }
+    // The scene is drawn without back face culling, both windings are turned the same way
+    if (area < 0.0f) {
+        std::swap(screen[1], screen[2]);
+        std::swap(v[1], v[2]);
+        area = -area;
+    }
+
+    Triangle triangle;
+    triangle.left = max((int)floorf(min(screen[0].x, min(screen[1].x, screen[2].x))), 0);
+    triangle.right = min((int)ceilf(max(screen[0].x, max(screen[1].x, screen[2].x))), width_ - 1);
+    triangle.top = max((int)floorf(min(screen[0].y, min(screen[1].y, screen[2].y))), 0);
+    triangle.bottom = min((int)ceilf(max(screen[0].y, max(screen[1].y, screen[2].y))), height_ - 1);
+    if (triangle.left > triangle.right || triangle.top > triangle.bottom) {
+        return;
+    }
+
+    // Edge i is opposite to vertex i and is divided by the area to give its barycentric weight
+    float invArea = 1.0f / area;
+    for (int i = 0; i < 3; i++) {
+        const XMFLOAT4& a = screen[(i + 1) % 3];
+        const XMFLOAT4& b = screen[(i + 2) % 3];
+        triangle.edgeA[i] = (a.y - b.y) * invArea;
+        triangle.edgeB[i] = (b.x - a.x) * invArea;
+        triangle.edgeC[i] = (a.x * b.y - a.y * b.x) * invArea;
+        triangle.depth[i] = screen[i].z;
+        triangle.invW[i] = screen[i].w;
+        XMStoreFloat3(&triangle.pos[i], XMVectorScale(XMLoadFloat3(&v[i]->pos), screen[i].w));
+        XMStoreFloat3(&triangle.normal[i], XMVectorScale(XMLoadFloat3(&v[i]->normal), screen[i].w));
+    }
+    triangle.material = material;
+
+    int index = (int)triangles_.size();
+    triangles_.push_back(triangle);
+    for (int ty = triangle.top / tileSize; ty <= triangle.bottom / tileSize; ty++) {
+        for (int tx = triangle.left / tileSize; tx <= triangle.right / tileSize; tx++) {
+            bins_[(size_t)ty * tilesX_ + tx].push_back(index);
+        }
+    }
+}
+
+void SoftwareRasterizer::Flush() {
+    std::fill(workerPixels_.begin(), workerPixels_.end(), 0);
+    pJobSystem_->ParallelFor(tilesX_ * tilesY_, 1, [&](int begin, int end, int worker) {
+        for (int tile = begin; tile < end; tile++) {
+            ShadeTile(tile, worker);
+        }
+    });
+
+    stats_.triangles += (int)triangles_.size();
+    for (UINT64 pixels : workerPixels_) {
+        stats_.pixels += pixels;
+    }
+    stats_.milliseconds = MillisecondsSince(frameStart_);
+
+    triangles_.clear();
+    materials_.clear();
+    for (std::vector<int>& bin : bins_) {
+        bin.clear();
+    }
+}
+
+void SoftwareRasterizer::ShadeTile(int tile, int worker) {
+    int left = tile % tilesX_ * tileSize;
+    int top = tile / tilesX_ * tileSize;
+    int right = min(left + tileSize, width_) - 1;
+    int bottom = min(top + tileSize, height_) - 1;
+    for (int index : bins_[tile]) {
+        const Triangle& triangle = triangles_[index];
+        ShadeTriangle(triangle, max(left, triangle.left), max(top, triangle.top), min(right, triangle.right),
+            min(bottom, triangle.bottom), worker);
+    }
+}
+
+void SoftwareRasterizer::ShadeTriangle(const Triangle& triangle, int left, int top, int right, int bottom, int worker) {
+    const SoftwareMaterial& material = materials_[triangle.material];
+    bool depthWrite = material.shader == SoftwareShader::Lit;
+
+    // Pixels on an edge belong to the triangle only if it is a top or left edge, so shared edges are drawn once
+    XMVECTOR edgeStepX[3], edgeTopLeft[3];
+    for (int i = 0; i < 3; i++) {
+        edgeStepX[i] = XMVectorReplicate(triangle.edgeA[i]);
+        bool topLeft = triangle.edgeA[i] > 0.0f || (triangle.edgeA[i] == 0.0f && triangle.edgeB[i] > 0.0f);
+        edgeTopLeft[i] = topLeft ? XMVectorTrueInt() : XMVectorFalseInt();
+    }
+    // Depth is affine in screen space
+    float depthA = triangle.depth[0] * triangle.edgeA[0] + triangle.depth[1] * triangle.edgeA[1] + triangle.depth[2] * triangle.edgeA[2];
+    float depthB = triangle.depth[0] * triangle.edgeB[0] + triangle.depth[1] * triangle.edgeB[1] + triangle.depth[2] * triangle.edgeB[2];
+    float depthC = triangle.depth[0] * triangle.edgeC[0] + triangle.depth[1] * triangle.edgeC[1] + triangle.depth[2] * triangle.edgeC[2];
+    XMVECTOR depthStepX = XMVectorReplicate(depthA);
+    XMVECTOR zero = XMVectorZero();
+    XMVECTOR rightEdge = XMVectorReplicate(right + 1.0f);
+    UINT64 pixels = 0;
+    // Lit and transparent pixels are shaded eight at a time, the sky per pixel
+    ShadingSamples packet;
+    XMFLOAT4* packetTargets[ShadingSamples::count];
+    int packetCount = 0;
+
+    left &= ~3;
+    for (int y = top; y <= bottom; y++) {
+        float py = y + 0.5f;
+        XMVECTOR px = XMVectorSet(left + 0.5f, left + 1.5f, left + 2.5f, left + 3.5f);
+        XMVECTOR e[3];
+        for (int i = 0; i < 3; i++) {
+            e[i] = XMVectorAdd(XMVectorMultiply(px, edgeStepX[i]), XMVectorReplicate(triangle.edgeB[i] * py + triangle.edgeC[i]));
+        }
+        XMVECTOR z = XMVectorAdd(XMVectorMultiply(px, depthStepX), XMVectorReplicate(depthB * py + depthC));
+
+        XMFLOAT4* colorRow = &color_[(size_t)y * stride_];
+        float* depthRow = &depth_[(size_t)y * stride_];
+        for (int x = left; x <= right; x += 4) {
+            XMVECTOR inside = XMVectorLess(px, rightEdge);
+            for (int i = 0; i < 3; i++) {
+                XMVECTOR onEdge = XMVectorAndInt(XMVectorEqual(e[i], zero), edgeTopLeft[i]);
+                inside = XMVectorAndInt(inside, XMVectorOrInt(XMVectorGreater(e[i], zero), onEdge));
+            }
+            if (!XMVector4EqualInt(inside, XMVectorFalseInt())) {
+                XMVECTOR oldDepth = XMLoadFloat4(reinterpret_cast<XMFLOAT4*>(depthRow + x));
+                // Reversed depth: GREATER for the cubes as pDepthState_[0], GREATER_EQUAL for the rest as pDepthState_[1]
+                XMVECTOR pass = XMVectorAndInt(inside, depthWrite ? XMVectorGreater(z, oldDepth) : XMVectorGreaterOrEqual(z, oldDepth));
+                XMUINT4 mask;
+                XMStoreUInt4(&mask, pass);
+                if (mask.x | mask.y | mask.z | mask.w) {
+                    if (depthWrite) {
+                        XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(depthRow + x), XMVectorSelect(oldDepth, z, pass));
+                    }
+                    XMFLOAT4 b[3];
+                    for (int i = 0; i < 3; i++) {
+                        XMStoreFloat4(&b[i], e[i]);
+                    }
+                    const UINT lanes[4] = { mask.x, mask.y, mask.z, mask.w };
+                    const float* b0 = &b[0].x;
+                    const float* b1 = &b[1].x;
+                    const float* b2 = &b[2].x;
+                    for (int lane = 0; lane < 4; lane++) {
+                        if (!lanes[lane]) {
+                            continue;
+                        }
+                        if (material.shader == SoftwareShader::Sky) {
+                            colorRow[x + lane] = ShadeSkyPixel(triangle, material, b0[lane], b1[lane], b2[lane]);
+                        }
+                        else {
+                            SetSample(triangle, material, b0[lane], b1[lane], b2[lane], packet, packetCount);
+                            packetTargets[packetCount++] = &colorRow[x + lane];
+                            if (packetCount == ShadingSamples::count) {
+                                ShadePacket(material, packet, packetTargets, packetCount);
+                                packetCount = 0;
+                            }
+                        }
+                        pixels++;
+                    }
+                }
+            }
+
+            px = XMVectorAdd(px, XMVectorReplicate(4.0f));
+            for (int i = 0; i < 3; i++) {
+                e[i] = XMVectorAdd(e[i], XMVectorScale(edgeStepX[i], 4.0f));
+            }
+            z = XMVectorAdd(z, XMVectorScale(depthStepX, 4.0f));
+        }
+    }
+    if (packetCount > 0) {
+        ShadePacket(material, packet, packetTargets, packetCount);
+    }
+    workerPixels_[worker] += pixels;
+}
+
+void SoftwareRasterizer::SetSample(const Triangle& triangle, const SoftwareMaterial& material, float b0, float b1, float b2,
+    ShadingSamples& samples, int lane) const {
+    // Perspective correct attributes: interpolate attribute / w and 1 / w, then divide
+    float w = 1.0f / (b0 * triangle.invW[0] + b1 * triangle.invW[1] + b2 * triangle.invW[2]);
+    samples.posX[lane] = (b0 * triangle.pos[0].x + b1 * triangle.pos[1].x + b2 * triangle.pos[2].x) * w;
+    samples.posY[lane] = (b0 * triangle.pos[0].y + b1 * triangle.pos[1].y + b2 * triangle.pos[2].y) * w;
+    samples.posZ[lane] = (b0 * triangle.pos[0].z + b1 * triangle.pos[1].z + b2 * triangle.pos[2].z) * w;
+
+    if (material.shader == SoftwareShader::Lit) {
+        samples.normalX[lane] = (b0 * triangle.normal[0].x + b1 * triangle.normal[1].x + b2 * triangle.normal[2].x) * w;
+        samples.normalY[lane] = (b0 * triangle.normal[0].y + b1 * triangle.normal[1].y + b2 * triangle.normal[2].y) * w;
+        samples.normalZ[lane] = (b0 * triangle.normal[0].z + b1 * triangle.normal[1].z + b2 * triangle.normal[2].z) * w;
+        samples.shine[lane] = material.shine;
+    }
+    else {
+        samples.normalX[lane] = 1.0f;
+        samples.normalY[lane] = 0.0f;
+        samples.normalZ[lane] = 0.0f;
+        samples.shine[lane] = 0.0f;
+    }
+    samples.colorR[lane] = material.color.x;
+    samples.colorG[lane] = material.color.y;
+    samples.colorB[lane] = material.color.z;
+}
+
+void SoftwareRasterizer::ShadePacket(const SoftwareMaterial& material, ShadingSamples& samples, XMFLOAT4* const* targets, int count) const {
+    // Unused lanes repeat the first sample
+    for (int lane = count; lane < ShadingSamples::count; lane++) {
+        samples.posX[lane] = samples.posX[0];
+        samples.posY[lane] = samples.posY[0];
+        samples.posZ[lane] = samples.posZ[0];
+        samples.normalX[lane] = samples.normalX[0];
+        samples.normalY[lane] = samples.normalY[0];
+        samples.normalZ[lane] = samples.normalZ[0];
+        samples.colorR[lane] = samples.colorR[0];
+        samples.colorG[lane] = samples.colorG[0];
+        samples.colorB[lane] = samples.colorB[0];
+        samples.shine[lane] = samples.shine[0];
+    }
+    bool transparent = material.shader == SoftwareShader::Transparent;
+    ShadedColors colors;
+    CalculateColor8(lighting_, samples, transparent, colors);
+
+    // Sky ambient of PS.hlsl, TPS.hlsl has none
+    if (material.shader == SoftwareShader::Lit && !lighting_.showNormals) {
+        for (int lane = 0; lane < count; lane++) {
+            XMFLOAT3 normal;
+            XMStoreFloat3(&normal, XMVector3Normalize(XMVectorSet(samples.normalX[lane], samples.normalY[lane], samples.normalZ[lane], 0.0f)));
+            XMFLOAT3 ambient = SkyIrradiance::EvaluateSH(ambientSH_, normal);
+            colors.r[lane] += ambient.x * samples.colorR[lane];
+            colors.g[lane] += ambient.y * samples.colorG[lane];
+            colors.b[lane] += ambient.z * samples.colorB[lane];
+        }
+    }
+
+    for (int lane = 0; lane < count; lane++) {
+        XMFLOAT4& dst = *targets[lane];
+        if (transparent) {
+            // SRC_ALPHA, INV_SRC_ALPHA for the color, the destination alpha is kept
+            dst.x = colors.r[lane] * material.alpha + dst.x * (1.0f - material.alpha);
+            dst.y = colors.g[lane] * material.alpha + dst.y * (1.0f - material.alpha);
+            dst.z = colors.b[lane] * material.alpha + dst.z * (1.0f - material.alpha);
+        }
+        else {
+            dst = XMFLOAT4(colors.r[lane], colors.g[lane], colors.b[lane], 1.0f);
+        }
+    }
+}
+
+XMFLOAT4 SoftwareRasterizer::ShadeSkyPixel(const Triangle& triangle, const SoftwareMaterial& material, float b0, float b1, float b2) const {
+    float w = 1.0f / (b0 * triangle.invW[0] + b1 * triangle.invW[1] + b2 * triangle.invW[2]);
+    XMVECTOR pos = XMVectorSet((b0 * triangle.pos[0].x + b1 * triangle.pos[1].x + b2 * triangle.pos[2].x) * w,
+        (b0 * triangle.pos[0].y + b1 * triangle.pos[1].y + b2 * triangle.pos[2].y) * w,
+        (b0 * triangle.pos[0].z + b1 * triangle.pos[1].z + b2 * triangle.pos[2].z) * w, 0.0f);
+
+    // The cubemap lives on the GPU only, a gradient from the horizon to material.color stands in for it
+    XMFLOAT3 dir;
+    XMStoreFloat3(&dir, XMVector3Normalize(pos));
+    float t = dir.y > 0.0f ? dir.y : 0.0f;
+    float ground = dir.y < 0.0f ? 1.0f + dir.y * 0.5f : 1.0f;
+    return XMFLOAT4((SkyHorizon.x + (material.color.x - SkyHorizon.x) * t) * ground,
+        (SkyHorizon.y + (material.color.y - SkyHorizon.y) * t) * ground,
+        (SkyHorizon.z + (material.color.z - SkyHorizon.z) * t) * ground, 1.0f);
+}
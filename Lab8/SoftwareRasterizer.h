@@ -0,0 +1,101 @@
+#pragma once
+
+#include "MathCommon.h"
+#include "Macros.h"
+#include "JobSystem.h"
+#include "Lighting.h"
+#include "SkyIrradiance.h"
+#include <chrono>
+#include <vector>
+
+// Post projection vertex: clip position and the attributes the pixel shaders need
+struct SoftwareVertex {
+    XMFLOAT4 clip;
+    XMFLOAT3 pos;    // world position, local position for the sky
+    XMFLOAT3 normal;
+};
+
+enum class SoftwareShader {
+    Lit,         // PS.hlsl, depth GREATER with writes
+    Sky,         // CubeMapPS.hlsl, depth GREATER_EQUAL without writes
+    Transparent  // TPS.hlsl, depth GREATER_EQUAL without writes, alpha blending
+};
+
+struct SoftwareMaterial {
+    SoftwareShader shader;
+    XMFLOAT3 color;
+    float shine;
+    float alpha;
+};
+
+struct SoftwareStats {
+    int triangles;
+    UINT64 pixels;
+    double milliseconds; // from Clear to the end of Flush
+};
+
+// CPU backend for the scene passes: triangles are clipped and binned into screen tiles on the calling thread,
+// Flush shades the tiles in parallel, in submission order within every tile. Coverage and depth are tested
+// four pixels at a time, lit and transparent pixels of a triangle are shaded in packets by CalculateColor8
+class SoftwareRasterizer {
+public:
+    static constexpr int tileSize = 32;
+
+    SoftwareRasterizer(JobSystem* pJobSystem);
+
+    void Resize(int width, int height);
+    void Clear(const XMFLOAT4& color);
+    // ambientSH - SkyIrradiance coefficients, copied
+    void SetLighting(const LightingParams& params, const XMFLOAT4* ambientSH);
+
+    void DrawTriangle(const SoftwareVertex& v0, const SoftwareVertex& v1, const SoftwareVertex& v2, const SoftwareMaterial& material);
+    void Flush();
+
+    // RGBA32F pixels, GetRowPitch bytes between rows
+    const XMFLOAT4* GetColor() const { return color_.data(); };
+    UINT GetRowPitch() const { return UINT(stride_ * sizeof(XMFLOAT4)); };
+    const SoftwareStats& GetStats() const { return stats_; };
+
+    ~SoftwareRasterizer() = default;
+private:
+    // Screen space setup, edge and plane equations are f(x, y) = a * x + b * y + c
+    struct Triangle {
+        float edgeA[3];
+        float edgeB[3];
+        float edgeC[3];
+        float depth[3];
+        float invW[3];
+        XMFLOAT3 pos[3];    // attributes divided by w
+        XMFLOAT3 normal[3];
+        int left, top, right, bottom;
+        int material;
+    };
+
+    void ClipAndSetup(const SoftwareVertex* polygon, int count, int material);
+    void SetupTriangle(const SoftwareVertex& v0, const SoftwareVertex& v1, const SoftwareVertex& v2, int material);
+    void ShadeTile(int tile, int worker);
+    void ShadeTriangle(const Triangle& triangle, int left, int top, int right, int bottom, int worker);
+    void SetSample(const Triangle& triangle, const SoftwareMaterial& material, float b0, float b1, float b2,
+        ShadingSamples& samples, int lane) const;
+    void ShadePacket(const SoftwareMaterial& material, ShadingSamples& samples, XMFLOAT4* const* targets, int count) const;
+    XMFLOAT4 ShadeSkyPixel(const Triangle& triangle, const SoftwareMaterial& material, float b0, float b1, float b2) const;
+
+    JobSystem* pJobSystem_;
+    int width_ = 0;
+    int height_ = 0;
+    int stride_ = 0;
+    int tilesX_ = 0;
+    int tilesY_ = 0;
+    std::vector<XMFLOAT4> color_;
+    std::vector<float> depth_;
+
+    std::vector<Triangle> triangles_;
+    std::vector<SoftwareMaterial> materials_;
+    std::vector<std::vector<int>> bins_;
+    std::vector<UINT64> workerPixels_;
+
+    LightingParams lighting_ = {};
+    XMFLOAT4 ambientSH_[SkyIrradiance::coefficientCount] = {};
+    SoftwareStats stats_ = {};
+    std::chrono::high_resolution_clock::time_point frameStart_;
+};
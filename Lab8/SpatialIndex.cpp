@@ -0,0 +1,123 @@
+#include "SpatialIndex.h"
+#include "LooseOctree.h"
+#include "HashGrid.h"
+#include <algorithm>
+
+SpatialIndex* SpatialIndex::Create(SpatialIndexType type) {
+    // Sized for the cubes of the scene, which are placed on a [-6, 6) grid
+    if (type == SpatialIndexType::HashGrid) {
+        return new HashGrid(2.0f);
+    }
+    return new LooseOctree(XMFLOAT3(0.0f, 0.0f, 0.0f), 8.0f, 6);
+}
+
+void SpatialIndex::Insert(int id, const XMFLOAT4& bbMin, const XMFLOAT4& bbMax) {
+    if (id >= (int)entries_.size()) {
+        entries_.resize((size_t)id + 1, { XMFLOAT4(), XMFLOAT4(), -1, -1 });
+    }
+    if (entries_[id].cell >= 0) {
+        Move(id, bbMin, bbMax);
+        return;
+    }
+
+    entries_[id].bbMin = bbMin;
+    entries_[id].bbMax = bbMax;
+    AddToCell(id, AcquireCell(bbMin, bbMax));
+}
+
+void SpatialIndex::Move(int id, const XMFLOAT4& bbMin, const XMFLOAT4& bbMax) {
+    if (!Contains(id)) {
+        Insert(id, bbMin, bbMax);
+        return;
+    }
+
+    entries_[id].bbMin = bbMin;
+    entries_[id].bbMax = bbMax;
+    int cell = AcquireCell(bbMin, bbMax);
+    if (cell != entries_[id].cell) {
+        RemoveFromCell(id);
+        AddToCell(id, cell);
+    }
+}
+
+void SpatialIndex::Remove(int id) {
+    if (Contains(id)) {
+        RemoveFromCell(id);
+    }
+}
+
+void SpatialIndex::AddToCell(int id, int cell) {
+    entries_[id].cell = cell;
+    entries_[id].slot = (int)cellIds_[cell].size();
+    cellIds_[cell].push_back(id);
+    count_++;
+    OnCellChanged(cell, 1);
+}
+
+void SpatialIndex::RemoveFromCell(int id) {
+    Entry& entry = entries_[id];
+    std::vector<int>& ids = cellIds_[entry.cell];
+    int last = ids.back();
+    ids[entry.slot] = last;
+    entries_[last].slot = entry.slot;
+    ids.pop_back();
+    count_--;
+    OnCellChanged(entry.cell, -1);
+    entry.cell = -1;
+}
+
+void SpatialIndex::Clear() {
+    entries_.clear();
+    cellIds_.clear();
+    count_ = 0;
+}
+
+int SpatialIndex::AppendCell(int cell, int* ids) const {
+    const std::vector<int>& cellIds = cellIds_[cell];
+    std::copy(cellIds.begin(), cellIds.end(), ids);
+    return (int)cellIds.size();
+}
+
+int SpatialIndex::TestCellFrustum(Frustum& frustum, int cell, UINT planeMask, int* ids) const {
+    int count = 0;
+    for (int id : cellIds_[cell]) {
+        int lastPlane = -1;
+        UINT boxPlanes = planeMask;
+        if (frustum.ClassifyRectangle(entries_[id].bbMin, entries_[id].bbMax, lastPlane, boxPlanes) != CullResult::Outside) {
+            ids[count++] = id;
+        }
+    }
+    return count;
+}
+
+int SpatialIndex::TestCellSphere(int cell, const XMFLOAT3& center, float radius, int* ids) const {
+    int count = 0;
+    for (int id : cellIds_[cell]) {
+        if (SphereIntersectsBox(center, radius, entries_[id].bbMin, entries_[id].bbMax)) {
+            ids[count++] = id;
+        }
+    }
+    return count;
+}
+
+int SpatialIndex::TestCellBox(int cell, const XMFLOAT4& bbMin, const XMFLOAT4& bbMax, int* ids) const {
+    int count = 0;
+    for (int id : cellIds_[cell]) {
+        if (BoxesIntersect(bbMin, bbMax, entries_[id].bbMin, entries_[id].bbMax)) {
+            ids[count++] = id;
+        }
+    }
+    return count;
+}
+
+bool SpatialIndex::SphereIntersectsBox(const XMFLOAT3& center, float radius, const XMFLOAT4& bbMin, const XMFLOAT4& bbMax) {
+    XMVECTOR c = XMLoadFloat3(&center);
+    XMVECTOR closest = XMVectorClamp(c, XMLoadFloat4(&bbMin), XMLoadFloat4(&bbMax));
+    return XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(c, closest))) <= radius * radius;
+}
+
+bool SpatialIndex::BoxesIntersect(const XMFLOAT4& aMin, const XMFLOAT4& aMax, const XMFLOAT4& bMin, const XMFLOAT4& bMax) {
+    return aMin.x <= bMax.x && aMax.x >= bMin.x &&
+        aMin.y <= bMax.y && aMax.y >= bMin.y &&
+        aMin.z <= bMax.z && aMax.z >= bMin.z;
+}
\ No newline at end of file
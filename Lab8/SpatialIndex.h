@@ -0,0 +1,57 @@
+#pragma once
+
+#include "MathCommon.h"
+#include "Frustum.h"
+#include <vector>
+
+enum class SpatialIndexType {
+    LooseOctree,
+    HashGrid
+};
+
+// Boxes keyed by dense ids (instance or light indices) kept in the cells of a spatial structure. Every cell holds
+// an unordered list of ids and a removed id is replaced by the last id of its cell, so Insert, Move and Remove are
+// O(1) amortized. Queries write the ids they find and return their number, ids must have room for GetCount() entries
+class SpatialIndex {
+public:
+    static SpatialIndex* Create(SpatialIndexType type);
+
+    void Insert(int id, const XMFLOAT4& bbMin, const XMFLOAT4& bbMax);
+    // Updates the bounds of an id, inserts it if it is not in the index
+    void Move(int id, const XMFLOAT4& bbMin, const XMFLOAT4& bbMax);
+    void Remove(int id);
+    bool Contains(int id) const { return id >= 0 && id < (int)entries_.size() && entries_[id].cell >= 0; };
+    int GetCount() const { return count_; };
+    virtual void Clear();
+
+    virtual int QueryFrustum(Frustum& frustum, int* ids) = 0;
+    virtual int QuerySphere(const XMFLOAT3& center, float radius, int* ids) = 0;
+    virtual int QueryBox(const XMFLOAT4& bbMin, const XMFLOAT4& bbMax, int* ids) = 0;
+
+    virtual ~SpatialIndex() = default;
+protected:
+    struct Entry {
+        XMFLOAT4 bbMin;
+        XMFLOAT4 bbMax;
+        int cell; // -1 if the id is not in the index
+        int slot; // position in the id list of the cell
+    };
+
+    // Returns the cell the box belongs to, creating it if needed
+    virtual int AcquireCell(const XMFLOAT4& bbMin, const XMFLOAT4& bbMax) = 0;
+    // Called after an id entered (delta 1) or left (delta -1) the cell
+    virtual void OnCellChanged(int cell, int delta) {};
+
+    void AddToCell(int id, int cell);
+    void RemoveFromCell(int id);
+    int AppendCell(int cell, int* ids) const;
+    int TestCellFrustum(Frustum& frustum, int cell, UINT planeMask, int* ids) const;
+    int TestCellSphere(int cell, const XMFLOAT3& center, float radius, int* ids) const;
+    int TestCellBox(int cell, const XMFLOAT4& bbMin, const XMFLOAT4& bbMax, int* ids) const;
+    static bool SphereIntersectsBox(const XMFLOAT3& center, float radius, const XMFLOAT4& bbMin, const XMFLOAT4& bbMax);
+    static bool BoxesIntersect(const XMFLOAT4& aMin, const XMFLOAT4& aMax, const XMFLOAT4& bMin, const XMFLOAT4& bMax);
+
+    std::vector<Entry> entries_;
+    std::vector<std::vector<int>> cellIds_;
+    int count_ = 0;
+};
@@ -7,7 +7,7 @@ struct PS_INPUT {
 
 float4 main(PS_INPUT input) : SV_TARGET {
 #ifdef USE_LIGHTS
-    return float4(CalculateColor(color.xyz, float3(1, 0, 0), input.worldPos.xyz, 0.0, true), 0.5f);
+    return float4(CalculateColor(color.xyz, float3(1, 0, 0), input.worldPos.xyz, input.position.xy, 0.0, true), 0.5f);
 #else
     return float4(color.xyz, 0.5f);
 #endif // !USE_LIGHTS
@@ -0,0 +1,177 @@
+#include "TemporalCulling.h"
+
+TemporalCuller::TemporalCuller(float tolerance):
+    tolerance_(tolerance) {}
+
+void TemporalCuller::SetTolerance(float tolerance) {
+    if (tolerance != tolerance_) {
+        tolerance_ = tolerance;
+        valid_ = false;
+    }
+}
+
+void TemporalCuller::Classify4(const XMFLOAT4* planes, const float* minX, const float* minY, const float* minZ,
+    const float* maxX, const float* maxY, const float* maxZ, UINT& visible, UINT& stable, XMVECTOR& extentSq) const {
+    XMVECTOR boxMin[3] = {
+        XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(minX)),
+        XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(minY)),
+        XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(minZ))
+    };
+    XMVECTOR boxMax[3] = {
+        XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(maxX)),
+        XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(maxY)),
+        XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(maxZ))
+    };
+    XMVECTOR zero = XMVectorZero();
+    XMVECTOR tolerance = XMVectorReplicate(tolerance_);
+    XMVECTOR minusTolerance = XMVectorNegate(tolerance);
+
+    XMVECTOR inside = XMVectorTrueInt();
+    XMVECTOR deepInside = XMVectorTrueInt();
+    XMVECTOR farOutside = XMVectorFalseInt();
+    for (int i = 0; i < 6; i++) {
+        // The p-vertex distance, summed in the same order as in Frustum::CheckRectangles4
+        XMVECTOR dotProduct = XMVectorMultiply(XMVectorReplicate(planes[i].x), planes[i].x >= 0.0f ? boxMax[0] : boxMin[0]);
+        dotProduct = XMVectorAdd(dotProduct, XMVectorMultiply(XMVectorReplicate(planes[i].y), planes[i].y >= 0.0f ? boxMax[1] : boxMin[1]));
+        dotProduct = XMVectorAdd(dotProduct, XMVectorMultiply(XMVectorReplicate(planes[i].z), planes[i].z >= 0.0f ? boxMax[2] : boxMin[2]));
+        dotProduct = XMVectorAdd(dotProduct, XMVectorReplicate(planes[i].w));
+
+        inside = XMVectorAndInt(inside, XMVectorGreaterOrEqual(dotProduct, zero));
+        deepInside = XMVectorAndInt(deepInside, XMVectorGreater(dotProduct, tolerance));
+        farOutside = XMVectorOrInt(farOutside, XMVectorLess(dotProduct, minusTolerance));
+    }
+    XMVECTOR stableMask = XMVectorOrInt(deepInside, farOutside);
+
+    for (int j = 0; j < 3; j++) {
+        XMVECTOR cornerSq = XMVectorMax(XMVectorMultiply(boxMin[j], boxMin[j]), XMVectorMultiply(boxMax[j], boxMax[j]));
+        boxMin[j] = cornerSq;
+    }
+    extentSq = XMVectorMax(extentSq, XMVectorAdd(XMVectorAdd(boxMin[0], boxMin[1]), boxMin[2]));
+
+    XMUINT4 insideBits, stableBits;
+    XMStoreUInt4(&insideBits, inside);
+    XMStoreUInt4(&stableBits, stableMask);
+    visible = (insideBits.x & 1u) | ((insideBits.y & 1u) << 1) | ((insideBits.z & 1u) << 2) | ((insideBits.w & 1u) << 3);
+    stable = (stableBits.x & 1u) | ((stableBits.y & 1u) << 1) | ((stableBits.z & 1u) << 2) | ((stableBits.w & 1u) << 3);
+}
+
+void TemporalCuller::ClassifyList(const XMFLOAT4* planes, const BoxStreams& boxes, const std::vector<int>& indices,
+    bool updateVisible, bool updateBoundary) {
+    XMVECTOR extentSq = XMVectorReplicate(extent_ * extent_);
+    for (size_t i = 0; i < indices.size(); i += 4) {
+        int n = (int)min(indices.size() - i, (size_t)4);
+        float values[6][4];
+        boxes.Gather4(&indices[i], n, values);
+
+        UINT visible, stable;
+        Classify4(planes, values[0], values[1], values[2], values[3], values[4], values[5], visible, stable, extentSq);
+        for (int k = 0; k < n; k++) {
+            int idx = indices[i + k];
+            if (updateVisible) {
+                visible_[idx] = (visible >> k) & 1u;
+            }
+            if (updateBoundary) {
+                bool isBoundary = !((stable >> k) & 1u);
+                if (isBoundary && !inBoundary_[idx]) {
+                    boundary_.push_back(idx);
+                }
+                inBoundary_[idx] = isBoundary;
+            }
+        }
+    }
+    extent_ = sqrtf(max(max(XMVectorGetX(extentSq), XMVectorGetY(extentSq)), max(XMVectorGetZ(extentSq), XMVectorGetW(extentSq))));
+}
+
+// Upper bound of the change of the signed distance of any point within extent_ of the origin to any plane
+float TemporalCuller::PlaneDrift(const XMFLOAT4* planes) const {
+    float drift = 0.0f;
+    for (int i = 0; i < 6; i++) {
+        XMVECTOR delta = XMVectorSubtract(XMLoadFloat4(&planes[i]), XMLoadFloat4(&reference_[i]));
+        float normalDelta = XMVectorGetX(XMVector3Length(delta));
+        drift = max(drift, normalDelta * extent_ + fabsf(XMVectorGetW(delta)));
+    }
+    return drift;
+}
+
+void TemporalCuller::FullRetest(const XMFLOAT4* planes, const BoxStreams& boxes, int count) {
+    for (int i = 0; i < 6; i++) {
+        reference_[i] = planes[i];
+    }
+    boundary_.clear();
+    XMVECTOR extentSq = XMVectorZero();
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        UINT visible, stable;
+        Classify4(planes, &boxes.minX[i], &boxes.minY[i], &boxes.minZ[i], &boxes.maxX[i], &boxes.maxY[i], &boxes.maxZ[i],
+            visible, stable, extentSq);
+        for (int k = 0; k < 4; k++) {
+            visible_[i + k] = (visible >> k) & 1u;
+            inBoundary_[i + k] = !((stable >> k) & 1u);
+            if (inBoundary_[i + k]) {
+                boundary_.push_back(i + k);
+            }
+        }
+    }
+    extent_ = sqrtf(max(max(XMVectorGetX(extentSq), XMVectorGetY(extentSq)), max(XMVectorGetZ(extentSq), XMVectorGetW(extentSq))));
+
+    retest_.clear();
+    for (; i < count; i++) {
+        inBoundary_[i] = 0;
+        retest_.push_back(i);
+    }
+    ClassifyList(planes, boxes, retest_, true, true);
+
+    valid_ = true;
+    stats_.tested = count;
+    stats_.fullRetest = true;
+}
+
+int TemporalCuller::Cull(Frustum& frustum, const BoxStreams& boxes, const char* dirty, int count, int* visibleIndices) {
+    const XMFLOAT4* planes = frustum.GetPlanes();
+    int previousCount = (int)visible_.size();
+    visible_.resize(count, 0);
+    inBoundary_.resize(count, 0);
+    stats_ = {};
+
+    if (!valid_) {
+        FullRetest(planes, boxes, count);
+    }
+    else {
+        // Moved and new instances are classified against the reference planes first, so the extent includes them
+        retest_.clear();
+        for (int i = 0; i < count; i++) {
+            if (dirty[i] || i >= previousCount) {
+                retest_.push_back(i);
+            }
+        }
+        ClassifyList(reference_, boxes, retest_, false, true);
+
+        if (PlaneDrift(planes) > tolerance_) {
+            FullRetest(planes, boxes, count);
+        }
+        else {
+            int boundaryCount = 0;
+            for (int idx : boundary_) {
+                if (idx < count && inBoundary_[idx]) {
+                    boundary_[boundaryCount++] = idx;
+                    if (!dirty[idx] && idx < previousCount) {
+                        retest_.push_back(idx);
+                    }
+                }
+            }
+            boundary_.resize(boundaryCount);
+
+            ClassifyList(planes, boxes, retest_, true, false);
+            stats_.tested = (int)retest_.size();
+        }
+    }
+    stats_.skipped = count - stats_.tested;
+    stats_.boundary = (int)boundary_.size();
+
+    int visibleCount = 0;
+    for (int i = 0; i < count; i++) {
+        visibleIndices[visibleCount] = i;
+        visibleCount += visible_[i];
+    }
+    return visibleCount;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "MathCommon.h"
+#include "Frustum.h"
+#include <vector>
+
+struct TemporalCullingStats {
+    int tested;      // instances tested this frame
+    int skipped;     // instances that kept the result of a previous frame
+    int boundary;    // instances near the planes of the reference frustum
+    bool fullRetest; // the frustum moved beyond the tolerance, or the results were invalid
+};
+
+// Keeps the frustum test result of every instance between frames. The planes of the last full re-test are the reference:
+// an instance is stable if its box is farther than the tolerance from one of them outside or from all of them inside,
+// otherwise it is in the boundary set. While the planes move less than the tolerance over the extent of the boxes,
+// only instances with changed bounds and the boundary set are tested again, with the same test as Frustum::CheckRectangles
+class TemporalCuller {
+public:
+    TemporalCuller(float tolerance);
+
+    // dirty[i] != 0 if the bounds of instance i changed since the previous call, instances added since then are tested anyway.
+    // Writes the visible indices in ascending order and returns their number
+    int Cull(Frustum& frustum, const BoxStreams& boxes, const char* dirty, int count, int* visibleIndices);
+    void Invalidate() { valid_ = false; };
+    void SetTolerance(float tolerance);
+    float GetTolerance() const { return tolerance_; };
+    const TemporalCullingStats& GetStats() const { return stats_; };
+
+    ~TemporalCuller() = default;
+private:
+    // Bit k of visible and stable is set for box k of the four, extentSq gets the farthest squared corner distance
+    void Classify4(const XMFLOAT4* planes, const float* minX, const float* minY, const float* minZ,
+        const float* maxX, const float* maxY, const float* maxZ, UINT& visible, UINT& stable, XMVECTOR& extentSq) const;
+    // Same for a list of indices, results are written per index
+    void ClassifyList(const XMFLOAT4* planes, const BoxStreams& boxes, const std::vector<int>& indices,
+        bool updateVisible, bool updateBoundary);
+    float PlaneDrift(const XMFLOAT4* planes) const;
+    void FullRetest(const XMFLOAT4* planes, const BoxStreams& boxes, int count);
+
+    float tolerance_;
+    bool valid_ = false;
+    XMFLOAT4 reference_[6];
+    float extent_ = 0.0f;
+    std::vector<char> visible_;
+    std::vector<char> inBoundary_;
+    std::vector<int> boundary_;
+    std::vector<int> retest_;
+    TemporalCullingStats stats_ = {};
+};
@@ -0,0 +1,155 @@
+#include "UploadRing.h"
+#include <cstring>
+
+UploadRing::UploadRing(RenderDevice* pDevice) :
+    pDevice_(pDevice) {
+}
+
+// Makes the staging buffer of the slot at least size bytes, a new buffer is never in use by the GPU
+HRESULT UploadRing::Reserve(UINT slot, UINT size) {
+    if (stagingSize_[slot] >= size) {
+        return S_OK;
+    }
+
+    UINT newSize = stagingSize_[slot] > 4096 ? stagingSize_[slot] : 4096;
+    while (newSize < size) {
+        newSize *= 2;
+    }
+    // Copies already issued keep the old buffer alive until the GPU is done with it
+    if (pStaging_[slot] != NULL) {
+        pStaging_[slot]->Release();
+        pStaging_[slot] = NULL;
+    }
+    stagingSize_[slot] = 0;
+
+    GpuBufferDesc desc = {};
+    desc.byteWidth = newSize;
+    desc.usage = GpuUsage::Staging;
+    desc.bindFlags = 0;
+    desc.cpuAccessFlags = GpuCpuAccess::Write;
+    desc.miscFlags = 0;
+    desc.structureByteStride = 0;
+
+    HRESULT result = pDevice_->CreateBuffer(desc, nullptr, &pStaging_[slot]);
+    if (FAILED(result)) {
+        return result;
+    }
+    stagingSize_[slot] = newSize;
+    return S_OK;
+}
+
+HRESULT UploadRing::Begin(CommandContext* pContext, UINT size) {
+    pContext_ = pContext;
+    copies_.clear();
+    frameCopies_ = 0;
+    frameBytes_ = 0;
+    offset_ = 0;
+    size_ = 0;
+    writeResult_ = S_OK;
+    pMapped_ = NULL;
+    if (size == 0) {
+        return S_OK;
+    }
+
+    // The oldest buffer is the most likely to be idle, a busy one is skipped rather than waited for
+    GpuMappedSubresource subresource;
+    HRESULT result = GPU_E_WAS_STILL_DRAWING;
+    for (UINT i = 1; i <= frameCount && result == GPU_E_WAS_STILL_DRAWING; i++) {
+        UINT slot = (current_ + i) % frameCount;
+        result = Reserve(slot, size);
+        if (FAILED(result)) {
+            return result;
+        }
+        result = pContext_->Map(pStaging_[slot], 0, GpuMap::Write, GpuMapFlag::DoNotWait, &subresource);
+        if (result != GPU_E_WAS_STILL_DRAWING) {
+            current_ = slot;
+        }
+    }
+    if (result == GPU_E_WAS_STILL_DRAWING) {
+        waits_++;
+        current_ = (current_ + 1) % frameCount;
+        result = pContext_->Map(pStaging_[current_], 0, GpuMap::Write, 0, &subresource);
+    }
+    if (FAILED(result)) {
+        return result;
+    }
+    pMapped_ = reinterpret_cast<BYTE*>(subresource.pData);
+    size_ = stagingSize_[current_];
+    return S_OK;
+}
+
+// Sends out what the frame wrote so far and maps a buffer with room for at least size more bytes
+HRESULT UploadRing::Grow(UINT size) {
+    growths_++;
+    pContext_->Unmap(pStaging_[current_], 0);
+    pMapped_ = NULL;
+    IssueCopies();
+
+    UINT64 needed = (UINT64)stagingSize_[current_] * 2;
+    HRESULT result = Reserve(current_, (UINT)(needed > size ? needed : size));
+    if (FAILED(result)) {
+        return result;
+    }
+    GpuMappedSubresource subresource;
+    result = pContext_->Map(pStaging_[current_], 0, GpuMap::Write, 0, &subresource);
+    if (FAILED(result)) {
+        return result;
+    }
+    pMapped_ = reinterpret_cast<BYTE*>(subresource.pData);
+    offset_ = 0;
+    size_ = stagingSize_[current_];
+    return S_OK;
+}
+
+void UploadRing::Write(GpuBuffer* pDst, UINT dstOffset, const void* pData, UINT size) {
+    if (size == 0 || FAILED(writeResult_)) {
+        return;
+    }
+    if (pMapped_ == NULL || offset_ + size > size_) {
+        writeResult_ = pContext_ == NULL ? E_FAIL : pMapped_ == NULL ? Begin(pContext_, size) : Grow(size);
+        if (FAILED(writeResult_)) {
+            return;
+        }
+    }
+    memcpy(pMapped_ + offset_, pData, size);
+    frameBytes_ += size;
+
+    // Neighbouring writes into the same buffer go out as one copy
+    if (!copies_.empty()) {
+        Copy& last = copies_.back();
+        if (last.pDst == pDst && last.dstOffset + last.size == dstOffset && last.srcOffset + last.size == offset_) {
+            last.size += size;
+            offset_ += size;
+            return;
+        }
+    }
+    copies_.push_back({ pDst, dstOffset, offset_, size });
+    offset_ += size;
+}
+
+void UploadRing::IssueCopies() {
+    for (const Copy& copy : copies_) {
+        GpuBox box = { copy.srcOffset, 0, 0, copy.srcOffset + copy.size, 1, 1 };
+        pContext_->CopySubresourceRegion(copy.pDst, 0, copy.dstOffset, 0, 0, pStaging_[current_], 0, &box);
+    }
+    frameCopies_ += (UINT)copies_.size();
+    copies_.clear();
+}
+
+HRESULT UploadRing::End() {
+    if (pMapped_ != NULL) {
+        pContext_->Unmap(pStaging_[current_], 0);
+        pMapped_ = NULL;
+        IssueCopies();
+    }
+    totalBytes_ += frameBytes_;
+    return writeResult_;
+}
+
+UploadRing::~UploadRing() {
+    for (UINT i = 0; i < frameCount; i++) {
+        if (pStaging_[i] != NULL) {
+            pStaging_[i]->Release();
+        }
+    }
+}
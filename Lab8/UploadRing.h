@@ -0,0 +1,58 @@
+#pragma once
+
+#include "RenderDevice.h"
+#include <vector>
+
+// Ring of staging buffers, each frame's data is written into the next idle one and copied into
+// the destination buffers, so the CPU never waits for the copies of the previous frames
+class UploadRing {
+public:
+    static constexpr UINT frameCount = 3;
+
+    UploadRing(RenderDevice* pDevice);
+
+    // Maps a staging buffer with room for at least size bytes that no queued copy reads any more,
+    // waits only if the GPU still reads all of them. The frame's commands go to pContext
+    HRESULT Begin(CommandContext* pContext, UINT size);
+    // Copies size bytes of pData into the destination buffer at dstOffset. A write past the size given to Begin
+    // sends out the filled part and continues in a larger buffer
+    void Write(GpuBuffer* pDst, UINT dstOffset, const void* pData, UINT size);
+    // Unmaps the staging buffer and issues the queued copies, fails if a write of the frame could not be made
+    HRESULT End();
+
+    UINT64 GetFrameBytes() const { return frameBytes_; };
+    UINT64 GetTotalBytes() const { return totalBytes_; };
+    UINT GetFrameCopies() const { return frameCopies_; };
+    // Frames that found every staging buffer still in use, and writes that outgrew their frame's buffer
+    UINT64 GetWaits() const { return waits_; };
+    UINT64 GetGrowths() const { return growths_; };
+
+    ~UploadRing();
+private:
+    struct Copy {
+        GpuBuffer* pDst;
+        UINT dstOffset;
+        UINT srcOffset;
+        UINT size;
+    };
+
+    HRESULT Reserve(UINT slot, UINT size);
+    HRESULT Grow(UINT size);
+    void IssueCopies();
+
+    RenderDevice* pDevice_;
+    CommandContext* pContext_ = NULL;
+    GpuBuffer* pStaging_[frameCount] = { NULL, NULL, NULL };
+    UINT stagingSize_[frameCount] = { 0, 0, 0 };
+    UINT current_ = 0;
+    BYTE* pMapped_ = NULL;
+    UINT offset_ = 0;
+    UINT size_ = 0;
+    HRESULT writeResult_ = S_OK;
+    std::vector<Copy> copies_;
+    UINT frameCopies_ = 0;
+    UINT64 frameBytes_ = 0;
+    UINT64 totalBytes_ = 0;
+    UINT64 waits_ = 0;
+    UINT64 growths_ = 0;
+};
@@ -1,10 +1,17 @@
 #include "Buffers.h"
 
 struct VS_INPUT {
+#ifdef QUANTIZED_VERTICES
+    float4 position : POSITION;
+    float2 uv : TEXCOORD;
+    float2 normal : NORMAL;
+    float2 tangent : TANGENT;
+#else
     float3 position : POSITION;
     float2 uv : TEXCOORD;
     float3 normal : NORMAL;
     float3 tangent : TANGENT;
+#endif
     uint instanceId : SV_InstanceID;
 };
 
@@ -20,12 +27,25 @@ struct PS_INPUT  {
 PS_INPUT main(VS_INPUT input) {
     PS_INPUT output;
 
-    unsigned int idx = objectIDs[input.instanceId].x;
-    output.worldPos = mul(geomBuffer[idx].worldMatrix, float4(input.position, 1.0f));
+#ifdef QUANTIZED_VERTICES
+    float3 position = input.position.xyz * positionScale.xyz + positionBias.xyz;
+    float3 normal = DecodeOctahedral(input.normal);
+    float3 tangent = DecodeOctahedral(input.tangent);
+#else
+    float3 position = input.position;
+    float3 normal = input.normal;
+    float3 tangent = input.tangent;
+#endif
+
+    unsigned int idx = objectIDs[drawParams.x + input.instanceId];
+    float4 posScale = geomBuffer[idx].posScale;
+    float4 rotation = UnpackQuaternion(geomBuffer[idx].rotation);
+    output.worldPos = float4(RotateVector(rotation, position * posScale.w) + posScale.xyz, 1.0f);
     output.position = mul(viewProjectionMatrix, output.worldPos);
     output.uv = input.uv;
-    output.normal = mul(geomBuffer[idx].norm, float4(input.normal, 0.0f)).xyz;
-    output.tangent = mul(geomBuffer[idx].norm, float4(input.tangent, 0.0f)).xyz;
+    // Uniform scale keeps the normal matrix a pure rotation
+    output.normal = RotateVector(rotation, normal);
+    output.tangent = RotateVector(rotation, tangent);
     output.instanceId = idx;
 
     return output;
@@ -0,0 +1,117 @@
+#include "VertexFormat.h"
+#include <DirectXPackedVector.h>
+#include <cfloat>
+
+using namespace DirectX::PackedVector;
+
+namespace {
+    float SignNotZero(float value) {
+        return value >= 0.0f ? 1.0f : -1.0f;
+    }
+
+    SHORT ToSnorm16(float value) {
+        value = value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+        return (SHORT)(value * 32767.0f + (value >= 0.0f ? 0.5f : -0.5f));
+    }
+
+    float FromSnorm16(SHORT value) {
+        float result = value / 32767.0f;
+        return result < -1.0f ? -1.0f : result;
+    }
+
+    USHORT ToUnorm16(float value) {
+        value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+        return (USHORT)(value * 65535.0f + 0.5f);
+    }
+}
+
+XMFLOAT2 EncodeOctahedral(const XMFLOAT3& n) {
+    float sum = fabsf(n.x) + fabsf(n.y) + fabsf(n.z);
+    if (sum == 0.0f) {
+        return XMFLOAT2(0.0f, 0.0f);
+    }
+    float x = n.x / sum;
+    float y = n.y / sum;
+    // The lower hemisphere is folded over the diagonals of the square
+    if (n.z < 0.0f) {
+        float foldedX = (1.0f - fabsf(y)) * SignNotZero(x);
+        float foldedY = (1.0f - fabsf(x)) * SignNotZero(y);
+        x = foldedX;
+        y = foldedY;
+    }
+    return XMFLOAT2(x, y);
+}
+
+XMFLOAT3 DecodeOctahedral(const XMFLOAT2& e) {
+    XMFLOAT3 n(e.x, e.y, 1.0f - fabsf(e.x) - fabsf(e.y));
+    if (n.z < 0.0f) {
+        float x = n.x;
+        n.x = (1.0f - fabsf(n.y)) * SignNotZero(x);
+        n.y = (1.0f - fabsf(x)) * SignNotZero(n.y);
+    }
+    XMStoreFloat3(&n, XMVector3Normalize(XMLoadFloat3(&n)));
+    return n;
+}
+
+MeshQuantization ComputeQuantization(const Vertex* pVertices, size_t count) {
+    MeshQuantization quantization = { XMFLOAT4(1.0f, 1.0f, 1.0f, 0.0f), XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f) };
+    if (count == 0) {
+        return quantization;
+    }
+    XMVECTOR bbMin = XMLoadFloat3(&pVertices[0].pos);
+    XMVECTOR bbMax = bbMin;
+    for (size_t i = 1; i < count; i++) {
+        XMVECTOR pos = XMLoadFloat3(&pVertices[i].pos);
+        bbMin = XMVectorMin(bbMin, pos);
+        bbMax = XMVectorMax(bbMax, pos);
+    }
+    // Flat axes keep a unit scale so that decoding never divides by zero
+    XMVECTOR size = XMVectorSubtract(bbMax, bbMin);
+    size = XMVectorSelect(size, XMVectorReplicate(1.0f), XMVectorEqual(size, XMVectorZero()));
+    XMStoreFloat4(&quantization.scale, XMVectorSetW(size, 0.0f));
+    XMStoreFloat4(&quantization.bias, XMVectorSetW(bbMin, 0.0f));
+    return quantization;
+}
+
+XMFLOAT3 PositionPackError(const MeshQuantization& quantization) {
+    float halfStep = 0.5f / 65535.0f;
+    XMFLOAT3 error;
+    error.x = quantization.scale.x * halfStep + (quantization.scale.x + fabsf(quantization.bias.x)) * FLT_EPSILON;
+    error.y = quantization.scale.y * halfStep + (quantization.scale.y + fabsf(quantization.bias.y)) * FLT_EPSILON;
+    error.z = quantization.scale.z * halfStep + (quantization.scale.z + fabsf(quantization.bias.z)) * FLT_EPSILON;
+    return error;
+}
+
+void PackVertex(const Vertex& vertex, const MeshQuantization& quantization, PackedVertex& packed) {
+    packed.pos[0] = ToUnorm16((vertex.pos.x - quantization.bias.x) / quantization.scale.x);
+    packed.pos[1] = ToUnorm16((vertex.pos.y - quantization.bias.y) / quantization.scale.y);
+    packed.pos[2] = ToUnorm16((vertex.pos.z - quantization.bias.z) / quantization.scale.z);
+    packed.pos[3] = 0;
+    packed.uv[0] = XMConvertFloatToHalf(vertex.uv.x);
+    packed.uv[1] = XMConvertFloatToHalf(vertex.uv.y);
+
+    XMFLOAT2 normal = EncodeOctahedral(vertex.normal);
+    packed.normal[0] = ToSnorm16(normal.x);
+    packed.normal[1] = ToSnorm16(normal.y);
+    XMFLOAT2 tangent = EncodeOctahedral(vertex.tangent);
+    packed.tangent[0] = ToSnorm16(tangent.x);
+    packed.tangent[1] = ToSnorm16(tangent.y);
+}
+
+void UnpackVertex(const PackedVertex& packed, const MeshQuantization& quantization, Vertex& vertex) {
+    vertex.pos.x = packed.pos[0] / 65535.0f * quantization.scale.x + quantization.bias.x;
+    vertex.pos.y = packed.pos[1] / 65535.0f * quantization.scale.y + quantization.bias.y;
+    vertex.pos.z = packed.pos[2] / 65535.0f * quantization.scale.z + quantization.bias.z;
+    vertex.uv.x = XMConvertHalfToFloat(packed.uv[0]);
+    vertex.uv.y = XMConvertHalfToFloat(packed.uv[1]);
+    vertex.normal = DecodeOctahedral(XMFLOAT2(FromSnorm16(packed.normal[0]), FromSnorm16(packed.normal[1])));
+    vertex.tangent = DecodeOctahedral(XMFLOAT2(FromSnorm16(packed.tangent[0]), FromSnorm16(packed.tangent[1])));
+}
+
+MeshQuantization PackVertices(const Vertex* pVertices, size_t count, PackedVertex* pPacked) {
+    MeshQuantization quantization = ComputeQuantization(pVertices, count);
+    for (size_t i = 0; i < count; i++) {
+        PackVertex(pVertices[i], quantization, pPacked[i]);
+    }
+    return quantization;
+}
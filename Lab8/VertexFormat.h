@@ -0,0 +1,40 @@
+#pragma once
+
+#include "MathCommon.h"
+
+struct Vertex {
+    XMFLOAT3 pos;
+    XMFLOAT2 uv;
+    XMFLOAT3 normal;
+    XMFLOAT3 tangent;
+};
+
+// 20 bytes instead of 44: unorm16 position over the mesh bounds, half uv, octahedral snorm16 normal and tangent
+struct PackedVertex {
+    USHORT pos[4];
+    USHORT uv[2];
+    SHORT normal[2];
+    SHORT tangent[2];
+};
+
+// Position of a packed vertex is pos / 65535 * scale + bias
+struct MeshQuantization {
+    XMFLOAT4 scale;
+    XMFLOAT4 bias;
+};
+
+// Largest component error of a decoded octahedral snorm16 unit vector
+constexpr float octahedralPackError = 1.0f / 8192.0f;
+// Half uv keeps 11 significant bits, so uv in [0, 1] is off by at most 2^-12
+
+XMFLOAT2 EncodeOctahedral(const XMFLOAT3& n);
+XMFLOAT3 DecodeOctahedral(const XMFLOAT2& e);
+
+MeshQuantization ComputeQuantization(const Vertex* pVertices, size_t count);
+// Largest position error per axis for the quantization: half a unorm16 step plus float rounding
+XMFLOAT3 PositionPackError(const MeshQuantization& quantization);
+
+void PackVertex(const Vertex& vertex, const MeshQuantization& quantization, PackedVertex& packed);
+void UnpackVertex(const PackedVertex& packed, const MeshQuantization& quantization, Vertex& vertex);
+// Converts an existing mesh, pPacked must hold count vertices
+MeshQuantization PackVertices(const Vertex* pVertices, size_t count, PackedVertex* pPacked);
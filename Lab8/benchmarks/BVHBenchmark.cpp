@@ -0,0 +1,69 @@
+#include "BenchmarkCommon.h"
+#include "BVH.h"
+#include "Macros.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// BVH build, refit and cull against the linear batch test. The boxes lie on a ground that grows with their number
+// and the camera looks down on it from above, so it sees about as many boxes at every size and the rest is off-screen
+int main(int argc, char** argv) {
+    bool quick = QuickRun(argc, argv);
+    const int counts[] = { 10000, 100000, 1000000 };
+    int frames = quick ? 10 : 60;
+    int failures = 0;
+
+    printf("%9s %10s %10s %10s %12s %9s\n", "boxes", "build ms", "refit ms", "cull ms", "linear ms", "visible");
+    for (int count : counts) {
+        if (quick && count > 10000) {
+            break;
+        }
+        std::mt19937 random(count);
+        float radius = 100.0f * sqrtf(count / 10000.0f);
+        std::uniform_real_distribution<float> ground(-radius, radius), height(0.0f, 2.0f);
+        std::vector<XMFLOAT4> bbMin(count), bbMax(count);
+        BoxStreams boxes;
+        boxes.Resize(count);
+        for (int i = 0; i < count; i++) {
+            XMFLOAT3 center(ground(random), height(random), ground(random));
+            bbMin[i] = XMFLOAT4(center.x - 0.5f, center.y - 0.5f, center.z - 0.5f, 1.0f);
+            bbMax[i] = XMFLOAT4(center.x + 0.5f, center.y + 0.5f, center.z + 0.5f, 1.0f);
+            boxes.Set(i, bbMin[i], bbMax[i]);
+        }
+        std::vector<TestCameraPoint> path = RandomCameraPath(random, frames, 50.0f);
+        XMFLOAT3 down;
+        XMStoreFloat3(&down, XMVector3Normalize(XMVectorSet(0.0f, -1.0f, 0.3f, 0.0f)));
+        for (TestCameraPoint& point : path) {
+            point.eye.y = 30.0f;
+            point.dir = down;
+        }
+
+        BVH bvh;
+        double buildTime = MeasureBest(quick ? 1 : 3, [&]() { bvh.Build(boxes, count); });
+        double refitTime = MeasureBest(quick ? 1 : 5, [&]() { bvh.Refit(boxes); });
+
+        std::vector<int> visible(count), linearVisible(count);
+        double cullTime = 0.0, linearTime = 0.0;
+        long long visibleTotal = 0;
+        for (const TestCameraPoint& point : path) {
+            Frustum frustum(SCREEN_NEAR);
+            frustum.ConstructFrustum(TestViewMatrix(point.eye, point.dir), Camera::GetProjectionMatrix(16.0f / 9.0f));
+            int visibleCount = 0, linearCount = 0;
+            cullTime += MeasureBest(1, [&]() { visibleCount = bvh.Cull(frustum, boxes, visible.data()); });
+            linearTime += MeasureBest(1, [&]() { linearCount = frustum.CheckRectangles(boxes, 0, count, linearVisible.data()); });
+            visibleTotal += visibleCount;
+
+            std::sort(visible.begin(), visible.begin() + visibleCount);
+            if (visibleCount != linearCount || !std::equal(visible.begin(), visible.begin() + visibleCount, linearVisible.begin())) {
+                failures++;
+            }
+        }
+
+        printf("%9d %10.2f %10.3f %10.4f %12.4f %9lld\n", count, buildTime, refitTime, cullTime / frames,
+            linearTime / frames, visibleTotal / frames);
+    }
+    if (failures) {
+        printf("%d frames where the BVH and the linear test disagree\n", failures);
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "TestScenes.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+// Benchmarks print their timings and fail only if the measured variants disagree.
+// With --quick they run on small inputs, that is how ctest runs them
+inline bool QuickRun(int argc, char** argv) {
+    return argc > 1 && strcmp(argv[1], "--quick") == 0;
+}
+
+class BenchmarkTimer {
+public:
+    BenchmarkTimer(): start_(std::chrono::high_resolution_clock::now()) {}
+
+    double Milliseconds() const {
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start_).count();
+    };
+private:
+    std::chrono::high_resolution_clock::time_point start_;
+};
+
+// Best time of several runs of f in milliseconds
+template <typename F>
+double MeasureBest(int runs, F f) {
+    double best = 1e30;
+    for (int i = 0; i < runs; i++) {
+        BenchmarkTimer timer;
+        f();
+        best = min(best, timer.Milliseconds());
+    }
+    return best;
+}
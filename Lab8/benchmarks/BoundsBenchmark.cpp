@@ -0,0 +1,58 @@
+#include "BenchmarkCommon.h"
+#include "Bounds.h"
+#include <cstring>
+#include <vector>
+
+// World bounds of the instances from their 8 transformed corners against Arvo's method, one by one and as a stream
+int main(int argc, char** argv) {
+    bool quick = QuickRun(argc, argv);
+    const int counts[] = { 10000, 100000, 1000000 };
+    int runs = quick ? 1 : 10;
+    int failures = 0;
+
+    const XMFLOAT4 localMin(-0.5f, -0.5f, -0.5f, 1.0f), localMax(0.5f, 0.5f, 0.5f, 1.0f);
+    printf("%10s %12s %12s %12s\n", "instances", "corners ms", "arvo ms", "stream ms");
+    for (int count : counts) {
+        if (quick && count > 10000) {
+            break;
+        }
+        std::mt19937 random(count);
+        std::vector<XMMATRIX> world(count);
+        for (XMMATRIX& matrix : world) {
+            matrix = RandomWorldMatrix(random, 100.0f);
+        }
+
+        std::vector<XMFLOAT4> cornerMin(count), cornerMax(count), arvoMin(count), arvoMax(count), streamMin(count), streamMax(count);
+        BoxStreams streams;
+        streams.Resize(count);
+        double cornersTime = MeasureBest(runs, [&]() {
+            for (int i = 0; i < count; i++) {
+                CornerAABB(localMin, localMax, world[i], cornerMin[i], cornerMax[i]);
+            }
+        });
+        double arvoTime = MeasureBest(runs, [&]() {
+            XMVECTOR lMin = XMLoadFloat4(&localMin), lMax = XMLoadFloat4(&localMax);
+            for (int i = 0; i < count; i++) {
+                XMVECTOR bbMin, bbMax;
+                TransformAABB(lMin, lMax, world[i], bbMin, bbMax);
+                XMStoreFloat4(&arvoMin[i], bbMin);
+                XMStoreFloat4(&arvoMax[i], bbMax);
+            }
+        });
+        double streamTime = MeasureBest(runs, [&]() {
+            TransformAABBStream(localMin, localMax, world.data(), sizeof(XMMATRIX), 0, count, streamMin.data(), streamMax.data(), streams);
+        });
+
+        printf("%10d %12.3f %12.3f %12.3f\n", count, cornersTime, arvoTime, streamTime);
+        for (int i = 0; i < count; i++) {
+            if (memcmp(&cornerMin[i], &arvoMin[i], 3 * sizeof(float)) || memcmp(&cornerMax[i], &arvoMax[i], 3 * sizeof(float)) ||
+                memcmp(&cornerMin[i], &streamMin[i], 3 * sizeof(float)) || memcmp(&cornerMax[i], &streamMax[i], 3 * sizeof(float))) {
+                failures++;
+            }
+        }
+    }
+    if (failures) {
+        printf("%d boxes differ from the corner bounds\n", failures);
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,83 @@
+#include "BenchmarkCommon.h"
+#include "CullingEmulator.h"
+#include "Frustum.h"
+#include "Macros.h"
+#include <vector>
+
+// The emulated FCS.hlsl dispatch against Frustum::CheckRectangles over millions of random boxes and cameras,
+// a validation run for the GPU path that also shows what the emulation costs
+int main(int argc, char** argv) {
+    bool quick = QuickRun(argc, argv);
+    const int counts[] = { 10000, 100000, 1000000 };
+    int cameras = quick ? 2 : 10;
+    int failures = 0;
+
+    JobSystem jobSystem;
+    CullingEmulator emulator(&jobSystem);
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> position(-10.0f, 10.0f);
+    std::uniform_real_distribution<float> aspect(0.5f, 2.5f);
+
+    printf("%10s %8s %12s %12s %12s %12s\n", "boxes", "cameras", "emulator ms", "batch ms", "visible", "mismatches");
+    for (int count : counts) {
+        if (quick && count > 10000) {
+            break;
+        }
+        std::vector<XMFLOAT4> bbMin, bbMax;
+        BoxStreams boxes;
+        boxes.Resize(count);
+        UINT groupCount = (count + CullingEmulator::groupSize - 1) / CullingEmulator::groupSize;
+        std::vector<UINT> objectsIds(count), groupIds((size_t)groupCount * CullingEmulator::groupSize);
+        std::vector<XMUINT2> groupRanges(groupCount);
+        std::vector<int> visible(count);
+
+        double emulatorTime = 0.0, batchTime = 0.0;
+        UINT64 visibleCount = 0, mismatches = 0;
+        for (int camera = 0; camera < cameras; camera++) {
+            RandomBoxes(random, count, 20.0f, 3.0f, bbMin, bbMax);
+            for (int i = 0; i < count; i++) {
+                boxes.Set(i, bbMin[i], bbMax[i]);
+            }
+            Frustum frustum(SCREEN_NEAR);
+            frustum.ConstructFrustum(TestViewMatrix(XMFLOAT3(position(random), position(random), position(random)), RandomDirection(random)),
+                Camera::GetProjectionMatrix(aspect(random)));
+
+            UINT indirectArgs[5] = { 36, 0, 0, 0, 0 };
+            BenchmarkTimer emulatorTimer;
+            emulator.Dispatch(groupCount, XMINT4(count, 0, 0, 0), frustum.GetPlanes(), bbMin.data(), bbMax.data(),
+                indirectArgs, objectsIds.data(), groupIds.data(), groupRanges.data());
+            emulatorTime += emulatorTimer.Milliseconds();
+
+            BenchmarkTimer batchTimer;
+            int cpuCount = frustum.CheckRectangles(boxes, 0, count, visible.data());
+            batchTime += batchTimer.Milliseconds();
+
+            // Both lists are in index order, merge them to count the boxes only one side kept
+            UINT gpuCount = indirectArgs[1];
+            UINT g = 0;
+            int c = 0;
+            while (g < gpuCount || c < cpuCount) {
+                if (c == cpuCount || (g < gpuCount && objectsIds[g] < (UINT)visible[c])) {
+                    mismatches++;
+                    g++;
+                }
+                else if (g == gpuCount || (UINT)visible[c] < objectsIds[g]) {
+                    mismatches++;
+                    c++;
+                }
+                else {
+                    g++;
+                    c++;
+                }
+            }
+            visibleCount += cpuCount;
+        }
+
+        printf("%10d %8d %12.3f %12.3f %12llu %12llu\n", count, cameras, emulatorTime / cameras, batchTime / cameras,
+            (unsigned long long)(visibleCount / cameras), (unsigned long long)mismatches);
+        if (mismatches > 0) {
+            failures++;
+        }
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,65 @@
+#include "BenchmarkCommon.h"
+#include "Frustum.h"
+#include "Macros.h"
+#include <vector>
+
+// Per-box CheckRectangle against the batch tests over SoA boxes, the way UpdateScene culls the cubes
+int main(int argc, char** argv) {
+    bool quick = QuickRun(argc, argv);
+    const int counts[] = { 10000, 100000, 1000000 };
+    int runs = quick ? 1 : 10;
+    int failures = 0;
+
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    Frustum frustum(SCREEN_NEAR);
+    frustum.ConstructFrustum(TestViewMatrix(XMFLOAT3(0.0f, 0.0f, -100.0f), XMFLOAT3(0.0f, 0.0f, 1.0f)),
+        Camera::GetProjectionMatrix(16.0f / 9.0f));
+
+    printf("%10s %12s %12s %12s %10s\n", "boxes", "scalar ms", "batch ms", "mask ms", "visible");
+    for (int count : counts) {
+        if (quick && count > 10000) {
+            break;
+        }
+        std::vector<XMFLOAT4> bbMin(count), bbMax(count);
+        BoxStreams boxes;
+        boxes.Resize(count);
+        for (int i = 0; i < count; i++) {
+            XMFLOAT3 center(position(random), position(random), position(random));
+            bbMin[i] = XMFLOAT4(center.x - 0.5f, center.y - 0.5f, center.z - 0.5f, 1.0f);
+            bbMax[i] = XMFLOAT4(center.x + 0.5f, center.y + 0.5f, center.z + 0.5f, 1.0f);
+            boxes.Set(i, bbMin[i], bbMax[i]);
+        }
+
+        std::vector<int> visible(count);
+        std::vector<UINT> mask((count + 31) / 32);
+        int scalarCount = 0, batchCount = 0, maskCount = 0;
+        double scalarTime = MeasureBest(runs, [&]() {
+            scalarCount = 0;
+            for (int i = 0; i < count; i++) {
+                if (frustum.CheckRectangle(bbMin[i], bbMax[i])) {
+                    visible[scalarCount++] = i;
+                }
+            }
+        });
+        double batchTime = MeasureBest(runs, [&]() {
+            batchCount = frustum.CheckRectangles(boxes, 0, count, visible.data());
+        });
+        double maskTime = MeasureBest(runs, [&]() {
+            frustum.CheckRectanglesMask(boxes, 0, count, mask.data());
+        });
+        maskCount = 0;
+        for (UINT bits : mask) {
+            for (; bits; bits &= bits - 1) {
+                maskCount++;
+            }
+        }
+
+        printf("%10d %12.3f %12.3f %12.3f %10d\n", count, scalarTime, batchTime, maskTime, batchCount);
+        if (scalarCount != batchCount || scalarCount != maskCount) {
+            printf("mismatch: scalar %d, batch %d, mask %d\n", scalarCount, batchCount, maskCount);
+            failures++;
+        }
+    }
+    return failures ? 1 : 0;
+}
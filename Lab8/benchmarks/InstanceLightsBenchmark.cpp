@@ -0,0 +1,83 @@
+#include "BenchmarkCommon.h"
+#include "InstanceLights.h"
+#include "LightClusters.h"
+#include <algorithm>
+#include <vector>
+
+// InstanceLights::Build against testing every light sphere on every instance box, over random lights and spinning
+// unit cubes at the density of the scene. Fails if a list differs from the brute force one
+int main(int argc, char** argv) {
+    bool quick = QuickRun(argc, argv);
+    const int sizes[][2] = { { 100, 10000 }, { 1000, 10000 }, { 1000, 100000 }, { 4096, 100000 } };
+    int runs = quick ? 1 : 5;
+    int failures = 0;
+
+    printf("%8s %10s %10s %14s %12s\n", "lights", "instances", "build ms", "brute force ms", "pairs");
+    for (const auto& size : sizes) {
+        int lightCount = size[0], instanceCount = size[1];
+        if (quick && instanceCount > 10000) {
+            break;
+        }
+        std::mt19937 random(1);
+        float worldSize = 6.0f * cbrtf(instanceCount / 1000.0f);
+        std::uniform_real_distribution<float> position(-worldSize, worldSize);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+        BoxStreams bounds;
+        bounds.Resize(instanceCount);
+        for (int i = 0; i < instanceCount; i++) {
+            XMFLOAT3 center(position(random), position(random), position(random));
+            // Bounds of a unit cube spinning around y
+            bounds.Set(i, XMFLOAT4(center.x - 1.42f, center.y - 1.0f, center.z - 1.42f, 1.0f),
+                XMFLOAT4(center.x + 1.42f, center.y + 1.0f, center.z + 1.42f, 1.0f));
+        }
+        std::vector<Light> lights(lightCount);
+        for (Light& light : lights) {
+            // Dim lights, ranges between 1.6 and 8
+            light.color = XMFLOAT4(max(unit(random) * 0.25f, 0.01f), unit(random) * 0.25f, unit(random) * 0.25f, 1.0f);
+            light.pos = XMFLOAT4(position(random), position(random), position(random), LightClusters::LightRange(light.color));
+        }
+
+        InstanceLights instanceLights(4.0f);
+        double buildTime = MeasureBest(runs, [&]() {
+            instanceLights.Build(lights.data(), lightCount, bounds, instanceCount);
+        });
+
+        std::vector<XMUINT2> ranges(instanceCount);
+        std::vector<UINT> indices;
+        double bruteForceTime = MeasureBest(1, [&]() {
+            indices.clear();
+            for (int i = 0; i < instanceCount; i++) {
+                UINT offset = (UINT)indices.size();
+                for (int j = 0; j < lightCount; j++) {
+                    const XMFLOAT4& sphere = lights[j].pos;
+                    float dx = max(max(bounds.minX[i] - sphere.x, sphere.x - bounds.maxX[i]), 0.0f);
+                    float dy = max(max(bounds.minY[i] - sphere.y, sphere.y - bounds.maxY[i]), 0.0f);
+                    float dz = max(max(bounds.minZ[i] - sphere.z, sphere.z - bounds.maxZ[i]), 0.0f);
+                    if (dx * dx + dy * dy + dz * dz <= sphere.w * sphere.w) {
+                        indices.push_back((UINT)j);
+                    }
+                }
+                ranges[i] = XMUINT2(offset, (UINT)indices.size() - offset);
+            }
+        });
+
+        int mismatches = 0;
+        std::vector<UINT> list;
+        for (int i = 0; i < instanceCount; i++) {
+            XMUINT2 range = instanceLights.GetRanges()[i];
+            list.assign(instanceLights.GetLightIndices().begin() + range.x, instanceLights.GetLightIndices().begin() + range.x + range.y);
+            std::sort(list.begin(), list.end());
+            if (range.y != ranges[i].y || !std::equal(list.begin(), list.end(), indices.begin() + ranges[i].x)) {
+                mismatches++;
+            }
+        }
+
+        printf("%8d %10d %10.3f %14.3f %12zu\n", lightCount, instanceCount, buildTime, bruteForceTime, instanceLights.GetLightIndices().size());
+        if (mismatches > 0) {
+            printf("mismatch: %d instances with a different list\n", mismatches);
+            failures++;
+        }
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,75 @@
+#include "BenchmarkCommon.h"
+#include "InstanceStore.h"
+#include "Macros.h"
+#include <vector>
+
+// One frame of the instance store passes on one thread: transforms, bounds and frustum culling, then the transforms
+// alone per instance and batched, which have to agree up to rounding
+int main(int argc, char** argv) {
+    bool quick = QuickRun(argc, argv);
+    const int counts[] = { 10000, 100000, 1000000 };
+    int runs = quick ? 1 : 5;
+    int failures = 0;
+
+    const XMFLOAT4 localMin(-1.0f, -1.0f, -1.0f, 1.0f), localMax(1.0f, 1.0f, 1.0f, 1.0f);
+    Frustum frustum(SCREEN_NEAR);
+    frustum.ConstructFrustum(TestViewMatrix(XMFLOAT3(0.0f, 0.0f, -10.0f), XMFLOAT3(0.0f, 0.0f, 1.0f)),
+        Camera::GetProjectionMatrix(16.0f / 9.0f));
+
+    printf("%10s %12s %12s %12s %12s %10s\n", "instances", "frame ms", "scalar ms", "batched ms", "max error", "visible");
+    for (int count : counts) {
+        if (quick && count > 10000) {
+            break;
+        }
+        // Same spread and spin speeds as the cubes of the scene, at the same density
+        std::mt19937 random(1);
+        float worldSize = 6.0f * cbrtf(count / 1000.0f);
+        std::uniform_real_distribution<float> position(-worldSize, worldSize);
+        InstanceStore store;
+        for (int i = 0; i < count; i++) {
+            store.Add({ XMFLOAT3(position(random), position(random), position(random)), (float)(random() % 5), 5.0f,
+                (UINT)(random() % 2), false });
+        }
+
+        std::vector<int> visible(count);
+        int visibleCount = 0;
+        int frame = 0;
+        double frameTime = MeasureBest(runs, [&]() {
+            store.UpdateTransforms(frame++ * 0.016f, 0, count);
+            store.UpdateBounds(localMin, localMax, 0, count);
+            visibleCount = frustum.CheckRectangles(store.GetBounds(), 0, count, visible.data());
+            // Static instances are clean after their first upload
+            store.ClearDirty(0, count);
+        });
+
+        std::vector<XMMATRIX> scalarWorld(count);
+        store.SetBatchedTransforms(false);
+        double scalarTime = MeasureBest(runs, [&]() {
+            store.MarkAllDirty();
+            store.UpdateTransforms(1.0f, 0, count);
+        });
+        std::copy(store.GetWorld(), store.GetWorld() + count, scalarWorld.begin());
+        store.SetBatchedTransforms(true);
+        double batchedTime = MeasureBest(runs, [&]() {
+            store.MarkAllDirty();
+            store.UpdateTransforms(1.0f, 0, count);
+        });
+
+        XMVECTOR maxError = XMVectorZero();
+        for (int i = 0; i < count; i++) {
+            for (int r = 0; r < 4; r++) {
+                maxError = XMVectorMax(maxError, XMVectorAbs(XMVectorSubtract(scalarWorld[i].r[r], store.GetWorld()[i].r[r])));
+            }
+        }
+        XMFLOAT4 error;
+        XMStoreFloat4(&error, maxError);
+        float worldError = max(max(error.x, error.y), max(error.z, error.w));
+
+        printf("%10d %12.3f %12.3f %12.3f %12g %10d\n", count, frameTime, scalarTime, batchedTime, worldError, visibleCount);
+        if (worldError > 1e-5f) {
+            printf("mismatch: batched transforms differ from the scalar ones by %g\n", worldError);
+            failures++;
+        }
+    }
+    return failures ? 1 : 0;
+}
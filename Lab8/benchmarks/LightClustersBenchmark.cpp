@@ -0,0 +1,82 @@
+#include "BenchmarkCommon.h"
+#include "LightClusters.h"
+#include "Macros.h"
+#include <algorithm>
+#include <vector>
+
+// Binning time and the lights a pixel loops over with clusters against all lights, as PS.hlsl did before,
+// for up to MAX_LIGHT lights spread over the scene. Fails if a light that reaches a sampled point is not in its cluster
+int main(int argc, char** argv) {
+    bool quick = QuickRun(argc, argv);
+    const int counts[] = { 64, 256, 1024, 4096, MAX_LIGHT };
+    int runs = quick ? 1 : 20;
+    int samples = quick ? 1000 : 20000;
+    int failures = 0;
+
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    LightClusters clusters(CLUSTER_X, CLUSTER_Y, CLUSTER_Z);
+    XMMATRIX view = TestViewMatrix(XMFLOAT3(0.0f, 5.0f, -40.0f), XMFLOAT3(0.0f, -0.1f, 1.0f));
+    XMMATRIX inverseView = XMMatrixInverse(nullptr, view);
+    float aspect = 16.0f / 9.0f;
+    float tanHalfY = tanf(XM_PI / 6);
+    clusters.SetView(view, XM_PI / 3, aspect, SCREEN_NEAR, SCREEN_FAR);
+
+    printf("%8s %10s %14s %14s %14s\n", "lights", "build ms", "pairs", "lights/pixel", "all/pixel");
+    for (int count : counts) {
+        if (quick && count > 1024) {
+            break;
+        }
+        std::uniform_real_distribution<float> position(-40.0f, 40.0f);
+        std::uniform_real_distribution<float> brightness(0.0f, 0.1f);
+        std::vector<Light> lights(count);
+        for (Light& light : lights) {
+            light.color = XMFLOAT4(brightness(random), brightness(random), brightness(random), 1.0f);
+            light.pos = XMFLOAT4(position(random), position(random) * 0.25f, position(random), LightClusters::LightRange(light.color));
+        }
+
+        double buildTime = MeasureBest(runs, [&]() {
+            clusters.Build(lights.data(), count);
+        });
+
+        // Points on a ground plane seen by the camera stand in for the pixels of the scene
+        const std::vector<XMUINT2>& ranges = clusters.GetRanges();
+        const std::vector<UINT>& indices = clusters.GetLightIndices();
+        UINT64 clusterLights = 0;
+        int pixels = 0, missing = 0;
+        for (int s = 0; s < samples; s++) {
+            float u = unit(random), v = 0.5f + unit(random) * 0.5f;
+            XMVECTOR ray = XMVector3TransformNormal(XMVectorSet((u * 2.0f - 1.0f) * tanHalfY * aspect, (1.0f - v * 2.0f) * tanHalfY, 1.0f, 0.0f),
+                inverseView);
+            XMFLOAT3 dir;
+            XMStoreFloat3(&dir, ray);
+            if (dir.y >= -1e-4f) {
+                continue;
+            }
+            // View depth of the hit, the ray has a view z of 1
+            float depth = 5.0f / -dir.y;
+            int cluster = clusters.FindCluster(depth, u, v);
+            if (cluster < 0) {
+                continue;
+            }
+            XMFLOAT3 point(dir.x * depth, 0.0f, -40.0f + dir.z * depth);
+            const XMUINT2& range = ranges[cluster];
+            clusterLights += range.y;
+            pixels++;
+            for (int i = 0; i < count; i++) {
+                float dx = lights[i].pos.x - point.x, dy = lights[i].pos.y - point.y, dz = lights[i].pos.z - point.z;
+                if (dx * dx + dy * dy + dz * dz <= lights[i].pos.w * lights[i].pos.w &&
+                    !std::binary_search(indices.begin() + range.x, indices.begin() + range.x + range.y, (UINT)i)) {
+                    missing++;
+                }
+            }
+        }
+
+        printf("%8d %10.3f %14zu %14.2f %14d\n", count, buildTime, indices.size(), pixels ? (double)clusterLights / pixels : 0.0, count);
+        if (missing > 0) {
+            printf("%d lights missing from the cluster of their points\n", missing);
+            failures++;
+        }
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,122 @@
+#include "BenchmarkCommon.h"
+#include "LightManager.h"
+#include "Macros.h"
+#include <vector>
+
+// Index updates and queries of LightManager on random lights, a hundred of them in the volume of the scene cubes
+// with ranges between 1 and 4. Fails if the cluster sized box queries count other lights than testing every light
+int main(int argc, char** argv) {
+    bool quick = QuickRun(argc, argv);
+    const int counts[] = { 1000, 10000, MAX_LIGHT };
+    const int rounds = quick ? 2 : 10;
+    int failures = 0;
+
+    printf("%8s %10s %10s %10s %8s %10s %12s %14s\n", "lights", "insert ms", "move ms", "all ms", "runs", "frustum ms", "clusters ms",
+        "brute force ms");
+    for (int lightCount : counts) {
+        if (quick && lightCount > 1000) {
+            break;
+        }
+        float worldSize = 6.0f * cbrtf(lightCount / 100.0f);
+        std::mt19937 random(1);
+        std::uniform_real_distribution<float> position(-worldSize, worldSize);
+        std::uniform_real_distribution<float> step(-0.5f, 0.5f);
+        std::uniform_real_distribution<float> range(1.0f, 4.0f);
+
+        LightManager manager(worldSize);
+        std::vector<Light> lights(lightCount);
+        for (Light& light : lights) {
+            light.pos = XMFLOAT4(position(random), position(random), position(random), range(random));
+            light.color = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+        }
+        BenchmarkTimer insertTimer;
+        for (const Light& light : lights) {
+            manager.Add(light);
+        }
+        double insertTime = insertTimer.Milliseconds();
+        std::vector<XMUINT2> runs;
+        manager.TakeDirtyRuns(runs);
+
+        auto move = [&](int index) {
+            const Light& light = manager.Get(index);
+            manager.SetPosition(index, XMFLOAT3(light.pos.x + step(random), light.pos.y + step(random), light.pos.z + step(random)));
+        };
+        // A tenth of the lights take a step, then the dirty runs are taken as the renderer does every frame
+        int moveCount = max(lightCount / 10, 1);
+        std::vector<int> moved(moveCount);
+        double moveTime = 0.0;
+        for (int r = 0; r < rounds; r++) {
+            for (int& index : moved) {
+                index = (int)(random() % (UINT)lightCount);
+            }
+            BenchmarkTimer timer;
+            for (int index : moved) {
+                move(index);
+            }
+            runs.clear();
+            manager.TakeDirtyRuns(runs);
+            moveTime += timer.Milliseconds() / rounds;
+        }
+        size_t uploadRuns = runs.size();
+
+        double moveAllTime = MeasureBest(rounds, [&]() {
+            for (int i = 0; i < lightCount; i++) {
+                move(i);
+            }
+            runs.clear();
+            manager.TakeDirtyRuns(runs);
+        });
+
+        // The frustum of the renderer from the edge of the world
+        std::vector<int> ids(lightCount);
+        Frustum frustum(SCREEN_NEAR);
+        frustum.ConstructFrustum(TestViewMatrix(XMFLOAT3(0.0f, 0.0f, -worldSize), XMFLOAT3(0.0f, 0.0f, 1.0f)),
+            Camera::GetProjectionMatrix(16.0f / 9.0f));
+        double frustumTime = MeasureBest(rounds, [&]() {
+            manager.QueryFrustum(frustum, ids.data());
+        });
+
+        // Boxes of a CLUSTER_X x CLUSTER_Y x CLUSTER_Z grid over the whole world
+        XMFLOAT3 cellSize(2.0f * worldSize / CLUSTER_X, 2.0f * worldSize / CLUSTER_Y, 2.0f * worldSize / CLUSTER_Z);
+        auto cellBounds = [&](int cell, XMFLOAT4& bbMin, XMFLOAT4& bbMax) {
+            int x = cell % CLUSTER_X, y = cell / CLUSTER_X % CLUSTER_Y, z = cell / (CLUSTER_X * CLUSTER_Y);
+            bbMin = XMFLOAT4(-worldSize + x * cellSize.x, -worldSize + y * cellSize.y, -worldSize + z * cellSize.z, 1.0f);
+            bbMax = XMFLOAT4(bbMin.x + cellSize.x, bbMin.y + cellSize.y, bbMin.z + cellSize.z, 1.0f);
+        };
+        const int cells = CLUSTER_X * CLUSTER_Y * CLUSTER_Z;
+        std::vector<int> found(cells), expected(cells);
+        XMFLOAT4 bbMin, bbMax;
+        double clusterTime = MeasureBest(rounds, [&]() {
+            for (int cell = 0; cell < cells; cell++) {
+                cellBounds(cell, bbMin, bbMax);
+                found[cell] = manager.QueryBox(bbMin, bbMax, ids.data());
+            }
+        });
+        double bruteForceTime = MeasureBest(1, [&]() {
+            for (int cell = 0; cell < cells; cell++) {
+                cellBounds(cell, bbMin, bbMax);
+                int count = 0;
+                for (int i = 0; i < lightCount; i++) {
+                    const XMFLOAT4& pos = manager.Get(i).pos;
+                    float dx = max(max(bbMin.x - pos.x, pos.x - bbMax.x), 0.0f);
+                    float dy = max(max(bbMin.y - pos.y, pos.y - bbMax.y), 0.0f);
+                    float dz = max(max(bbMin.z - pos.z, pos.z - bbMax.z), 0.0f);
+                    count += dx * dx + dy * dy + dz * dz <= pos.w * pos.w;
+                }
+                expected[cell] = count;
+            }
+        });
+        int mismatches = 0;
+        for (int cell = 0; cell < cells; cell++) {
+            mismatches += found[cell] != expected[cell];
+        }
+
+        printf("%8d %10.3f %10.3f %10.3f %8zu %10.3f %12.3f %14.3f\n", lightCount, insertTime, moveTime, moveAllTime, uploadRuns,
+            frustumTime, clusterTime, bruteForceTime);
+        if (mismatches > 0) {
+            printf("mismatch: %d cells with a different light count\n", mismatches);
+            failures++;
+        }
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,86 @@
+#include "BenchmarkCommon.h"
+#include "Lighting.h"
+#include <vector>
+
+// CalculateColor per sample against CalculateColor8 per packet on one thread, opaque and transparent samples
+// under 1 to 256 random lights. Fails if a channel differs by more than 1e-5 relative to max(1, channel)
+int main(int argc, char** argv) {
+    bool quick = QuickRun(argc, argv);
+    const int lightCounts[] = { 1, 4, 16, 64, 256 };
+    int sampleCount = quick ? 8000 : 100000;
+    int runs = quick ? 1 : 5;
+    int failures = 0;
+
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> position(-6.0f, 6.0f);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    int packets = (sampleCount + ShadingSamples::count - 1) / ShadingSamples::count;
+    std::vector<ShadingSamples> samples(packets);
+    for (ShadingSamples& packet : samples) {
+        for (int j = 0; j < ShadingSamples::count; j++) {
+            XMFLOAT3 normal;
+            XMStoreFloat3(&normal, XMVector3Normalize(XMVectorSet(unit(random) - 0.5f, unit(random) - 0.5f, unit(random) - 0.5f, 0.0f)));
+            packet.posX[j] = position(random);
+            packet.posY[j] = position(random);
+            packet.posZ[j] = position(random);
+            packet.normalX[j] = normal.x;
+            packet.normalY[j] = normal.y;
+            packet.normalZ[j] = normal.z;
+            packet.colorR[j] = unit(random);
+            packet.colorG[j] = unit(random);
+            packet.colorB[j] = unit(random);
+            packet.shine[j] = (j & 1) ? 0.0f : 5.0f;
+        }
+    }
+    std::vector<XMFLOAT3> scalar((size_t)packets * ShadingSamples::count);
+    std::vector<ShadedColors> shaded(packets);
+
+    printf("%8s %8s %12s %12s %10s %12s\n", "lights", "samples", "scalar ms", "8-wide ms", "speedup", "max error");
+    for (int lightCount : lightCounts) {
+        if (quick && lightCount > 16) {
+            break;
+        }
+        std::vector<Light> lights(lightCount);
+        for (Light& light : lights) {
+            light.color = XMFLOAT4(unit(random), unit(random), unit(random), 1.0f);
+            light.pos = XMFLOAT4(position(random), position(random), position(random), 4.0f + unit(random) * 12.0f);
+        }
+        LightingParams params = { XMFLOAT3(0.0f, 2.0f, -12.0f), lightCount, false, lights.data() };
+
+        double scalarTime = 0.0, packetTime = 0.0;
+        float maxError = 0.0f;
+        for (int transparent = 0; transparent < 2; transparent++) {
+            scalarTime += MeasureBest(runs, [&]() {
+                for (int p = 0; p < packets; p++) {
+                    const ShadingSamples& packet = samples[p];
+                    for (int j = 0; j < ShadingSamples::count; j++) {
+                        scalar[(size_t)p * ShadingSamples::count + j] = CalculateColor(params,
+                            XMFLOAT3(packet.colorR[j], packet.colorG[j], packet.colorB[j]), XMFLOAT3(packet.normalX[j], packet.normalY[j], packet.normalZ[j]),
+                            XMFLOAT3(packet.posX[j], packet.posY[j], packet.posZ[j]), packet.shine[j], transparent != 0);
+                    }
+                }
+            });
+            packetTime += MeasureBest(runs, [&]() {
+                for (int p = 0; p < packets; p++) {
+                    CalculateColor8(params, samples[p], transparent != 0, shaded[p]);
+                }
+            });
+
+            for (int p = 0; p < packets; p++) {
+                for (int j = 0; j < ShadingSamples::count; j++) {
+                    const XMFLOAT3& expected = scalar[(size_t)p * ShadingSamples::count + j];
+                    maxError = max(maxError, fabsf(shaded[p].r[j] - expected.x) / max(1.0f, fabsf(expected.x)));
+                    maxError = max(maxError, fabsf(shaded[p].g[j] - expected.y) / max(1.0f, fabsf(expected.y)));
+                    maxError = max(maxError, fabsf(shaded[p].b[j] - expected.z) / max(1.0f, fabsf(expected.z)));
+                }
+            }
+        }
+
+        printf("%8d %8d %12.3f %12.3f %10.2f %12.2g\n", lightCount, packets * ShadingSamples::count, scalarTime, packetTime,
+            scalarTime / packetTime, maxError);
+        if (maxError > 1e-5f) {
+            failures++;
+        }
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,66 @@
+#include "BenchmarkCommon.h"
+#include "Frustum.h"
+#include "Macros.h"
+#include <algorithm>
+#include <vector>
+
+// One MultiViewFrustum pass against one Frustum::CheckRectangles pass per view over the same bounds.
+// Renderer::BuildCullingViews culls seven views, the main camera and the faces of a reflection probe
+int main(int argc, char** argv) {
+    bool quick = QuickRun(argc, argv);
+    const int counts[] = { 10000, 100000, 1000000 };
+    const int viewCounts[] = { 1, 2, 4, 7, 16, 32 };
+    int runs = quick ? 1 : 10;
+    int failures = 0;
+
+    std::mt19937 random(1);
+    printf("%10s %6s %14s %14s %10s\n", "boxes", "views", "multi-view ms", "sequential ms", "speedup");
+    for (int count : counts) {
+        if (quick && count > 10000) {
+            break;
+        }
+        std::vector<XMFLOAT4> bbMin, bbMax;
+        RandomBoxes(random, count, 100.0f, 2.0f, bbMin, bbMax);
+        BoxStreams boxes;
+        boxes.Resize(count);
+        for (int i = 0; i < count; i++) {
+            boxes.Set(i, bbMin[i], bbMax[i]);
+        }
+
+        std::vector<UINT> masks(count), sequentialMasks(count);
+        std::vector<int> visible(count);
+        for (int viewCount : viewCounts) {
+            std::vector<Frustum> frustums(viewCount, Frustum(SCREEN_NEAR));
+            MultiViewFrustum multiView;
+            for (int v = 0; v < viewCount; v++) {
+                frustums[v].ConstructFrustum(TestViewMatrix(XMFLOAT3(0.0f, 0.0f, 0.0f), RandomDirection(random)),
+                    Camera::GetProjectionMatrix(v == 0 ? 16.0f / 9.0f : 1.0f));
+                multiView.AddView(frustums[v].GetPlanes());
+            }
+
+            double multiViewTime = MeasureBest(runs, [&]() {
+                multiView.CheckRectangles(boxes, 0, count, masks.data());
+            });
+            double sequentialTime = MeasureBest(runs, [&]() {
+                std::fill(sequentialMasks.begin(), sequentialMasks.end(), 0u);
+                for (int v = 0; v < viewCount; v++) {
+                    int visibleCount = frustums[v].CheckRectangles(boxes, 0, count, visible.data());
+                    for (int i = 0; i < visibleCount; i++) {
+                        sequentialMasks[visible[i]] |= 1u << v;
+                    }
+                }
+            });
+
+            int mismatches = 0;
+            for (int i = 0; i < count; i++) {
+                mismatches += masks[i] != sequentialMasks[i];
+            }
+            printf("%10d %6d %14.3f %14.3f %10.2f\n", count, viewCount, multiViewTime, sequentialTime, sequentialTime / multiViewTime);
+            if (mismatches > 0) {
+                printf("mismatch: %d boxes with different view masks\n", mismatches);
+                failures++;
+            }
+        }
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,95 @@
+#include "BenchmarkCommon.h"
+#include "InstanceStore.h"
+#include "JobSystem.h"
+#include "Macros.h"
+#include <vector>
+
+// One frame of the instance update and frustum culling of UpdateScene: transforms, bounds and the batch test per
+// chunk, then the per-chunk visible lists compacted in order. One worker against all cores
+static const int chunkSize = 1024; // Renderer::cullingChunkSize
+
+struct CullingFrame {
+    std::vector<int> visible;
+    std::vector<int> chunkVisibleCounts;
+
+    void Resize(int count) {
+        visible.resize(count);
+        chunkVisibleCounts.assign((count + chunkSize - 1) / chunkSize, 0);
+    }
+};
+
+static int CullFrame(JobSystem& jobs, InstanceStore& store, Frustum& frustum, float t, CullingFrame& frame) {
+    int count = store.Size();
+    const XMFLOAT4 localMin(-1.0f, -1.0f, -1.0f, 1.0f), localMax(1.0f, 1.0f, 1.0f, 1.0f);
+    const BoxStreams& bounds = store.GetBounds();
+    jobs.ParallelFor(count, chunkSize, [&](int begin, int end, int) {
+        store.UpdateTransforms(t, begin, end - begin);
+        store.UpdateBounds(localMin, localMax, begin, end - begin);
+        frame.chunkVisibleCounts[begin / chunkSize] = frustum.CheckRectangles(bounds, begin, end - begin, &frame.visible[begin]);
+    });
+    // Static instances are clean after their first upload
+    store.ClearDirty(0, count);
+
+    int visibleCount = 0;
+    for (int c = 0; c < (int)frame.chunkVisibleCounts.size(); c++) {
+        int chunkBegin = c * chunkSize;
+        if (visibleCount != chunkBegin) {
+            std::copy(&frame.visible[chunkBegin], &frame.visible[chunkBegin] + frame.chunkVisibleCounts[c], &frame.visible[visibleCount]);
+        }
+        visibleCount += frame.chunkVisibleCounts[c];
+    }
+    return visibleCount;
+}
+
+int main(int argc, char** argv) {
+    bool quick = QuickRun(argc, argv);
+    const int counts[] = { 10000, 100000, 1000000 };
+    int runs = quick ? 1 : 10;
+    int failures = 0;
+
+    JobSystem single(1);
+    JobSystem all;
+    Frustum frustum(SCREEN_NEAR);
+    frustum.ConstructFrustum(TestViewMatrix(XMFLOAT3(0.0f, 0.0f, -150.0f), XMFLOAT3(0.0f, 0.0f, 1.0f)),
+        Camera::GetProjectionMatrix(16.0f / 9.0f));
+
+    printf("%d workers\n", all.GetWorkerCount());
+    printf("%10s %12s %12s %10s %10s\n", "instances", "1 worker ms", "all ms", "speedup", "visible");
+    for (int count : counts) {
+        if (quick && count > 10000) {
+            break;
+        }
+        std::mt19937 random(1);
+        std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+        std::uniform_int_distribution<int> spin(0, 4);
+        InstanceStore store;
+        for (int i = 0; i < count; i++) {
+            InstanceDesc desc;
+            desc.pos = XMFLOAT3(position(random), position(random), position(random));
+            desc.spin = (float)spin(random);
+            desc.shine = 5.0f;
+            desc.textureId = i % 2;
+            desc.normalMap = desc.textureId == 0;
+            store.Add(desc);
+        }
+
+        CullingFrame singleFrame, allFrame;
+        singleFrame.Resize(count);
+        allFrame.Resize(count);
+        int singleCount = 0, allCount = 0;
+        double singleTime = MeasureBest(runs, [&]() {
+            singleCount = CullFrame(single, store, frustum, 1.0f, singleFrame);
+        });
+        double allTime = MeasureBest(runs, [&]() {
+            allCount = CullFrame(all, store, frustum, 1.0f, allFrame);
+        });
+
+        printf("%10d %12.3f %12.3f %10.2f %10d\n", count, singleTime, allTime, singleTime / allTime, allCount);
+        if (singleCount != allCount || !std::equal(singleFrame.visible.begin(), singleFrame.visible.begin() + singleCount,
+            allFrame.visible.begin())) {
+            printf("mismatch: 1 worker %d visible, all %d visible\n", singleCount, allCount);
+            failures++;
+        }
+    }
+    return failures ? 1 : 0;
+}
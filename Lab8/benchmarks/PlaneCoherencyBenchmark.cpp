@@ -0,0 +1,86 @@
+#include "BenchmarkCommon.h"
+#include "Frustum.h"
+#include "Macros.h"
+#include <vector>
+
+// 8-corner CheckRectangle against the p/n-vertex ClassifyRectangle with and without the plane that rejected
+// each box the frame before, over random camera paths
+int main(int argc, char** argv) {
+    bool quick = QuickRun(argc, argv);
+    const int counts[] = { 10000, 100000 };
+    int frames = quick ? 60 : 600;
+    int failures = 0;
+
+    printf("%8s %8s %14s %14s %14s %10s %10s\n", "boxes", "frames", "corners ms", "p/n ms", "p/n cached ms",
+        "culled", "cache hit");
+    for (int count : counts) {
+        if (quick && count > 10000) {
+            break;
+        }
+        std::mt19937 random(count);
+        std::vector<XMFLOAT4> bbMin, bbMax;
+        RandomBoxes(random, count, 100.0f, 1.0f, bbMin, bbMax);
+        std::vector<TestCameraPoint> path = RandomCameraPath(random, frames, 80.0f);
+        std::vector<Frustum> frustums(frames, Frustum(SCREEN_NEAR));
+        for (int f = 0; f < frames; f++) {
+            frustums[f].ConstructFrustum(TestViewMatrix(path[f].eye, path[f].dir), Camera::GetProjectionMatrix(16.0f / 9.0f));
+        }
+
+        std::vector<int> visibleCorners(frames), visiblePN(frames), visibleCached(frames);
+        std::vector<int> lastPlanes(count, 0);
+        BenchmarkTimer cornersTimer;
+        for (int f = 0; f < frames; f++) {
+            int visible = 0;
+            for (int i = 0; i < count; i++) {
+                visible += frustums[f].CheckRectangle(bbMin[i], bbMax[i]);
+            }
+            visibleCorners[f] = visible;
+        }
+        double cornersTime = cornersTimer.Milliseconds();
+
+        BenchmarkTimer pnTimer;
+        for (int f = 0; f < frames; f++) {
+            int visible = 0;
+            for (int i = 0; i < count; i++) {
+                int lastPlane = -1;
+                UINT planeMask = Frustum::allPlanes;
+                visible += frustums[f].ClassifyRectangle(bbMin[i], bbMax[i], lastPlane, planeMask) != CullResult::Outside;
+            }
+            visiblePN[f] = visible;
+        }
+        double pnTime = pnTimer.Milliseconds();
+
+        BenchmarkTimer cachedTimer;
+        for (int f = 0; f < frames; f++) {
+            int visible = 0;
+            for (int i = 0; i < count; i++) {
+                UINT planeMask = Frustum::allPlanes;
+                visible += frustums[f].ClassifyRectangle(bbMin[i], bbMax[i], lastPlanes[i], planeMask) != CullResult::Outside;
+            }
+            visibleCached[f] = visible;
+        }
+        double cachedTime = cachedTimer.Milliseconds();
+
+        // Share of culled boxes rejected by the plane cached the frame before, measured outside of the timings
+        long long culled = 0, hits = 0;
+        std::fill(lastPlanes.begin(), lastPlanes.end(), 0);
+        for (int f = 0; f < frames; f++) {
+            for (int i = 0; i < count; i++) {
+                int previous = lastPlanes[i];
+                UINT planeMask = Frustum::allPlanes;
+                if (frustums[f].ClassifyRectangle(bbMin[i], bbMax[i], lastPlanes[i], planeMask) == CullResult::Outside) {
+                    culled++;
+                    hits += lastPlanes[i] == previous;
+                }
+            }
+        }
+
+        printf("%8d %8d %14.4f %14.4f %14.4f %9.1f%% %9.1f%%\n", count, frames, cornersTime / frames, pnTime / frames,
+            cachedTime / frames, 100.0 * culled / ((double)count * frames), culled ? 100.0 * hits / culled : 0.0);
+        if (visibleCorners != visiblePN || visibleCorners != visibleCached) {
+            printf("mismatch between the corner and the p/n-vertex tests\n");
+            failures++;
+        }
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,71 @@
+#include "BenchmarkCommon.h"
+#include "SkyIrradiance.h"
+#include <thread>
+
+// SkyIrradiance::Project on one worker and on all of them for cubemaps up to the 256 texels the decoder keeps,
+// and the error against the exact irradiance of a sky L2 holds exactly. Fails if the error or the difference
+// between the worker counts is above 1e-4
+int main(int argc, char** argv) {
+    bool quick = QuickRun(argc, argv);
+    const int sizes[] = { 32, 64, 128, 256 };
+    int runs = quick ? 1 : 10;
+    int failures = 0;
+
+    // Quadratic radiance, its irradiance over pi is a + 2 / 3 b.n + c (1 + nz^2) / 4
+    auto radiance = [](const XMFLOAT3& w) {
+        return XMFLOAT3(0.5f + 0.25f * w.y + w.z * w.z, 0.6f + 0.3f * w.y, 0.9f + 0.1f * w.x + 0.5f * w.z * w.z);
+    };
+    auto irradiance = [](const XMFLOAT3& n) {
+        float zz = (1.0f + n.z * n.z) / 4.0f;
+        return XMFLOAT3(0.5f + 0.25f * n.y * 2.0f / 3.0f + zz, 0.6f + 0.3f * n.y * 2.0f / 3.0f, 0.9f + 0.1f * n.x * 2.0f / 3.0f + 0.5f * zz);
+    };
+
+    JobSystem oneWorker(1);
+    JobSystem allWorkers;
+    SkyIrradiance single(&oneWorker);
+    SkyIrradiance parallel(&allWorkers);
+    printf("%6s %10s %10s %14s %10s %12s\n", "size", "Mtexels", "1 core ms", "workers", "ms", "max error");
+    for (int size : sizes) {
+        if (quick && size > 64) {
+            break;
+        }
+        CubeMapFaces faces;
+        faces.size = size;
+        faces.texels.resize((size_t)6 * size * size);
+        for (int face = 0; face < 6; face++) {
+            for (int y = 0; y < size; y++) {
+                for (int x = 0; x < size; x++) {
+                    XMFLOAT3 dir = SkyIrradiance::FaceDirection(face, -1.0f + (x + 0.5f) * 2.0f / size, -1.0f + (y + 0.5f) * 2.0f / size);
+                    XMStoreFloat3(&dir, XMVector3Normalize(XMLoadFloat3(&dir)));
+                    faces.texels[((size_t)face * size + y) * size + x] = radiance(dir);
+                }
+            }
+        }
+
+        double singleTime = MeasureBest(runs, [&]() {
+            single.Project(faces);
+        });
+        double parallelTime = MeasureBest(runs, [&]() {
+            parallel.Project(faces);
+        });
+
+        std::mt19937 random(1);
+        float maxError = 0.0f, maxDifference = 0.0f;
+        for (int i = 0; i < 10000; i++) {
+            XMFLOAT3 normal = RandomDirection(random);
+            XMFLOAT3 actual = parallel.Evaluate(normal);
+            XMFLOAT3 expected = irradiance(normal);
+            XMFLOAT3 other = single.Evaluate(normal);
+            maxError = max(maxError, max(fabsf(actual.x - expected.x), max(fabsf(actual.y - expected.y), fabsf(actual.z - expected.z))));
+            maxDifference = max(maxDifference, max(fabsf(actual.x - other.x), max(fabsf(actual.y - other.y), fabsf(actual.z - other.z))));
+        }
+
+        printf("%6d %10.3f %10.3f %14d %10.3f %12.2g\n", size, 6.0 * size * size / 1e6, singleTime, allWorkers.GetWorkerCount(),
+            parallelTime, maxError);
+        if (maxError > 1e-4f || maxDifference > 1e-4f) {
+            printf("error %g, difference between worker counts %g\n", maxError, maxDifference);
+            failures++;
+        }
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,142 @@
+#include "BenchmarkCommon.h"
+#include "SoftwareRasterizer.h"
+#include <vector>
+
+namespace {
+    struct Scene {
+        std::vector<XMMATRIX> cubes;
+        std::vector<Light> lights;
+        XMFLOAT3 eye;
+        XMFLOAT3 dir;
+    };
+
+    // A grid of cubes in front of the camera, a sky quad behind them and two transparent planes,
+    // the same passes RenderSoftware draws
+    Scene MakeScene(int side) {
+        Scene scene;
+        for (int z = 0; z < side; z++) {
+            for (int x = 0; x < side; x++) {
+                scene.cubes.push_back(XMMatrixRotationY(0.3f * (x + z)) *
+                    XMMatrixTranslation((x - side * 0.5f) * 2.5f, 0.0f, 4.0f + z * 2.5f));
+            }
+        }
+        for (int i = 0; i < 8; i++) {
+            Light light = { XMFLOAT4((i - 4) * 4.0f, 3.0f, 6.0f + i * 3.0f, 12.0f), XMFLOAT4(1.0f, 0.9f, 0.8f, 1.0f) };
+            scene.lights.push_back(light);
+        }
+        scene.eye = XMFLOAT3(0.0f, 6.0f, -6.0f);
+        scene.dir = XMFLOAT3(0.0f, -0.35f, 1.0f);
+        return scene;
+    }
+
+    void DrawQuad(SoftwareRasterizer& rasterizer, const XMFLOAT3* corners, const XMFLOAT3& normal, FXMMATRIX viewProjection,
+        const SoftwareMaterial& material, bool sky) {
+        SoftwareVertex v[4];
+        for (int i = 0; i < 4; i++) {
+            XMVECTOR pos = XMVectorSetW(XMLoadFloat3(&corners[i]), 1.0f);
+            XMStoreFloat4(&v[i].clip, XMVector4Transform(pos, viewProjection));
+            if (sky) {
+                v[i].clip.z = 0.0f;
+            }
+            v[i].pos = corners[i];
+            v[i].normal = normal;
+        }
+        rasterizer.DrawTriangle(v[0], v[1], v[2], material);
+        rasterizer.DrawTriangle(v[0], v[2], v[3], material);
+    }
+
+    void DrawScene(SoftwareRasterizer& rasterizer, const Scene& scene, float aspect) {
+        static const XMFLOAT3 Colors[] = { {0.7f, 0.55f, 0.4f}, {0.55f, 0.6f, 0.65f} };
+        XMMATRIX viewProjection = XMMatrixMultiply(TestViewMatrix(scene.eye, scene.dir), Camera::GetProjectionMatrix(aspect));
+
+        for (size_t c = 0; c < scene.cubes.size(); c++) {
+            SoftwareMaterial material = { SoftwareShader::Lit, Colors[c % 2], 32.0f, 1.0f };
+            for (int face = 0; face < 6; face++) {
+                int axis = face / 2;
+                float sign = face % 2 ? -1.0f : 1.0f;
+                XMFLOAT3 corners[4], normal(0.0f, 0.0f, 0.0f);
+                (&normal.x)[axis] = sign;
+                for (int i = 0; i < 4; i++) {
+                    float local[3];
+                    local[axis] = sign * 0.5f;
+                    local[(axis + 1) % 3] = (i == 1 || i == 2) ? 0.5f : -0.5f;
+                    local[(axis + 2) % 3] = i >= 2 ? 0.5f : -0.5f;
+                    XMStoreFloat3(&corners[i], XMVector3TransformCoord(XMVectorSet(local[0], local[1], local[2], 1.0f), scene.cubes[c]));
+                }
+                XMFLOAT3 worldNormal;
+                XMStoreFloat3(&worldNormal, XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&normal), scene.cubes[c])));
+                DrawQuad(rasterizer, corners, worldNormal, viewProjection, material, false);
+            }
+        }
+
+        SoftwareMaterial skyMaterial = { SoftwareShader::Sky, XMFLOAT3(0.3f, 0.5f, 0.85f), 0.0f, 1.0f };
+        XMFLOAT3 sky[4] = { {-500.0f, -200.0f, 400.0f}, {-500.0f, 400.0f, 400.0f}, {500.0f, 400.0f, 400.0f}, {500.0f, -200.0f, 400.0f} };
+        DrawQuad(rasterizer, sky, XMFLOAT3(0.0f, 0.0f, -1.0f), viewProjection, skyMaterial, true);
+
+        for (int plane = 0; plane < 2; plane++) {
+            SoftwareMaterial material = { SoftwareShader::Transparent, plane ? XMFLOAT3(0.0f, 1.0f, 0.0f) : XMFLOAT3(1.0f, 0.0f, 0.0f), 0.0f, 0.5f };
+            float x = plane ? 2.0f : -2.0f;
+            XMFLOAT3 corners[4] = { {x, -1.0f, 2.0f}, {x, 3.0f, 2.0f}, {x, 3.0f, 12.0f}, {x, -1.0f, 12.0f} };
+            DrawQuad(rasterizer, corners, XMFLOAT3(1.0f, 0.0f, 0.0f), viewProjection, material, false);
+        }
+        rasterizer.Flush();
+    }
+
+    bool SameImage(const SoftwareRasterizer& a, const SoftwareRasterizer& b, int width, int height) {
+        for (int y = 0; y < height; y++) {
+            const XMFLOAT4* rowA = reinterpret_cast<const XMFLOAT4*>(reinterpret_cast<const uint8_t*>(a.GetColor()) + (size_t)y * a.GetRowPitch());
+            const XMFLOAT4* rowB = reinterpret_cast<const XMFLOAT4*>(reinterpret_cast<const uint8_t*>(b.GetColor()) + (size_t)y * b.GetRowPitch());
+            if (memcmp(rowA, rowB, sizeof(XMFLOAT4) * width) != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+// Frame time, pixel and triangle throughput of the software backend on one worker and on every core.
+// Tiles are shaded in submission order, so both images must be identical
+int main(int argc, char** argv) {
+    bool quick = QuickRun(argc, argv);
+    const int sizes[][2] = { { 640, 360 }, { 1280, 720 }, { 1920, 1080 } };
+    int runs = quick ? 1 : 10;
+    int failures = 0;
+
+    Scene scene = MakeScene(quick ? 8 : 24);
+    XMFLOAT4 ambientSH[SkyIrradiance::coefficientCount] = {};
+    ambientSH[0] = XMFLOAT4(0.2f, 0.2f, 0.25f, 0.0f);
+    LightingParams lighting = { scene.eye, (int)scene.lights.size(), false, scene.lights.data() };
+
+    JobSystem serialJobs(1);
+    JobSystem parallelJobs;
+    printf("%d cubes, %d workers\n", (int)scene.cubes.size(), parallelJobs.GetWorkerCount());
+    printf("%12s %8s %10s %10s %10s %10s\n", "size", "workers", "ms", "Mpix/s", "Mtri/s", "pixels");
+    for (const auto& size : sizes) {
+        if (quick && size[0] > 640) {
+            break;
+        }
+        int width = size[0], height = size[1];
+        SoftwareRasterizer serial(&serialJobs);
+        SoftwareRasterizer parallel(&parallelJobs);
+        SoftwareRasterizer* rasterizers[] = { &serial, &parallel };
+        for (SoftwareRasterizer* rasterizer : rasterizers) {
+            rasterizer->Resize(width, height);
+            rasterizer->SetLighting(lighting, ambientSH);
+            double ms = MeasureBest(runs, [&]() {
+                rasterizer->Clear(XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f));
+                DrawScene(*rasterizer, scene, width / (float)height);
+            });
+            const SoftwareStats& stats = rasterizer->GetStats();
+            char label[32];
+            snprintf(label, sizeof(label), "%dx%d", width, height);
+            printf("%12s %8d %10.3f %10.1f %10.2f %10llu\n", label, rasterizer == &serial ? 1 : parallelJobs.GetWorkerCount(),
+                ms, stats.pixels / (ms * 1000.0), stats.triangles / (ms * 1000.0), (unsigned long long)stats.pixels);
+        }
+
+        if (serial.GetStats().pixels != parallel.GetStats().pixels || !SameImage(serial, parallel, width, height)) {
+            printf("mismatch at %dx%d: the images of one and %d workers differ\n", width, height, parallelJobs.GetWorkerCount());
+            failures++;
+        }
+    }
+    return failures ? 1 : 0;
+}
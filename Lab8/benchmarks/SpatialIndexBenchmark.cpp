@@ -0,0 +1,127 @@
+#include "BenchmarkCommon.h"
+#include "SpatialIndex.h"
+#include "LooseOctree.h"
+#include "HashGrid.h"
+#include "Macros.h"
+#include <memory>
+#include <vector>
+
+namespace {
+    struct IndexTimings {
+        double insertMilliseconds;
+        double movesPerSecond;
+        double frustumQueriesPerSecond;
+        double sphereQueriesPerSecond;
+        double boxQueriesPerSecond;
+        UINT64 found; // ids of every query, the same for both structures
+    };
+
+    // Inserts, churn and queries on unit boxes at the density of the scene, the same random sequence for every type
+    IndexTimings Run(SpatialIndex& index, int objectCount, float worldSize, int frustumQueries, int smallQueries) {
+        IndexTimings result = {};
+        std::mt19937 random(1);
+        std::uniform_real_distribution<float> position(-worldSize, worldSize);
+        std::uniform_real_distribution<float> step(-0.5f, 0.5f);
+        std::vector<XMFLOAT4> centers(objectCount);
+        for (XMFLOAT4& c : centers) {
+            c = XMFLOAT4(position(random), position(random), position(random), 1.0f);
+        }
+        auto boundsMin = [&](int i) { return XMFLOAT4(centers[i].x - 1.0f, centers[i].y - 1.0f, centers[i].z - 1.0f, 1.0f); };
+        auto boundsMax = [&](int i) { return XMFLOAT4(centers[i].x + 1.0f, centers[i].y + 1.0f, centers[i].z + 1.0f, 1.0f); };
+
+        BenchmarkTimer insertTimer;
+        for (int i = 0; i < objectCount; i++) {
+            index.Insert(i, boundsMin(i), boundsMax(i));
+        }
+        result.insertMilliseconds = insertTimer.Milliseconds();
+
+        // Churn: a tenth of the objects take a small step every round
+        const int rounds = 10;
+        int moveCount = max(objectCount / 10, 1);
+        std::vector<int> moved(moveCount);
+        double moveMilliseconds = 0.0;
+        for (int r = 0; r < rounds; r++) {
+            for (int& id : moved) {
+                id = (int)(random() % (UINT)objectCount);
+                centers[id].x += step(random);
+                centers[id].y += step(random);
+                centers[id].z += step(random);
+            }
+            BenchmarkTimer moveTimer;
+            for (int id : moved) {
+                index.Move(id, boundsMin(id), boundsMax(id));
+            }
+            moveMilliseconds += moveTimer.Milliseconds();
+        }
+        result.movesPerSecond = rounds * moveCount / (moveMilliseconds / 1000.0);
+
+        // The frustum of the renderer
+        std::vector<int> ids(objectCount);
+        Frustum frustum(SCREEN_NEAR);
+        XMMATRIX projection = Camera::GetProjectionMatrix(16.0f / 9.0f);
+        double frustumMilliseconds = 0.0;
+        for (int q = 0; q < frustumQueries; q++) {
+            frustum.ConstructFrustum(TestViewMatrix(XMFLOAT3(position(random), position(random), position(random)), RandomDirection(random)),
+                projection);
+            BenchmarkTimer queryTimer;
+            result.found += index.QueryFrustum(frustum, ids.data());
+            frustumMilliseconds += queryTimer.Milliseconds();
+        }
+        result.frustumQueriesPerSecond = frustumQueries / (frustumMilliseconds / 1000.0);
+
+        std::vector<XMFLOAT3> queryCenters(smallQueries);
+        for (XMFLOAT3& c : queryCenters) {
+            c = XMFLOAT3(position(random), position(random), position(random));
+        }
+        BenchmarkTimer sphereTimer;
+        for (const XMFLOAT3& c : queryCenters) {
+            result.found += index.QuerySphere(c, 4.0f, ids.data());
+        }
+        result.sphereQueriesPerSecond = smallQueries / (sphereTimer.Milliseconds() / 1000.0);
+
+        BenchmarkTimer boxTimer;
+        for (const XMFLOAT3& c : queryCenters) {
+            result.found += index.QueryBox(XMFLOAT4(c.x - 4.0f, c.y - 4.0f, c.z - 4.0f, 1.0f), XMFLOAT4(c.x + 4.0f, c.y + 4.0f, c.z + 4.0f, 1.0f),
+                ids.data());
+        }
+        result.boxQueriesPerSecond = smallQueries / (boxTimer.Milliseconds() / 1000.0);
+        return result;
+    }
+}
+
+// Insert, churn and query throughput of the two spatial index structures on up to a million boxes.
+// Both must find the same number of ids
+int main(int argc, char** argv) {
+    bool quick = QuickRun(argc, argv);
+    const int counts[] = { 10000, 100000, 1000000 };
+    int failures = 0;
+
+    printf("%10s %12s %10s %10s %12s %12s %12s\n", "objects", "index", "insert ms", "moves M/s", "frustum q/s", "sphere q/s", "box q/s");
+    for (int count : counts) {
+        if (quick && count > 10000) {
+            break;
+        }
+        // A world large enough for count unit boxes at the density of the scene
+        float worldSize = 6.0f * cbrtf(count / 1000.0f);
+        int frustumQueries = quick ? 2 : 20;
+        int smallQueries = quick ? 100 : 10000;
+
+        std::unique_ptr<SpatialIndex> indices[] = {
+            std::unique_ptr<SpatialIndex>(new LooseOctree(XMFLOAT3(0.0f, 0.0f, 0.0f), worldSize, 12)),
+            std::unique_ptr<SpatialIndex>(new HashGrid(2.0f))
+        };
+        const char* names[] = { "octree", "hash grid" };
+        UINT64 found[2];
+        for (int k = 0; k < 2; k++) {
+            IndexTimings timings = Run(*indices[k], count, worldSize, frustumQueries, smallQueries);
+            found[k] = timings.found;
+            printf("%10d %12s %10.1f %10.2f %12.0f %12.0f %12.0f\n", count, names[k], timings.insertMilliseconds,
+                timings.movesPerSecond / 1e6, timings.frustumQueriesPerSecond, timings.sphereQueriesPerSecond, timings.boxQueriesPerSecond);
+        }
+        if (found[0] != found[1]) {
+            printf("mismatch: octree found %llu ids, hash grid %llu\n", (unsigned long long)found[0], (unsigned long long)found[1]);
+            failures++;
+        }
+    }
+    return failures ? 1 : 0;
+}
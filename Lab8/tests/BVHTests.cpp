@@ -0,0 +1,98 @@
+#include "TestCommon.h"
+#include "BVH.h"
+#include "Macros.h"
+#include <algorithm>
+#include <vector>
+
+static void FillStreams(const std::vector<XMFLOAT4>& bbMin, const std::vector<XMFLOAT4>& bbMax, BoxStreams& boxes) {
+    boxes.Resize(bbMin.size());
+    for (size_t i = 0; i < bbMin.size(); i++) {
+        boxes.Set(i, bbMin[i], bbMax[i]);
+    }
+}
+
+// Sorted indices of the visible boxes from the BVH and from CheckRectangle
+static int CountMismatches(BVH& bvh, Frustum& frustum, const BoxStreams& boxes,
+    const std::vector<XMFLOAT4>& bbMin, const std::vector<XMFLOAT4>& bbMax) {
+    std::vector<int> visible(bbMin.size() + 1);
+    visible.resize(bvh.Cull(frustum, boxes, visible.data()));
+    std::sort(visible.begin(), visible.end());
+
+    std::vector<int> expected;
+    for (size_t i = 0; i < bbMin.size(); i++) {
+        if (frustum.CheckRectangle(bbMin[i], bbMax[i])) {
+            expected.push_back((int)i);
+        }
+    }
+    return visible == expected ? 0 : 1;
+}
+
+static void TestCullMatchesLinear() {
+    std::mt19937 random(1);
+    for (int count : { 0, 1, 3, 4, 5, 100, 5000 }) {
+        std::vector<XMFLOAT4> bbMin, bbMax;
+        RandomBoxes(random, count, 60.0f, 2.0f, bbMin, bbMax);
+        BoxStreams boxes;
+        FillStreams(bbMin, bbMax, boxes);
+
+        BVH bvh;
+        bvh.Build(boxes, count);
+        CHECK(bvh.GetCount() == count);
+        int mismatches = 0;
+        std::vector<TestCameraPoint> path = RandomCameraPath(random, 120, 50.0f);
+        for (const TestCameraPoint& point : path) {
+            Frustum frustum(SCREEN_NEAR);
+            frustum.ConstructFrustum(TestViewMatrix(point.eye, point.dir), Camera::GetProjectionMatrix(16.0f / 9.0f));
+            mismatches += CountMismatches(bvh, frustum, boxes, bbMin, bbMax);
+        }
+        CHECK(mismatches == 0);
+    }
+}
+
+// Boxes spin around their centers like the cubes, the tree is refit every frame without a rebuild
+static void TestRefitMatchesLinear() {
+    std::mt19937 random(2);
+    const int count = 3000;
+    std::vector<XMFLOAT4> bbMin, bbMax;
+    RandomBoxes(random, count, 60.0f, 2.0f, bbMin, bbMax);
+    std::vector<XMFLOAT4> startMin = bbMin, startMax = bbMax;
+    BoxStreams boxes;
+    FillStreams(bbMin, bbMax, boxes);
+    BVH bvh;
+    bvh.Build(boxes, count);
+
+    std::uniform_real_distribution<float> drift(-0.5f, 0.5f);
+    std::vector<XMFLOAT3> velocity(count);
+    for (XMFLOAT3& v : velocity) {
+        v = XMFLOAT3(drift(random), drift(random), drift(random));
+    }
+
+    int mismatches = 0;
+    std::vector<TestCameraPoint> path = RandomCameraPath(random, 120, 50.0f);
+    for (size_t f = 0; f < path.size(); f++) {
+        float t = (float)f;
+        for (int i = 0; i < count; i++) {
+            float grow = 0.5f + 0.5f * fabsf(sinf(t * 0.05f + i));
+            XMFLOAT3 center((startMin[i].x + startMax[i].x) * 0.5f + velocity[i].x * t,
+                (startMin[i].y + startMax[i].y) * 0.5f + velocity[i].y * t,
+                (startMin[i].z + startMax[i].z) * 0.5f + velocity[i].z * t);
+            XMFLOAT3 half((startMax[i].x - startMin[i].x) * grow, (startMax[i].y - startMin[i].y) * grow,
+                (startMax[i].z - startMin[i].z) * grow);
+            bbMin[i] = XMFLOAT4(center.x - half.x, center.y - half.y, center.z - half.z, 1.0f);
+            bbMax[i] = XMFLOAT4(center.x + half.x, center.y + half.y, center.z + half.z, 1.0f);
+            boxes.Set(i, bbMin[i], bbMax[i]);
+        }
+        bvh.Refit(boxes);
+
+        Frustum frustum(SCREEN_NEAR);
+        frustum.ConstructFrustum(TestViewMatrix(path[f].eye, path[f].dir), Camera::GetProjectionMatrix(16.0f / 9.0f));
+        mismatches += CountMismatches(bvh, frustum, boxes, bbMin, bbMax);
+    }
+    CHECK(mismatches == 0);
+}
+
+int main() {
+    TestCullMatchesLinear();
+    TestRefitMatchesLinear();
+    return TestResult("BVHTests");
+}
@@ -0,0 +1,119 @@
+#include "TestCommon.h"
+#include "Bounds.h"
+#include <cstring>
+#include <vector>
+
+static bool SameBits(const XMFLOAT4& a, const XMFLOAT4& b) {
+    return memcmp(&a, &b, 3 * sizeof(float)) == 0;
+}
+
+// TransformAABB gives the corner min/max bit for bit, for the unit cube of the scene and for uneven boxes
+static void TestMatchesCorners() {
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> coordinate(-3.0f, 3.0f);
+    int mismatches = 0;
+    for (int i = 0; i < 200000; i++) {
+        XMFLOAT4 localMin(-0.5f, -0.5f, -0.5f, 1.0f), localMax(0.5f, 0.5f, 0.5f, 1.0f);
+        if (i % 2) {
+            float a[3] = { coordinate(random), coordinate(random), coordinate(random) };
+            float b[3] = { coordinate(random), coordinate(random), coordinate(random) };
+            localMin = XMFLOAT4(min(a[0], b[0]), min(a[1], b[1]), min(a[2], b[2]), 1.0f);
+            localMax = XMFLOAT4(max(a[0], b[0]), max(a[1], b[1]), max(a[2], b[2]), 1.0f);
+        }
+        XMMATRIX world = RandomWorldMatrix(random, 1000.0f);
+
+        XMFLOAT4 expectedMin, expectedMax, actualMin, actualMax;
+        CornerAABB(localMin, localMax, world, expectedMin, expectedMax);
+        XMVECTOR bbMin, bbMax;
+        TransformAABB(XMLoadFloat4(&localMin), XMLoadFloat4(&localMax), world, bbMin, bbMax);
+        XMStoreFloat4(&actualMin, bbMin);
+        XMStoreFloat4(&actualMax, bbMax);
+        mismatches += !SameBits(expectedMin, actualMin) || !SameBits(expectedMax, actualMax);
+    }
+    CHECK(mismatches == 0);
+}
+
+// Pure rotations by right angles and mirrored axes make several corners tie for the extreme,
+// the four-wide stream matches the one-instance path in all four components
+static void TestAxisAlignedMatrices() {
+    XMFLOAT4 localMin(-0.5f, -1.0f, -2.0f, 1.0f), localMax(1.5f, 1.0f, 0.25f, 1.0f);
+    std::vector<XMMATRIX> matrices;
+    int mismatches = 0;
+    for (int quarter = 0; quarter < 4; quarter++) {
+        for (int mirror = 0; mirror < 8; mirror++) {
+            XMMATRIX world = XMMatrixScaling(mirror & 1 ? -1.0f : 1.0f, mirror & 2 ? -2.0f : 2.0f, mirror & 4 ? -0.5f : 0.5f) *
+                XMMatrixRotationY(quarter * XM_PIDIV2) * XMMatrixTranslation(3.0f, -4.0f, 5.0f);
+            XMFLOAT4 expectedMin, expectedMax, actualMin, actualMax;
+            CornerAABB(localMin, localMax, world, expectedMin, expectedMax);
+            XMVECTOR bbMin, bbMax;
+            TransformAABB(XMLoadFloat4(&localMin), XMLoadFloat4(&localMax), world, bbMin, bbMax);
+            XMStoreFloat4(&actualMin, bbMin);
+            XMStoreFloat4(&actualMax, bbMax);
+            mismatches += !SameBits(expectedMin, actualMin) || !SameBits(expectedMax, actualMax);
+            matrices.push_back(world);
+        }
+    }
+    CHECK(mismatches == 0);
+
+    int count = (int)matrices.size();
+    std::vector<XMFLOAT4> streamMin(count), streamMax(count);
+    BoxStreams streams;
+    streams.Resize(count);
+    TransformAABBStream(localMin, localMax, matrices.data(), sizeof(XMMATRIX), 0, count, streamMin.data(), streamMax.data(), streams);
+    int streamMismatches = 0;
+    for (int i = 0; i < count; i++) {
+        XMVECTOR bbMin, bbMax;
+        TransformAABB(XMLoadFloat4(&localMin), XMLoadFloat4(&localMax), matrices[i], bbMin, bbMax);
+        XMFLOAT4 expectedMin, expectedMax;
+        XMStoreFloat4(&expectedMin, bbMin);
+        XMStoreFloat4(&expectedMax, bbMax);
+        streamMismatches += memcmp(&expectedMin, &streamMin[i], sizeof(XMFLOAT4)) != 0 ||
+            memcmp(&expectedMax, &streamMax[i], sizeof(XMFLOAT4)) != 0;
+    }
+    CHECK(streamMismatches == 0);
+}
+
+// The stream version reads matrices with a stride, writes only [first, first + count) and fills AoS and SoA alike
+static void TestStream() {
+    struct Instance {
+        XMMATRIX world;
+        XMFLOAT4 payload;
+    };
+    std::mt19937 random(2);
+    const int count = 1000, first = 13, rangeCount = 901;
+    std::vector<Instance> instances(count);
+    for (Instance& instance : instances) {
+        instance.world = RandomWorldMatrix(random, 100.0f);
+    }
+
+    XMFLOAT4 localMin(-0.5f, -0.5f, -0.5f, 1.0f), localMax(0.5f, 0.5f, 0.5f, 1.0f);
+    const XMFLOAT4 untouched(7.0f, 7.0f, 7.0f, 7.0f);
+    std::vector<XMFLOAT4> bbMin(count, untouched), bbMax(count, untouched);
+    BoxStreams streams;
+    streams.Resize(count);
+    TransformAABBStream(localMin, localMax, &instances[0].world, sizeof(Instance), first, rangeCount,
+        bbMin.data(), bbMax.data(), streams);
+
+    int mismatches = 0, overwritten = 0;
+    for (int i = 0; i < count; i++) {
+        if (i < first || i >= first + rangeCount) {
+            overwritten += !SameBits(bbMin[i], untouched) || !SameBits(bbMax[i], untouched);
+            continue;
+        }
+        XMFLOAT4 expectedMin, expectedMax;
+        CornerAABB(localMin, localMax, instances[i].world, expectedMin, expectedMax);
+        XMFLOAT4 streamMin(streams.minX[i], streams.minY[i], streams.minZ[i], 1.0f);
+        XMFLOAT4 streamMax(streams.maxX[i], streams.maxY[i], streams.maxZ[i], 1.0f);
+        mismatches += !SameBits(expectedMin, bbMin[i]) || !SameBits(expectedMax, bbMax[i]) ||
+            !SameBits(expectedMin, streamMin) || !SameBits(expectedMax, streamMax);
+    }
+    CHECK(mismatches == 0);
+    CHECK(overwritten == 0);
+}
+
+int main() {
+    TestMatchesCorners();
+    TestAxisAlignedMatrices();
+    TestStream();
+    return TestResult("BoundsTests");
+}
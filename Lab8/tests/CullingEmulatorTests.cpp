@@ -0,0 +1,159 @@
+#include "TestCommon.h"
+#include "CullingEmulator.h"
+#include "Frustum.h"
+#include "Macros.h"
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+namespace {
+    // Buffers of one FCS.hlsl dispatch sized for count boxes
+    struct CullingBuffers {
+        std::vector<UINT> objectsIds;
+        std::vector<UINT> groupIds;
+        std::vector<XMUINT2> groupRanges;
+        UINT groupCount;
+
+        CullingBuffers(int count) :
+            groupCount(((UINT)count + CullingEmulator::groupSize - 1) / CullingEmulator::groupSize) {
+            objectsIds.resize(count);
+            groupIds.resize((size_t)groupCount * CullingEmulator::groupSize);
+            groupRanges.resize(groupCount);
+        }
+    };
+
+    // Runs the emulated shader and Frustum::CheckRectangles on the same boxes and checks that the indirect args,
+    // the group offsets and the visible ids match, returns the visible count
+    int CheckDispatch(CullingEmulator& emulator, Frustum& frustum, const std::vector<XMFLOAT4>& bbMin,
+        const std::vector<XMFLOAT4>& bbMax) {
+        int count = (int)bbMin.size();
+        CullingBuffers buffers(count);
+        BoxStreams boxes;
+        boxes.Resize(count);
+        for (int i = 0; i < count; i++) {
+            boxes.Set(i, bbMin[i], bbMax[i]);
+        }
+
+        UINT indirectArgs[5] = { 36, 0, 0, 0, 0 };
+        emulator.Dispatch(buffers.groupCount, XMINT4(count, 0, 0, 0), frustum.GetPlanes(), bbMin.data(), bbMax.data(),
+            indirectArgs, buffers.objectsIds.data(), buffers.groupIds.data(), buffers.groupRanges.data());
+        std::vector<int> cpuVisible(count);
+        int cpuCount = frustum.CheckRectangles(boxes, 0, count, cpuVisible.data());
+
+        UINT gpuCount = indirectArgs[1];
+        CHECK(indirectArgs[0] == 36);
+        CHECK(gpuCount == (UINT)cpuCount);
+        if (gpuCount != (UINT)cpuCount) {
+            return cpuCount;
+        }
+        // Compacted in index order without sorting
+        CHECK(std::equal(cpuVisible.begin(), cpuVisible.begin() + cpuCount, buffers.objectsIds.begin(),
+            [](int a, UINT b) { return (UINT)a == b; }));
+
+        std::vector<UINT> groupCounts(buffers.groupCount), groupOffsets(buffers.groupCount);
+        for (UINT i = 0; i < buffers.groupCount; i++) {
+            groupCounts[i] = buffers.groupRanges[i].x;
+        }
+        CHECK(CullingEmulator::ExclusiveScan(groupCounts.data(), groupOffsets.data(), buffers.groupCount) == gpuCount);
+        for (UINT i = 0; i < buffers.groupCount; i++) {
+            CHECK(buffers.groupRanges[i].y == groupOffsets[i]);
+        }
+        return cpuCount;
+    }
+
+    Frustum RandomFrustum(std::mt19937& random) {
+        std::uniform_real_distribution<float> position(-10.0f, 10.0f);
+        std::uniform_real_distribution<float> aspect(0.5f, 2.5f);
+        Frustum frustum(SCREEN_NEAR);
+        frustum.ConstructFrustum(TestViewMatrix(XMFLOAT3(position(random), position(random), position(random)), RandomDirection(random)),
+            Camera::GetProjectionMatrix(aspect(random)));
+        return frustum;
+    }
+}
+
+// ScanGroup is the inclusive version of ExclusiveScan for every power of two size the shader uses
+void TestScan() {
+    std::mt19937 random(3);
+    std::uniform_int_distribution<UINT> value(0, CullingEmulator::groupSize);
+    for (UINT size = 1; size <= CullingEmulator::scanSize; size <<= 1) {
+        std::vector<UINT> src(size), exclusive(size), inclusive(size);
+        for (UINT& v : src) {
+            v = value(random);
+        }
+        inclusive = src;
+        UINT total = CullingEmulator::ExclusiveScan(src.data(), exclusive.data(), size);
+        CullingEmulator::ScanGroup(inclusive.data(), size);
+        CHECK(inclusive[size - 1] == total);
+        for (UINT i = 0; i < size; i++) {
+            CHECK(inclusive[i] == exclusive[i] + src[i]);
+        }
+    }
+}
+
+// IsBoxInside keeps a box while any corner is in front of every plane, like Frustum::CheckRectangle,
+// boxes straddling a plane with a single corner catch corners the shader skips
+void TestIsBoxInside() {
+    std::mt19937 random(5);
+    std::vector<XMFLOAT4> bbMin, bbMax;
+    int mismatches = 0;
+    for (int camera = 0; camera < 50; camera++) {
+        Frustum frustum = RandomFrustum(random);
+        RandomBoxes(random, 2000, 20.0f, 3.0f, bbMin, bbMax);
+        for (size_t i = 0; i < bbMin.size(); i++) {
+            bool shader = CullingEmulator::IsBoxInside(frustum.GetPlanes(), XMFLOAT3(bbMin[i].x, bbMin[i].y, bbMin[i].z),
+                XMFLOAT3(bbMax[i].x, bbMax[i].y, bbMax[i].z));
+            mismatches += shader != frustum.CheckRectangle(bbMin[i], bbMax[i]);
+        }
+    }
+    CHECK(mismatches == 0);
+
+    // Only the (min, max, min) corner is in front of the plane y = x + z
+    XMFLOAT4 planes[6] = { { -1.0f, 1.0f, -1.0f, 0.0f } };
+    for (int i = 1; i < 6; i++) {
+        planes[i] = XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
+    }
+    CHECK(CullingEmulator::IsBoxInside(planes, XMFLOAT3(0.0f, -1.0f, 0.0f), XMFLOAT3(1.0f, 0.5f, 1.0f)));
+    CHECK(!CullingEmulator::IsBoxInside(planes, XMFLOAT3(0.0f, -1.0f, 0.0f), XMFLOAT3(1.0f, -0.5f, 1.0f)));
+}
+
+// Full dispatches: partial groups, empty and full results and more groups than one ScanGroups pass covers
+void TestDispatch(JobSystem& jobSystem) {
+    CullingEmulator emulator(&jobSystem);
+    std::mt19937 random(7);
+    std::vector<XMFLOAT4> bbMin, bbMax;
+
+    const int counts[] = { 1, 63, 64, 65, 1000, CullingEmulator::groupSize * CullingEmulator::scanSize + 100 };
+    for (int count : counts) {
+        for (int camera = 0; camera < 4; camera++) {
+            RandomBoxes(random, count, 20.0f, 3.0f, bbMin, bbMax);
+            Frustum frustum = RandomFrustum(random);
+            CheckDispatch(emulator, frustum, bbMin, bbMax);
+        }
+    }
+
+    Frustum frustum(SCREEN_NEAR);
+    frustum.ConstructFrustum(TestViewMatrix(XMFLOAT3(0.0f, 0.0f, -50.0f), XMFLOAT3(0.0f, 0.0f, 1.0f)),
+        Camera::GetProjectionMatrix(1.0f));
+    RandomBoxes(random, 5000, 1.0f, 0.5f, bbMin, bbMax);
+    CHECK(CheckDispatch(emulator, frustum, bbMin, bbMax) == 5000);
+    frustum.ConstructFrustum(TestViewMatrix(XMFLOAT3(0.0f, 0.0f, 50.0f), XMFLOAT3(0.0f, 0.0f, 1.0f)),
+        Camera::GetProjectionMatrix(1.0f));
+    CHECK(CheckDispatch(emulator, frustum, bbMin, bbMax) == 0);
+
+    // A million boxes over many cameras, the agreement the GPU path has to keep
+    int visible = 0;
+    for (int camera = 0; camera < 20; camera++) {
+        RandomBoxes(random, 50000, 20.0f, 3.0f, bbMin, bbMax);
+        Frustum cameraFrustum = RandomFrustum(random);
+        visible += CheckDispatch(emulator, cameraFrustum, bbMin, bbMax);
+    }
+    CHECK(visible > 0);
+}
+
+int main() {
+    JobSystem jobSystem(4);
+    TestScan();
+    TestIsBoxInside();
+    TestDispatch(jobSystem);
+    return TestResult("CullingEmulatorTests");
+}
@@ -0,0 +1,173 @@
+#include "TestCommon.h"
+#include "Frustum.h"
+#include "Macros.h"
+#include <vector>
+
+static void TestBatchMatchesScalar() {
+    std::mt19937 random(1);
+    std::vector<XMFLOAT4> bbMin, bbMax;
+    const int count = 4099;
+    RandomBoxes(random, count, 60.0f, 4.0f, bbMin, bbMax);
+    BoxStreams boxes;
+    boxes.Resize(count);
+    for (int i = 0; i < count; i++) {
+        boxes.Set(i, bbMin[i], bbMax[i]);
+    }
+
+    std::vector<int> visible(count);
+    std::vector<UINT> mask((count + 31) / 32);
+    for (int view = 0; view < 16; view++) {
+        Frustum frustum(SCREEN_NEAR);
+        frustum.ConstructFrustum(TestViewMatrix(XMFLOAT3(0.0f, 2.0f, 0.0f), RandomDirection(random)),
+            Camera::GetProjectionMatrix(16.0f / 9.0f));
+
+        // Odd ranges exercise the partial group at both ends
+        int first = view % 5, rangeCount = count - first - view % 3;
+        std::vector<int> expected;
+        for (int i = first; i < first + rangeCount; i++) {
+            if (frustum.CheckRectangle(bbMin[i], bbMax[i])) {
+                expected.push_back(i);
+            }
+        }
+        CHECK(!expected.empty());
+
+        int visibleCount = frustum.CheckRectangles(boxes, first, rangeCount, visible.data());
+        CHECK(visibleCount == (int)expected.size());
+        CHECK(std::equal(expected.begin(), expected.end(), visible.begin()));
+
+        std::fill(mask.begin(), mask.end(), 0u);
+        frustum.CheckRectanglesMask(boxes, first, rangeCount, mask.data());
+        int maskMismatches = 0;
+        size_t e = 0;
+        for (int j = 0; j < rangeCount; j++) {
+            bool inMask = (mask[j / 32] >> (j % 32)) & 1u;
+            bool inList = e < expected.size() && expected[e] == first + j;
+            e += inList;
+            maskMismatches += inMask != inList;
+        }
+        CHECK(maskMismatches == 0);
+    }
+}
+
+static void TestClassifyMatchesCheck() {
+    std::mt19937 random(2);
+    std::vector<XMFLOAT4> bbMin, bbMax;
+    RandomBoxes(random, 2000, 60.0f, 4.0f, bbMin, bbMax);
+    Frustum frustum(SCREEN_NEAR);
+    frustum.ConstructFrustum(TestViewMatrix(XMFLOAT3(0.0f, 2.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 1.0f)),
+        Camera::GetProjectionMatrix(16.0f / 9.0f));
+
+    int outsideMismatches = 0, insideMismatches = 0;
+    for (size_t i = 0; i < bbMin.size(); i++) {
+        int lastPlane = -1;
+        UINT planeMask = Frustum::allPlanes;
+        CullResult result = frustum.ClassifyRectangle(bbMin[i], bbMax[i], lastPlane, planeMask);
+        outsideMismatches += (result == CullResult::Outside) == frustum.CheckRectangle(bbMin[i], bbMax[i]);
+        if (result == CullResult::Inside) {
+            // Every corner of an inside box is in front of every plane
+            const XMFLOAT4* planes = frustum.GetPlanes();
+            for (int c = 0; c < 8; c++) {
+                XMFLOAT3 corner(c & 1 ? bbMax[i].x : bbMin[i].x, c & 2 ? bbMax[i].y : bbMin[i].y, c & 4 ? bbMax[i].z : bbMin[i].z);
+                for (int p = 0; p < 6; p++) {
+                    insideMismatches += planes[p].x * corner.x + planes[p].y * corner.y + planes[p].z * corner.z + planes[p].w < -1e-4f;
+                }
+            }
+        }
+    }
+    CHECK(outsideMismatches == 0);
+    CHECK(insideMismatches == 0);
+}
+
+// The plane cached per box and the plane mask passed to children must not change the answer of CheckRectangle
+static void TestPlaneCoherency() {
+    std::mt19937 random(4);
+    std::vector<XMFLOAT4> bbMin, bbMax;
+    const int count = 3000;
+    RandomBoxes(random, count, 60.0f, 4.0f, bbMin, bbMax);
+    std::vector<int> lastPlanes(count, 0);
+    std::vector<TestCameraPoint> path = RandomCameraPath(random, 240, 50.0f);
+
+    int mismatches = 0, wrongPlanes = 0, childMismatches = 0;
+    Frustum frustum(SCREEN_NEAR);
+    for (const TestCameraPoint& point : path) {
+        frustum.ConstructFrustum(TestViewMatrix(point.eye, point.dir), Camera::GetProjectionMatrix(16.0f / 9.0f));
+        for (int i = 0; i < count; i++) {
+            UINT planeMask = Frustum::allPlanes;
+            CullResult result = frustum.ClassifyRectangle(bbMin[i], bbMax[i], lastPlanes[i], planeMask);
+            bool visible = frustum.CheckRectangle(bbMin[i], bbMax[i]);
+            mismatches += (result != CullResult::Outside) != visible;
+            if (result == CullResult::Outside) {
+                // The cached plane alone rejects the box
+                int plane = lastPlanes[i];
+                UINT onlyPlane = 1u << plane;
+                wrongPlanes += frustum.ClassifyRectangle(bbMin[i], bbMax[i], plane, onlyPlane) != CullResult::Outside;
+            }
+            else if (result == CullResult::Intersect) {
+                // Octants of the box tested against the straddled planes only
+                XMFLOAT4 center((bbMin[i].x + bbMax[i].x) * 0.5f, (bbMin[i].y + bbMax[i].y) * 0.5f,
+                    (bbMin[i].z + bbMax[i].z) * 0.5f, 1.0f);
+                for (int c = 0; c < 8; c++) {
+                    XMFLOAT4 childMin(c & 1 ? center.x : bbMin[i].x, c & 2 ? center.y : bbMin[i].y, c & 4 ? center.z : bbMin[i].z, 1.0f);
+                    XMFLOAT4 childMax(c & 1 ? bbMax[i].x : center.x, c & 2 ? bbMax[i].y : center.y, c & 4 ? bbMax[i].z : center.z, 1.0f);
+                    int childPlane = -1;
+                    UINT childMask = planeMask;
+                    bool childVisible = frustum.ClassifyRectangle(childMin, childMax, childPlane, childMask) != CullResult::Outside;
+                    childMismatches += childVisible != frustum.CheckRectangle(childMin, childMax);
+                }
+            }
+        }
+    }
+    CHECK(mismatches == 0);
+    CHECK(wrongPlanes == 0);
+    CHECK(childMismatches == 0);
+}
+
+static void TestMultiViewMatchesFrustums() {
+    std::mt19937 random(3);
+    std::vector<XMFLOAT4> bbMin, bbMax;
+    const int count = 1027;
+    RandomBoxes(random, count, 60.0f, 4.0f, bbMin, bbMax);
+    BoxStreams boxes;
+    boxes.Resize(count);
+    for (int i = 0; i < count; i++) {
+        boxes.Set(i, bbMin[i], bbMax[i]);
+    }
+
+    // The main camera with a reflection probe as in Renderer::BuildCullingViews, and every bit of the mask
+    const int viewCounts[] = { 1, 7, MultiViewFrustum::maxViews };
+    for (int viewCount : viewCounts) {
+        std::vector<Frustum> frustums(viewCount, Frustum(SCREEN_NEAR));
+        MultiViewFrustum multiView;
+        for (int v = 0; v < viewCount; v++) {
+            frustums[v].ConstructFrustum(TestViewMatrix(XMFLOAT3(0.0f, 2.0f, 0.0f), RandomDirection(random)),
+                Camera::GetProjectionMatrix(1.0f));
+            CHECK(multiView.AddView(frustums[v].GetPlanes()) == v);
+        }
+        if (viewCount == MultiViewFrustum::maxViews) {
+            CHECK(multiView.AddView(frustums[0].GetPlanes()) == -1);
+            CHECK(multiView.GetViewCount() == MultiViewFrustum::maxViews);
+        }
+
+        // Ranges that start and end inside a group of four
+        int first = viewCount % 3, rangeCount = count - first - 2;
+        std::vector<UINT> viewMasks(rangeCount, 0u);
+        multiView.CheckRectangles(boxes, first, rangeCount, viewMasks.data());
+        int mismatches = 0;
+        for (int j = 0; j < rangeCount; j++) {
+            int i = first + j;
+            for (int v = 0; v < viewCount; v++) {
+                mismatches += (((viewMasks[j] >> v) & 1u) != 0) != frustums[v].CheckRectangle(bbMin[i], bbMax[i]);
+            }
+            mismatches += viewCount < 32 && (viewMasks[j] >> viewCount) != 0;
+        }
+        CHECK(mismatches == 0);
+    }
+}
+
+int main() {
+    TestBatchMatchesScalar();
+    TestClassifyMatchesCheck();
+    TestPlaneCoherency();
+    TestMultiViewMatchesFrustums();
+    return TestResult("FrustumTests");
+}
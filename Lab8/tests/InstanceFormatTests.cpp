@@ -0,0 +1,150 @@
+#include "TestCommon.h"
+#include "InstanceFormat.h"
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+static XMFLOAT4 Components(FXMVECTOR q) {
+    XMFLOAT4 v;
+    XMStoreFloat4(&v, q);
+    return v;
+}
+
+// Largest difference between q and p or -p, both are the same rotation
+static float QuaternionError(FXMVECTOR q, FXMVECTOR p) {
+    XMFLOAT4 a = Components(q), b = Components(p);
+    float plus = max(max(fabsf(a.x - b.x), fabsf(a.y - b.y)), max(fabsf(a.z - b.z), fabsf(a.w - b.w)));
+    float minus = max(max(fabsf(a.x + b.x), fabsf(a.y + b.y)), max(fabsf(a.z + b.z), fabsf(a.w + b.w)));
+    return min(plus, minus);
+}
+
+// Zero components, as in every spin around one axis, come back as exact zeros
+static void TestZeroComponents() {
+    XMFLOAT4 identity = Components(UnpackQuaternion(PackQuaternion(XMQuaternionIdentity())));
+    CHECK(identity.x == 0.0f && identity.y == 0.0f && identity.z == 0.0f && identity.w == 1.0f);
+
+    int tilted = 0;
+    for (int i = 0; i <= 720; i++) {
+        float angle = XMConvertToRadians((float)i);
+        XMFLOAT4 y = Components(UnpackQuaternion(PackQuaternion(XMQuaternionRotationRollPitchYaw(0.0f, angle, 0.0f))));
+        XMFLOAT4 x = Components(UnpackQuaternion(PackQuaternion(XMQuaternionRotationRollPitchYaw(angle, 0.0f, 0.0f))));
+        XMFLOAT4 z = Components(UnpackQuaternion(PackQuaternion(XMQuaternionRotationRollPitchYaw(0.0f, 0.0f, angle))));
+        tilted += y.x != 0.0f || y.z != 0.0f;
+        tilted += x.y != 0.0f || x.z != 0.0f;
+        tilted += z.x != 0.0f || z.y != 0.0f;
+
+        // The axis of a Y spin stays the Y axis
+        InstanceData instance;
+        PackInstance(XMVectorSet(1.0f, 2.0f, 3.0f, 1.0f), 1.0f, XMQuaternionRotationRollPitchYaw(0.0f, angle, 0.0f), 0.0f, 0, false, instance);
+        XMFLOAT4X4 world;
+        XMStoreFloat4x4(&world, UnpackInstance(instance));
+        tilted += world._21 != 0.0f || world._22 != 1.0f || world._23 != 0.0f;
+    }
+    CHECK(tilted == 0);
+}
+
+static void TestRoundTripError() {
+    std::mt19937 random(1);
+    std::normal_distribution<float> component(0.0f, 1.0f);
+    float maxError = 0.0f;
+    int badCodes = 0;
+    for (int i = 0; i < 100000; i++) {
+        XMVECTOR q = XMQuaternionNormalize(XMVectorSet(component(random), component(random), component(random), component(random)));
+        UINT packed = PackQuaternion(q);
+        for (int shift = 0; shift <= 20; shift += 10) {
+            UINT code = (packed >> shift) & 0x3FF;
+            badCodes += code < 1;
+        }
+        maxError = max(maxError, QuaternionError(q, UnpackQuaternion(packed)));
+    }
+    CHECK(badCodes == 0);
+    CHECK(maxError <= quaternionPackError);
+
+    // Components at the edges of the stored range
+    const float edge = 0.70710678f;
+    XMVECTOR edges[] = {
+        XMVectorSet(edge, 0.0f, 0.0f, edge), XMVectorSet(-edge, 0.0f, 0.0f, edge),
+        XMVectorSet(0.5f, -0.5f, 0.5f, -0.5f), XMVectorSet(0.0f, 0.0f, 0.0f, -1.0f)
+    };
+    for (XMVECTOR q : edges) {
+        CHECK(QuaternionError(q, UnpackQuaternion(PackQuaternion(q))) <= quaternionPackError);
+    }
+}
+
+static void TestInstanceFields() {
+    InstanceData instance;
+    PackInstance(XMVectorSet(-5.5f, 0.25f, 1e4f, 1.0f), 2.5f, XMQuaternionIdentity(), 64.0f, 0x12345, true, instance);
+    CHECK(instance.posScale.x == -5.5f && instance.posScale.y == 0.25f && instance.posScale.z == 1e4f);
+    CHECK(instance.posScale.w == 2.5f);
+    CHECK(instance.material == (0x2345u | 0x10000u));
+    CHECK(instance.shine == 64.0f);
+
+    XMFLOAT4X4 world;
+    XMStoreFloat4x4(&world, UnpackInstance(instance));
+    CHECK(world._11 == 2.5f && world._22 == 2.5f && world._33 == 2.5f);
+    CHECK(world._41 == -5.5f && world._42 == 0.25f && world._43 == 1e4f && world._44 == 1.0f);
+}
+
+// The batch path packs the same bits as PackInstance and returns the matrices UnpackInstance rebuilds
+static void TestSpinInstances() {
+    std::mt19937 random(2);
+    std::uniform_real_distribution<float> position(-50.0f, 50.0f), speed(-3.0f, 3.0f);
+    const int count = 103, first = 2, rangeCount = 98;
+    std::vector<float> posX(count), posY(count), posZ(count), spin(count), shine(count);
+    std::vector<UINT> textureId(count);
+    std::vector<char> normalMap(count);
+    for (int i = 0; i < count; i++) {
+        posX[i] = position(random);
+        posY[i] = position(random);
+        posZ[i] = position(random);
+        spin[i] = speed(random);
+        shine[i] = (float)(i % 7);
+        textureId[i] = i % 3;
+        normalMap[i] = i % 2;
+    }
+
+    int codeMismatches = 0, fieldMismatches = 0, tilted = 0;
+    float maxMatrixError = 0.0f;
+    std::vector<InstanceData> instances(count);
+    std::vector<XMMATRIX> world(count);
+    for (float t : { 0.0f, 0.37f, 1.0f, 12.5f, 1000.0f }) {
+        PackSpinInstances(t, posX.data(), posY.data(), posZ.data(), spin.data(), shine.data(), textureId.data(), normalMap.data(),
+            first, rangeCount, instances.data(), world.data());
+        for (int i = first; i < first + rangeCount; i++) {
+            InstanceData expected;
+            PackInstance(XMVectorSet(posX[i], posY[i], posZ[i], 1.0f), 1.0f, XMQuaternionRotationRollPitchYaw(0.0f, t * spin[i], 0.0f),
+                shine[i], textureId[i], normalMap[i] != 0, expected);
+            // Sin and cos are evaluated differently, a component may round to the neighbouring code
+            UINT codeDifference = 0;
+            for (int shift = 0; shift <= 20; shift += 10) {
+                int a = (expected.rotation >> shift) & 0x3FF, b = (instances[i].rotation >> shift) & 0x3FF;
+                codeDifference = max(codeDifference, (UINT)abs(a - b));
+            }
+            codeMismatches += codeDifference > 1 || (codeDifference == 0 && expected.rotation >> 30 != instances[i].rotation >> 30);
+            fieldMismatches += memcmp(&expected.posScale, &instances[i].posScale, sizeof(XMFLOAT4)) != 0 ||
+                expected.material != instances[i].material || expected.shine != instances[i].shine;
+
+            XMFLOAT4X4 actual, rebuilt;
+            XMStoreFloat4x4(&actual, world[i]);
+            XMStoreFloat4x4(&rebuilt, UnpackInstance(instances[i]));
+            for (int r = 0; r < 4; r++) {
+                for (int c = 0; c < 4; c++) {
+                    maxMatrixError = max(maxMatrixError, fabsf(actual.m[r][c] - rebuilt.m[r][c]));
+                }
+            }
+            tilted += actual._21 != 0.0f || actual._22 != 1.0f || actual._23 != 0.0f;
+        }
+    }
+    CHECK(codeMismatches == 0);
+    CHECK(fieldMismatches == 0);
+    CHECK(maxMatrixError <= 1e-5f);
+    CHECK(tilted == 0);
+}
+
+int main() {
+    TestZeroComponents();
+    TestRoundTripError();
+    TestInstanceFields();
+    TestSpinInstances();
+    return TestResult("InstanceFormatTests");
+}
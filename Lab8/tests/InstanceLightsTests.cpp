@@ -0,0 +1,109 @@
+#include "TestCommon.h"
+#include "InstanceLights.h"
+#include "LightClusters.h"
+#include <algorithm>
+#include <vector>
+
+namespace {
+    // Lights without range are off
+    bool SphereTouchesBox(const XMFLOAT4& sphere, const XMFLOAT4& bbMin, const XMFLOAT4& bbMax) {
+        if (sphere.w <= 0.0f) {
+            return false;
+        }
+        float dx = max(max(bbMin.x - sphere.x, sphere.x - bbMax.x), 0.0f);
+        float dy = max(max(bbMin.y - sphere.y, sphere.y - bbMax.y), 0.0f);
+        float dz = max(max(bbMin.z - sphere.z, sphere.z - bbMax.z), 0.0f);
+        return dx * dx + dy * dy + dz * dz <= sphere.w * sphere.w;
+    }
+
+    // Instances whose list is not the set of lights touching their box
+    int CountMismatches(const InstanceLights& instanceLights, const std::vector<Light>& lights, const std::vector<XMFLOAT4>& bbMin,
+        const std::vector<XMFLOAT4>& bbMax) {
+        int mismatches = 0;
+        std::vector<UINT> list, expected;
+        for (size_t i = 0; i < bbMin.size(); i++) {
+            XMUINT2 range = instanceLights.GetRanges()[i];
+            list.assign(instanceLights.GetLightIndices().begin() + range.x, instanceLights.GetLightIndices().begin() + range.x + range.y);
+            std::sort(list.begin(), list.end());
+            expected.clear();
+            for (size_t j = 0; j < lights.size(); j++) {
+                if (SphereTouchesBox(lights[j].pos, bbMin[i], bbMax[i])) {
+                    expected.push_back((UINT)j);
+                }
+            }
+            mismatches += list != expected;
+        }
+        return mismatches;
+    }
+
+    void Build(InstanceLights& instanceLights, const std::vector<Light>& lights, const std::vector<XMFLOAT4>& bbMin,
+        const std::vector<XMFLOAT4>& bbMax) {
+        BoxStreams bounds;
+        bounds.Resize((int)bbMin.size());
+        for (size_t i = 0; i < bbMin.size(); i++) {
+            bounds.Set((int)i, bbMin[i], bbMax[i]);
+        }
+        instanceLights.Build(lights.data(), (int)lights.size(), bounds, (int)bbMin.size());
+    }
+}
+
+// Lists match the brute force ones for instances of every size, lights beyond the instances and a grid that
+// has to grow its cells to stay under maxCells
+void TestMatchesBruteForce() {
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    const float radii[] = { 5.0f, 30.0f, 2000.0f };
+    for (float radius : radii) {
+        std::vector<XMFLOAT4> bbMin, bbMax;
+        RandomBoxes(random, 3000, radius, 2.0f, bbMin, bbMax);
+        std::vector<Light> lights(300);
+        std::uniform_real_distribution<float> position(-radius * 1.2f, radius * 1.2f);
+        for (Light& light : lights) {
+            light.color = XMFLOAT4(unit(random) * 0.25f, unit(random) * 0.25f, unit(random) * 0.25f, 1.0f);
+            light.pos = XMFLOAT4(position(random), position(random), position(random), LightClusters::LightRange(light.color));
+        }
+        lights[0].pos.w = 0.0f;
+
+        InstanceLights instanceLights(4.0f);
+        Build(instanceLights, lights, bbMin, bbMax);
+        CHECK((int)instanceLights.GetRanges().size() == 3000);
+        CHECK(CountMismatches(instanceLights, lights, bbMin, bbMax) == 0);
+        int maxCount = 0;
+        for (const XMUINT2& range : instanceLights.GetRanges()) {
+            maxCount = max(maxCount, (int)range.y);
+        }
+        CHECK(instanceLights.GetMaxCount() == maxCount);
+    }
+}
+
+// A light reaching exactly to the face of a box touches it, the lists of a rebuild do not keep old entries
+void TestEdgesAndRebuild() {
+    std::vector<XMFLOAT4> bbMin = { XMFLOAT4(-1.0f, -1.0f, -1.0f, 1.0f), XMFLOAT4(10.0f, -1.0f, -1.0f, 1.0f) };
+    std::vector<XMFLOAT4> bbMax = { XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f), XMFLOAT4(12.0f, 1.0f, 1.0f, 1.0f) };
+    std::vector<Light> lights = {
+        { XMFLOAT4(3.0f, 0.0f, 0.0f, 2.0f), XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f) },
+        { XMFLOAT4(20.0f, 0.0f, 0.0f, 1.0f), XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f) }
+    };
+    InstanceLights instanceLights(4.0f);
+    Build(instanceLights, lights, bbMin, bbMax);
+    CHECK(instanceLights.GetRanges()[0].y == 1);
+    CHECK(instanceLights.GetRanges()[1].y == 0);
+    CHECK(CountMismatches(instanceLights, lights, bbMin, bbMax) == 0);
+
+    lights[1].pos = XMFLOAT4(11.0f, 0.0f, 0.0f, 0.5f);
+    Build(instanceLights, lights, bbMin, bbMax);
+    CHECK(instanceLights.GetLightIndices().size() == 2);
+    CHECK(CountMismatches(instanceLights, lights, bbMin, bbMax) == 0);
+
+    bbMin.clear();
+    bbMax.clear();
+    Build(instanceLights, lights, bbMin, bbMax);
+    CHECK(instanceLights.GetRanges().empty());
+    CHECK(instanceLights.GetLightIndices().empty());
+}
+
+int main() {
+    TestMatchesBruteForce();
+    TestEdgesAndRebuild();
+    return TestResult("InstanceLightsTests");
+}
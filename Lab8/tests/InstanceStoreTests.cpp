@@ -0,0 +1,168 @@
+#include "TestCommon.h"
+#include "InstanceStore.h"
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+static const XMFLOAT4 localMin(-1.0f, -1.0f, -1.0f, 1.0f);
+static const XMFLOAT4 localMax(1.0f, 1.0f, 1.0f, 1.0f);
+
+static InstanceDesc RandomDesc(std::mt19937& random) {
+    std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+    return { XMFLOAT3(position(random), position(random), position(random)), (float)(random() % 3), 5.0f,
+        (UINT)(random() % 2), random() % 2 == 0 };
+}
+
+static bool Aligned(const void* p) {
+    return ((uintptr_t)p & 15) == 0;
+}
+
+// Handles keep pointing at their instance through removals, stale handles are rejected even when their slot is reused
+static void TestHandles() {
+    std::mt19937 random(1);
+    InstanceStore store;
+    std::vector<InstanceHandle> handles;
+    std::vector<XMFLOAT3> positions;
+    for (int i = 0; i < 1000; i++) {
+        InstanceDesc desc = RandomDesc(random);
+        handles.push_back(store.Add(desc));
+        positions.push_back(desc.pos);
+    }
+
+    std::vector<InstanceHandle> removed;
+    for (int i = 0; i < 400; i++) {
+        size_t pos = (size_t)random() % handles.size();
+        int last = store.Size() - 1;
+        int index = store.GetIndex(handles[pos]);
+        int moved = store.Remove(handles[pos]);
+        CHECK(moved == (index != last ? index : -1));
+        removed.push_back(handles[pos]);
+        handles[pos] = handles.back();
+        handles.pop_back();
+        positions[pos] = positions.back();
+        positions.pop_back();
+    }
+    CHECK(store.Size() == 600);
+
+    int wrongPositions = 0, wrongHandles = 0;
+    for (size_t i = 0; i < handles.size(); i++) {
+        int index = store.GetIndex(handles[i]);
+        XMFLOAT3 pos = store.GetPosition(index);
+        wrongPositions += pos.x != positions[i].x || pos.y != positions[i].y || pos.z != positions[i].z;
+        InstanceHandle back = store.GetHandle(index);
+        wrongHandles += back.slot != handles[i].slot || back.generation != handles[i].generation;
+    }
+    CHECK(wrongPositions == 0);
+    CHECK(wrongHandles == 0);
+
+    // Freed slots are reused with a new generation
+    for (int i = 0; i < 400; i++) {
+        store.Add(RandomDesc(random));
+    }
+    int staleValid = 0;
+    for (const InstanceHandle& handle : removed) {
+        staleValid += store.IsValid(handle);
+        CHECK(store.Remove(handle) == -1);
+    }
+    CHECK(staleValid == 0);
+    CHECK(store.Size() == 1000);
+
+    store.Clear();
+    CHECK(store.Size() == 0);
+    CHECK(!store.IsValid(handles[0]));
+}
+
+// The moved instance carries its derived columns and is uploaded again at its new index
+static void TestRemoveMovesColumns() {
+    std::mt19937 random(2);
+    InstanceStore store;
+    std::vector<InstanceHandle> handles;
+    for (int i = 0; i < 64; i++) {
+        handles.push_back(store.Add(RandomDesc(random)));
+    }
+    store.UpdateTransforms(1.0f, 0, store.Size());
+    store.UpdateBounds(localMin, localMax, 0, store.Size());
+    store.ClearDirty(0, store.Size());
+
+    InstanceHandle lastHandle = store.GetHandle(store.Size() - 1);
+    XMMATRIX lastWorld = store.GetWorld()[store.Size() - 1];
+    InstanceData lastInstance = store.GetInstances()[store.Size() - 1];
+    XMFLOAT4 lastMin = store.GetBoundsMin()[store.Size() - 1];
+    XMFLOAT4 lastMax = store.GetBoundsMax()[store.Size() - 1];
+
+    int moved = store.Remove(handles[5]);
+    CHECK(moved == 5);
+    CHECK(store.GetIndex(lastHandle) == 5);
+    CHECK(store.GetDirty()[5] == 1);
+    int otherDirty = 0;
+    for (int i = 0; i < store.Size(); i++) {
+        otherDirty += i != 5 && store.GetDirty()[i];
+    }
+    CHECK(otherDirty == 0);
+    CHECK(memcmp(&store.GetWorld()[5], &lastWorld, sizeof(XMMATRIX)) == 0);
+    CHECK(memcmp(&store.GetInstances()[5], &lastInstance, sizeof(InstanceData)) == 0);
+    CHECK(store.GetBoundsMin()[5].x == lastMin.x && store.GetBoundsMax()[5].z == lastMax.z);
+    const BoxStreams& bounds = store.GetBounds();
+    CHECK(bounds.minX[5] == lastMin.x && bounds.maxY[5] == lastMax.y);
+}
+
+// Only spinning and dirty instances are rebuilt, and both bounds layouts match the corners of the world box
+static void TestUpdates() {
+    std::mt19937 random(3);
+    InstanceStore store;
+    std::vector<InstanceDesc> descs;
+    for (int i = 0; i < 500; i++) {
+        descs.push_back(RandomDesc(random));
+        store.Add(descs.back());
+    }
+    store.UpdateTransforms(0.5f, 0, store.Size());
+    store.UpdateBounds(localMin, localMax, 0, store.Size());
+
+    int boundsMismatches = 0;
+    const BoxStreams& bounds = store.GetBounds();
+    for (int i = 0; i < store.Size(); i++) {
+        XMFLOAT4 bbMin, bbMax;
+        CornerAABB(localMin, localMax, store.GetWorld()[i], bbMin, bbMax);
+        boundsMismatches += fabsf(bbMin.x - store.GetBoundsMin()[i].x) > 1e-4f || fabsf(bbMax.y - store.GetBoundsMax()[i].y) > 1e-4f;
+        boundsMismatches += bounds.minZ[i] != store.GetBoundsMin()[i].z || bounds.maxX[i] != store.GetBoundsMax()[i].x;
+    }
+    CHECK(boundsMismatches == 0);
+
+    store.ClearDirty(0, store.Size());
+    store.UpdateTransforms(1.0f, 0, store.Size());
+    int wrongDirty = 0;
+    for (int i = 0; i < store.Size(); i++) {
+        wrongDirty += (descs[i].spin != 0.0f) != (store.GetDirty()[i] != 0);
+    }
+    CHECK(wrongDirty == 0);
+
+    store.MarkAllDirty();
+    int clean = 0;
+    for (int i = 0; i < store.Size(); i++) {
+        clean += !store.GetDirty()[i];
+    }
+    CHECK(clean == 0);
+}
+
+// The columns the SIMD passes load start on 16 bytes
+static void TestAlignment() {
+    std::mt19937 random(4);
+    InstanceStore store;
+    for (int i = 0; i < 37; i++) {
+        store.Add(RandomDesc(random));
+    }
+    const BoxStreams& bounds = store.GetBounds();
+    CHECK(Aligned(store.GetWorld()));
+    CHECK(Aligned(store.GetBoundsMin()));
+    CHECK(Aligned(store.GetBoundsMax()));
+    CHECK(Aligned(bounds.minX.data()) && Aligned(bounds.minY.data()) && Aligned(bounds.minZ.data()));
+    CHECK(Aligned(bounds.maxX.data()) && Aligned(bounds.maxY.data()) && Aligned(bounds.maxZ.data()));
+}
+
+int main() {
+    TestHandles();
+    TestRemoveMovesColumns();
+    TestUpdates();
+    TestAlignment();
+    return TestResult("InstanceStoreTests");
+}
@@ -0,0 +1,97 @@
+#include "TestCommon.h"
+#include "JobSystem.h"
+#include <atomic>
+#include <vector>
+
+// Every index is visited exactly once, by a worker in range, whatever the count and chunk size
+static void TestCoversRange(JobSystem& jobs) {
+    const int counts[] = { 1, 7, 64, 1000, 100003 };
+    const int chunkSizes[] = { 0, 1, 13, 256, 200000 };
+    for (int count : counts) {
+        for (int chunkSize : chunkSizes) {
+            std::vector<std::atomic<int>> visits(count);
+            for (auto& visit : visits) {
+                visit = 0;
+            }
+            std::atomic<int> badWorkers(0), badRanges(0);
+            jobs.ParallelFor(count, chunkSize, [&](int begin, int end, int worker) {
+                badWorkers += worker < 0 || worker >= jobs.GetWorkerCount();
+                badRanges += begin < 0 || end > count || begin >= end || (chunkSize > 0 && end - begin > chunkSize);
+                for (int i = begin; i < end; i++) {
+                    visits[i]++;
+                }
+            });
+
+            int wrongVisits = 0;
+            for (auto& visit : visits) {
+                wrongVisits += visit != 1;
+            }
+            CHECK(wrongVisits == 0);
+            CHECK(badWorkers == 0);
+            CHECK(badRanges == 0);
+        }
+    }
+}
+
+static void TestEmptyRange(JobSystem& jobs) {
+    int calls = 0;
+    jobs.ParallelFor(0, 16, [&](int, int, int) { calls++; });
+    jobs.ParallelFor(-5, 16, [&](int, int, int) { calls++; });
+    CHECK(calls == 0);
+}
+
+// Per-worker partial sums merged after the call, the way the renderer merges per-chunk visible counts
+static void TestPerWorkerSums(JobSystem& jobs) {
+    const int count = 1 << 20;
+    std::vector<long long> sums(jobs.GetWorkerCount(), 0);
+    for (int repeat = 0; repeat < 20; repeat++) {
+        std::fill(sums.begin(), sums.end(), 0);
+        jobs.ParallelFor(count, 4096, [&](int begin, int end, int worker) {
+            long long sum = 0;
+            for (int i = begin; i < end; i++) {
+                sum += i;
+            }
+            sums[worker] += sum;
+        });
+        long long total = 0;
+        for (long long sum : sums) {
+            total += sum;
+        }
+        CHECK(total == (long long)count * (count - 1) / 2);
+    }
+}
+
+// Uneven chunks: workers that run out of their own jobs steal the rest, so the call still finishes
+static void TestUnevenChunks(JobSystem& jobs) {
+    std::atomic<long long> total(0);
+    jobs.ParallelFor(64, 1, [&](int begin, int end, int) {
+        volatile long long sum = 0;
+        for (int i = 0; i < (begin % 8 == 0 ? 2000000 : 1000); i++) {
+            sum += i;
+        }
+        total += end - begin;
+    });
+    CHECK(total == 64);
+}
+
+int main() {
+    JobSystem single(1);
+    CHECK(single.GetWorkerCount() == 1);
+    TestCoversRange(single);
+    TestEmptyRange(single);
+    TestPerWorkerSums(single);
+
+    // More workers than cores exercises the stealing even on small machines
+    JobSystem many(8);
+    CHECK(many.GetWorkerCount() == 8);
+    TestCoversRange(many);
+    TestEmptyRange(many);
+    TestPerWorkerSums(many);
+    TestUnevenChunks(many);
+
+    JobSystem hardware;
+    CHECK(hardware.GetWorkerCount() >= 1);
+    TestPerWorkerSums(hardware);
+
+    return TestResult("JobSystemTests");
+}
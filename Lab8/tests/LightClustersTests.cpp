@@ -0,0 +1,123 @@
+#include "TestCommon.h"
+#include "LightClusters.h"
+#include "Macros.h"
+#include <algorithm>
+#include <vector>
+
+namespace {
+    std::vector<Light> RandomLights(std::mt19937& random, int count, float radius) {
+        std::uniform_real_distribution<float> position(-radius, radius);
+        std::uniform_real_distribution<float> brightness(0.0f, 0.05f);
+        std::vector<Light> lights(count);
+        for (Light& light : lights) {
+            light.color = XMFLOAT4(brightness(random), brightness(random), brightness(random), 1.0f);
+            light.pos = XMFLOAT4(position(random), position(random), position(random), LightClusters::LightRange(light.color));
+        }
+        return lights;
+    }
+
+    // World position of the pixel (u, v) at a view depth, the inverse of what PS.hlsl does to find its cluster
+    XMFLOAT3 UnprojectPoint(FXMMATRIX inverseView, float tanHalfX, float tanHalfY, float u, float v, float depth) {
+        XMVECTOR viewPoint = XMVectorSet((u * 2.0f - 1.0f) * tanHalfX * depth, (1.0f - v * 2.0f) * tanHalfY * depth, depth, 1.0f);
+        XMFLOAT3 point;
+        XMStoreFloat3(&point, XMVector3TransformCoord(viewPoint, inverseView));
+        return point;
+    }
+}
+
+// Every light that reaches a point is in the cluster of the point, for points all over the frustum
+void TestNoMissingLights() {
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::uniform_real_distribution<float> aspect(0.5f, 2.5f);
+    LightClusters clusters(CLUSTER_X, CLUSTER_Y, CLUSTER_Z);
+
+    UINT64 pairs = 0;
+    int missing = 0;
+    for (int view = 0; view < 10; view++) {
+        std::vector<Light> lights = RandomLights(random, 1000, 30.0f);
+        XMMATRIX viewMatrix = TestViewMatrix(XMFLOAT3(0.0f, 0.0f, 0.0f), RandomDirection(random));
+        float viewAspect = aspect(random);
+        clusters.SetView(viewMatrix, XM_PI / 3, viewAspect, SCREEN_NEAR, SCREEN_FAR);
+        clusters.Build(lights.data(), (int)lights.size());
+
+        const std::vector<XMUINT2>& ranges = clusters.GetRanges();
+        const std::vector<UINT>& indices = clusters.GetLightIndices();
+        CHECK((int)ranges.size() == CLUSTER_X * CLUSTER_Y * CLUSTER_Z);
+        for (const XMUINT2& range : ranges) {
+            CHECK(range.x + range.y <= indices.size());
+            CHECK(std::is_sorted(indices.begin() + range.x, indices.begin() + range.x + range.y));
+        }
+
+        XMMATRIX inverseView = XMMatrixInverse(nullptr, viewMatrix);
+        float tanHalfY = tanf(XM_PI / 6);
+        for (int p = 0; p < 2000; p++) {
+            float u = unit(random), v = unit(random);
+            // Log-uniform depths put the same number of points in every slice
+            float depth = SCREEN_NEAR * powf(SCREEN_FAR / SCREEN_NEAR, unit(random) * 0.999f);
+            XMFLOAT3 point = UnprojectPoint(inverseView, tanHalfY * viewAspect, tanHalfY, u, v, depth);
+            int cluster = clusters.FindCluster(depth, u, v);
+            CHECK(cluster >= 0);
+            if (cluster < 0) {
+                continue;
+            }
+            const XMUINT2& range = ranges[cluster];
+            for (UINT i = 0; i < lights.size(); i++) {
+                float dx = lights[i].pos.x - point.x, dy = lights[i].pos.y - point.y, dz = lights[i].pos.z - point.z;
+                if (dx * dx + dy * dy + dz * dz > lights[i].pos.w * lights[i].pos.w) {
+                    continue;
+                }
+                pairs++;
+                missing += !std::binary_search(indices.begin() + range.x, indices.begin() + range.x + range.y, i);
+            }
+        }
+    }
+    CHECK(pairs > 0);
+    CHECK(missing == 0);
+}
+
+// Only the given ids are binned, lights without range are skipped
+void TestIdsAndRanges() {
+    std::mt19937 random(2);
+    LightClusters clusters(CLUSTER_X, CLUSTER_Y, CLUSTER_Z);
+    clusters.SetView(TestViewMatrix(XMFLOAT3(0.0f, 0.0f, -5.0f), XMFLOAT3(0.0f, 0.0f, 1.0f)), XM_PI / 3, 16.0f / 9.0f,
+        SCREEN_NEAR, SCREEN_FAR);
+    std::vector<Light> lights = RandomLights(random, 200, 5.0f);
+    lights[7].pos.w = 0.0f;
+    std::vector<int> ids;
+    for (int i = 1; i < 200; i += 2) {
+        ids.push_back(i);
+    }
+    clusters.Build(lights.data(), (int)ids.size(), ids.data());
+    std::vector<char> seen(lights.size(), 0);
+    for (UINT light : clusters.GetLightIndices()) {
+        seen[light] = 1;
+    }
+    int evenLights = 0;
+    for (size_t i = 0; i < seen.size(); i += 2) {
+        evenLights += seen[i];
+    }
+    CHECK(evenLights == 0);
+    CHECK(!seen[7]);
+    CHECK(!clusters.GetLightIndices().empty());
+
+    // Behind the camera or beyond the far plane
+    Light behind = { XMFLOAT4(0.0f, 0.0f, -20.0f, 2.0f), XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f) };
+    Light far = { XMFLOAT4(0.0f, 0.0f, SCREEN_FAR + 10.0f, 2.0f), XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f) };
+    Light outside[2] = { behind, far };
+    clusters.Build(outside, 2);
+    CHECK(clusters.GetLightIndices().empty());
+    CHECK(clusters.FindCluster(SCREEN_NEAR * 0.5f, 0.5f, 0.5f) == -1);
+    CHECK(clusters.FindCluster(SCREEN_FAR, 0.5f, 0.5f) == -1);
+
+    // At the range the diffuse term of the brightest channel is 1/256
+    XMFLOAT4 color(0.5f, 2.0f, 1.0f, 1.0f);
+    float range = LightClusters::LightRange(color);
+    CHECK_NEAR(2.0f / (range * range), 1.0f / 256.0f, 1e-6f);
+}
+
+int main() {
+    TestNoMissingLights();
+    TestIdsAndRanges();
+    return TestResult("LightClustersTests");
+}
@@ -0,0 +1,161 @@
+#include "TestCommon.h"
+#include "LightManager.h"
+#include "Macros.h"
+#include <algorithm>
+#include <vector>
+
+namespace {
+    Light RandomLight(std::mt19937& random, float radius) {
+        std::uniform_real_distribution<float> position(-radius, radius);
+        std::uniform_real_distribution<float> range(0.5f, 4.0f);
+        Light light;
+        light.pos = XMFLOAT4(position(random), position(random), position(random), range(random));
+        light.color = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+        return light;
+    }
+
+    // Indices covered by the runs, each one at most once
+    std::vector<int> RunIndices(const std::vector<XMUINT2>& runs) {
+        std::vector<int> indices;
+        for (const XMUINT2& run : runs) {
+            for (UINT i = 0; i < run.y; i++) {
+                indices.push_back((int)(run.x + i));
+            }
+        }
+        return indices;
+    }
+
+    bool SphereTouchesBox(const XMFLOAT4& sphere, const XMFLOAT4& bbMin, const XMFLOAT4& bbMax) {
+        float dx = max(max(bbMin.x - sphere.x, sphere.x - bbMax.x), 0.0f);
+        float dy = max(max(bbMin.y - sphere.y, sphere.y - bbMax.y), 0.0f);
+        float dz = max(max(bbMin.z - sphere.z, sphere.z - bbMax.z), 0.0f);
+        return dx * dx + dy * dy + dz * dz <= sphere.w * sphere.w;
+    }
+}
+
+// Box and frustum queries find what testing every light finds, after moves, range changes and removals
+void TestQueriesMatchBruteForce() {
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> position(-20.0f, 20.0f);
+    std::uniform_real_distribution<float> step(-1.0f, 1.0f);
+    LightManager manager(32.0f);
+    for (int i = 0; i < 2000; i++) {
+        manager.Add(RandomLight(random, 30.0f));
+    }
+    for (int round = 0; round < 5; round++) {
+        for (int i = 0; i < 300; i++) {
+            int index = (int)(random() % (UINT)manager.Size());
+            const XMFLOAT4& pos = manager.Get(index).pos;
+            manager.SetPosition(index, XMFLOAT3(pos.x + step(random), pos.y + step(random), pos.z + step(random)));
+            manager.SetRange((int)(random() % (UINT)manager.Size()), 0.5f + fabsf(step(random)) * 3.0f);
+        }
+        for (int i = 0; i < 100; i++) {
+            manager.Remove((int)(random() % (UINT)manager.Size()));
+        }
+
+        std::vector<int> ids(manager.Size());
+        for (int q = 0; q < 50; q++) {
+            XMFLOAT4 bbMin(position(random), position(random), position(random), 1.0f);
+            XMFLOAT4 bbMax(bbMin.x + 4.0f, bbMin.y + 4.0f, bbMin.z + 4.0f, 1.0f);
+            int count = manager.QueryBox(bbMin, bbMax, ids.data());
+            std::sort(ids.begin(), ids.begin() + count);
+            std::vector<int> expected;
+            for (int i = 0; i < manager.Size(); i++) {
+                if (SphereTouchesBox(manager.Get(i).pos, bbMin, bbMax)) {
+                    expected.push_back(i);
+                }
+            }
+            CHECK(std::equal(expected.begin(), expected.end(), ids.begin(), ids.begin() + count) && (int)expected.size() == count);
+        }
+
+        Frustum frustum(SCREEN_NEAR);
+        frustum.ConstructFrustum(TestViewMatrix(XMFLOAT3(0.0f, 0.0f, -25.0f), RandomDirection(random)), Camera::GetProjectionMatrix(16.0f / 9.0f));
+        int count = manager.QueryFrustum(frustum, ids.data());
+        std::sort(ids.begin(), ids.begin() + count);
+        int expected = 0, missing = 0;
+        for (int i = 0; i < manager.Size(); i++) {
+            const XMFLOAT4& pos = manager.Get(i).pos;
+            XMFLOAT4 bbMin(pos.x - pos.w, pos.y - pos.w, pos.z - pos.w, 1.0f), bbMax(pos.x + pos.w, pos.y + pos.w, pos.z + pos.w, 1.0f);
+            if (frustum.CheckRectangle(bbMin, bbMax)) {
+                expected++;
+                missing += !std::binary_search(ids.begin(), ids.begin() + count, i);
+            }
+        }
+        CHECK(count == expected && missing == 0);
+    }
+}
+
+// Runs cover each changed light once and nothing past the end, also when a dirty light is removed and another
+// one is added at its index before the runs are taken
+void TestDirtyRuns() {
+    std::mt19937 random(2);
+    LightManager manager(32.0f);
+    for (int i = 0; i < 10; i++) {
+        manager.Add(RandomLight(random, 10.0f));
+    }
+    std::vector<XMUINT2> runs;
+    manager.TakeDirtyRuns(runs);
+    CHECK(runs.size() == 1 && runs[0].x == 0 && runs[0].y == 10);
+
+    runs.clear();
+    manager.TakeDirtyRuns(runs);
+    CHECK(runs.empty());
+
+    manager.SetColor(3, XMFLOAT4(0.5f, 0.5f, 0.5f, 1.0f));
+    manager.SetRange(4, 2.0f);
+    manager.SetPosition(8, XMFLOAT3(1.0f, 2.0f, 3.0f));
+    manager.SetPosition(3, XMFLOAT3(1.0f, 2.0f, 3.0f));
+    runs.clear();
+    manager.TakeDirtyRuns(runs);
+    CHECK(runs.size() == 2 && runs[0].x == 3 && runs[0].y == 2 && runs[1].x == 8 && runs[1].y == 1);
+
+    manager.SetColor(9, XMFLOAT4(0.5f, 0.5f, 0.5f, 1.0f));
+    manager.Remove(9);
+    manager.Add(RandomLight(random, 10.0f));
+    manager.SetColor(9, XMFLOAT4(0.25f, 0.25f, 0.25f, 1.0f));
+    manager.Remove(2);
+    runs.clear();
+    manager.TakeDirtyRuns(runs);
+    std::vector<int> indices = RunIndices(runs);
+    CHECK(indices == std::vector<int>({ 2 }));
+
+    manager.Remove(8);
+    manager.Remove(7);
+    runs.clear();
+    manager.TakeDirtyRuns(runs);
+    CHECK(runs.empty());
+
+    manager.MarkAllDirty();
+    runs.clear();
+    manager.TakeDirtyRuns(runs);
+    CHECK(runs.size() == 1 && runs[0].x == 0 && (int)runs[0].y == manager.Size());
+
+    manager.Clear();
+    runs.clear();
+    manager.TakeDirtyRuns(runs);
+    CHECK(runs.empty() && manager.Size() == 0);
+}
+
+// A dirty light removed and added again many times over stays a single entry of a single run
+void TestReaddedIndexListedOnce() {
+    std::mt19937 random(3);
+    LightManager manager(32.0f);
+    for (int i = 0; i < 4; i++) {
+        manager.Add(RandomLight(random, 10.0f));
+    }
+    for (int i = 0; i < 100; i++) {
+        manager.Remove(3);
+        manager.Add(RandomLight(random, 10.0f));
+    }
+    std::vector<XMUINT2> runs;
+    manager.TakeDirtyRuns(runs);
+    std::vector<int> indices = RunIndices(runs);
+    CHECK(indices == std::vector<int>({ 0, 1, 2, 3 }));
+}
+
+int main() {
+    TestQueriesMatchBruteForce();
+    TestDirtyRuns();
+    TestReaddedIndexListedOnce();
+    return TestResult("LightManagerTests");
+}
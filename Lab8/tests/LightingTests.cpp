@@ -0,0 +1,103 @@
+#include "TestCommon.h"
+#include "Lighting.h"
+#include <vector>
+
+namespace {
+    std::vector<Light> RandomLights(std::mt19937& random, int count) {
+        std::uniform_real_distribution<float> position(-6.0f, 6.0f);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        std::vector<Light> lights(count);
+        for (Light& light : lights) {
+            light.color = XMFLOAT4(unit(random), unit(random), unit(random), 1.0f);
+            light.pos = XMFLOAT4(position(random), position(random), position(random), 4.0f + unit(random) * 12.0f);
+        }
+        return lights;
+    }
+
+    ShadingSamples RandomSamples(std::mt19937& random) {
+        std::uniform_real_distribution<float> position(-6.0f, 6.0f);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        std::uniform_real_distribution<float> shine(0.0f, 64.0f);
+        ShadingSamples samples;
+        for (int j = 0; j < ShadingSamples::count; j++) {
+            XMFLOAT3 normal;
+            XMStoreFloat3(&normal, XMVector3Normalize(XMVectorSet(unit(random) - 0.5f, unit(random) - 0.5f, unit(random) - 0.5f, 0.0f)));
+            samples.posX[j] = position(random);
+            samples.posY[j] = position(random);
+            samples.posZ[j] = position(random);
+            samples.normalX[j] = normal.x;
+            samples.normalY[j] = normal.y;
+            samples.normalZ[j] = normal.z;
+            samples.colorR[j] = unit(random);
+            samples.colorG[j] = unit(random);
+            samples.colorB[j] = unit(random);
+            // Materials without specular next to shiny ones in the same packet
+            samples.shine[j] = (j & 1) ? 0.0f : shine(random);
+        }
+        return samples;
+    }
+
+    // Largest channel difference of CalculateColor8 from CalculateColor, divided by max(1, channel)
+    float MaxError(const LightingParams& params, const ShadingSamples& samples, bool transparent) {
+        ShadedColors colors;
+        CalculateColor8(params, samples, transparent, colors);
+        float maxError = 0.0f;
+        for (int j = 0; j < ShadingSamples::count; j++) {
+            XMFLOAT3 expected = CalculateColor(params, XMFLOAT3(samples.colorR[j], samples.colorG[j], samples.colorB[j]),
+                XMFLOAT3(samples.normalX[j], samples.normalY[j], samples.normalZ[j]), XMFLOAT3(samples.posX[j], samples.posY[j], samples.posZ[j]),
+                samples.shine[j], transparent);
+            maxError = max(maxError, fabsf(colors.r[j] - expected.x) / max(1.0f, fabsf(expected.x)));
+            maxError = max(maxError, fabsf(colors.g[j] - expected.y) / max(1.0f, fabsf(expected.y)));
+            maxError = max(maxError, fabsf(colors.b[j] - expected.z) / max(1.0f, fabsf(expected.z)));
+        }
+        return maxError;
+    }
+}
+
+// The packet path follows the scalar one for opaque and transparent samples, any light count and the normals view
+void TestPacketMatchesScalar() {
+    std::mt19937 random(1);
+    const int lightCounts[] = { 0, 1, 7, 64, 256 };
+    for (int lightCount : lightCounts) {
+        std::vector<Light> lights = RandomLights(random, lightCount);
+        LightingParams params = { XMFLOAT3(0.0f, 2.0f, -12.0f), lightCount, false, lights.data() };
+        float maxError = 0.0f;
+        for (int p = 0; p < 500; p++) {
+            ShadingSamples samples = RandomSamples(random);
+            maxError = max(maxError, MaxError(params, samples, false));
+            maxError = max(maxError, MaxError(params, samples, true));
+        }
+        CHECK_NEAR(maxError, 0.0f, 1e-5f);
+
+        params.showNormals = true;
+        CHECK(MaxError(params, RandomSamples(random), false) == 0.0f);
+    }
+}
+
+// One light in front of a surface: diffuse color * cos / d^2 inside the range window, nothing beyond the range
+void TestKnownValues() {
+    Light light = { XMFLOAT4(0.0f, 2.0f, 0.0f, 8.0f), XMFLOAT4(1.0f, 0.5f, 0.25f, 1.0f) };
+    LightingParams params = { XMFLOAT3(0.0f, 10.0f, 10.0f), 1, false, &light };
+    XMFLOAT3 color = CalculateColor(params, XMFLOAT3(1.0f, 1.0f, 1.0f), XMFLOAT3(0.0f, 1.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 0.0f), 0.0f, false);
+    float ratio = 2.0f / 8.0f;
+    float window = (1.0f - ratio * ratio * ratio * ratio) * (1.0f - ratio * ratio * ratio * ratio);
+    CHECK_NEAR(color.x, 0.25f * window, 1e-6f);
+    CHECK_NEAR(color.y, 0.125f * window, 1e-6f);
+    CHECK_NEAR(color.z, 0.0625f * window, 1e-6f);
+
+    // Lit from behind: opaque surfaces stay dark, transparent ones flip the normal
+    color = CalculateColor(params, XMFLOAT3(1.0f, 1.0f, 1.0f), XMFLOAT3(0.0f, -1.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 0.0f), 0.0f, false);
+    CHECK(color.x == 0.0f);
+    color = CalculateColor(params, XMFLOAT3(1.0f, 1.0f, 1.0f), XMFLOAT3(0.0f, -1.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 0.0f), 0.0f, true);
+    CHECK_NEAR(color.x, 0.25f * window, 1e-6f);
+
+    light.pos.w = 1.5f;
+    color = CalculateColor(params, XMFLOAT3(1.0f, 1.0f, 1.0f), XMFLOAT3(0.0f, 1.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 0.0f), 32.0f, false);
+    CHECK(color.x == 0.0f && color.y == 0.0f && color.z == 0.0f);
+}
+
+int main() {
+    TestPacketMatchesScalar();
+    TestKnownValues();
+    return TestResult("LightingTests");
+}
@@ -0,0 +1,133 @@
+#include "TestCommon.h"
+#include "OcclusionCulling.h"
+#include <vector>
+
+// Dense grids of unit cubes like the renderer draws them: the local box [-1, 1] translated to the cube center
+static const XMFLOAT4 localMin(-1.0f, -1.0f, -1.0f, 1.0f);
+static const XMFLOAT4 localMax(1.0f, 1.0f, 1.0f, 1.0f);
+
+struct GridScene {
+    std::vector<XMFLOAT3> centers;
+    std::vector<int> layers; // 0 - the front layer, rendered as occluders
+};
+
+// side x side columns of touching cubes, layers deep along +z starting at z = 0
+static GridScene DenseGrid(int side, int layers) {
+    GridScene scene;
+    for (int z = 0; z < layers; z++) {
+        for (int y = 0; y < side; y++) {
+            for (int x = 0; x < side; x++) {
+                scene.centers.push_back(XMFLOAT3(2.0f * x - side + 1.0f, 2.0f * y - side + 1.0f, 2.0f * z));
+                scene.layers.push_back(z);
+            }
+        }
+    }
+    return scene;
+}
+
+static bool TestCube(OcclusionCuller& culler, const XMFLOAT3& center) {
+    XMFLOAT4 bbMin(center.x - 1.0f, center.y - 1.0f, center.z - 1.0f, 1.0f);
+    XMFLOAT4 bbMax(center.x + 1.0f, center.y + 1.0f, center.z + 1.0f, 1.0f);
+    return culler.TestRectangle(bbMin, bbMax);
+}
+
+static void RenderFrontLayer(OcclusionCuller& culler, const GridScene& scene, const XMFLOAT3& eye, const XMFLOAT3& dir) {
+    culler.Clear();
+    culler.SetViewProjection(XMMatrixMultiply(TestViewMatrix(eye, dir),
+        Camera::GetProjectionMatrix((float)OCCLUSION_WIDTH / OCCLUSION_HEIGHT)));
+    for (size_t i = 0; i < scene.centers.size(); i++) {
+        if (scene.layers[i] == 0) {
+            const XMFLOAT3& c = scene.centers[i];
+            culler.RenderBox(XMMatrixTranslation(c.x, c.y, c.z), localMin, localMax);
+        }
+    }
+    culler.BuildHierarchy();
+}
+
+// Straight in front of the wall every cube behind it is hidden, the occluders and the cubes in front or beside stay
+static void TestDenseGridHidden() {
+    GridScene scene = DenseGrid(8, 8);
+    OcclusionCuller culler(OCCLUSION_WIDTH, OCCLUSION_HEIGHT);
+    RenderFrontLayer(culler, scene, XMFLOAT3(0.0f, 0.0f, -20.0f), XMFLOAT3(0.0f, 0.0f, 1.0f));
+
+    int frontRejected = 0, hidden = 0, behind = 0;
+    for (size_t i = 0; i < scene.centers.size(); i++) {
+        bool visible = TestCube(culler, scene.centers[i]);
+        if (scene.layers[i] == 0) {
+            frontRejected += !visible;
+        }
+        else {
+            behind++;
+            hidden += !visible;
+        }
+    }
+    CHECK(frontRejected == 0);
+    CHECK(hidden == behind);
+    printf("straight: %d of %d cubes behind the front layer occluded\n", hidden, behind);
+
+    CHECK(TestCube(culler, XMFLOAT3(0.0f, 0.0f, -4.0f)));
+    CHECK(TestCube(culler, XMFLOAT3(14.0f, 0.0f, 0.0f)));
+    CHECK(TestCube(culler, XMFLOAT3(0.0f, 12.0f, 6.0f)));
+}
+
+// From an oblique eye the sides of the back layers show past the wall: the culler stays conservative and still
+// rejects most of the grid
+static void TestDenseGridOblique() {
+    GridScene scene = DenseGrid(8, 8);
+    OcclusionCuller culler(OCCLUSION_WIDTH, OCCLUSION_HEIGHT);
+    // Looking at the middle of the grid
+    XMFLOAT3 eye(12.0f, 8.0f, -20.0f);
+    XMFLOAT3 dir;
+    XMStoreFloat3(&dir, XMVector3Normalize(XMVectorSet(-eye.x, -eye.y, 7.0f - eye.z, 0.0f)));
+    RenderFrontLayer(culler, scene, eye, dir);
+
+    int frontRejected = 0, hidden = 0, behind = 0, peeking = 0, wrongHidden = 0;
+    for (size_t i = 0; i < scene.centers.size(); i++) {
+        const XMFLOAT3& c = scene.centers[i];
+        bool visible = TestCube(culler, c);
+        if (scene.layers[i] == 0) {
+            frontRejected += !visible;
+            continue;
+        }
+        behind++;
+        hidden += !visible;
+
+        // A cube is surely visible if the ray from the eye to one of its near corners passes outside the wall
+        bool outsideWall = false;
+        for (int corner = 0; corner < 4 && !outsideWall; corner++) {
+            XMFLOAT3 p(c.x + (corner & 1 ? 1.0f : -1.0f), c.y + (corner & 2 ? 1.0f : -1.0f), c.z - 1.0f);
+            float s = (-1.0f - eye.z) / (p.z - eye.z);
+            float x = eye.x + (p.x - eye.x) * s, y = eye.y + (p.y - eye.y) * s;
+            outsideWall = fabsf(x) > 8.5f || fabsf(y) > 8.5f;
+        }
+        peeking += outsideWall;
+        wrongHidden += outsideWall && !visible;
+    }
+    CHECK(frontRejected == 0);
+    CHECK(peeking > 0);
+    CHECK(wrongHidden == 0);
+    CHECK(hidden * 2 > behind);
+    printf("oblique: %d of %d cubes behind the front layer occluded, %d show past it\n", hidden, behind, peeking);
+}
+
+// Without occluders nothing in front of the far plane is rejected
+static void TestEmptyBuffer() {
+    OcclusionCuller culler(OCCLUSION_WIDTH, OCCLUSION_HEIGHT);
+    culler.Clear();
+    culler.SetViewProjection(XMMatrixMultiply(TestViewMatrix(XMFLOAT3(0.0f, 0.0f, -20.0f), XMFLOAT3(0.0f, 0.0f, 1.0f)),
+        Camera::GetProjectionMatrix((float)OCCLUSION_WIDTH / OCCLUSION_HEIGHT)));
+    culler.BuildHierarchy();
+    GridScene scene = DenseGrid(8, 8);
+    int rejected = 0;
+    for (const XMFLOAT3& c : scene.centers) {
+        rejected += !TestCube(culler, c);
+    }
+    CHECK(rejected == 0);
+}
+
+int main() {
+    TestDenseGridHidden();
+    TestDenseGridOblique();
+    TestEmptyBuffer();
+    return TestResult("OcclusionCullingTests");
+}
@@ -0,0 +1,74 @@
+#include "TestCommon.h"
+#include "Renderer.h"
+#include "NullRenderDevice.h"
+
+// The whole renderer runs on the null device: every frame is recorded and validated, the UI is laid out
+void TestHeadlessFrames() {
+    NullRenderDevice* pDevice = new NullRenderDevice(Renderer::defaultWidth, Renderer::defaultHeight);
+    Renderer& renderer = Renderer::GetInstance();
+    CHECK(renderer.Init(pDevice));
+    CHECK(renderer.Resize(Renderer::defaultWidth, Renderer::defaultHeight));
+    // The GPU as far behind as the upload ring allows without waiting
+    pDevice->GetContext()->SetGpuLatency(UploadRing::frameCount);
+
+    const int frameCount = 8;
+    for (int frame = 0; frame < frameCount; frame++) {
+        renderer.MoveCamera(XMFLOAT3(4.0f, 2.0f, 0.0f), XMFLOAT4(frame % 2 ? 1.0f : 0.0f, 0.0f, 0.0f, 0.0f));
+        CHECK(renderer.Render());
+
+        const CommandCounters& counters = pDevice->GetContext()->GetCounters();
+        CHECK(counters.errors == 0);
+        CHECK(counters.drawCalls > 0);
+        CHECK(counters.mapStalls == 0);
+        if (frame == 0) {
+            // Instances, bounds, lights and cluster lists of the first frame
+            CHECK(counters.uploadBytes > 0);
+        }
+        if (counters.errors > 0) {
+            printf("frame %d: %s\n", frame, pDevice->GetContext()->GetLastError().c_str());
+        }
+    }
+    CHECK(pDevice->GetPresentCount() == (UINT)frameCount);
+
+    renderer.Cleanup();
+}
+
+// A resize recreates the size-dependent targets, later frames still validate
+void TestResize() {
+    NullRenderDevice* pDevice = new NullRenderDevice(Renderer::defaultWidth, Renderer::defaultHeight);
+    Renderer& renderer = Renderer::GetInstance();
+    CHECK(renderer.Init(pDevice));
+    CHECK(renderer.Resize(Renderer::defaultWidth, Renderer::defaultHeight));
+    CHECK(renderer.Render());
+    CHECK(renderer.Resize(640, 360));
+    CHECK(renderer.Render());
+    CHECK(pDevice->GetContext()->GetCounters().errors == 0);
+    renderer.Cleanup();
+}
+
+// Every culling path records valid frames, also when the mode changes between frames
+void TestCullingModes() {
+    NullRenderDevice* pDevice = new NullRenderDevice(Renderer::defaultWidth, Renderer::defaultHeight);
+    Renderer& renderer = Renderer::GetInstance();
+    CHECK(renderer.Init(pDevice));
+    CHECK(renderer.Resize(Renderer::defaultWidth, Renderer::defaultHeight));
+    for (int mode = (int)CullingMode::None; mode <= (int)CullingMode::GPU; mode++) {
+        renderer.SetCullingMode((CullingMode)mode);
+        for (int frame = 0; frame < 2; frame++) {
+            CHECK(renderer.Render());
+            const CommandCounters& counters = pDevice->GetContext()->GetCounters();
+            CHECK(counters.errors == 0);
+            if (counters.errors > 0) {
+                printf("mode %d: %s\n", mode, pDevice->GetContext()->GetLastError().c_str());
+            }
+        }
+    }
+    renderer.Cleanup();
+}
+
+int main() {
+    TestHeadlessFrames();
+    TestResize();
+    TestCullingModes();
+    return TestResult("RendererTests");
+}
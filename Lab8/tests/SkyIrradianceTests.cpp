@@ -0,0 +1,337 @@
+#include "TestCommon.h"
+#include "SkyIrradiance.h"
+#include <DirectXPackedVector.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+
+using namespace DirectX::PackedVector;
+
+namespace {
+    typedef std::function<XMFLOAT3(const XMFLOAT3& dir)> Radiance;
+
+    CubeMapFaces MakeFaces(int size, const Radiance& radiance) {
+        CubeMapFaces faces;
+        faces.size = size;
+        faces.texels.resize((size_t)6 * size * size);
+        for (int face = 0; face < 6; face++) {
+            for (int y = 0; y < size; y++) {
+                for (int x = 0; x < size; x++) {
+                    XMFLOAT3 dir = SkyIrradiance::FaceDirection(face, -1.0f + (x + 0.5f) * 2.0f / size, -1.0f + (y + 0.5f) * 2.0f / size);
+                    XMStoreFloat3(&dir, XMVector3Normalize(XMLoadFloat3(&dir)));
+                    faces.texels[((size_t)face * size + y) * size + x] = radiance(dir);
+                }
+            }
+        }
+        return faces;
+    }
+
+    // Largest channel difference of the projected irradiance from the exact one over random normals
+    float MaxError(const SkyIrradiance& sky, const Radiance& irradiance) {
+        std::mt19937 random(7);
+        float maxError = 0.0f;
+        for (int i = 0; i < 1000; i++) {
+            XMFLOAT3 normal = RandomDirection(random);
+            XMFLOAT3 actual = sky.Evaluate(normal);
+            XMFLOAT3 expected = irradiance(normal);
+            maxError = max(maxError, max(fabsf(actual.x - expected.x), max(fabsf(actual.y - expected.y), fabsf(actual.z - expected.z))));
+        }
+        return maxError;
+    }
+
+    void Append(std::vector<uint8_t>& data, const void* bytes, size_t size) {
+        data.insert(data.end(), (const uint8_t*)bytes, (const uint8_t*)bytes + size);
+    }
+
+    void Append32(std::vector<uint8_t>& data, uint32_t value) {
+        Append(data, &value, sizeof(value));
+    }
+
+    const uint32_t fourCCDX10 = 0x30315844;
+    const uint32_t fourCCDXT1 = 0x31545844;
+    const uint32_t fourCCDXT3 = 0x33545844;
+    const uint32_t fourCCDXT5 = 0x35545844;
+
+    // Magic, DDS_HEADER and DDS_HEADER_DXT10 when fourCC is DX10, of a cube texture with all six faces
+    std::vector<uint8_t> DDSHeader(int size, int mips, uint32_t fourCC, uint32_t maskR, uint32_t maskB, uint32_t dxgiFormat) {
+        std::vector<uint8_t> data;
+        Append32(data, 0x20534444);
+        Append32(data, 124);
+        Append32(data, 0x1007 | (mips > 1 ? 0x20000 : 0));
+        Append32(data, size);
+        Append32(data, size);
+        Append32(data, 0);
+        Append32(data, 0);
+        Append32(data, mips);
+        for (int i = 0; i < 11; i++) {
+            Append32(data, 0);
+        }
+        Append32(data, 32);
+        Append32(data, fourCC ? 0x4 : 0x41);
+        Append32(data, fourCC);
+        Append32(data, fourCC ? 0 : 32);
+        Append32(data, maskR);
+        Append32(data, 0x0000FF00);
+        Append32(data, maskB);
+        Append32(data, fourCC ? 0 : 0xFF000000);
+        Append32(data, 0x401008);
+        Append32(data, 0xFE00 | 0x200);
+        Append32(data, 0);
+        Append32(data, 0);
+        Append32(data, 0);
+        if (fourCC == fourCCDX10) {
+            Append32(data, dxgiFormat);
+            Append32(data, 3);
+            Append32(data, 0x4);
+            Append32(data, 1);
+            Append32(data, 0);
+        }
+        return data;
+    }
+
+    uint8_t Unorm8(float value) {
+        return (uint8_t)(min(max(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+    }
+
+    enum class Encoding { RGBA8, BGRA8, RGBA16F, RGBA32F, BC1, BC2, BC3 };
+
+    // Appends a face of the format and returns the texels the decoder should produce for it. Compressed blocks
+    // hold one color, the mean of their texels
+    std::vector<XMFLOAT3> AppendFace(std::vector<uint8_t>& data, Encoding encoding, int size, const std::vector<XMFLOAT3>& texels) {
+        std::vector<XMFLOAT3> expected(texels.size());
+        if (encoding == Encoding::BC1 || encoding == Encoding::BC2 || encoding == Encoding::BC3) {
+            for (int by = 0; by < size / 4; by++) {
+                for (int bx = 0; bx < size / 4; bx++) {
+                    XMFLOAT3 mean(0.0f, 0.0f, 0.0f);
+                    for (int i = 0; i < 16; i++) {
+                        const XMFLOAT3& t = texels[(by * 4 + i / 4) * size + bx * 4 + i % 4];
+                        mean = XMFLOAT3(mean.x + t.x / 16, mean.y + t.y / 16, mean.z + t.z / 16);
+                    }
+                    int r = (int)(mean.x * 31.0f + 0.5f), g = (int)(mean.y * 63.0f + 0.5f), b = (int)(mean.z * 31.0f + 0.5f);
+                    uint16_t color = (uint16_t)((r << 11) | (g << 5) | b);
+                    if (encoding != Encoding::BC1) {
+                        const uint8_t alpha[8] = { 0xFF, 0xFF, 0, 0, 0, 0, 0, 0 };
+                        Append(data, alpha, sizeof(alpha));
+                    }
+                    Append(data, &color, sizeof(color));
+                    Append(data, &color, sizeof(color));
+                    Append32(data, 0);
+                    for (int i = 0; i < 16; i++) {
+                        expected[(by * 4 + i / 4) * size + bx * 4 + i % 4] = XMFLOAT3(r / 31.0f, g / 63.0f, b / 31.0f);
+                    }
+                }
+            }
+            return expected;
+        }
+        for (size_t i = 0; i < texels.size(); i++) {
+            const XMFLOAT3& t = texels[i];
+            switch (encoding) {
+            case Encoding::RGBA8:
+            case Encoding::BGRA8: {
+                uint8_t texel[4] = { Unorm8(t.x), Unorm8(t.y), Unorm8(t.z), 255 };
+                expected[i] = XMFLOAT3(texel[0] / 255.0f, texel[1] / 255.0f, texel[2] / 255.0f);
+                if (encoding == Encoding::BGRA8) {
+                    std::swap(texel[0], texel[2]);
+                }
+                Append(data, texel, sizeof(texel));
+                break;
+            }
+            case Encoding::RGBA16F: {
+                HALF texel[4] = { XMConvertFloatToHalf(t.x), XMConvertFloatToHalf(t.y), XMConvertFloatToHalf(t.z), XMConvertFloatToHalf(1.0f) };
+                expected[i] = XMFLOAT3(XMConvertHalfToFloat(texel[0]), XMConvertHalfToFloat(texel[1]), XMConvertHalfToFloat(texel[2]));
+                Append(data, texel, sizeof(texel));
+                break;
+            }
+            default: {
+                float texel[4] = { t.x, t.y, t.z, 1.0f };
+                expected[i] = t;
+                Append(data, texel, sizeof(texel));
+                break;
+            }
+            }
+        }
+        return expected;
+    }
+
+    float SrgbToLinear(float value) {
+        return value <= 0.04045f ? value / 12.92f : powf((value + 0.055f) / 1.055f, 2.4f);
+    }
+
+    // A sky that is brighter and bluer upwards
+    XMFLOAT3 TestSky(const XMFLOAT3& dir) {
+        return XMFLOAT3(0.3f + 0.2f * dir.y, 0.4f + 0.25f * dir.y + 0.05f * dir.x, 0.6f + 0.3f * dir.y * dir.y);
+    }
+
+    bool SameCoefficients(const XMFLOAT4* a, const XMFLOAT4* b) {
+        return memcmp(a, b, sizeof(XMFLOAT4) * SkyIrradiance::coefficientCount) == 0;
+    }
+}
+
+// Radiance that L2 holds exactly, constant, linear and quadratic in the direction, against its irradiance over pi:
+// a + 2 / 3 b.n for a + b.w, (1 + nz^2) / 4 for z^2 and nx ny / 4 for x y
+void TestAnalyticSkies() {
+    JobSystem jobSystem(4);
+    SkyIrradiance sky(&jobSystem);
+    CHECK_NEAR(MaxError(sky, [](const XMFLOAT3&) { return XMFLOAT3(1.0f, 1.0f, 1.0f); }), 0.0f, 1e-6f);
+
+    sky.Project(MakeFaces(64, [](const XMFLOAT3&) { return XMFLOAT3(0.5f, 1.0f, 2.0f); }));
+    CHECK_NEAR(MaxError(sky, [](const XMFLOAT3&) { return XMFLOAT3(0.5f, 1.0f, 2.0f); }), 0.0f, 1e-5f);
+
+    sky.Project(MakeFaces(64, [](const XMFLOAT3& w) { return XMFLOAT3(1.0f + 0.5f * w.x, 1.0f - 0.25f * w.y, 1.0f + 0.75f * w.z); }));
+    CHECK_NEAR(MaxError(sky, [](const XMFLOAT3& n) {
+        return XMFLOAT3(1.0f + 0.5f * n.x * 2.0f / 3.0f, 1.0f - 0.25f * n.y * 2.0f / 3.0f, 1.0f + 0.75f * n.z * 2.0f / 3.0f);
+    }), 0.0f, 1e-4f);
+
+    sky.Project(MakeFaces(64, [](const XMFLOAT3& w) { return XMFLOAT3(w.z * w.z, 1.0f + w.x * w.y, 0.5f + w.z * w.z + 0.5f * w.x * w.y); }));
+    CHECK_NEAR(MaxError(sky, [](const XMFLOAT3& n) {
+        float zz = (1.0f + n.z * n.z) / 4.0f, xy = n.x * n.y / 4.0f;
+        return XMFLOAT3(zz, 1.0f + xy, 0.5f + zz + 0.5f * xy);
+    }), 0.0f, 1e-4f);
+
+    // Worker count only changes the order of the sums
+    JobSystem oneWorker(1);
+    SkyIrradiance single(&oneWorker);
+    CubeMapFaces faces = MakeFaces(32, TestSky);
+    single.Project(faces);
+    sky.Project(faces);
+    for (int i = 0; i < SkyIrradiance::coefficientCount; i++) {
+        CHECK_NEAR(sky.GetCoefficients()[i].x, single.GetCoefficients()[i].x, 1e-5f);
+        CHECK_NEAR(sky.GetCoefficients()[i].y, single.GetCoefficients()[i].y, 1e-5f);
+        CHECK_NEAR(sky.GetCoefficients()[i].z, single.GetCoefficients()[i].z, 1e-5f);
+    }
+}
+
+// Every format the decoder accepts, legacy and DX10 headers, gives back the texels that were encoded
+void TestDecodeFormats() {
+    struct Case {
+        Encoding encoding;
+        uint32_t fourCC;
+        uint32_t maskR;
+        uint32_t maskB;
+        uint32_t dxgiFormat;
+        bool srgb;
+    };
+    const Case cases[] = {
+        { Encoding::RGBA8, 0, 0x000000FF, 0x00FF0000, 0, false },
+        { Encoding::BGRA8, 0, 0x00FF0000, 0x000000FF, 0, false },
+        { Encoding::RGBA16F, 113, 0, 0, 0, false },
+        { Encoding::RGBA32F, 116, 0, 0, 0, false },
+        { Encoding::BC1, fourCCDXT1, 0, 0, 0, false },
+        { Encoding::BC2, fourCCDXT3, 0, 0, 0, false },
+        { Encoding::BC3, fourCCDXT5, 0, 0, 0, false },
+        { Encoding::RGBA8, fourCCDX10, 0, 0, 28, false },
+        { Encoding::RGBA8, fourCCDX10, 0, 0, 29, true },
+        { Encoding::BGRA8, fourCCDX10, 0, 0, 87, false },
+        { Encoding::BGRA8, fourCCDX10, 0, 0, 91, true },
+        { Encoding::RGBA16F, fourCCDX10, 0, 0, 10, false },
+        { Encoding::RGBA32F, fourCCDX10, 0, 0, 2, false },
+        { Encoding::BC1, fourCCDX10, 0, 0, 72, true },
+        { Encoding::BC3, fourCCDX10, 0, 0, 77, false }
+    };
+    const int size = 16;
+    CubeMapFaces source = MakeFaces(size, TestSky);
+    for (const Case& c : cases) {
+        std::vector<uint8_t> data = DDSHeader(size, 1, c.fourCC, c.maskR, c.maskB, c.dxgiFormat);
+        std::vector<XMFLOAT3> expected;
+        for (int face = 0; face < 6; face++) {
+            std::vector<XMFLOAT3> texels(source.texels.begin() + face * size * size, source.texels.begin() + (face + 1) * size * size);
+            std::vector<XMFLOAT3> faceExpected = AppendFace(data, c.encoding, size, texels);
+            expected.insert(expected.end(), faceExpected.begin(), faceExpected.end());
+        }
+        CubeMapFaces faces;
+        CHECK(SkyIrradiance::DecodeCubeMap(data, faces));
+        CHECK(faces.size == size && faces.texels.size() == expected.size());
+        float maxError = 0.0f;
+        for (size_t i = 0; i < expected.size() && i < faces.texels.size(); i++) {
+            XMFLOAT3 e = expected[i];
+            if (c.srgb) {
+                e = XMFLOAT3(SrgbToLinear(e.x), SrgbToLinear(e.y), SrgbToLinear(e.z));
+            }
+            maxError = max(maxError, max(fabsf(faces.texels[i].x - e.x), max(fabsf(faces.texels[i].y - e.y), fabsf(faces.texels[i].z - e.z))));
+        }
+        CHECK_NEAR(maxError, 0.0f, 1e-6f);
+
+        // Truncated files are refused
+        data.pop_back();
+        CHECK(!SkyIrradiance::DecodeCubeMap(data, faces));
+    }
+}
+
+// The largest mip of at most maxSize texels is decoded, the top one if there is no such mip
+void TestDecodeMips() {
+    std::vector<uint8_t> data = DDSHeader(32, 3, 116, 0, 0, 0);
+    for (int face = 0; face < 6; face++) {
+        for (int mip = 0; mip < 3; mip++) {
+            int mipSize = 32 >> mip;
+            std::vector<XMFLOAT3> texels((size_t)mipSize * mipSize, XMFLOAT3((float)mip, (float)face, 0.0f));
+            AppendFace(data, Encoding::RGBA32F, mipSize, texels);
+        }
+    }
+    CubeMapFaces faces;
+    CHECK(SkyIrradiance::DecodeCubeMap(data, faces, 16));
+    CHECK(faces.size == 16 && faces.texels[0].x == 1.0f && faces.texels.back().x == 1.0f && faces.texels.back().y == 5.0f);
+    CHECK(SkyIrradiance::DecodeCubeMap(data, faces, 64));
+    CHECK(faces.size == 32 && faces.texels[0].x == 0.0f && faces.texels.back().y == 5.0f);
+    CHECK(SkyIrradiance::DecodeCubeMap(data, faces, 4));
+    CHECK(faces.size == 8 && faces.texels[0].x == 2.0f);
+
+    // Not a cube, a format the loader has no sky for, no DDS at all
+    std::vector<uint8_t> flat = data;
+    flat[4 + 108] = 0;
+    flat[4 + 109] = 0;
+    CHECK(!SkyIrradiance::DecodeCubeMap(flat, faces));
+    std::vector<uint8_t> unknown = DDSHeader(4, 1, fourCCDX10, 0, 0, 24);
+    unknown.resize(unknown.size() + 6 * 4 * 4 * 4);
+    CHECK(!SkyIrradiance::DecodeCubeMap(unknown, faces));
+    CHECK(!SkyIrradiance::DecodeCubeMap(std::vector<uint8_t>(200, 0), faces));
+}
+
+// The second load reads the cache, a changed file is projected again, a missing file keeps the coefficients
+void TestCache() {
+    const char* ddsPath = "SkyIrradianceTests.dds";
+    const char* cachePath = "SkyIrradianceTests.sh";
+    std::vector<uint8_t> data = DDSHeader(16, 1, 116, 0, 0, 0);
+    CubeMapFaces source = MakeFaces(16, TestSky);
+    for (int face = 0; face < 6; face++) {
+        AppendFace(data, Encoding::RGBA32F, 16,
+            std::vector<XMFLOAT3>(source.texels.begin() + face * 16 * 16, source.texels.begin() + (face + 1) * 16 * 16));
+    }
+    auto write = [&]() {
+        std::ofstream file(ddsPath, std::ios::binary | std::ios::trunc);
+        file.write((const char*)data.data(), data.size());
+    };
+    write();
+    remove(cachePath);
+
+    JobSystem jobSystem(2);
+    SkyIrradiance sky(&jobSystem);
+    CHECK(sky.Load(ddsPath, cachePath));
+    CHECK(!sky.IsFromCache());
+    XMFLOAT4 projected[SkyIrradiance::coefficientCount];
+    memcpy(projected, sky.GetCoefficients(), sizeof(projected));
+
+    SkyIrradiance cached(&jobSystem);
+    CHECK(cached.Load(ddsPath, cachePath));
+    CHECK(cached.IsFromCache());
+    CHECK(SameCoefficients(cached.GetCoefficients(), projected));
+
+    data.back() ^= 1;
+    write();
+    CHECK(cached.Load(ddsPath, cachePath));
+    CHECK(!cached.IsFromCache());
+    CHECK(cached.Load(ddsPath, cachePath));
+    CHECK(cached.IsFromCache());
+
+    remove(ddsPath);
+    CHECK(!cached.Load(ddsPath, cachePath));
+    remove(cachePath);
+}
+
+int main() {
+    TestAnalyticSkies();
+    TestDecodeFormats();
+    TestDecodeMips();
+    TestCache();
+    return TestResult("SkyIrradianceTests");
+}
@@ -0,0 +1,165 @@
+#include "TestCommon.h"
+#include "SoftwareRasterizer.h"
+#include <cstring>
+#include <vector>
+
+namespace {
+    const int width = 97;
+    const int height = 61;
+
+    SoftwareVertex ClipVertex(float x, float y, float z, float w = 1.0f) {
+        SoftwareVertex v;
+        v.clip = XMFLOAT4(x * w, y * w, z * w, w);
+        v.pos = XMFLOAT3(x, y, 0.0f);
+        v.normal = XMFLOAT3(0.0f, 0.0f, -1.0f);
+        return v;
+    }
+
+    void DrawScreenQuad(SoftwareRasterizer& rasterizer, float depth, const SoftwareMaterial& material) {
+        rasterizer.DrawTriangle(ClipVertex(-1.0f, -1.0f, depth), ClipVertex(-1.0f, 1.0f, depth), ClipVertex(1.0f, 1.0f, depth), material);
+        rasterizer.DrawTriangle(ClipVertex(-1.0f, -1.0f, depth), ClipVertex(1.0f, 1.0f, depth), ClipVertex(1.0f, -1.0f, depth), material);
+    }
+
+    std::vector<XMFLOAT4> Image(const SoftwareRasterizer& rasterizer) {
+        std::vector<XMFLOAT4> image((size_t)width * height);
+        for (int y = 0; y < height; y++) {
+            memcpy(&image[(size_t)y * width], reinterpret_cast<const uint8_t*>(rasterizer.GetColor()) + (size_t)y * rasterizer.GetRowPitch(),
+                sizeof(XMFLOAT4) * width);
+        }
+        return image;
+    }
+
+    bool SameImage(const std::vector<XMFLOAT4>& a, const std::vector<XMFLOAT4>& b) {
+        return memcmp(a.data(), b.data(), sizeof(XMFLOAT4) * a.size()) == 0;
+    }
+
+    const SoftwareMaterial Red = { SoftwareShader::Lit, XMFLOAT3(1.0f, 0.0f, 0.0f), 0.0f, 1.0f };
+    const SoftwareMaterial Green = { SoftwareShader::Lit, XMFLOAT3(0.0f, 1.0f, 0.0f), 0.0f, 1.0f };
+}
+
+// Two triangles sharing the diagonal of the screen cover every pixel exactly once
+void TestTopLeftRule(SoftwareRasterizer& rasterizer) {
+    rasterizer.Clear(XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f));
+    DrawScreenQuad(rasterizer, 0.5f, Red);
+    rasterizer.Flush();
+    CHECK(rasterizer.GetStats().triangles == 2);
+    CHECK(rasterizer.GetStats().pixels == (UINT64)width * height);
+
+    // Pixel centers exactly on the shared edge of a fan around the screen center
+    rasterizer.Clear(XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f));
+    const float corners[4][2] = { { -1.0f, -1.0f }, { -1.0f, 1.0f }, { 1.0f, 1.0f }, { 1.0f, -1.0f } };
+    for (int i = 0; i < 4; i++) {
+        const float* a = corners[i];
+        const float* b = corners[(i + 1) % 4];
+        rasterizer.DrawTriangle(ClipVertex(0.0f, 0.0f, 0.5f), ClipVertex(a[0], a[1], 0.5f), ClipVertex(b[0], b[1], 0.5f), Green);
+    }
+    rasterizer.Flush();
+    CHECK(rasterizer.GetStats().pixels == (UINT64)width * height);
+}
+
+// Reversed depth: the larger z wins whatever the order of the draws
+void TestDepthOrder(SoftwareRasterizer& rasterizer) {
+    rasterizer.Clear(XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f));
+    DrawScreenQuad(rasterizer, 0.8f, Red);
+    rasterizer.Flush();
+    std::vector<XMFLOAT4> nearOnly = Image(rasterizer);
+
+    rasterizer.Clear(XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f));
+    DrawScreenQuad(rasterizer, 0.2f, Green);
+    DrawScreenQuad(rasterizer, 0.8f, Red);
+    rasterizer.Flush();
+    CHECK(SameImage(Image(rasterizer), nearOnly));
+
+    rasterizer.Clear(XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f));
+    DrawScreenQuad(rasterizer, 0.8f, Red);
+    DrawScreenQuad(rasterizer, 0.2f, Green);
+    rasterizer.Flush();
+    CHECK(SameImage(Image(rasterizer), nearOnly));
+    CHECK(nearOnly[0].x > 0.0f && nearOnly[0].y == 0.0f);
+
+    // The sky at z = 0 passes GREATER_EQUAL on a clear depth buffer but not behind a cube
+    SoftwareMaterial sky = { SoftwareShader::Sky, XMFLOAT3(0.3f, 0.5f, 0.85f), 0.0f, 1.0f };
+    rasterizer.Clear(XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f));
+    DrawScreenQuad(rasterizer, 0.8f, Red);
+    DrawScreenQuad(rasterizer, 0.0f, sky);
+    rasterizer.Flush();
+    CHECK(SameImage(Image(rasterizer), nearOnly));
+}
+
+// Transparent pixels are blended over the target and do not write depth
+void TestBlending(SoftwareRasterizer& rasterizer) {
+    SoftwareMaterial glass = { SoftwareShader::Transparent, XMFLOAT3(0.0f, 0.0f, 1.0f), 0.0f, 0.5f };
+    rasterizer.Clear(XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f));
+    DrawScreenQuad(rasterizer, 0.2f, Red);
+    rasterizer.Flush();
+    std::vector<XMFLOAT4> opaque = Image(rasterizer);
+
+    rasterizer.Clear(XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f));
+    DrawScreenQuad(rasterizer, 0.2f, Red);
+    DrawScreenQuad(rasterizer, 0.5f, glass);
+    DrawScreenQuad(rasterizer, 0.3f, Green);
+    rasterizer.Flush();
+    std::vector<XMFLOAT4> blended = Image(rasterizer);
+    // Green lands in front of the glass because the glass left the depth buffer alone
+    CHECK(blended[0].y > 0.0f && blended[0].x == 0.0f && blended[0].z == 0.0f);
+
+    rasterizer.Clear(XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f));
+    DrawScreenQuad(rasterizer, 0.2f, Red);
+    DrawScreenQuad(rasterizer, 0.1f, glass);
+    rasterizer.Flush();
+    blended = Image(rasterizer);
+    // Behind the red quad the glass fails the depth test
+    CHECK(SameImage(blended, opaque));
+
+    rasterizer.Clear(XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f));
+    DrawScreenQuad(rasterizer, 0.2f, Red);
+    DrawScreenQuad(rasterizer, 0.5f, glass);
+    rasterizer.Flush();
+    blended = Image(rasterizer);
+    CHECK_NEAR(blended[0].x, opaque[0].x * 0.5f, 1e-6f);
+    CHECK(blended[0].z > 0.0f);
+    CHECK(blended[0].w == 1.0f);
+}
+
+// Triangles through the near plane are clipped instead of being projected through w = 0
+void TestNearClip(SoftwareRasterizer& rasterizer) {
+    rasterizer.Clear(XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f));
+    SoftwareVertex behind = ClipVertex(0.0f, 2.0f, 0.5f);
+    behind.clip = XMFLOAT4(0.0f, 2.0f, 2.0f * SCREEN_NEAR, -1.0f);
+    rasterizer.DrawTriangle(ClipVertex(-0.5f, -0.5f, 0.5f), ClipVertex(0.5f, -0.5f, 0.5f), behind, Red);
+    rasterizer.Flush();
+    CHECK(rasterizer.GetStats().triangles == 2);
+    CHECK(rasterizer.GetStats().pixels > 0);
+    CHECK(rasterizer.GetStats().pixels < (UINT64)width * height);
+    for (const XMFLOAT4& pixel : Image(rasterizer)) {
+        CHECK(pixel.x == pixel.x && pixel.x >= 0.0f);
+    }
+
+    // Entirely behind the camera
+    rasterizer.Clear(XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f));
+    SoftwareVertex a = behind, b = behind, c = behind;
+    a.clip.x = -0.5f;
+    b.clip.x = 0.5f;
+    c.clip.y = -0.5f;
+    rasterizer.DrawTriangle(a, b, c, Red);
+    rasterizer.Flush();
+    CHECK(rasterizer.GetStats().pixels == 0);
+}
+
+int main() {
+    Light light = { XMFLOAT4(0.0f, 0.0f, -2.0f, 10.0f), XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f) };
+    LightingParams lighting = { XMFLOAT3(0.0f, 0.0f, -3.0f), 1, false, &light };
+    XMFLOAT4 ambientSH[SkyIrradiance::coefficientCount] = {};
+    ambientSH[0] = XMFLOAT4(0.1f, 0.1f, 0.1f, 0.0f);
+
+    JobSystem jobSystem(4);
+    SoftwareRasterizer rasterizer(&jobSystem);
+    rasterizer.Resize(width, height);
+    rasterizer.SetLighting(lighting, ambientSH);
+
+    TestTopLeftRule(rasterizer);
+    TestDepthOrder(rasterizer);
+    TestBlending(rasterizer);
+    TestNearClip(rasterizer);
+    return TestResult("SoftwareRasterizerTests");
+}
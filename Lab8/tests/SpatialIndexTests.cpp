@@ -0,0 +1,151 @@
+#include "TestCommon.h"
+#include "SpatialIndex.h"
+#include "LooseOctree.h"
+#include "HashGrid.h"
+#include "Macros.h"
+#include <algorithm>
+#include <vector>
+
+namespace {
+    // Reference for the queries: every box that is in the index, tested one by one
+    struct Reference {
+        std::vector<XMFLOAT4> bbMin;
+        std::vector<XMFLOAT4> bbMax;
+        std::vector<char> present;
+
+        template <typename Test>
+        std::vector<int> Query(Test test) const {
+            std::vector<int> ids;
+            for (int i = 0; i < (int)present.size(); i++) {
+                if (present[i] && test(bbMin[i], bbMax[i])) {
+                    ids.push_back(i);
+                }
+            }
+            return ids;
+        }
+    };
+
+    bool SameIds(std::vector<int>& ids, int count, const std::vector<int>& expected) {
+        std::sort(ids.begin(), ids.begin() + count);
+        return count == (int)expected.size() && std::equal(expected.begin(), expected.end(), ids.begin());
+    }
+
+    bool SphereIntersectsBox(const XMFLOAT3& c, float radius, const XMFLOAT4& bbMin, const XMFLOAT4& bbMax) {
+        float dx = max(max(bbMin.x - c.x, c.x - bbMax.x), 0.0f);
+        float dy = max(max(bbMin.y - c.y, c.y - bbMax.y), 0.0f);
+        float dz = max(max(bbMin.z - c.z, c.z - bbMax.z), 0.0f);
+        return dx * dx + dy * dy + dz * dz <= radius * radius;
+    }
+
+    void CheckQueries(SpatialIndex& index, const Reference& reference, std::mt19937& random, float radius) {
+        std::uniform_real_distribution<float> position(-radius, radius);
+        std::uniform_real_distribution<float> size(0.5f, radius * 0.5f);
+        std::vector<int> ids(reference.present.size());
+
+        for (int q = 0; q < 8; q++) {
+            Frustum frustum(SCREEN_NEAR);
+            frustum.ConstructFrustum(TestViewMatrix(XMFLOAT3(position(random), position(random), position(random)),
+                RandomDirection(random)), Camera::GetProjectionMatrix(16.0f / 9.0f));
+            int count = index.QueryFrustum(frustum, ids.data());
+            CHECK(SameIds(ids, count, reference.Query([&](const XMFLOAT4& bbMin, const XMFLOAT4& bbMax) {
+                return frustum.CheckRectangle(bbMin, bbMax);
+            })));
+
+            XMFLOAT3 center(position(random), position(random), position(random));
+            float sphereRadius = size(random);
+            count = index.QuerySphere(center, sphereRadius, ids.data());
+            CHECK(SameIds(ids, count, reference.Query([&](const XMFLOAT4& bbMin, const XMFLOAT4& bbMax) {
+                return SphereIntersectsBox(center, sphereRadius, bbMin, bbMax);
+            })));
+
+            float half = size(random);
+            XMFLOAT4 queryMin(center.x - half, center.y - half, center.z - half, 1.0f);
+            XMFLOAT4 queryMax(center.x + half, center.y + half * 0.5f, center.z + half, 1.0f);
+            count = index.QueryBox(queryMin, queryMax, ids.data());
+            CHECK(SameIds(ids, count, reference.Query([&](const XMFLOAT4& bbMin, const XMFLOAT4& bbMax) {
+                return bbMin.x <= queryMax.x && bbMax.x >= queryMin.x && bbMin.y <= queryMax.y && bbMax.y >= queryMin.y &&
+                    bbMin.z <= queryMax.z && bbMax.z >= queryMin.z;
+            })));
+        }
+    }
+}
+
+// Queries of an index match the brute force reference after inserts, moves, removes and reinserts,
+// boxes of every size and some outside the octree cube
+void TestIndex(SpatialIndex& index, const char* name, float radius, float maxExtent) {
+    const int count = 3000;
+    std::mt19937 random(11);
+    Reference reference;
+    RandomBoxes(random, count, radius, maxExtent, reference.bbMin, reference.bbMax);
+    reference.present.assign(count, 1);
+    for (int i = 0; i < count; i++) {
+        index.Insert(i, reference.bbMin[i], reference.bbMax[i]);
+    }
+    CHECK(index.GetCount() == count);
+    CheckQueries(index, reference, random, radius + maxExtent);
+
+    std::uniform_int_distribution<int> id(0, count - 1);
+    std::uniform_real_distribution<float> step(-3.0f, 3.0f);
+    for (int round = 0; round < 4; round++) {
+        for (int k = 0; k < count / 5; k++) {
+            int i = id(random);
+            XMFLOAT3 offset(step(random), step(random), step(random));
+            if (k % 7 == 0) {
+                offset.x *= 10.0f;
+            }
+            reference.bbMin[i] = XMFLOAT4(reference.bbMin[i].x + offset.x, reference.bbMin[i].y + offset.y, reference.bbMin[i].z + offset.z, 1.0f);
+            reference.bbMax[i] = XMFLOAT4(reference.bbMax[i].x + offset.x, reference.bbMax[i].y + offset.y, reference.bbMax[i].z + offset.z, 1.0f);
+            index.Move(i, reference.bbMin[i], reference.bbMax[i]);
+            reference.present[i] = 1;
+        }
+        for (int k = 0; k < count / 10; k++) {
+            int i = id(random);
+            index.Remove(i);
+            reference.present[i] = 0;
+            CHECK(!index.Contains(i));
+        }
+        int present = (int)std::count(reference.present.begin(), reference.present.end(), 1);
+        CHECK(index.GetCount() == present);
+        CheckQueries(index, reference, random, radius + maxExtent);
+    }
+
+    index.Clear();
+    CHECK(index.GetCount() == 0);
+    std::vector<int> ids(count);
+    Frustum frustum(SCREEN_NEAR);
+    frustum.ConstructFrustum(TestViewMatrix(XMFLOAT3(0.0f, 0.0f, -20.0f), XMFLOAT3(0.0f, 0.0f, 1.0f)), Camera::GetProjectionMatrix(1.0f));
+    CHECK(index.QueryFrustum(frustum, ids.data()) == 0);
+    if (testFailures) {
+        printf("%s failed\n", name);
+    }
+}
+
+// A box centered in the cube but larger than it stays in the root, which must still reach past its own cell
+void TestBoxLargerThanCube() {
+    LooseOctree octree(XMFLOAT3(0.0f, 0.0f, 0.0f), 8.0f, 6);
+    octree.Insert(0, XMFLOAT4(-3.0f, -10.0f, -10.0f, 1.0f), XMFLOAT4(17.0f, 10.0f, 10.0f, 1.0f));
+    octree.Insert(1, XMFLOAT4(-1.0f, -1.0f, -1.0f, 1.0f), XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f));
+    int ids[2];
+    CHECK(octree.QueryBox(XMFLOAT4(16.5f, -0.5f, -0.5f, 1.0f), XMFLOAT4(17.0f, 0.5f, 0.5f, 1.0f), ids) == 1 && ids[0] == 0);
+    CHECK(octree.QuerySphere(XMFLOAT3(0.0f, 0.0f, 19.0f), 9.5f, ids) == 1 && ids[0] == 0);
+
+    // A narrow frustum along the edge of the large box only
+    Frustum frustum(SCREEN_NEAR);
+    frustum.ConstructFrustum(TestViewMatrix(XMFLOAT3(16.8f, 0.0f, -40.0f), XMFLOAT3(0.0f, 0.0f, 1.0f)), Camera::GetProjectionMatrix(0.01f));
+    CHECK(octree.QueryFrustum(frustum, ids) == 1 && ids[0] == 0);
+}
+
+int main() {
+    // The sizes of SpatialIndex::Create, the octree covers a part of the boxes only
+    LooseOctree octree(XMFLOAT3(0.0f, 0.0f, 0.0f), 8.0f, 6);
+    HashGrid grid(2.0f);
+    TestIndex(octree, "LooseOctree", 12.0f, 2.0f);
+    TestIndex(grid, "HashGrid", 12.0f, 2.0f);
+    // Centers in the cube and boxes up to twice its size, like lights with a long range
+    LooseOctree largeOctree(XMFLOAT3(0.0f, 0.0f, 0.0f), 8.0f, 6);
+    HashGrid largeGrid(2.0f);
+    TestIndex(largeOctree, "LooseOctree, large boxes", 7.5f, 16.0f);
+    TestIndex(largeGrid, "HashGrid, large boxes", 7.5f, 16.0f);
+    TestBoxLargerThanCube();
+    return TestResult("SpatialIndexTests");
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "TestScenes.h"
+#include <cmath>
+#include <cstdio>
+
+// Checks of the test executables, a test passes if none of them fails
+static int testFailures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            printf("%s(%d): check failed: %s\n", __FILE__, __LINE__, #condition); \
+            testFailures++; \
+        } \
+    } while (0)
+
+#define CHECK_NEAR(actual, expected, tolerance) \
+    do { \
+        double actualValue = (double)(actual), expectedValue = (double)(expected); \
+        if (!(fabs(actualValue - expectedValue) <= (double)(tolerance))) { \
+            printf("%s(%d): check failed: %s = %g, expected %g within %g\n", __FILE__, __LINE__, #actual, \
+                actualValue, expectedValue, (double)(tolerance)); \
+            testFailures++; \
+        } \
+    } while (0)
+
+inline int TestResult(const char* name) {
+    printf(testFailures ? "%s: %d checks failed\n" : "%s: passed\n", name, testFailures);
+    return testFailures ? 1 : 0;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "MathCommon.h"
+#include "Camera.h"
+#include <cmath>
+#include <random>
+#include <vector>
+
+// Scenes and cameras shared by the tests and the benchmarks
+
+// View of the main camera from eye along dir
+inline XMMATRIX TestViewMatrix(const XMFLOAT3& eye, const XMFLOAT3& dir) {
+    return XMMatrixLookToLH(XMVectorSet(eye.x, eye.y, eye.z, 0.0f), XMVectorSet(dir.x, dir.y, dir.z, 0.0f),
+        XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+}
+
+inline XMFLOAT3 RandomDirection(std::mt19937& random) {
+    std::uniform_real_distribution<float> angle(-XM_PI, XM_PI);
+    float phi = angle(random), theta = angle(random) * 0.4f;
+    return XMFLOAT3(cosf(theta) * cosf(phi), sinf(theta), cosf(theta) * sinf(phi));
+}
+
+struct TestCameraPoint {
+    XMFLOAT3 eye;
+    XMFLOAT3 dir;
+};
+
+// Smooth path through random points of the cube [-radius, radius]^3: the camera flies between the points and
+// turns to look at the next one, so consecutive frames see nearly the same objects like in the application
+inline std::vector<TestCameraPoint> RandomCameraPath(std::mt19937& random, int frames, float radius) {
+    std::uniform_real_distribution<float> position(-radius, radius);
+    const int framesPerSegment = 60;
+    std::vector<XMFLOAT3> points;
+    for (int i = 0; i < frames / framesPerSegment + 3; i++) {
+        points.push_back(XMFLOAT3(position(random), position(random) * 0.25f, position(random)));
+    }
+
+    std::vector<TestCameraPoint> path(frames);
+    XMVECTOR dir = XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f);
+    for (int f = 0; f < frames; f++) {
+        int segment = f / framesPerSegment;
+        float t = (float)(f % framesPerSegment) / framesPerSegment;
+        XMVECTOR from = XMLoadFloat3(&points[segment]);
+        XMVECTOR to = XMLoadFloat3(&points[segment + 1]);
+        XMVECTOR next = XMLoadFloat3(&points[segment + 2]);
+        XMVECTOR eye = XMVectorLerp(from, to, t);
+        XMVECTOR target = XMVectorLerp(to, next, t);
+        XMVECTOR toTarget = XMVectorSubtract(target, eye);
+        if (XMVectorGetX(XMVector3LengthSq(toTarget)) > 1e-6f) {
+            dir = XMVector3Normalize(toTarget);
+        }
+        XMStoreFloat3(&path[f].eye, eye);
+        XMStoreFloat3(&path[f].dir, dir);
+    }
+    return path;
+}
+
+// Random boxes in the cube [-radius, radius]^3 with half extents up to maxExtent, every 17th box is a point
+inline void RandomBoxes(std::mt19937& random, int count, float radius, float maxExtent,
+    std::vector<XMFLOAT4>& bbMin, std::vector<XMFLOAT4>& bbMax) {
+    std::uniform_real_distribution<float> position(-radius, radius);
+    std::uniform_real_distribution<float> extent(0.0f, maxExtent);
+    bbMin.resize(count);
+    bbMax.resize(count);
+    for (int i = 0; i < count; i++) {
+        XMFLOAT3 center(position(random), position(random), position(random));
+        XMFLOAT3 half = i % 17 == 0 ? XMFLOAT3(0.0f, 0.0f, 0.0f) : XMFLOAT3(extent(random), extent(random), extent(random));
+        bbMin[i] = XMFLOAT4(center.x - half.x, center.y - half.y, center.z - half.z, 1.0f);
+        bbMax[i] = XMFLOAT4(center.x + half.x, center.y + half.y, center.z + half.z, 1.0f);
+    }
+}
+
+// Random scale, rotation and translation like the transforms of the instances
+inline XMMATRIX RandomWorldMatrix(std::mt19937& random, float radius) {
+    std::uniform_real_distribution<float> position(-radius, radius);
+    std::uniform_real_distribution<float> scale(0.1f, 4.0f);
+    std::uniform_real_distribution<float> angle(-XM_PI, XM_PI);
+    return XMMatrixScaling(scale(random), scale(random), scale(random)) *
+        XMMatrixRotationQuaternion(XMQuaternionRotationRollPitchYaw(angle(random), angle(random), angle(random))) *
+        XMMatrixTranslation(position(random), position(random), position(random));
+}
+
+// World AABB as the min/max of the 8 transformed corners, the reference for TransformAABB
+inline void CornerAABB(const XMFLOAT4& localMin, const XMFLOAT4& localMax, FXMMATRIX world, XMFLOAT4& bbMin, XMFLOAT4& bbMax) {
+    for (int j = 0; j < 8; j++) {
+        XMFLOAT4 corner(j & 1 ? localMax.x : localMin.x, j & 2 ? localMax.y : localMin.y, j & 4 ? localMax.z : localMin.z, 1.0f);
+        XMFLOAT4 vec;
+        XMStoreFloat4(&vec, XMVector4Transform(XMLoadFloat4(&corner), world));
+        if (j == 0) {
+            bbMin = vec;
+            bbMax = vec;
+            continue;
+        }
+        bbMax.x = bbMax.x >= vec.x ? bbMax.x : vec.x;
+        bbMax.y = bbMax.y >= vec.y ? bbMax.y : vec.y;
+        bbMax.z = bbMax.z >= vec.z ? bbMax.z : vec.z;
+        bbMin.x = bbMin.x <= vec.x ? bbMin.x : vec.x;
+        bbMin.y = bbMin.y <= vec.y ? bbMin.y : vec.y;
+        bbMin.z = bbMin.z <= vec.z ? bbMin.z : vec.z;
+    }
+}
@@ -0,0 +1,150 @@
+#include "TestCommon.h"
+#include "UploadRing.h"
+#include "NullRenderDevice.h"
+#include <vector>
+
+static GpuBuffer* CreateTarget(RenderDevice& device, UINT size) {
+    GpuBufferDesc desc = {};
+    desc.byteWidth = size;
+    desc.usage = GpuUsage::Default;
+    desc.bindFlags = GpuBind::ShaderResource;
+    GpuBuffer* pBuffer = NULL;
+    CHECK(SUCCEEDED(device.CreateBuffer(desc, nullptr, &pBuffer)));
+    return pBuffer;
+}
+
+// Every written byte goes out exactly once, as counted by the context, and neighbouring writes share a copy
+static void TestUploadVolume() {
+    NullRenderDevice device(64, 64);
+    NullCommandContext* pContext = device.GetContext();
+    GpuBuffer* pTarget = CreateTarget(device, 1 << 16);
+    std::vector<BYTE> data(1 << 16, 7);
+    UploadRing ring(&device);
+
+    UINT64 expectedTotal = 0;
+    for (int frame = 0; frame < 10; frame++) {
+        pContext->BeginFrame();
+        UINT runs = 1 + frame % 4, runSize = 256 * (frame + 1);
+        CHECK(SUCCEEDED(ring.Begin(pContext, runs * runSize)));
+        for (UINT r = 0; r < runs; r++) {
+            // Two halves of one run merge into one copy, runs are apart
+            ring.Write(pTarget, 2 * r * runSize, data.data(), runSize / 2);
+            ring.Write(pTarget, 2 * r * runSize + runSize / 2, data.data(), runSize - runSize / 2);
+        }
+        CHECK(SUCCEEDED(ring.End()));
+        expectedTotal += runs * runSize;
+
+        const CommandCounters& counters = pContext->GetCounters();
+        CHECK(ring.GetFrameBytes() == runs * runSize);
+        CHECK(counters.uploadBytes == runs * runSize);
+        CHECK(ring.GetFrameCopies() == runs);
+        CHECK(counters.copies == runs);
+        CHECK(counters.errors == 0);
+    }
+    CHECK(ring.GetTotalBytes() == expectedTotal);
+    CHECK(ring.GetGrowths() == 0);
+    pTarget->Release();
+}
+
+// Writes past the size given to Begin are not dropped: the filled part goes out and the rest follows
+static void TestOverflowGrows() {
+    NullRenderDevice device(64, 64);
+    NullCommandContext* pContext = device.GetContext();
+    GpuBuffer* pTarget = CreateTarget(device, 1 << 20);
+    std::vector<BYTE> data(1 << 20, 3);
+    UploadRing ring(&device);
+
+    pContext->BeginFrame();
+    CHECK(SUCCEEDED(ring.Begin(pContext, 64)));
+    UINT written = 0;
+    for (UINT size = 1000; written + size <= (1u << 20); size *= 2) {
+        ring.Write(pTarget, written, data.data(), size);
+        written += size;
+    }
+    CHECK(SUCCEEDED(ring.End()));
+    CHECK(ring.GetGrowths() > 0);
+    CHECK(ring.GetFrameBytes() == written);
+    CHECK(pContext->GetCounters().uploadBytes == written);
+    CHECK(pContext->GetCounters().errors == 0);
+
+    // Writes without a reservation map a buffer on demand
+    pContext->BeginFrame();
+    CHECK(SUCCEEDED(ring.Begin(pContext, 0)));
+    ring.Write(pTarget, 0, data.data(), 5000);
+    CHECK(SUCCEEDED(ring.End()));
+    CHECK(pContext->GetCounters().uploadBytes == 5000);
+    CHECK(pContext->GetCounters().errors == 0);
+
+    // The staging buffers replaced by the growths are no longer tracked by the context
+    CHECK(pContext->GetTrackedResourceCount() <= UploadRing::frameCount);
+    pTarget->Release();
+}
+
+// A released buffer takes its state along: a new buffer, maybe at the same address, is neither busy nor mapped
+static void TestReleasedBufferForgotten() {
+    NullRenderDevice device(64, 64);
+    NullCommandContext* pContext = device.GetContext();
+    pContext->SetGpuLatency(4);
+    GpuBuffer* pTarget = CreateTarget(device, 256);
+
+    GpuBufferDesc desc = {};
+    desc.byteWidth = 256;
+    desc.usage = GpuUsage::Staging;
+    desc.cpuAccessFlags = GpuCpuAccess::Write;
+    for (int i = 0; i < 16; i++) {
+        pContext->BeginFrame();
+        GpuBuffer* pStaging = NULL;
+        CHECK(SUCCEEDED(device.CreateBuffer(desc, nullptr, &pStaging)));
+        GpuMappedSubresource mapped;
+        CHECK(pContext->Map(pStaging, 0, GpuMap::Write, GpuMapFlag::DoNotWait, &mapped) == S_OK);
+        if (i % 2 == 0) {
+            pContext->Unmap(pStaging, 0);
+        }
+        pContext->CopyResource(pTarget, pStaging);
+        pStaging->Release();
+    }
+    CHECK(pContext->GetCounters().mapStalls == 0);
+    CHECK(pContext->GetCounters().errors == 0);
+    CHECK(pContext->GetTrackedResourceCount() == 0);
+    pTarget->Release();
+}
+
+// While the GPU runs at most as many frames behind as there are staging buffers, no map waits; further behind,
+// Begin skips the busy buffers and only waits when all of them are in use
+static void TestBusyBuffersSkipped() {
+    const UINT latencies[] = { 0, 1, UploadRing::frameCount, UploadRing::frameCount + 2 };
+    for (UINT latency : latencies) {
+        NullRenderDevice device(64, 64);
+        NullCommandContext* pContext = device.GetContext();
+        pContext->SetGpuLatency(latency);
+        GpuBuffer* pTarget = CreateTarget(device, 4096);
+        std::vector<BYTE> data(4096, 1);
+        UploadRing ring(&device);
+
+        UINT stalls = 0;
+        for (int frame = 0; frame < 12; frame++) {
+            pContext->BeginFrame();
+            CHECK(SUCCEEDED(ring.Begin(pContext, 4096)));
+            ring.Write(pTarget, 0, data.data(), 4096);
+            CHECK(SUCCEEDED(ring.End()));
+            CHECK(pContext->GetCounters().errors == 0);
+            stalls += pContext->GetCounters().mapStalls;
+        }
+        CHECK(stalls == ring.GetWaits());
+        if (latency <= UploadRing::frameCount) {
+            CHECK(stalls == 0);
+        }
+        else {
+            CHECK(stalls > 0);
+        }
+        pTarget->Release();
+    }
+}
+
+int main() {
+    TestUploadVolume();
+    TestOverflowGrows();
+    TestReleasedBufferForgotten();
+    TestBusyBuffersSkipped();
+    return TestResult("UploadRingTests");
+}
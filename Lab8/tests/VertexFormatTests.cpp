@@ -0,0 +1,112 @@
+#include "TestCommon.h"
+#include "VertexFormat.h"
+#include <vector>
+
+static XMFLOAT3 RandomUnitVector(std::mt19937& random) {
+    std::normal_distribution<float> component(0.0f, 1.0f);
+    XMFLOAT3 v;
+    XMStoreFloat3(&v, XMVector3Normalize(XMVectorSet(component(random), component(random), component(random), 0.0f)));
+    return v;
+}
+
+static float ComponentError(const XMFLOAT3& a, const XMFLOAT3& b) {
+    return max(max(fabsf(a.x - b.x), fabsf(a.y - b.y)), fabsf(a.z - b.z));
+}
+
+// Packed and decoded through snorm16 the way the vertex shader reads it
+static XMFLOAT3 RoundTripDirection(const XMFLOAT3& n) {
+    Vertex vertex = {};
+    vertex.normal = n;
+    vertex.tangent = n;
+    MeshQuantization quantization = ComputeQuantization(&vertex, 1);
+    PackedVertex packed;
+    PackVertex(vertex, quantization, packed);
+    Vertex unpacked;
+    UnpackVertex(packed, quantization, unpacked);
+    CHECK(ComponentError(unpacked.normal, unpacked.tangent) == 0.0f);
+    return unpacked.normal;
+}
+
+static void TestOctahedralError() {
+    std::mt19937 random(1);
+    float maxError = 0.0f;
+    for (int i = 0; i < 100000; i++) {
+        XMFLOAT3 n = RandomUnitVector(random);
+        maxError = max(maxError, ComponentError(n, RoundTripDirection(n)));
+    }
+    CHECK(maxError <= octahedralPackError);
+
+    // Axes, the fold of the lower hemisphere and the diagonals
+    const float d = 0.57735027f, h = 0.70710678f;
+    const XMFLOAT3 special[] = {
+        XMFLOAT3(1.0f, 0.0f, 0.0f), XMFLOAT3(-1.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 1.0f, 0.0f), XMFLOAT3(0.0f, -1.0f, 0.0f),
+        XMFLOAT3(0.0f, 0.0f, 1.0f), XMFLOAT3(0.0f, 0.0f, -1.0f), XMFLOAT3(d, d, d), XMFLOAT3(-d, -d, -d),
+        XMFLOAT3(d, -d, -d), XMFLOAT3(h, 0.0f, -h), XMFLOAT3(0.0f, -h, -h), XMFLOAT3(h, h, 0.0f)
+    };
+    for (const XMFLOAT3& n : special) {
+        CHECK(ComponentError(n, RoundTripDirection(n)) <= octahedralPackError);
+    }
+    for (const XMFLOAT3& n : special) {
+        XMFLOAT3 decoded = DecodeOctahedral(EncodeOctahedral(n));
+        CHECK(ComponentError(n, decoded) <= 1e-6f);
+    }
+}
+
+static void TestPositionAndUvError() {
+    std::mt19937 random(2);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    const XMFLOAT3 offsets[] = { XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(-1000.0f, 250.0f, 1e4f), XMFLOAT3(0.5f, -0.5f, 3.0f) };
+    const XMFLOAT3 sizes[] = { XMFLOAT3(1.0f, 1.0f, 1.0f), XMFLOAT3(2000.0f, 0.01f, 35.0f), XMFLOAT3(0.0f, 4.0f, 0.0f) };
+    for (int m = 0; m < 3; m++) {
+        std::vector<Vertex> vertices(5000);
+        for (Vertex& vertex : vertices) {
+            vertex.pos = XMFLOAT3(offsets[m].x + sizes[m].x * unit(random), offsets[m].y + sizes[m].y * unit(random),
+                offsets[m].z + sizes[m].z * unit(random));
+            vertex.uv = XMFLOAT2(unit(random), unit(random));
+            vertex.normal = RandomUnitVector(random);
+            vertex.tangent = RandomUnitVector(random);
+        }
+        std::vector<PackedVertex> packed(vertices.size());
+        MeshQuantization quantization = PackVertices(vertices.data(), vertices.size(), packed.data());
+        CHECK(quantization.scale.x > 0.0f && quantization.scale.y > 0.0f && quantization.scale.z > 0.0f);
+        XMFLOAT3 bound = PositionPackError(quantization);
+
+        int positionErrors = 0, uvErrors = 0, directionErrors = 0, paddingErrors = 0;
+        for (size_t i = 0; i < vertices.size(); i++) {
+            Vertex unpacked;
+            UnpackVertex(packed[i], quantization, unpacked);
+            positionErrors += fabsf(unpacked.pos.x - vertices[i].pos.x) > bound.x ||
+                fabsf(unpacked.pos.y - vertices[i].pos.y) > bound.y || fabsf(unpacked.pos.z - vertices[i].pos.z) > bound.z;
+            uvErrors += fabsf(unpacked.uv.x - vertices[i].uv.x) > 1.0f / 4096.0f || fabsf(unpacked.uv.y - vertices[i].uv.y) > 1.0f / 4096.0f;
+            directionErrors += ComponentError(unpacked.normal, vertices[i].normal) > octahedralPackError ||
+                ComponentError(unpacked.tangent, vertices[i].tangent) > octahedralPackError;
+            paddingErrors += packed[i].pos[3] != 0;
+        }
+        CHECK(positionErrors == 0);
+        CHECK(uvErrors == 0);
+        CHECK(directionErrors == 0);
+        CHECK(paddingErrors == 0);
+    }
+}
+
+// The bounds of the mesh map to the ends of the unorm16 range
+static void TestQuantizationBounds() {
+    Vertex vertices[2] = {};
+    vertices[0].pos = XMFLOAT3(-2.0f, 5.0f, 1.0f);
+    vertices[1].pos = XMFLOAT3(6.0f, 7.0f, 1.0f);
+    PackedVertex packed[2];
+    MeshQuantization quantization = PackVertices(vertices, 2, packed);
+    CHECK(quantization.bias.x == -2.0f && quantization.bias.y == 5.0f && quantization.bias.z == 1.0f);
+    CHECK(quantization.scale.x == 8.0f && quantization.scale.y == 2.0f && quantization.scale.z == 1.0f);
+    CHECK(packed[0].pos[0] == 0 && packed[0].pos[1] == 0 && packed[0].pos[2] == 0);
+    CHECK(packed[1].pos[0] == 65535 && packed[1].pos[1] == 65535 && packed[1].pos[2] == 0);
+}
+
+int main() {
+    // Less than half of the vertex fetch bandwidth
+    CHECK(sizeof(PackedVertex) == 20 && sizeof(Vertex) == 44);
+    TestOctahedralError();
+    TestPositionAndUvError();
+    TestQuantizationBounds();
+    return TestResult("VertexFormatTests");
+}